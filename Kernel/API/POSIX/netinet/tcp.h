@@ -12,6 +12,7 @@ extern "C" {
 
 #define TCP_NODELAY 10
 #define TCP_MAXSEG 11
+#define TCP_CONGESTION 12
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <Kernel/API/POSIX/fcntl.h>
+#include <Kernel/API/POSIX/poll.h>
+#include <Kernel/API/POSIX/sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EPOLL_CLOEXEC O_CLOEXEC
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLLIN POLLIN
+#define EPOLLPRI POLLPRI
+#define EPOLLOUT POLLOUT
+#define EPOLLERR POLLERR
+#define EPOLLHUP POLLHUP
+#define EPOLLWRBAND POLLWRBAND
+#define EPOLLRDHUP POLLRDHUP
+#define EPOLLRDNORM EPOLLIN
+#define EPOLLWRNORM EPOLLOUT
+
+// Only report an event when the file becomes ready, instead of for as long as it is ready.
+#define EPOLLET (1u << 31)
+// Disable the interest after reporting one event, until it is re-armed with EPOLL_CTL_MOD.
+#define EPOLLONESHOT (1u << 30)
+
+typedef union epoll_data {
+    void* ptr;
+    int fd;
+    uint32_t u32;
+    uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+    uint32_t events;
+    epoll_data_t data;
+};
+
+#ifdef __cplusplus
+}
+#endif
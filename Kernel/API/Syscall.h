@@ -18,6 +18,8 @@
 constexpr int syscall_vector = 0x82;
 
 extern "C" {
+struct epoll_event;
+struct mmsghdr;
 struct pollfd;
 struct timeval;
 struct timespec;
@@ -70,6 +72,9 @@ enum class NeedsBigProcessLock {
     S(dump_backtrace, NeedsBigProcessLock::No)             \
     S(dup2, NeedsBigProcessLock::No)                       \
     S(emuctl, NeedsBigProcessLock::No)                     \
+    S(epoll_create, NeedsBigProcessLock::No)               \
+    S(epoll_ctl, NeedsBigProcessLock::No)                  \
+    S(epoll_wait, NeedsBigProcessLock::No)                 \
     S(execve, NeedsBigProcessLock::Yes)                    \
     S(exit, NeedsBigProcessLock::Yes)                      \
     S(exit_thread, NeedsBigProcessLock::Yes)               \
@@ -151,6 +156,7 @@ enum class NeedsBigProcessLock {
     S(readv, NeedsBigProcessLock::Yes)                     \
     S(realpath, NeedsBigProcessLock::No)                   \
     S(recvfd, NeedsBigProcessLock::No)                     \
+    S(recvmmsg, NeedsBigProcessLock::Yes)                  \
     S(recvmsg, NeedsBigProcessLock::Yes)                   \
     S(rename, NeedsBigProcessLock::No)                     \
     S(remount, NeedsBigProcessLock::No)                    \
@@ -158,6 +164,8 @@ enum class NeedsBigProcessLock {
     S(scheduler_get_parameters, NeedsBigProcessLock::No)   \
     S(scheduler_set_parameters, NeedsBigProcessLock::No)   \
     S(sendfd, NeedsBigProcessLock::No)                     \
+    S(sendfile, NeedsBigProcessLock::Yes)                  \
+    S(sendmmsg, NeedsBigProcessLock::Yes)                  \
     S(sendmsg, NeedsBigProcessLock::Yes)                   \
     S(set_mmap_name, NeedsBigProcessLock::No)              \
     S(setegid, NeedsBigProcessLock::No)                    \
@@ -265,6 +273,22 @@ struct SC_poll_params {
     u32 const* sigmask;
 };
 
+struct SC_epoll_wait_params {
+    int epoll_fd;
+    struct epoll_event* events;
+    int max_events;
+    const struct timespec* timeout;
+    u32 const* sigmask;
+};
+
+struct SC_recvmmsg_params {
+    int sockfd;
+    struct mmsghdr* msgvec;
+    unsigned int vlen;
+    int flags;
+    const struct timespec* timeout;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -64,6 +64,8 @@ public:
     static bool is_smp_enabled();
     static void smp_enable();
     static u32 smp_wake_n_idle_processors(u32 wake_count);
+    // Wakes up one idle processor out of the given mask, other than the current one. Returns whether there was one.
+    static bool smp_wake_idle_processor(u32 processor_mask);
 
     static void flush_tlb_local(VirtualAddress vaddr, size_t page_count);
     static void flush_tlb(Memory::PageDirectory const*, VirtualAddress, size_t);
@@ -29,6 +29,9 @@ public:
         m_raw |= PhysicalAddress::physical_page_base(value);
     }
 
+    // The physical address of a huge entry, without the PAT and NX bits that page_table_base() would pick up.
+    PhysicalPtr large_page_base() const { return m_raw & 0x000fffffffe00000ULL; }
+
     bool is_null() const { return m_raw == 0; }
     void clear() { m_raw = 0; }
 
@@ -43,6 +46,8 @@ public:
         CacheDisabled = 1 << 4,
         Huge = 1 << 7,
         Global = 1 << 8,
+        // For huge entries, bit 7 is taken by the page size, so the PAT bit moves to bit 12.
+        LargePagePAT = 1 << 12,
         NoExecute = 0x8000000000000000ULL,
     };
 
@@ -52,6 +57,9 @@ public:
     bool is_user_allowed() const { return (raw() & UserSupervisor) == UserSupervisor; }
     void set_user_allowed(bool b) { set_bit(UserSupervisor, b); }
 
+    bool is_large_page_pat() const { return (raw() & LargePagePAT) == LargePagePAT; }
+    void set_large_page_pat(bool b) { set_bit(LargePagePAT, b); }
+
     bool is_huge() const { return (raw() & Huge) == Huge; }
     void set_huge(bool b) { set_bit(Huge, b); }
 
@@ -100,6 +108,7 @@ public:
         UserSupervisor = 1 << 2,
         WriteThrough = 1 << 3,
         CacheDisabled = 1 << 4,
+        Accessed = 1 << 5,
         PAT = 1 << 7,
         Global = 1 << 8,
         NoExecute = 0x8000000000000000ULL,
@@ -129,6 +138,9 @@ public:
     bool is_pat() const { return (raw() & PAT) == PAT; }
     void set_pat(bool b) { set_bit(PAT, b); }
 
+    bool is_accessed() const { return (raw() & Accessed) == Accessed; }
+    void set_accessed(bool b) { set_bit(Accessed, b); }
+
     bool is_null() const { return m_raw == 0; }
     void clear() { m_raw = 0; }
 
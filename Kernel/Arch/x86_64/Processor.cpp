@@ -1066,6 +1066,28 @@ u32 ProcessorBase<T>::smp_wake_n_idle_processors(u32 wake_count)
     return did_wake_count;
 }
 
+template<typename T>
+bool ProcessorBase<T>::smp_wake_idle_processor(u32 processor_mask)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    if (!s_smp_enabled)
+        return false;
+
+    processor_mask &= ~(1u << Processor::current_id());
+    for (;;) {
+        u32 idle_mask = Processor::s_idle_cpu_mask.load(AK::MemoryOrder::memory_order_relaxed) & processor_mask;
+        if (idle_mask == 0)
+            return false;
+        u32 cpu = bit_scan_forward(idle_mask) - 1;
+
+        // Flip it to busy first, so that nobody else sends it an IPI as well.
+        if (!(Processor::s_idle_cpu_mask.fetch_and(~(1u << cpu), AK::MemoryOrder::memory_order_acq_rel) & (1u << cpu)))
+            continue;
+        APIC::the().send_ipi(cpu);
+        return true;
+    }
+}
+
 template<typename T>
 UNMAP_AFTER_INIT void ProcessorBase<T>::smp_enable()
 {
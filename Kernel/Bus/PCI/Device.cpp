@@ -29,6 +29,10 @@ bool Device::is_msix_capable() const
 {
     return m_pci_identifier->is_msix_capable();
 }
+u16 Device::msix_table_size() const
+{
+    return m_pci_identifier->get_msix_table_size();
+}
 
 void Device::enable_pin_based_interrupts() const
 {
@@ -46,6 +46,7 @@ public:
 
     bool is_msi_capable() const;
     bool is_msix_capable() const;
+    u16 msix_table_size() const;
 
     void enable_message_signalled_interrupts();
     void disable_message_signalled_interrupts();
@@ -144,13 +144,16 @@ bool Device::handle_irq(Badge<TransportInterruptHandler>)
     }
     if (isr_type & QUEUE_INTERRUPT) {
         dbgln_if(VIRTIO_DEBUG, "{}: VirtIO Queue interrupt!", class_name());
+        // NOTE: Devices with multiple queues may have used buffers in several of them for the same interrupt.
+        bool did_handle_queue_update = false;
         for (size_t i = 0; i < m_queues.size(); i++) {
             if (get_queue(i).new_data_available()) {
                 handle_queue_update(i);
-                return true;
+                did_handle_queue_update = true;
             }
         }
-        dbgln_if(VIRTIO_DEBUG, "{}: Got queue interrupt but all queues are up to date!", class_name());
+        if (!did_handle_queue_update)
+            dbgln_if(VIRTIO_DEBUG, "{}: Got queue interrupt but all queues are up to date!", class_name());
     }
     return true;
 }
@@ -72,6 +72,13 @@ public:
         start();
     }
 
+    // The request is serviced as part of an earlier one that it was merged into, so it is never started on its own.
+    void mark_started_by_merge()
+    {
+        VERIFY(m_result == Pending);
+        m_result = Started;
+    }
+
     void complete(RequestResult result);
 
     void set_private(void* priv)
@@ -17,6 +17,7 @@ AsyncBlockDeviceRequest::AsyncBlockDeviceRequest(Device& block_device, RequestTy
     , m_block_count(block_count)
     , m_buffer(buffer)
     , m_buffer_size(buffer_size)
+    , m_total_block_count(block_count)
 {
 }
 
@@ -25,8 +26,35 @@ void AsyncBlockDeviceRequest::start()
     m_block_device.start_request(*this);
 }
 
+ErrorOr<void> AsyncBlockDeviceRequest::try_merge(AsyncBlockDeviceRequest& following_request)
+{
+    VERIFY(following_request.m_request_type == m_request_type);
+    VERIFY(following_request.m_block_index == m_block_index + m_total_block_count);
+    TRY(m_merged_requests.try_append(following_request));
+    m_total_block_count += following_request.m_block_count;
+    return {};
+}
+
 BlockDevice::~BlockDevice() = default;
 
+bool BlockDevice::try_merge_requests(AsyncDeviceRequest& request, AsyncDeviceRequest& following_request)
+{
+    auto max_block_count = max_merged_block_count();
+    if (max_block_count == 0)
+        return false;
+
+    // Only block device requests are ever queued on a block device.
+    auto& block_request = static_cast<AsyncBlockDeviceRequest&>(request);
+    auto& following_block_request = static_cast<AsyncBlockDeviceRequest&>(following_request);
+    if (following_block_request.request_type() != block_request.request_type())
+        return false;
+    if (following_block_request.block_index() != block_request.block_index() + block_request.total_block_count())
+        return false;
+    if (block_request.total_block_count() + following_block_request.block_count() > max_block_count)
+        return false;
+    return !block_request.try_merge(following_block_request).is_error();
+}
+
 void BlockDevice::after_inserting_add_symlink_to_device_identifier_directory()
 {
     VERIFY(m_symlink_sysfs_component);
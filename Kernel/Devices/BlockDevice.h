@@ -27,6 +27,10 @@ public:
 
     virtual void start_request(AsyncBlockDeviceRequest&) = 0;
 
+    // How many blocks a request may cover once the requests for the blocks following it are merged into it.
+    // Zero means the device doesn't want requests to be merged.
+    virtual u32 max_merged_block_count() const { return 0; }
+
 protected:
     BlockDevice(MajorNumber major, MinorNumber minor, size_t block_size = PAGE_SIZE)
         : Device(major, minor)
@@ -40,6 +44,7 @@ protected:
 
 protected:
     virtual bool is_block_device() const final { return true; }
+    virtual bool try_merge_requests(AsyncDeviceRequest&, AsyncDeviceRequest&) override;
 
     virtual void after_inserting_add_symlink_to_device_identifier_directory() override final;
     virtual void before_will_be_destroyed_remove_symlink_from_device_identifier_directory() override final;
@@ -70,6 +75,11 @@ public:
     UserOrKernelBuffer const& buffer() const { return m_buffer; }
     size_t buffer_size() const { return m_buffer_size; }
 
+    // Requests for the blocks directly following this request's, which the device services together with this one.
+    Span<NonnullLockRefPtr<AsyncBlockDeviceRequest>> merged_requests() { return m_merged_requests; }
+    u32 total_block_count() const { return m_total_block_count; }
+    ErrorOr<void> try_merge(AsyncBlockDeviceRequest&);
+
     virtual void start() override;
     virtual StringView name() const override
     {
@@ -90,6 +100,8 @@ private:
     const u32 m_block_count;
     UserOrKernelBuffer m_buffer;
     const size_t m_buffer_size;
+    Vector<NonnullLockRefPtr<AsyncBlockDeviceRequest>> m_merged_requests;
+    u32 m_total_block_count { 0 };
 };
 
 }
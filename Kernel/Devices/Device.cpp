@@ -71,16 +71,44 @@ ErrorOr<NonnullRefPtr<OpenFileDescription>> Device::open(int options)
 
 void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceRequest const& completed_request)
 {
-    SpinlockLocker lock(m_requests_lock);
-    VERIFY(!m_requests.is_empty());
-    VERIFY(m_requests.first().ptr() == &completed_request);
-    m_requests.remove(m_requests.begin());
-    if (!m_requests.is_empty()) {
-        auto* next_request = m_requests.first().ptr();
-        next_request->do_start(move(lock));
+    {
+        SpinlockLocker lock(m_requests_lock);
+        VERIFY(m_requests_in_flight > 0);
+        auto it = m_requests.begin();
+        while (it != m_requests.end() && it->ptr() != &completed_request)
+            ++it;
+        VERIFY(it != m_requests.end());
+        m_requests.remove(it);
+        --m_requests_in_flight;
     }
+    start_queued_requests();
 
     evaluate_block_conditions();
 }
 
+void Device::start_queued_requests()
+{
+    for (;;) {
+        SpinlockLocker lock(m_requests_lock);
+        if (m_requests_in_flight >= max_requests_in_flight())
+            return;
+
+        auto it = m_requests.begin();
+        for (size_t i = 0; i < m_requests_in_flight && it != m_requests.end(); ++i)
+            ++it;
+        if (it == m_requests.end())
+            return;
+
+        auto* request = it->ptr();
+        ++m_requests_in_flight;
+        for (auto next = it; ++next != m_requests.end();) {
+            if (!try_merge_requests(*request, **next))
+                break;
+            (*next)->mark_started_by_merge();
+            ++m_requests_in_flight;
+        }
+        request->do_start(move(lock));
+    }
+}
+
 }
@@ -51,15 +51,18 @@ public:
     virtual bool is_openable_by_jailed_processes() const { return false; }
     void process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceRequest const&);
 
+    // How many requests the device can work on at the same time. The others wait in the queue in order.
+    virtual size_t max_requests_in_flight() const { return 1; }
+
     template<typename AsyncRequestType, typename... Args>
     ErrorOr<NonnullLockRefPtr<AsyncRequestType>> try_make_request(Args&&... args)
     {
         auto request = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) AsyncRequestType(*this, forward<Args>(args)...)));
-        SpinlockLocker lock(m_requests_lock);
-        bool was_empty = m_requests.is_empty();
-        TRY(m_requests.try_append(request));
-        if (was_empty)
-            request->do_start(move(lock));
+        {
+            SpinlockLocker lock(m_requests_lock);
+            TRY(m_requests.try_append(request));
+        }
+        start_queued_requests();
         return request;
     }
 
@@ -77,7 +80,12 @@ protected:
     virtual void after_inserting_add_to_device_identifier_directory() = 0;
     virtual void before_will_be_destroyed_remove_from_device_identifier_directory() = 0;
 
+    // Lets a request that is about to be started also service the queued request directly following it.
+    virtual bool try_merge_requests(AsyncDeviceRequest&, AsyncDeviceRequest&) { return false; }
+
 private:
+    void start_queued_requests();
+
     MajorNumber const m_major { 0 };
     MinorNumber const m_minor { 0 };
 
@@ -85,6 +93,8 @@ private:
 
     Spinlock<LockRank::None> m_requests_lock {};
     DoublyLinkedList<LockRefPtr<AsyncDeviceRequest>> m_requests;
+    // The requests in flight are always the first ones in m_requests, since requests are started in order.
+    size_t m_requests_in_flight { 0 };
 
 protected:
     // FIXME: This pointer will be eventually removed after all nodes in /sys/dev/block/ and
@@ -45,6 +45,15 @@ void DiskPartition::start_request(AsyncBlockDeviceRequest& request)
     request.add_sub_request(sub_request_or_error.release_value());
 }
 
+size_t DiskPartition::max_requests_in_flight() const
+{
+    // Our requests just become requests of the underlying device, so let it decide.
+    auto device = m_device.strong_ref();
+    if (!device)
+        return 1;
+    return device->max_requests_in_flight();
+}
+
 ErrorOr<size_t> DiskPartition::read(OpenFileDescription& fd, u64 offset, UserOrKernelBuffer& outbuf, size_t len)
 {
     u64 adjust = m_metadata.start_block() * block_size();
@@ -6,6 +6,7 @@
  */
 
 #include <AK/Format.h>
+#include <AK/IntegralMath.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/Delay.h>
 #include <Kernel/Arch/Interrupts.h>
@@ -35,8 +36,8 @@ UNMAP_AFTER_INIT NVMeController::NVMeController(const PCI::DeviceIdentifier& dev
 
 UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize(bool is_queue_polled)
 {
-    // Nr of queues = one queue per core
-    auto nr_of_queues = Processor::count();
+    // Ideally one IO queue per core, but the controller and the number of MSI-X vectors may allow fewer.
+    u32 nr_of_queues = Processor::count();
     auto queue_type = is_queue_polled ? QueueType::Polled : QueueType::IRQ;
 
     PCI::enable_memory_space(device_identifier());
@@ -53,16 +54,21 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize(bool is_queue_polled)
     m_ready_timeout = Duration::from_milliseconds((CAP_TO(caps) + 1) * 500); // CAP.TO is in 500ms units
 
     calculate_doorbell_stride();
+    // Every IO queue gets its own MSI-X vector, next to the admin queue's.
+    if (queue_type == QueueType::IRQ && is_msix_capable())
+        nr_of_queues = min(nr_of_queues, max<u32>(msix_table_size(), 2) - 1);
     // IO queues + 1 admin queue
     m_irq_type = TRY(reserve_irqs(nr_of_queues + 1, true));
 
     TRY(create_admin_queue(queue_type));
     VERIFY(m_admin_queue_ready == true);
 
-    VERIFY(IO_QUEUE_SIZE < MQES(caps));
-    dbgln_if(NVME_DEBUG, "NVMe: IO queue depth is: {}", IO_QUEUE_SIZE);
+    m_io_queue_depth = min<u32>(IO_QUEUE_SIZE, MQES(caps));
+    dbgln_if(NVME_DEBUG, "NVMe: IO queue depth is: {}", m_io_queue_depth);
 
     TRY(identify_and_init_controller());
+    nr_of_queues = TRY(request_io_queues(nr_of_queues));
+    dbgln_if(NVME_DEBUG, "NVMe: Using {} IO queues", nr_of_queues);
     // Create an IO queue per core
     for (u32 cpuid = 0; cpuid < nr_of_queues; ++cpuid) {
         // qid is zero is used for admin queue
@@ -209,7 +215,7 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::identify_and_init_namespaces()
 
             dbgln_if(NVME_DEBUG, "NVMe: Block count is {} and Block size is {}", block_counts, block_size);
 
-            m_namespaces.append(TRY(NVMeNameSpace::try_create(*this, m_queues, nsid, block_counts, block_size)));
+            m_namespaces.append(TRY(NVMeNameSpace::try_create(*this, m_queues, nsid, block_counts, block_size, m_max_transfer_pages)));
             m_device_count++;
             dbgln_if(NVME_DEBUG, "NVMe: Initialized namespace with NSID: {}", nsid);
         }
@@ -222,6 +228,7 @@ ErrorOr<void> NVMeController::identify_and_init_controller()
     RefPtr<Memory::PhysicalPage> prp_dma_buffer;
     OwnPtr<Memory::Region> prp_dma_region;
     IdentifyController ctrl {};
+    static_assert(sizeof(IdentifyController) == NVMe_IDENTIFY_SIZE);
 
     {
         auto buffer = TRY(MM.allocate_dma_buffer_page("Identify PRP"sv, Memory::Region::Access::ReadWrite, prp_dma_buffer));
@@ -245,6 +252,15 @@ ErrorOr<void> NVMeController::identify_and_init_controller()
         }
     }
 
+    // MDTS is a power of two in units of the minimum memory page size, and 0 means there is no limit.
+    if (ctrl.mdts) {
+        u64 max_transfer_size = (1ull << ctrl.mdts) << (12 + CAP_MPSMIN(m_controller_regs->cap));
+        m_max_transfer_pages = min<u64>(m_max_transfer_pages, max(max_transfer_size / PAGE_SIZE, 1ull));
+    }
+    // Keeps every command's PRP list within a single page of the queue's PRP list region.
+    m_max_transfer_pages = static_cast<size_t>(1) << AK::log2(m_max_transfer_pages);
+    dbgln_if(NVME_DEBUG, "NVMe: Maximum transfer size is {} pages", m_max_transfer_pages);
+
     if (ctrl.oacs & ID_CTRL_SHADOW_DBBUF_MASK) {
         OwnPtr<Memory::Region> dbbuf_dma_region;
         OwnPtr<Memory::Region> eventidx_dma_region;
@@ -276,6 +292,26 @@ ErrorOr<void> NVMeController::identify_and_init_controller()
     return {};
 }
 
+UNMAP_AFTER_INIT ErrorOr<u32> NVMeController::request_io_queues(u32 count)
+{
+    NVMeSubmission sub {};
+    sub.op = OP_ADMIN_SET_FEATURES;
+    sub.generic.cdw10 = AK::convert_between_host_and_little_endian(static_cast<u32>(FEATURE_NUMBER_OF_QUEUES));
+    // Both counts are 0 based
+    sub.generic.cdw11 = AK::convert_between_host_and_little_endian(((count - 1) << 16) | (count - 1));
+    u32 result = 0;
+    u16 status = submit_admin_command(sub, true, &result);
+    if (status) {
+        dmesgln_pci(*this, "Failed to set the number of IO queues");
+        return EFAULT;
+    }
+
+    // The controller may allocate a different number of queues than requested.
+    u32 allocated_submission_queues = (result & 0xffff) + 1;
+    u32 allocated_completion_queues = (result >> 16) + 1;
+    return min(count, min(allocated_submission_queues, allocated_completion_queues));
+}
+
 UNMAP_AFTER_INIT Tuple<u64, u8> NVMeController::get_ns_features(IdentifyNamespace& identify_data_struct)
 {
     auto flbas = identify_data_struct.flbas & FLBA_SIZE_MASK;
@@ -358,7 +394,7 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_admin_queue(QueueType queu
         return maybe_error;
     }
     set_admin_queue_ready_flag();
-    m_admin_queue = TRY(NVMeQueue::try_create(*this, 0, irq, qdepth, move(cq_dma_region), move(sq_dma_region), move(doorbell), queue_type));
+    m_admin_queue = TRY(NVMeQueue::try_create(*this, 0, irq, qdepth, 0, move(cq_dma_region), move(sq_dma_region), move(doorbell), queue_type));
 
     dbgln_if(NVME_DEBUG, "NVMe: Admin queue created");
     return {};
@@ -370,8 +406,8 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 qid, QueueType
     Vector<NonnullRefPtr<Memory::PhysicalPage>> cq_dma_pages;
     OwnPtr<Memory::Region> sq_dma_region;
     Vector<NonnullRefPtr<Memory::PhysicalPage>> sq_dma_pages;
-    auto cq_size = round_up_to_power_of_two(CQ_SIZE(IO_QUEUE_SIZE), 4096);
-    auto sq_size = round_up_to_power_of_two(SQ_SIZE(IO_QUEUE_SIZE), 4096);
+    auto cq_size = round_up_to_power_of_two(CQ_SIZE(m_io_queue_depth), 4096);
+    auto sq_size = round_up_to_power_of_two(SQ_SIZE(m_io_queue_depth), 4096);
 
     {
         auto buffer = TRY(MM.allocate_dma_buffer_pages(cq_size, "IO CQ queue"sv, Memory::Region::Access::ReadWrite, cq_dma_pages));
@@ -393,7 +429,7 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 qid, QueueType
         sub.create_cq.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(cq_dma_pages.first()->paddr().as_ptr()));
         sub.create_cq.cqid = qid;
         // The queue size is 0 based
-        sub.create_cq.qsize = AK::convert_between_host_and_little_endian(IO_QUEUE_SIZE - 1);
+        sub.create_cq.qsize = AK::convert_between_host_and_little_endian(m_io_queue_depth - 1);
         auto flags = (queue_type == QueueType::IRQ) ? QUEUE_IRQ_ENABLED : QUEUE_IRQ_DISABLED;
         flags |= QUEUE_PHY_CONTIGUOUS;
         // When using MSIx interrupts, qid is used as an index into the interrupt table
@@ -407,7 +443,7 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 qid, QueueType
         sub.create_sq.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(sq_dma_pages.first()->paddr().as_ptr()));
         sub.create_sq.sqid = qid;
         // The queue size is 0 based
-        sub.create_sq.qsize = AK::convert_between_host_and_little_endian(IO_QUEUE_SIZE - 1);
+        sub.create_sq.qsize = AK::convert_between_host_and_little_endian(m_io_queue_depth - 1);
         auto flags = QUEUE_PHY_CONTIGUOUS;
         sub.create_sq.cqid = qid;
         sub.create_sq.sq_flags = AK::convert_between_host_and_little_endian(flags);
@@ -432,7 +468,7 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 qid, QueueType
 
     auto irq = TRY(allocate_irq(qid));
 
-    m_queues.append(TRY(NVMeQueue::try_create(*this, qid, irq, IO_QUEUE_SIZE, move(cq_dma_region), move(sq_dma_region), move(doorbell), queue_type)));
+    m_queues.append(TRY(NVMeQueue::try_create(*this, qid, irq, m_io_queue_depth, m_max_transfer_pages, move(cq_dma_region), move(sq_dma_region), move(doorbell), queue_type)));
     dbgln_if(NVME_DEBUG, "NVMe: Created IO Queue with QID{}", m_queues.size());
     return {};
 }
@@ -41,11 +41,11 @@ public:
     ErrorOr<void> start_controller();
     u32 get_admin_q_dept();
 
-    u16 submit_admin_command(NVMeSubmission& sub, bool sync = false)
+    u16 submit_admin_command(NVMeSubmission& sub, bool sync = false, u32* result = nullptr)
     {
         // First queue is always the admin queue
         if (sync) {
-            return m_admin_queue->submit_sync_sqe(sub);
+            return m_admin_queue->submit_sync_sqe(sub, result);
         }
         m_admin_queue->submit_sqe(sub);
         return 0;
@@ -59,6 +59,7 @@ private:
 
     ErrorOr<void> identify_and_init_namespaces();
     ErrorOr<void> identify_and_init_controller();
+    ErrorOr<u32> request_io_queues(u32 count);
     Tuple<u64, u8> get_ns_features(IdentifyNamespace& identify_data_struct);
     ErrorOr<void> create_admin_queue(QueueType queue_type);
     ErrorOr<void> create_io_queue(u8 qid, QueueType queue_type);
@@ -80,6 +81,8 @@ private:
     AK::Duration m_ready_timeout;
     u32 m_bar { 0 };
     u8 m_dbl_stride { 0 };
+    u32 m_io_queue_depth { 0 };
+    size_t m_max_transfer_pages { MAX_IO_TRANSFER_PAGES };
     PCI::InterruptType m_irq_type;
     QueueType m_queue_type { QueueType::IRQ };
     static Atomic<u8> s_controller_id;
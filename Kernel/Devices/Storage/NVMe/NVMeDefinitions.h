@@ -34,13 +34,15 @@ struct IdentifyNamespace {
     u64 rsvd3[488];
 };
 
-// FIXME: For now only one value is used. Once we start using
+// FIXME: For now only a few values are used. Once we start using
 // more values from id_ctrl command, use separate member variables
 // instead of using rsd array.
 struct IdentifyController {
-    u8 rsdv1[256];
+    u8 rsdv1[77];
+    u8 mdts;
+    u8 rsdv2[178];
     u16 oacs;
-    u8 rsdv2[3838];
+    u8 rsdv3[3838];
 };
 
 // DOORBELL
@@ -64,6 +66,13 @@ static constexpr u32 CAP_TO(u64 cap)
     return (cap & CAP_TO_MASK) >> CAP_TO_SHIFT;
 }
 
+static constexpr u8 CAP_MPSMIN_SHIFT = 48;
+static constexpr u64 CAP_MPSMIN_MASK = 0xfull << CAP_MPSMIN_SHIFT;
+static constexpr u32 CAP_MPSMIN(u64 cap)
+{
+    return (cap & CAP_MPSMIN_MASK) >> CAP_MPSMIN_SHIFT;
+}
+
 // CC – Controller Configuration
 static constexpr u8 CC_EN_BIT = 0x0;
 static constexpr u8 CSTS_RDY_BIT = 0x0;
@@ -106,7 +115,13 @@ static constexpr u16 CQ_STATUS_FIELD(u16 x)
     return (x & CQ_STATUS_FIELD_MASK) >> 1;
 }
 
-static constexpr u16 IO_QUEUE_SIZE = 64; // TODO:Need to be configurable
+static constexpr u16 IO_QUEUE_SIZE = 256; // Clamped to what the controller supports (CAP.MQES)
+// Every IO queue bounces data through a pool of DMA pages, which also limits how much data it can have in flight.
+static constexpr u16 IO_QUEUE_DMA_POOL_PAGES = 128;
+// The most a single read or write may transfer, it's further limited by the controller's MDTS.
+static constexpr u16 MAX_IO_TRANSFER_PAGES = 16;
+// How many requests a namespace hands to its queues at once, the rest wait in the block layer to be merged.
+static constexpr u16 MAX_IO_REQUESTS_IN_FLIGHT = 64;
 
 // IDENTIFY
 static constexpr u16 NVMe_IDENTIFY_SIZE = 4096;
@@ -124,9 +139,13 @@ enum AdminCommandOpCode {
     OP_ADMIN_CREATE_COMPLETION_QUEUE = 0x5,
     OP_ADMIN_CREATE_SUBMISSION_QUEUE = 0x1,
     OP_ADMIN_IDENTIFY = 0x6,
+    OP_ADMIN_SET_FEATURES = 0x9,
     OP_ADMIN_DBBUF_CONFIG = 0x7C,
 };
 
+// FEATURES
+static constexpr u8 FEATURE_NUMBER_OF_QUEUES = 0x7;
+
 // IO opcodes
 enum IOCommandOpcode {
     OP_NVME_WRITE = 0x1,
@@ -138,6 +157,9 @@ static constexpr u8 QUEUE_PHY_CONTIGUOUS = (1 << 0);
 static constexpr u8 QUEUE_IRQ_ENABLED = (1 << 1);
 static constexpr u8 QUEUE_IRQ_DISABLED = (0 << 1);
 
+// Generic command status, internal error
+static constexpr u16 STATUS_INTERNAL_ERROR = 0x6;
+
 struct [[gnu::packed]] NVMeCompletion {
     LittleEndian<u32> cmd_spec;
     LittleEndian<u32> res;
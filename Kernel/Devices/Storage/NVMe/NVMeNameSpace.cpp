@@ -12,31 +12,24 @@
 
 namespace Kernel {
 
-UNMAP_AFTER_INIT ErrorOr<NonnullLockRefPtr<NVMeNameSpace>> NVMeNameSpace::try_create(NVMeController const& controller, Vector<NonnullLockRefPtr<NVMeQueue>> queues, u16 nsid, size_t storage_size, size_t lba_size)
+UNMAP_AFTER_INIT ErrorOr<NonnullLockRefPtr<NVMeNameSpace>> NVMeNameSpace::try_create(NVMeController const& controller, Vector<NonnullLockRefPtr<NVMeQueue>> queues, u16 nsid, size_t storage_size, size_t lba_size, size_t max_transfer_pages)
 {
-    auto device = TRY(DeviceManagement::try_create_device<NVMeNameSpace>(StorageDevice::LUNAddress { controller.controller_id(), nsid, 0 }, controller.hardware_relative_controller_id(), move(queues), storage_size, lba_size, nsid));
+    auto device = TRY(DeviceManagement::try_create_device<NVMeNameSpace>(StorageDevice::LUNAddress { controller.controller_id(), nsid, 0 }, controller.hardware_relative_controller_id(), move(queues), storage_size, lba_size, nsid, max_transfer_pages));
     return device;
 }
 
-UNMAP_AFTER_INIT NVMeNameSpace::NVMeNameSpace(LUNAddress logical_unit_number_address, u32 hardware_relative_controller_id, Vector<NonnullLockRefPtr<NVMeQueue>> queues, size_t max_addresable_block, size_t lba_size, u16 nsid)
+UNMAP_AFTER_INIT NVMeNameSpace::NVMeNameSpace(LUNAddress logical_unit_number_address, u32 hardware_relative_controller_id, Vector<NonnullLockRefPtr<NVMeQueue>> queues, size_t max_addresable_block, size_t lba_size, u16 nsid, size_t max_transfer_pages)
     : StorageDevice(logical_unit_number_address, hardware_relative_controller_id, lba_size, max_addresable_block)
     , m_nsid(nsid)
+    , m_max_transfer_pages(max_transfer_pages)
     , m_queues(move(queues))
 {
 }
 
 void NVMeNameSpace::start_request(AsyncBlockDeviceRequest& request)
 {
-    auto index = Processor::current_id();
-    auto& queue = m_queues.at(index);
-    // TODO: For now we support only IO transfers of size PAGE_SIZE (Going along with the current constraint in the block layer)
-    // Eventually remove this constraint by using the PRP2 field in the submission struct and remove block layer constraint for NVMe driver.
-    VERIFY(request.block_count() <= (PAGE_SIZE / block_size()));
-
-    if (request.request_type() == AsyncBlockDeviceRequest::Read) {
-        queue->read(request, m_nsid, request.block_index(), request.block_count());
-    } else {
-        queue->write(request, m_nsid, request.block_index(), request.block_count());
-    }
+    // There may be fewer queues than processors if the controller doesn't support that many.
+    auto& queue = m_queues.at(Processor::current_id() % m_queues.size());
+    queue->submit_io(request, m_nsid);
 }
 }
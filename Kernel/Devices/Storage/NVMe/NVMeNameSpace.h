@@ -23,15 +23,18 @@ class NVMeNameSpace : public StorageDevice {
     friend class DeviceManagement;
 
 public:
-    static ErrorOr<NonnullLockRefPtr<NVMeNameSpace>> try_create(NVMeController const&, Vector<NonnullLockRefPtr<NVMeQueue>> queues, u16 nsid, size_t storage_size, size_t lba_size);
+    static ErrorOr<NonnullLockRefPtr<NVMeNameSpace>> try_create(NVMeController const&, Vector<NonnullLockRefPtr<NVMeQueue>> queues, u16 nsid, size_t storage_size, size_t lba_size, size_t max_transfer_pages);
 
     CommandSet command_set() const override { return CommandSet::NVMe; }
     void start_request(AsyncBlockDeviceRequest& request) override;
+    virtual size_t max_requests_in_flight() const override { return MAX_IO_REQUESTS_IN_FLIGHT; }
+    virtual u32 max_merged_block_count() const override { return m_max_transfer_pages * PAGE_SIZE / block_size(); }
 
 private:
-    NVMeNameSpace(LUNAddress, u32 hardware_relative_controller_id, Vector<NonnullLockRefPtr<NVMeQueue>> queues, size_t storage_size, size_t lba_size, u16 nsid);
+    NVMeNameSpace(LUNAddress, u32 hardware_relative_controller_id, Vector<NonnullLockRefPtr<NVMeQueue>> queues, size_t storage_size, size_t lba_size, u16 nsid, size_t max_transfer_pages);
 
     u16 m_nsid;
+    size_t m_max_transfer_pages { 0 };
     Vector<NonnullLockRefPtr<NVMeQueue>> m_queues;
 };
 
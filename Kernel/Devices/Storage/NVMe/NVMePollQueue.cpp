@@ -11,57 +11,42 @@
 
 namespace Kernel {
 
-ErrorOr<NonnullLockRefPtr<NVMePollQueue>> NVMePollQueue::try_create(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtr<Memory::PhysicalPage> rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
+ErrorOr<NonnullLockRefPtr<NVMePollQueue>> NVMePollQueue::try_create(DMAPool dma_pool, Bitmap used_dma_pages, size_t max_transfer_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
 {
-    return TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), rw_dma_page, qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs))));
+    return TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(dma_pool), move(used_dma_pages), max_transfer_pages, qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs))));
 }
 
-UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtr<Memory::PhysicalPage> rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
-    : NVMeQueue(move(rw_dma_region), rw_dma_page, qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs))
+UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(DMAPool dma_pool, Bitmap used_dma_pages, size_t max_transfer_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
+    : NVMeQueue(move(dma_pool), move(used_dma_pages), max_transfer_pages, qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs))
 {
+    // There can never be more completions than commands, so collecting them doesn't need to allocate.
+    m_completions.ensure_capacity(q_depth);
 }
 
 void NVMePollQueue::submit_sqe(NVMeSubmission& sub)
 {
     NVMeQueue::submit_sqe(sub);
-    SpinlockLocker lock_cq(m_cq_lock);
-    while (!process_cq()) {
-        microseconds_delay(1);
-    }
-}
-
-void NVMePollQueue::complete_current_request(u16 cmdid, u16 status)
-{
-    SpinlockLocker lock(m_request_lock);
-    auto& request_pdu = m_requests.get(cmdid).release_value();
-    auto current_request = request_pdu.request;
-    AsyncDeviceRequest::RequestResult req_result = AsyncDeviceRequest::Success;
-
-    ScopeGuard guard = [req_result, status, &request_pdu] {
-        if (request_pdu.request)
-            request_pdu.request->complete(req_result);
-        if (request_pdu.end_io_handler)
-            request_pdu.end_io_handler(status);
-        request_pdu.clear();
-    };
-
-    // There can be submission without any request associated with it such as with
-    // admin queue commands during init. If there is no request, we are done
-    if (!current_request)
-        return;
-
-    if (status) {
-        req_result = AsyncBlockDeviceRequest::Failure;
-        return;
+    {
+        SpinlockLocker lock_cq(m_cq_lock);
+        while (!process_cq()) {
+            microseconds_delay(1);
+        }
     }
 
-    if (current_request->request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
-        if (auto result = current_request->write_to_buffer(current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), current_request->buffer_size()); result.is_error()) {
-            req_result = AsyncBlockDeviceRequest::MemoryFault;
-            return;
+    for (;;) {
+        Completion completion;
+        {
+            SpinlockLocker lock_cq(m_cq_lock);
+            if (m_completions.is_empty())
+                break;
+            completion = m_completions.take_first();
         }
+        finish_command(completion.cmdid, completion.status);
     }
+}
 
-    return;
+void NVMePollQueue::complete_current_request(u16 cmdid, u16 status)
+{
+    m_completions.unchecked_append({ cmdid, status });
 }
 }
@@ -12,14 +12,21 @@ namespace Kernel {
 
 class NVMePollQueue : public NVMeQueue {
 public:
-    static ErrorOr<NonnullLockRefPtr<NVMePollQueue>> try_create(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtr<Memory::PhysicalPage> rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs);
+    static ErrorOr<NonnullLockRefPtr<NVMePollQueue>> try_create(DMAPool dma_pool, Bitmap used_dma_pages, size_t max_transfer_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs);
     void submit_sqe(NVMeSubmission& submission) override;
     virtual ~NVMePollQueue() override {};
 
 protected:
-    NVMePollQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtr<Memory::PhysicalPage> rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs);
+    NVMePollQueue(DMAPool dma_pool, Bitmap used_dma_pages, size_t max_transfer_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs);
 
 private:
     virtual void complete_current_request(u16 cmdid, u16 status) override;
+
+    struct Completion {
+        u16 cmdid;
+        u16 status;
+    };
+    // Completions found while polling, to be finished once the completion queue lock is dropped
+    Vector<Completion> m_completions;
 };
 }
@@ -12,36 +12,45 @@
 #include <Kernel/Library/StdLib.h>
 
 namespace Kernel {
-ErrorOr<NonnullLockRefPtr<NVMeQueue>> NVMeQueue::try_create(NVMeController& device, u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs, QueueType queue_type)
+ErrorOr<NonnullLockRefPtr<NVMeQueue>> NVMeQueue::try_create(NVMeController& device, u16 qid, u8 irq, u32 q_depth, size_t max_transfer_pages, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs, QueueType queue_type)
 {
-    // Note: Allocate DMA region for RW operation. For now the requests don't exceed more than 4096 bytes (Storage device takes care of it)
-    RefPtr<Memory::PhysicalPage> rw_dma_page;
-    auto rw_dma_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_page));
-
-    if (rw_dma_page.is_null())
-        return ENOMEM;
+    // The admin queue only carries synchronous commands, which bring their own buffers.
+    DMAPool dma_pool;
+    Bitmap used_dma_pages;
+    if (qid != 0) {
+        VERIFY(max_transfer_pages > 0 && max_transfer_pages <= IO_QUEUE_DMA_POOL_PAGES);
+        dma_pool.region = TRY(MM.allocate_dma_buffer_pages(IO_QUEUE_DMA_POOL_PAGES * PAGE_SIZE, "NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, dma_pool.pages));
+        auto prp_list_size = Memory::page_round_up(q_depth * max_transfer_pages * sizeof(u64)).release_value_but_fixme_should_propagate_errors();
+        dma_pool.prp_list_region = TRY(MM.allocate_dma_buffer_pages(prp_list_size, "NVMe Queue PRP lists"sv, Memory::Region::Access::ReadWrite, dma_pool.prp_list_pages));
+        used_dma_pages = TRY(Bitmap::create(IO_QUEUE_DMA_POOL_PAGES, false));
+    }
 
     if (queue_type == QueueType::Polled) {
-        auto queue = NVMePollQueue::try_create(move(rw_dma_region), rw_dma_page.release_nonnull(), qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs));
+        auto queue = NVMePollQueue::try_create(move(dma_pool), move(used_dma_pages), max_transfer_pages, qid, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs));
         return queue;
     }
 
-    auto queue = NVMeInterruptQueue::try_create(device, move(rw_dma_region), rw_dma_page.release_nonnull(), qid, irq, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs));
+    auto queue = NVMeInterruptQueue::try_create(device, move(dma_pool), move(used_dma_pages), max_transfer_pages, qid, irq, q_depth, move(cq_dma_region), move(sq_dma_region), move(db_regs));
     return queue;
 }
 
-UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
-    : m_rw_dma_region(move(rw_dma_region))
-    , m_qid(qid)
+UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(DMAPool dma_pool, Bitmap used_dma_pages, size_t max_transfer_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs)
+    : m_qid(qid)
     , m_admin_queue(qid == 0)
     , m_qdepth(q_depth)
     , m_cq_dma_region(move(cq_dma_region))
     , m_sq_dma_region(move(sq_dma_region))
     , m_db_regs(move(db_regs))
-    , m_rw_dma_page(rw_dma_page)
-
+    , m_dma_pool(move(dma_pool))
+    , m_used_dma_pages(move(used_dma_pages))
+    , m_max_transfer_pages(max_transfer_pages)
 {
-    m_requests.try_ensure_capacity(q_depth).release_value_but_fixme_should_propagate_errors();
+    m_requests.resize(q_depth);
+    // A full queue would look just like an empty one, so at most q_depth - 1 commands can be outstanding.
+    m_free_command_ids.ensure_capacity(q_depth - 1);
+    for (u16 cid = q_depth - 1; cid > 0; --cid)
+        m_free_command_ids.unchecked_append(cid - 1);
+    m_pending_io.ensure_capacity(q_depth);
     m_sqe_array = { reinterpret_cast<NVMeSubmission*>(m_sq_dma_region->vaddr().as_ptr()), m_qdepth };
     m_cqe_array = { reinterpret_cast<NVMeCompletion*>(m_cq_dma_region->vaddr().as_ptr()), m_qdepth };
 }
@@ -74,10 +83,11 @@ u32 NVMeQueue::process_cq()
         cmdid = m_cqe_array[m_cq_head].command_id;
         dbgln_if(NVME_DEBUG, "NVMe: Completion with status {:x} and command identifier {}. CQ_HEAD: {}", status, cmdid, m_cq_head);
 
-        if (!m_requests.contains(cmdid)) {
+        if (cmdid >= m_requests.size() || !m_requests[cmdid].used) {
             dmesgln("Bogus cmd id: {}", cmdid);
             VERIFY_NOT_REACHED();
         }
+        m_requests[cmdid].result = m_cqe_array[m_cq_head].cmd_spec;
         complete_current_request(cmdid, status);
         update_cqe_head();
     }
@@ -104,77 +114,203 @@ void NVMeQueue::submit_sqe(NVMeSubmission& sub)
     update_sq_doorbell();
 }
 
-u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
+u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub, u32* result)
 {
-    // For now let's use sq tail as a unique command id.
     u16 cmd_status;
-    u16 cid = get_request_cid();
-    sub.cmdid = cid;
-
+    u32 cmd_result;
     {
         SpinlockLocker req_lock(m_request_lock);
-
-        if (m_requests.contains(sub.cmdid) && m_requests.get(sub.cmdid).release_value().used)
-            VERIFY_NOT_REACHED();
-        m_requests.set(sub.cmdid, { nullptr, true, [this, &cmd_status](u16 status) mutable { cmd_status = status; m_sync_wait_queue.wake_all(); } });
+        // FIXME: Wait for a command id instead, though only the admin queue submits synchronously for now.
+        VERIFY(!m_free_command_ids.is_empty());
+        sub.cmdid = m_free_command_ids.take_last();
+        VERIFY(!m_requests[sub.cmdid].used);
+        m_requests[sub.cmdid] = { nullptr, true, [this, &cmd_status, &cmd_result](u16 status, u32 result) mutable { cmd_status = status; cmd_result = result; m_sync_wait_queue.wake_all(); } };
     }
     submit_sqe(sub);
 
     // FIXME: Only sync submissions (usually used for admin commands) use a WaitQueue based IO. Eventually we need to
     //  move this logic into the block layer instead of sprinkling them in the driver code.
     m_sync_wait_queue.wait_forever("NVMe sync submit"sv);
+    if (result)
+        *result = cmd_result;
     return cmd_status;
 }
 
-void NVMeQueue::read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+static size_t dma_page_count_for(AsyncBlockDeviceRequest& request)
 {
-    NVMeSubmission sub {};
-    sub.op = OP_NVME_READ;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
-    // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
-    sub.cmdid = get_request_cid();
+    size_t transfer_size = static_cast<size_t>(request.total_block_count()) * request.block_size();
+    return ceil_div(transfer_size, static_cast<size_t>(PAGE_SIZE));
+}
+
+Optional<u16> NVMeQueue::try_reserve_command(AsyncBlockDeviceRequest& request)
+{
+    VERIFY(m_request_lock.is_locked());
+    size_t page_count = dma_page_count_for(request);
+    VERIFY(page_count > 0 && page_count <= m_max_transfer_pages);
+    if (m_free_command_ids.is_empty())
+        return {};
+    auto first_page = m_used_dma_pages.find_first_fit(page_count);
+    if (!first_page.has_value())
+        return {};
 
+    m_used_dma_pages.set_range(first_page.value(), page_count, true);
+    u16 cid = m_free_command_ids.take_last();
+    VERIFY(!m_requests[cid].used);
+    m_requests[cid] = { request, true, nullptr, first_page.value(), page_count, 0 };
+    return cid;
+}
+
+void NVMeQueue::submit_io(AsyncBlockDeviceRequest& request, u16 nsid)
+{
+    VERIFY(!m_admin_queue);
+    Optional<u16> cid;
     {
         SpinlockLocker req_lock(m_request_lock);
-        if (m_requests.contains(sub.cmdid) && m_requests.get(sub.cmdid).release_value().used)
-            VERIFY_NOT_REACHED();
-        m_requests.set(sub.cmdid, { request, true, nullptr });
+        // Requests are submitted in order, so once anything is waiting for a command to finish, everything else has to wait as well.
+        if (m_pending_io.is_empty())
+            cid = try_reserve_command(request);
+        if (!cid.has_value()) {
+            if (!m_pending_io.try_append({ request, nsid }).is_error())
+                return;
+            req_lock.unlock();
+            NVMeIO io { request, true, nullptr, 0, 0, 0 };
+            complete_requests(io, AsyncDeviceRequest::OutOfMemory, STATUS_INTERNAL_ERROR);
+            return;
+        }
     }
-
-    full_memory_barrier();
-    submit_sqe(sub);
+    start_io(cid.value(), nsid);
 }
 
-void NVMeQueue::write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+void NVMeQueue::start_io(u16 cid, u16 nsid)
 {
-    NVMeSubmission sub {};
+    auto& request = *m_requests[cid].request;
+    size_t first_page = m_requests[cid].first_dma_page;
+    size_t page_count = m_requests[cid].dma_page_count;
 
-    sub.op = OP_NVME_WRITE;
+    NVMeSubmission sub {};
+    sub.op = request.request_type() == AsyncBlockDeviceRequest::Read ? OP_NVME_READ : OP_NVME_WRITE;
     sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
+    sub.rw.slba = AK::convert_between_host_and_little_endian(request.block_index());
     // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
-    sub.cmdid = get_request_cid();
-
-    {
-        SpinlockLocker req_lock(m_request_lock);
-        if (m_requests.contains(sub.cmdid) && m_requests.get(sub.cmdid).release_value().used)
-            VERIFY_NOT_REACHED();
-        m_requests.set(sub.cmdid, { request, true, nullptr });
+    sub.rw.length = AK::convert_between_host_and_little_endian((request.total_block_count() - 1) & 0xFFFF);
+    sub.rw.data_ptr.prp1 = m_dma_pool.pages[first_page]->paddr().get();
+    if (page_count == 2) {
+        sub.rw.data_ptr.prp2 = m_dma_pool.pages[first_page + 1]->paddr().get();
+    } else if (page_count > 2) {
+        // The rest of the pages are described by a PRP list, in this command's slot of the PRP list region.
+        auto prp_list_offset = static_cast<size_t>(cid) * m_max_transfer_pages * sizeof(u64);
+        auto* prp_list = reinterpret_cast<u64*>(m_dma_pool.prp_list_region->vaddr().offset(prp_list_offset).as_ptr());
+        for (size_t i = 1; i < page_count; ++i)
+            prp_list[i - 1] = AK::convert_between_host_and_little_endian(m_dma_pool.pages[first_page + i]->paddr().get());
+        auto& prp_list_page = m_dma_pool.prp_list_pages[prp_list_offset / PAGE_SIZE];
+        sub.rw.data_ptr.prp2 = prp_list_page->paddr().offset(prp_list_offset % PAGE_SIZE).get();
     }
+    sub.cmdid = cid;
 
-    if (auto result = request.read_from_buffer(request.buffer(), m_rw_dma_region->vaddr().as_ptr(), request.buffer_size()); result.is_error()) {
-        complete_current_request(sub.cmdid, AsyncDeviceRequest::MemoryFault);
-        return;
+    if (request.request_type() == AsyncBlockDeviceRequest::Write) {
+        auto* dma_buffer = m_dma_pool.region->vaddr().offset(first_page * PAGE_SIZE).as_ptr();
+        auto copy_to_dma_buffer = [&](AsyncBlockDeviceRequest& request_to_copy) -> ErrorOr<void> {
+            size_t size = static_cast<size_t>(request_to_copy.block_count()) * request_to_copy.block_size();
+            TRY(request_to_copy.read_from_buffer(request_to_copy.buffer(), dma_buffer, size));
+            dma_buffer += size;
+            return {};
+        };
+        bool failed = copy_to_dma_buffer(request).is_error();
+        for (auto& merged_request : request.merged_requests()) {
+            if (failed)
+                break;
+            failed = copy_to_dma_buffer(*merged_request).is_error();
+        }
+        if (failed) {
+            auto io = release_command(cid);
+            complete_requests(io, AsyncDeviceRequest::MemoryFault, 0);
+            submit_pending_io();
+            return;
+        }
     }
 
     full_memory_barrier();
     submit_sqe(sub);
 }
 
+NVMeIO NVMeQueue::release_command(u16 cmdid)
+{
+    SpinlockLocker req_lock(m_request_lock);
+    auto& slot = m_requests[cmdid];
+    VERIFY(slot.used);
+    NVMeIO io = move(slot);
+    slot.clear();
+    if (io.dma_page_count > 0)
+        m_used_dma_pages.set_range(io.first_dma_page, io.dma_page_count, false);
+    m_free_command_ids.unchecked_append(cmdid);
+    return io;
+}
+
+void NVMeQueue::complete_requests(NVMeIO& io, AsyncDeviceRequest::RequestResult result, u16 status)
+{
+    if (io.request) {
+        for (auto& merged_request : io.request->merged_requests())
+            merged_request->complete(result);
+        io.request->complete(result);
+    }
+    if (io.end_io_handler)
+        io.end_io_handler(status, io.result);
+}
+
+void NVMeQueue::finish_command(u16 cmdid, u16 status)
+{
+    // Nobody else touches the slot until the command id is released.
+    auto& slot = m_requests[cmdid];
+    AsyncDeviceRequest::RequestResult result = AsyncDeviceRequest::Success;
+    if (slot.request && status) {
+        result = AsyncDeviceRequest::Failure;
+    } else if (slot.request && slot.request->request_type() == AsyncBlockDeviceRequest::Read) {
+        auto const* dma_buffer = m_dma_pool.region->vaddr().offset(slot.first_dma_page * PAGE_SIZE).as_ptr();
+        auto copy_from_dma_buffer = [&](AsyncBlockDeviceRequest& request) -> ErrorOr<void> {
+            size_t size = static_cast<size_t>(request.block_count()) * request.block_size();
+            TRY(request.write_to_buffer(request.buffer(), dma_buffer, size));
+            dma_buffer += size;
+            return {};
+        };
+        bool failed = copy_from_dma_buffer(*slot.request).is_error();
+        for (auto& merged_request : slot.request->merged_requests()) {
+            if (failed)
+                break;
+            failed = copy_from_dma_buffer(*merged_request).is_error();
+        }
+        if (failed)
+            result = AsyncDeviceRequest::MemoryFault;
+    }
+
+    auto io = release_command(cmdid);
+    complete_requests(io, result, status);
+    submit_pending_io();
+}
+
+void NVMeQueue::fail_command(u16 cmdid)
+{
+    auto io = release_command(cmdid);
+    complete_requests(io, AsyncDeviceRequest::OutOfMemory, STATUS_INTERNAL_ERROR);
+}
+
+void NVMeQueue::submit_pending_io()
+{
+    for (;;) {
+        u16 cid;
+        u16 nsid;
+        {
+            SpinlockLocker req_lock(m_request_lock);
+            if (m_pending_io.is_empty())
+                return;
+            auto reserved_cid = try_reserve_command(*m_pending_io.first().request);
+            if (!reserved_cid.has_value())
+                return;
+            cid = reserved_cid.value();
+            nsid = m_pending_io.take_first().nsid;
+        }
+        start_io(cid, nsid);
+    }
+}
+
 UNMAP_AFTER_INIT NVMeQueue::~NVMeQueue() = default;
 }
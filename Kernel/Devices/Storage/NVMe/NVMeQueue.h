@@ -7,10 +7,11 @@
 #pragma once
 
 #include <AK/AtomicRefCounted.h>
-#include <AK/HashMap.h>
+#include <AK/Bitmap.h>
 #include <AK/OwnPtr.h>
 #include <AK/Types.h>
 #include <Kernel/Bus/PCI/Device.h>
+#include <Kernel/Devices/AsyncDeviceRequest.h>
 #include <Kernel/Devices/Storage/NVMe/NVMeDefinitions.h>
 #include <Kernel/Interrupts/IRQHandler.h>
 #include <Kernel/Library/LockRefPtr.h>
@@ -45,26 +46,48 @@ struct NVMeIO {
         used = false;
         request = nullptr;
         end_io_handler = nullptr;
+        first_dma_page = 0;
+        dma_page_count = 0;
+        result = 0;
     }
     RefPtr<AsyncBlockDeviceRequest> request;
     bool used = false;
-    Function<void(u16 status)> end_io_handler;
+    Function<void(u16 status, u32 result)> end_io_handler;
+    // The pages of the queue's DMA pool that the data goes through
+    size_t first_dma_page { 0 };
+    size_t dma_page_count { 0 };
+    // The command specific dword of the completion
+    u32 result { 0 };
 };
 
 class NVMeController;
 class NVMeQueue : public AtomicRefCounted<NVMeQueue> {
 public:
-    static ErrorOr<NonnullLockRefPtr<NVMeQueue>> try_create(NVMeController& device, u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs, QueueType queue_type);
+    static ErrorOr<NonnullLockRefPtr<NVMeQueue>> try_create(NVMeController& device, u16 qid, u8 irq, u32 q_depth, size_t max_transfer_pages, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs, QueueType queue_type);
     bool is_admin_queue() { return m_admin_queue; }
-    u16 submit_sync_sqe(NVMeSubmission&);
-    void read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
-    void write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
+    u16 submit_sync_sqe(NVMeSubmission&, u32* result = nullptr);
+    // Reads or writes the blocks of the request and of all requests merged into it with a single command.
+    void submit_io(AsyncBlockDeviceRequest& request, u16 nsid);
     virtual void submit_sqe(NVMeSubmission&);
     virtual ~NVMeQueue();
 
 protected:
+    struct DMAPool {
+        OwnPtr<Memory::Region> region;
+        Vector<NonnullRefPtr<Memory::PhysicalPage>> pages;
+        // Every command id gets a slot of max_transfer_pages entries for its PRP list.
+        OwnPtr<Memory::Region> prp_list_region;
+        Vector<NonnullRefPtr<Memory::PhysicalPage>> prp_list_pages;
+    };
+
     u32 process_cq();
 
+    // Copies the data of a finished read to the requests, releases the command and completes its requests.
+    // This may touch the requests' buffers and submit waiting IO, so it must not be called in IRQ context.
+    void finish_command(u16 cmdid, u16 status);
+    // Fails the command's requests without touching their buffers, for when the completion can't be deferred.
+    void fail_command(u16 cmdid);
+
     // Updates the shadow buffer and returns if mmio is needed
     bool update_shadow_buf(u16 new_value, u32* dbbuf, u32* ei)
     {
@@ -85,22 +108,14 @@ protected:
             m_db_regs.mmio_reg->sq_tail = m_sq_tail;
     }
 
-    NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs);
-
-    [[nodiscard]] u32 get_request_cid()
-    {
-        u32 expected_tag = m_tag.load(AK::memory_order_acquire);
-
-        for (;;) {
-            u32 cid = expected_tag + 1;
-            if (cid == m_qdepth)
-                cid = 0;
-            if (m_tag.compare_exchange_strong(expected_tag, cid, AK::memory_order_acquire))
-                return cid;
-        }
-    }
+    NVMeQueue(DMAPool dma_pool, Bitmap used_dma_pages, size_t max_transfer_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, OwnPtr<Memory::Region> sq_dma_region, Doorbell db_regs);
 
 private:
+    struct PendingIO {
+        NonnullRefPtr<AsyncBlockDeviceRequest> request;
+        u16 nsid;
+    };
+
     bool cqe_available();
     void update_cqe_head();
     virtual void complete_current_request(u16 cmdid, u16 status) = 0;
@@ -112,10 +127,17 @@ private:
             m_db_regs.mmio_reg->cq_head = m_cq_head;
     }
 
+    // Takes a command id and the DMA pages for the request, if both are available.
+    Optional<u16> try_reserve_command(AsyncBlockDeviceRequest&);
+    void start_io(u16 cmdid, u16 nsid);
+    NVMeIO release_command(u16 cmdid);
+    void complete_requests(NVMeIO&, AsyncDeviceRequest::RequestResult, u16 status);
+    void submit_pending_io();
+
 protected:
     Spinlock<LockRank::Interrupts> m_cq_lock {};
-    HashMap<u16, NVMeIO> m_requests;
-    NonnullOwnPtr<Memory::Region> m_rw_dma_region;
+    // Indexed by command id
+    Vector<NVMeIO> m_requests;
     Spinlock<LockRank::None> m_request_lock {};
 
 private:
@@ -125,7 +147,8 @@ private:
     u16 m_cq_head {};
     bool m_admin_queue { false };
     u32 m_qdepth {};
-    Atomic<u32> m_tag { 0 }; // used for the cid in a submission queue entry
+    Vector<u16> m_free_command_ids;
+    Vector<PendingIO> m_pending_io;
     Spinlock<LockRank::Interrupts> m_sq_lock {};
     OwnPtr<Memory::Region> m_cq_dma_region;
     Span<NVMeSubmission> m_sqe_array;
@@ -133,6 +156,8 @@ private:
     Span<NVMeCompletion> m_cqe_array;
     WaitQueue m_sync_wait_queue;
     Doorbell m_db_regs;
-    NonnullRefPtr<Memory::PhysicalPage const> const m_rw_dma_page;
+    DMAPool m_dma_pool;
+    Bitmap m_used_dma_pages;
+    size_t m_max_transfer_pages { 0 };
 };
 }
@@ -92,8 +92,10 @@ ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKern
 
     // PATAChannel will chuck a wobbly if we try to read more than PAGE_SIZE
     // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= m_blocks_per_page) {
-        whole_blocks = m_blocks_per_page;
+    // Devices that can merge requests can take a single one just as large, though.
+    size_t max_blocks_per_request = max<size_t>(m_blocks_per_page, max_merged_block_count());
+    if (whole_blocks >= max_blocks_per_request) {
+        whole_blocks = max_blocks_per_request;
         remaining = 0;
     }
 
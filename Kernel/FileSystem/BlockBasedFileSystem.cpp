@@ -4,117 +4,325 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
+#include <AK/FixedArray.h>
 #include <AK/IntrusiveList.h>
+#include <AK/QuickSort.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Tasks/Process.h>
 
 namespace Kernel {
 
+// The most read_blocks() asks the device for at once.
+static constexpr size_t max_bytes_per_device_read = 256 * KiB;
+
+// The cache is split into shards with a lock each, so that accesses to different parts of the disk don't contend.
+// Stripes of consecutive blocks go to the same shard, which keeps sequential accesses under a single lock.
+static constexpr size_t cache_shard_count = 16;
+static constexpr size_t cache_shard_stripe_blocks = 64;
+
+// Cached blocks live in chunks of memory from the MemoryManager, so they can be handed back when memory runs low.
+static constexpr size_t cache_chunk_size = 64 * KiB;
+
+// All block caches together use at most this fraction of physical memory.
+static constexpr size_t cache_memory_fraction = 8;
+
+static Atomic<size_t> s_cache_memory_in_use;
+
+static bool cache_may_grow_by(size_t size)
+{
+    auto memory_info = MM.get_system_memory_info();
+    if (s_cache_memory_in_use.load() + size > memory_info.physical_pages * PAGE_SIZE / cache_memory_fraction)
+        return false;
+    return memory_info.physical_pages_uncommitted > memory_info.low_watermark() + size / PAGE_SIZE;
+}
+
+static ErrorOr<void> read_from_device(BlockBasedFileSystem const& fs, u64 offset, Bytes data)
+{
+    // NOTE: The device may not be able to take all of it with a single request.
+    size_t nread = 0;
+    while (nread < data.size()) {
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(data.data() + nread);
+        auto nread_now = TRY(fs.file_description().read(buffer, offset + nread, data.size() - nread));
+        if (nread_now == 0)
+            return EIO;
+        nread += nread_now;
+    }
+    return {};
+}
+
+static ErrorOr<void> write_to_device(BlockBasedFileSystem& fs, u64 offset, ReadonlyBytes data)
+{
+    size_t nwritten = 0;
+    while (nwritten < data.size()) {
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(const_cast<u8*>(data.data()) + nwritten);
+        auto nwritten_now = TRY(fs.file_description().write(offset + nwritten, buffer, data.size() - nwritten));
+        if (nwritten_now == 0)
+            return EIO;
+        nwritten += nwritten_now;
+    }
+    return {};
+}
+
 struct CacheEntry {
+    // Links the entry into its shard's free list while unused, and into the dirty list while dirty.
     IntrusiveListNode<CacheEntry> list_node;
     BlockBasedFileSystem::BlockIndex block_index { 0 };
     u8* data { nullptr };
-    bool has_data { false };
+    bool is_in_use { false };
+    bool is_dirty { false };
+    // Set on every access, and cleared by the clock hand as it sweeps past.
+    bool was_referenced { false };
 };
 
-class DiskCache {
+struct CacheChunk {
+    NonnullOwnPtr<Memory::Region> region;
+    FixedArray<CacheEntry> entries;
+};
+
+class DiskCacheShard {
 public:
-    static constexpr size_t EntryCount = 10000;
-    explicit DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> cached_block_data, NonnullOwnPtr<KBuffer> entries_buffer)
-        : m_fs(fs)
-        , m_cached_block_data(move(cached_block_data))
-        , m_entries(move(entries_buffer))
+    DiskCacheShard() = default;
+
+    ~DiskCacheShard()
     {
-        for (size_t i = 0; i < EntryCount; ++i) {
-            entries()[i].data = m_cached_block_data->data() + i * m_fs->logical_block_size();
-            m_clean_list.append(entries()[i]);
-        }
+        m_free_list.clear();
+        m_dirty_list.clear();
+        for (auto& chunk : m_chunks)
+            s_cache_memory_in_use.fetch_sub(chunk->region->size());
     }
 
-    ~DiskCache() = default;
-
     bool is_dirty() const { return !m_dirty_list.is_empty(); }
-    bool entry_is_dirty(CacheEntry const& entry) const { return m_dirty_list.contains(entry); }
 
-    void mark_all_clean()
+    CacheEntry* get(BlockBasedFileSystem::BlockIndex block_index)
     {
-        while (auto* entry = m_dirty_list.first())
-            m_clean_list.prepend(*entry);
+        auto it = m_entries.find(block_index);
+        if (it == m_entries.end())
+            return nullptr;
+        auto& entry = *it->value;
+        VERIFY(entry.block_index == block_index);
+        entry.was_referenced = true;
+        return &entry;
     }
 
-    void mark_dirty(CacheEntry& entry)
+    bool contains(BlockBasedFileSystem::BlockIndex block_index) const { return m_entries.contains(block_index); }
+
+    // Returns the entry for the block, making room for it if it isn't cached yet.
+    // NOTE: A new entry must be filled with the block's data before the shard is unlocked.
+    ErrorOr<CacheEntry*> ensure(BlockBasedFileSystem& fs, BlockBasedFileSystem::BlockIndex block_index)
     {
-        m_dirty_list.prepend(entry);
+        if (auto* entry = get(block_index))
+            return entry;
+
+        auto* entry = m_free_list.first();
+        if (!entry && try_grow(fs))
+            entry = m_free_list.first();
+        if (!entry)
+            entry = evict_one();
+        if (!entry) {
+            // Every block in this shard is dirty, so write them back and try again.
+            write_back(fs);
+            entry = evict_one();
+        }
+        if (!entry)
+            return ENOMEM;
+
+        if (entry->list_node.is_in_list())
+            m_free_list.remove(*entry);
+        if (auto result = m_entries.try_set(block_index, entry); result.is_error()) {
+            m_free_list.append(*entry);
+            return result.release_error();
+        }
+        entry->block_index = block_index;
+        entry->is_in_use = true;
+        entry->was_referenced = true;
+        return entry;
     }
 
-    void mark_clean(CacheEntry& entry)
+    void mark_dirty(CacheEntry& entry)
     {
-        m_clean_list.prepend(entry);
+        if (entry.is_dirty)
+            return;
+        entry.is_dirty = true;
+        m_dirty_list.append(entry);
     }
 
-    CacheEntry* get(BlockBasedFileSystem::BlockIndex block_index) const
+    // Writes all dirty blocks back to the device, merging runs of consecutive blocks into single writes.
+    size_t write_back(BlockBasedFileSystem& fs)
     {
-        auto it = m_hash.find(block_index);
-        if (it == m_hash.end())
-            return nullptr;
-        auto& entry = const_cast<CacheEntry&>(*it->value);
-        VERIFY(entry.block_index == block_index);
-        if (!entry_is_dirty(entry) && (m_clean_list.first() != &entry)) {
-            // Cache hit! Promote the entry to the front of the list.
-            m_clean_list.prepend(entry);
+        if (m_dirty_list.is_empty())
+            return 0;
+
+        size_t block_size = fs.logical_block_size();
+        Vector<CacheEntry*> dirty_entries;
+        for (auto& entry : m_dirty_list) {
+            if (dirty_entries.try_append(&entry).is_error()) {
+                [[maybe_unused]] auto result = write_to_device(fs, entry.block_index.value() * block_size, { entry.data, block_size });
+            }
         }
-        return &entry;
+        quick_sort(dirty_entries, [](auto* a, auto* b) { return a->block_index < b->block_index; });
+
+        size_t max_blocks_per_write = max<size_t>(max_bytes_per_device_read / block_size, 1);
+        for (size_t i = 0; i < dirty_entries.size();) {
+            size_t run_length = 1;
+            while (i + run_length < dirty_entries.size() && run_length < max_blocks_per_write
+                && dirty_entries[i + run_length]->block_index.value() == dirty_entries[i]->block_index.value() + run_length)
+                ++run_length;
+
+            u64 base_offset = dirty_entries[i]->block_index.value() * block_size;
+            Optional<ByteBuffer> run_data;
+            if (run_length > 1) {
+                if (auto run_data_or_error = ByteBuffer::create_uninitialized(run_length * block_size); !run_data_or_error.is_error())
+                    run_data = run_data_or_error.release_value();
+            }
+            if (run_data.has_value()) {
+                for (size_t j = 0; j < run_length; ++j)
+                    memcpy(run_data->data() + j * block_size, dirty_entries[i + j]->data, block_size);
+                [[maybe_unused]] auto result = write_to_device(fs, base_offset, run_data->bytes());
+            } else {
+                for (size_t j = 0; j < run_length; ++j)
+                    [[maybe_unused]] auto result = write_to_device(fs, base_offset + j * block_size, { dirty_entries[i + j]->data, block_size });
+            }
+            i += run_length;
+        }
+
+        size_t count = 0;
+        while (auto* entry = m_dirty_list.first()) {
+            m_dirty_list.remove(*entry);
+            entry->is_dirty = false;
+            ++count;
+        }
+        return count;
     }
 
-    ErrorOr<CacheEntry*> ensure(BlockBasedFileSystem::BlockIndex block_index) const
+    // Hands the shard's newest chunk back to the MemoryManager, and returns how many bytes that freed.
+    // The last chunk is kept, so that the shard can always make progress.
+    size_t release_chunk(BlockBasedFileSystem& fs)
     {
-        if (auto* entry = get(block_index))
-            return entry;
-
-        if (m_clean_list.is_empty()) {
-            // Not a single clean entry! Flush writes and try again.
-            // NOTE: We want to make sure we only call FileBackedFileSystem flush here,
-            //       not some FileBackedFileSystem subclass flush!
-            m_fs->flush_writes_impl();
-            return ensure(block_index);
+        if (m_chunks.size() <= 1)
+            return 0;
+
+        write_back(fs);
+        auto chunk = m_chunks.take_last();
+        for (auto& entry : chunk->entries) {
+            if (entry.is_in_use)
+                m_entries.remove(entry.block_index);
+            else
+                m_free_list.remove(entry);
         }
+        if (m_clock_hand >= entry_count())
+            m_clock_hand = 0;
 
-        VERIFY(m_clean_list.last());
-        auto& new_entry = *m_clean_list.last();
-        m_clean_list.prepend(new_entry);
+        size_t size = chunk->region->size();
+        s_cache_memory_in_use.fetch_sub(size);
+        return size;
+    }
 
-        m_hash.remove(new_entry.block_index);
-        TRY(m_hash.try_set(block_index, &new_entry));
+private:
+    size_t entry_count() const { return m_chunks.size() * m_entries_per_chunk; }
 
-        new_entry.block_index = block_index;
-        new_entry.has_data = false;
+    bool try_grow(BlockBasedFileSystem& fs)
+    {
+        size_t block_size = fs.logical_block_size();
+        m_entries_per_chunk = max<size_t>(cache_chunk_size / block_size, 1);
+        auto size_or_error = Memory::page_round_up(m_entries_per_chunk * block_size);
+        if (size_or_error.is_error())
+            return false;
+        size_t size = size_or_error.value();
+        // NOTE: A shard without memory may always get some, otherwise it couldn't cache anything at all.
+        if (!m_chunks.is_empty() && !cache_may_grow_by(size))
+            return false;
+
+        auto region_or_error = MM.allocate_kernel_region(size, "BlockBasedFS: Cache blocks"sv, Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow);
+        if (region_or_error.is_error())
+            return false;
+        auto entries_or_error = FixedArray<CacheEntry>::create(m_entries_per_chunk);
+        if (entries_or_error.is_error())
+            return false;
+        auto chunk = adopt_own_if_nonnull(new (nothrow) CacheChunk { region_or_error.release_value(), entries_or_error.release_value() });
+        if (!chunk || m_chunks.try_append(chunk.release_nonnull()).is_error())
+            return false;
+
+        auto& new_chunk = *m_chunks.last();
+        for (size_t i = 0; i < m_entries_per_chunk; ++i) {
+            new_chunk.entries[i].data = new_chunk.region->vaddr().offset(i * block_size).as_ptr();
+            m_free_list.append(new_chunk.entries[i]);
+        }
+        s_cache_memory_in_use.fetch_add(size);
+        return true;
+    }
 
-        return &new_entry;
+    // CLOCK: Sweep over all entries, giving referenced ones a second chance, and take the first clean one that wasn't.
+    CacheEntry* evict_one()
+    {
+        size_t count = entry_count();
+        // Two full sweeps are enough, as the first one clears every reference bit it passes.
+        for (size_t i = 0; i < 2 * count; ++i) {
+            auto& entry = m_chunks[m_clock_hand / m_entries_per_chunk]->entries[m_clock_hand % m_entries_per_chunk];
+            m_clock_hand = (m_clock_hand + 1) % count;
+            VERIFY(entry.is_in_use);
+            if (entry.is_dirty)
+                continue;
+            if (entry.was_referenced) {
+                entry.was_referenced = false;
+                continue;
+            }
+            m_entries.remove(entry.block_index);
+            entry.is_in_use = false;
+            return &entry;
+        }
+        return nullptr;
     }
 
-    CacheEntry const* entries() const { return (CacheEntry const*)m_entries->data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries->data(); }
+    // NOTE: m_chunks must be declared before the lists, because their entries are allocated from it.
+    //       We need to ensure that the lists are destroyed before the chunks are.
+    Vector<NonnullOwnPtr<CacheChunk>> m_chunks;
+    size_t m_entries_per_chunk { 0 };
+    size_t m_clock_hand { 0 };
+    IntrusiveList<&CacheEntry::list_node> m_free_list;
+    IntrusiveList<&CacheEntry::list_node> m_dirty_list;
+    HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_entries;
+};
 
-    template<typename Callback>
-    void for_each_dirty_entry(Callback callback)
+class DiskCache {
+public:
+    MutexProtected<DiskCacheShard>& shard_for(BlockBasedFileSystem::BlockIndex block_index)
     {
-        for (auto& entry : m_dirty_list)
-            callback(entry);
+        return m_shards[(block_index.value() / cache_shard_stripe_blocks) % cache_shard_count];
     }
 
+    Array<MutexProtected<DiskCacheShard>, cache_shard_count>& shards() { return m_shards; }
+
+    // Bumped on every cached write, so that reads from the device can tell whether their data might already be stale.
+    u64 write_generation() const { return m_write_generation.load(); }
+    void did_write() { m_write_generation.fetch_add(1); }
+
 private:
-    mutable NonnullRefPtr<BlockBasedFileSystem> m_fs;
-    NonnullOwnPtr<KBuffer> m_cached_block_data;
-
-    // NOTE: m_entries must be declared before m_dirty_list and m_clean_list because their entries are allocated from it.
-    // We need to ensure that the destructors of m_dirty_list and m_clean_list are called before m_entries is destroyed.
-    NonnullOwnPtr<KBuffer> m_entries;
-    mutable IntrusiveList<&CacheEntry::list_node> m_dirty_list;
-    mutable IntrusiveList<&CacheEntry::list_node> m_clean_list;
-    mutable HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
+    Array<MutexProtected<DiskCacheShard>, cache_shard_count> m_shards;
+    Atomic<u64> m_write_generation { 0 };
 };
 
+// Caches a block that was just read from the device, unless another copy got cached in the meantime, and copies it out.
+// NOTE: If the block was written to while it was being read, the device's copy may be stale, so it's handed out but not cached.
+static ErrorOr<void> cache_block_and_copy_out(BlockBasedFileSystem& fs, DiskCache& cache, BlockBasedFileSystem::BlockIndex index, ReadonlyBytes device_data, u64 write_generation, UserOrKernelBuffer* buffer, size_t buffer_offset, size_t offset, size_t count)
+{
+    return cache.shard_for(index).with_exclusive([&](auto& shard) -> ErrorOr<void> {
+        u8 const* data = device_data.data();
+        if (auto* entry = shard.get(index)) {
+            data = entry->data;
+        } else if (cache.write_generation() == write_generation) {
+            // NOTE: Caching is best-effort here, the caller gets its data either way.
+            if (auto entry_or_error = shard.ensure(fs, index); !entry_or_error.is_error())
+                memcpy(entry_or_error.value()->data, device_data.data(), device_data.size());
+        }
+        if (buffer)
+            TRY(buffer->write(data + offset, buffer_offset, count));
+        return {};
+    });
+}
+
 BlockBasedFileSystem::BlockBasedFileSystem(OpenFileDescription& file_description)
     : FileBackedFileSystem(file_description)
 {
@@ -136,9 +344,8 @@ ErrorOr<void> BlockBasedFileSystem::initialize_while_locked()
     VERIFY(m_lock.is_locked());
     VERIFY(!is_initialized_while_locked());
     VERIFY(logical_block_size() != 0);
-    auto cached_block_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache blocks"sv, DiskCache::EntryCount * logical_block_size()));
-    auto entries_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache entries"sv, DiskCache::EntryCount * sizeof(CacheEntry)));
-    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(cached_block_data), move(entries_data))));
+    // NOTE: The cache starts out empty, and its shards grab memory as they need it.
+    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache));
 
     m_cache.with_exclusive([&](auto& cache) {
         cache = move(disk_cache);
@@ -152,6 +359,14 @@ ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, UserOrKernelBu
     VERIFY(offset + count <= logical_block_size());
     dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::write_block {}, size={}", index, count);
 
+    if (!allow_cache) {
+        flush_specific_block_if_needed(index);
+        u64 base_offset = index.value() * logical_block_size() + offset;
+        auto nwritten = TRY(file_description().write(base_offset, data, count));
+        VERIFY(nwritten == count);
+        return {};
+    }
+
     // NOTE: We copy the `data` to write into a local buffer before taking the cache lock.
     //       This makes sure any page faults caused by accessing the data will occur before
     //       we tie down the cache.
@@ -159,26 +374,28 @@ ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, UserOrKernelBu
 
     TRY(data.read(buffered_data.bytes()));
 
-    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
-        if (!allow_cache) {
-            flush_specific_block_if_needed(index);
-            u64 base_offset = index.value() * logical_block_size() + offset;
-            auto nwritten = TRY(file_description().write(base_offset, data, count));
-            VERIFY(nwritten == count);
+    while (true) {
+        auto did_write = TRY(m_cache.with_shared([&](auto& cache) -> ErrorOr<bool> {
+            return cache->shard_for(index).with_exclusive([&](auto& shard) -> ErrorOr<bool> {
+                auto* entry = shard.get(index);
+                if (!entry) {
+                    // Partial writes need the rest of the block, which we don't have yet.
+                    if (count < logical_block_size())
+                        return false;
+                    entry = TRY(shard.ensure(*this, index));
+                }
+                memcpy(entry->data + offset, buffered_data.data(), count);
+                shard.mark_dirty(*entry);
+                cache->did_write();
+                return true;
+            });
+        }));
+        if (did_write)
             return {};
-        }
 
-        auto entry = TRY(cache->ensure(index));
-        if (count < logical_block_size()) {
-            // Fill the cache first.
-            TRY(read_block(index, nullptr, logical_block_size()));
-        }
-        memcpy(entry->data + offset, buffered_data.data(), count);
-
-        cache->mark_dirty(*entry);
-        entry->has_data = true;
-        return {};
-    });
+        // Fill the cache first.
+        TRY(read_block(index, nullptr, logical_block_size()));
+    }
 }
 
 ErrorOr<void> BlockBasedFileSystem::raw_read(BlockIndex index, UserOrKernelBuffer& buffer)
@@ -233,76 +450,119 @@ ErrorOr<void> BlockBasedFileSystem::read_block(BlockIndex index, UserOrKernelBuf
     VERIFY(offset + count <= logical_block_size());
     dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_block {}", index);
 
-    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
-        if (!allow_cache) {
-            const_cast<BlockBasedFileSystem*>(this)->flush_specific_block_if_needed(index);
-            u64 base_offset = index.value() * logical_block_size() + offset;
-            auto nread = TRY(file_description().read(*buffer, base_offset, count));
-            VERIFY(nread == count);
+    if (!allow_cache) {
+        const_cast<BlockBasedFileSystem*>(this)->flush_specific_block_if_needed(index);
+        u64 base_offset = index.value() * logical_block_size() + offset;
+        auto nread = TRY(file_description().read(*buffer, base_offset, count));
+        VERIFY(nread == count);
+        return {};
+    }
+
+    return m_cache.with_shared([&](auto& cache) -> ErrorOr<void> {
+        auto was_cached = TRY(cache->shard_for(index).with_exclusive([&](auto& shard) -> ErrorOr<bool> {
+            auto* entry = shard.get(index);
+            if (!entry)
+                return false;
+            if (buffer)
+                TRY(buffer->write(entry->data + offset, count));
+            return true;
+        }));
+        if (was_cached)
             return {};
-        }
 
-        auto* entry = TRY(cache->ensure(index));
-        if (!entry->has_data) {
-            auto base_offset = index.value() * logical_block_size();
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
-            auto nread = TRY(file_description().read(entry_data_buffer, base_offset, logical_block_size()));
-            VERIFY(nread == logical_block_size());
-            entry->has_data = true;
-        }
-        if (buffer)
-            TRY(buffer->write(entry->data + offset, count));
-        return {};
+        // NOTE: The device is read without holding the shard's lock, so other blocks in the shard stay accessible meanwhile.
+        auto write_generation = cache->write_generation();
+        auto block_data = TRY(ByteBuffer::create_uninitialized(logical_block_size()));
+        TRY(read_from_device(*this, index.value() * logical_block_size(), block_data.bytes()));
+        return cache_block_and_copy_out(const_cast<BlockBasedFileSystem&>(*this), *cache, index, block_data.bytes(), write_generation, buffer, 0, offset, count);
     });
 }
 
-ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count, UserOrKernelBuffer& buffer, bool allow_cache) const
+ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count, UserOrKernelBuffer* buffer, bool allow_cache) const
 {
     VERIFY(m_device_block_size);
     if (!count)
         return EINVAL;
     if (count == 1)
-        return read_block(index, &buffer, logical_block_size(), 0, allow_cache);
-    auto out = buffer;
-    for (unsigned i = 0; i < count; ++i) {
-        TRY(read_block(BlockIndex { index.value() + i }, &out, logical_block_size(), 0, allow_cache));
-        out = out.offset(logical_block_size());
+        return read_block(index, buffer, logical_block_size(), 0, allow_cache);
+    if (!allow_cache) {
+        VERIFY(buffer);
+        auto out = *buffer;
+        for (unsigned i = 0; i < count; ++i) {
+            TRY(read_block(BlockIndex { index.value() + i }, &out, logical_block_size(), 0, allow_cache));
+            out = out.offset(logical_block_size());
+        }
+        return {};
     }
 
-    return {};
+    dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_blocks {}, count={}", index, count);
+    size_t block_size = logical_block_size();
+    // Blocks that aren't cached yet are read in runs with a single request each, instead of one request per block.
+    size_t max_blocks_per_read = max<size_t>(max_bytes_per_device_read / block_size, 1);
+
+    return m_cache.with_shared([&](auto& cache) -> ErrorOr<void> {
+        unsigned i = 0;
+        while (i < count) {
+            BlockIndex block_index { index.value() + i };
+            auto was_cached = TRY(cache->shard_for(block_index).with_exclusive([&](auto& shard) -> ErrorOr<bool> {
+                auto* entry = shard.get(block_index);
+                if (!entry)
+                    return false;
+                if (buffer)
+                    TRY(buffer->write(entry->data, i * block_size, block_size));
+                return true;
+            }));
+            if (was_cached) {
+                ++i;
+                continue;
+            }
+
+            unsigned run_length = 1;
+            while (i + run_length < count && run_length < max_blocks_per_read) {
+                BlockIndex next_block_index { index.value() + i + run_length };
+                if (cache->shard_for(next_block_index).with_exclusive([&](auto& shard) { return shard.contains(next_block_index); }))
+                    break;
+                ++run_length;
+            }
+
+            auto write_generation = cache->write_generation();
+            auto run_data = TRY(ByteBuffer::create_uninitialized(run_length * block_size));
+            TRY(read_from_device(*this, block_index.value() * block_size, run_data.bytes()));
+            for (unsigned j = 0; j < run_length; ++j) {
+                auto block_data = run_data.bytes().slice(j * block_size, block_size);
+                TRY(cache_block_and_copy_out(const_cast<BlockBasedFileSystem&>(*this), *cache, BlockIndex { block_index.value() + j }, block_data, write_generation, buffer, (i + j) * block_size, 0, block_size));
+            }
+            i += run_length;
+        }
+        return {};
+    });
 }
 
 void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
 {
-    m_cache.with_exclusive([&](auto& cache) {
-        if (!cache->is_dirty())
-            return;
-        auto* entry = cache->get(index);
-        if (!entry)
-            return;
-        if (!cache->entry_is_dirty(*entry))
-            return;
-        size_t base_offset = entry->block_index.value() * logical_block_size();
-        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
-        (void)file_description().write(base_offset, entry_data_buffer, logical_block_size());
+    m_cache.with_shared([&](auto& cache) {
+        cache->shard_for(index).with_exclusive([&](auto& shard) {
+            if (!shard.is_dirty())
+                return;
+            auto* entry = shard.get(index);
+            if (!entry || !entry->is_dirty)
+                return;
+            size_t base_offset = entry->block_index.value() * logical_block_size();
+            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
+            (void)file_description().write(base_offset, entry_data_buffer, logical_block_size());
+        });
     });
 }
 
 void BlockBasedFileSystem::flush_writes_impl()
 {
     size_t count = 0;
-    m_cache.with_exclusive([&](auto& cache) {
-        if (!cache->is_dirty())
-            return;
-        cache->for_each_dirty_entry([&](CacheEntry& entry) {
-            auto base_offset = entry.block_index.value() * logical_block_size();
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-            [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, logical_block_size());
-            ++count;
-        });
-        cache->mark_all_clean();
-        dbgln("{}: Flushed {} blocks to disk", class_name(), count);
+    m_cache.with_shared([&](auto& cache) {
+        for (auto& shard : cache->shards())
+            count += shard.with_exclusive([&](auto& locked_shard) { return locked_shard.write_back(*this); });
     });
+    if (count > 0)
+        dbgln("{}: Flushed {} blocks to disk", class_name(), count);
 }
 
 ErrorOr<void> BlockBasedFileSystem::flush_writes()
@@ -311,4 +571,29 @@ ErrorOr<void> BlockBasedFileSystem::flush_writes()
     return {};
 }
 
+size_t BlockBasedFileSystem::release_cache_memory(size_t size)
+{
+    size_t released = m_cache.with_shared([&](auto& cache) -> size_t {
+        if (!cache)
+            return 0;
+        // Take a chunk from each shard in turn, so that they all keep roughly the same share.
+        size_t total = 0;
+        bool did_release_any = true;
+        while (total < size && did_release_any) {
+            did_release_any = false;
+            for (auto& shard : cache->shards()) {
+                auto released_from_shard = shard.with_exclusive([&](auto& locked_shard) { return locked_shard.release_chunk(*this); });
+                total += released_from_shard;
+                did_release_any |= released_from_shard > 0;
+                if (total >= size)
+                    break;
+            }
+        }
+        return total;
+    });
+    if (released > 0)
+        dbgln("{}: Released {} KiB of cached blocks", class_name(), released / KiB);
+    return released;
+}
+
 }
@@ -22,13 +22,15 @@ public:
     virtual ErrorOr<void> flush_writes() override;
     void flush_writes_impl();
 
+    virtual size_t release_cache_memory(size_t) override;
+
 protected:
     explicit BlockBasedFileSystem(OpenFileDescription&);
 
     virtual ErrorOr<void> initialize_while_locked() override;
 
     ErrorOr<void> read_block(BlockIndex, UserOrKernelBuffer*, size_t count, u64 offset = 0, bool allow_cache = true) const;
-    ErrorOr<void> read_blocks(BlockIndex, unsigned count, UserOrKernelBuffer&, bool allow_cache = true) const;
+    ErrorOr<void> read_blocks(BlockIndex, unsigned count, UserOrKernelBuffer*, bool allow_cache = true) const;
 
     ErrorOr<void> raw_read(BlockIndex, UserOrKernelBuffer&);
     ErrorOr<void> raw_write(BlockIndex, UserOrKernelBuffer const&);
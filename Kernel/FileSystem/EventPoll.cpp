@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+ErrorOr<NonnullRefPtr<EventPollInterest>> EventPollInterest::try_create(EventPoll& event_poll, OpenFileDescription& description, int fd, u32 events, u64 data)
+{
+    return adopt_nonnull_ref_or_enomem(new (nothrow) EventPollInterest(event_poll, description, fd, events, data));
+}
+
+EventPollInterest::EventPollInterest(EventPoll& event_poll, OpenFileDescription& description, int fd, u32 events, u64 data)
+    : m_event_poll(event_poll)
+    , m_description(description)
+    , m_file(description.file())
+    , m_fd(fd)
+    , m_events(events)
+    , m_data(data)
+{
+}
+
+EventPollInterest::~EventPollInterest() = default;
+
+void EventPollInterest::file_state_changed(Badge<FileBlockerSet>)
+{
+    m_event_poll->interest_state_changed({}, *this);
+}
+
+static BlockFlags block_flags_for(u32 events)
+{
+    BlockFlags block_flags = BlockFlags::WriteError | BlockFlags::WriteHangUp; // always want EPOLLERR, EPOLLHUP
+    if (events & EPOLLIN)
+        block_flags |= BlockFlags::Read;
+    if (events & EPOLLOUT)
+        block_flags |= BlockFlags::Write;
+    if (events & EPOLLPRI)
+        block_flags |= BlockFlags::ReadPriority;
+    if (events & EPOLLWRBAND)
+        block_flags |= BlockFlags::WritePriority;
+    if (events & EPOLLRDHUP)
+        block_flags |= BlockFlags::ReadHangUp;
+    return block_flags;
+}
+
+static u32 events_for(BlockFlags unblocked_flags)
+{
+    u32 events = 0;
+    if (has_flag(unblocked_flags, BlockFlags::WriteHangUp))
+        events |= EPOLLHUP;
+    if (has_flag(unblocked_flags, BlockFlags::WriteError)) {
+        events |= EPOLLERR;
+        return events;
+    }
+    if (has_flag(unblocked_flags, BlockFlags::Read))
+        events |= EPOLLIN;
+    if (has_flag(unblocked_flags, BlockFlags::ReadPriority))
+        events |= EPOLLPRI;
+    if (!has_flag(unblocked_flags, BlockFlags::WriteHangUp) && has_flag(unblocked_flags, BlockFlags::Write))
+        events |= EPOLLOUT;
+    if (has_flag(unblocked_flags, BlockFlags::WritePriority))
+        events |= EPOLLWRBAND;
+    if (has_flag(unblocked_flags, BlockFlags::ReadHangUp))
+        events |= EPOLLRDHUP;
+    return events;
+}
+
+void EventPoll::unregister_interest(EventPollInterest::ReadyList& ready_list, EventPollInterest& interest)
+{
+    interest.m_is_registered = false;
+    if (ready_list.contains(interest))
+        ready_list.remove(interest);
+}
+
+ErrorOr<NonnullRefPtr<EventPoll>> EventPoll::try_create()
+{
+    return adopt_nonnull_ref_or_enomem(new (nothrow) EventPoll);
+}
+
+EventPoll::~EventPoll()
+{
+    (void)close();
+}
+
+bool EventPoll::can_read(OpenFileDescription const&, u64) const
+{
+    return m_interests.with([](auto& interests) { return !interests.ready_list.is_empty(); });
+}
+
+ErrorOr<void> EventPoll::close()
+{
+    // NOTE: Interests keep their EventPoll alive, so this is what breaks the cycle when the epoll fd is closed.
+    auto by_key = m_interests.with([](auto& interests) {
+        for (auto& it : interests.by_key)
+            unregister_interest(interests.ready_list, *it.value);
+        return move(interests.by_key);
+    });
+
+    for (auto& it : by_key)
+        forget_interest(*it.value);
+    return {};
+}
+
+ErrorOr<NonnullOwnPtr<KString>> EventPoll::pseudo_path(OpenFileDescription const&) const
+{
+    return m_interests.with([](auto& interests) -> ErrorOr<NonnullOwnPtr<KString>> {
+        return KString::formatted("EventPoll:({})", interests.by_key.size());
+    });
+}
+
+ErrorOr<void> EventPoll::add_interest(OpenFileDescription& description, int fd, u32 events, u64 data)
+{
+    auto interest = TRY(EventPollInterest::try_create(*this, description, fd, events, data));
+
+    // NOTE: The interest has to be linked into the file first, so that it can't miss a state change between being
+    //       registered and being linked. Until it is registered, state changes are ignored.
+    interest->file().blocker_set().add_event_poll_interest(*interest);
+
+    auto result = m_interests.with([&](auto& interests) -> ErrorOr<void> {
+        InterestKey key { &description, fd };
+        if (interests.by_key.contains(key))
+            return EEXIST;
+        TRY(interests.by_key.try_set(key, interest));
+        interest->m_is_registered = true;
+
+        // Let the next wait find out whether the file is already ready.
+        interests.ready_list.append(*interest);
+        return {};
+    });
+    if (result.is_error()) {
+        forget_interest(*interest);
+        return result.release_error();
+    }
+
+    evaluate_block_conditions();
+    return {};
+}
+
+ErrorOr<void> EventPoll::modify_interest(OpenFileDescription& description, int fd, u32 events, u64 data)
+{
+    TRY(m_interests.with([&](auto& interests) -> ErrorOr<void> {
+        auto it = interests.by_key.find({ &description, fd });
+        if (it == interests.by_key.end())
+            return ENOENT;
+
+        auto& interest = *it->value;
+        interest.m_events = events;
+        interest.m_data = data;
+        interest.m_is_armed = true;
+        if (!interests.ready_list.contains(interest))
+            interests.ready_list.append(interest);
+        return {};
+    }));
+
+    evaluate_block_conditions();
+    return {};
+}
+
+ErrorOr<void> EventPoll::remove_interest(OpenFileDescription& description, int fd)
+{
+    auto interest = TRY(m_interests.with([&](auto& interests) -> ErrorOr<NonnullRefPtr<EventPollInterest>> {
+        auto it = interests.by_key.find({ &description, fd });
+        if (it == interests.by_key.end())
+            return ENOENT;
+
+        auto interest = it->value;
+        interests.by_key.remove(it);
+        unregister_interest(interests.ready_list, *interest);
+        return interest;
+    }));
+
+    forget_interest(*interest);
+    return {};
+}
+
+ErrorOr<Vector<epoll_event>> EventPoll::collect_ready_events(size_t max_events)
+{
+    max_events = min(max_events, max_events_per_wait);
+
+    struct Candidate {
+        NonnullRefPtr<EventPollInterest> interest;
+        NonnullRefPtr<OpenFileDescription> description;
+        u32 events { 0 };
+        u64 data { 0 };
+        u32 ready_events { 0 };
+    };
+    Vector<Candidate> candidates;
+    TRY(candidates.try_ensure_capacity(max_events));
+
+    Vector<epoll_event> ready_events;
+    TRY(ready_events.try_ensure_capacity(max_events));
+
+    m_interests.with([&](auto& interests) {
+        while (candidates.size() < max_events && !interests.ready_list.is_empty()) {
+            auto* interest = interests.ready_list.take_first();
+            // NOTE: If the description is already going away, it will unregister this interest on its way out.
+            if (!interest->description().try_ref())
+                continue;
+            candidates.unchecked_append({ *interest, adopt_ref(interest->description()), interest->m_events, interest->m_data });
+        }
+    });
+
+    // NOTE: Checking whether a file is ready may take the file's blocker set lock, which has to be taken before ours.
+    for (auto& candidate : candidates) {
+        auto unblocked_flags = candidate.description->should_unblock(block_flags_for(candidate.events));
+        candidate.ready_events = events_for(unblocked_flags);
+    }
+
+    m_interests.with([&](auto& interests) {
+        for (auto& candidate : candidates) {
+            auto& interest = *candidate.interest;
+            // If the file isn't ready, it will put the interest back on the ready list once it changes state.
+            if (!interest.m_is_registered || candidate.ready_events == 0)
+                continue;
+
+            if (candidate.events & EPOLLONESHOT)
+                interest.m_is_armed = false;
+            else if (!(candidate.events & EPOLLET) && !interests.ready_list.contains(interest))
+                interests.ready_list.append(interest); // Level-triggered interests are reported for as long as the file stays ready.
+
+            epoll_event event {};
+            event.events = candidate.ready_events;
+            event.data.u64 = candidate.data;
+            ready_events.unchecked_append(event);
+        }
+    });
+
+    return ready_events;
+}
+
+void EventPoll::remove_interests_in_description(Badge<OpenFileDescription>, OpenFileDescription& description)
+{
+    while (auto interest = description.blocker_set().take_any_event_poll_interest_in(description)) {
+        interest->event_poll().m_interests.with([&](auto& interests) {
+            if (!interest->m_is_registered)
+                return;
+            unregister_interest(interests.ready_list, *interest);
+            interests.by_key.remove({ &description, interest->fd() });
+        });
+    }
+}
+
+void EventPoll::interest_state_changed(Badge<EventPollInterest>, EventPollInterest& interest)
+{
+    bool became_ready = m_interests.with([&](auto& interests) {
+        if (!interest.m_is_registered || !interest.m_is_armed || interests.ready_list.contains(interest))
+            return false;
+        interests.ready_list.append(interest);
+        return true;
+    });
+
+    if (became_ready)
+        evaluate_block_conditions();
+}
+
+void EventPoll::forget_interest(EventPollInterest& interest)
+{
+    interest.file().blocker_set().remove_event_poll_interest(interest);
+}
+
+}
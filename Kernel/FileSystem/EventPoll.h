@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Badge.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/API/POSIX/sys/epoll.h>
+#include <Kernel/FileSystem/EventPollInterest.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+
+namespace Kernel {
+
+// The file behind an epoll file descriptor.
+//
+// Interests are kept per (file description, fd) pair, just like on other systems. An interest goes away when it is
+// deleted with EPOLL_CTL_DEL, when the EventPoll is closed, or when the last reference to its file description goes
+// away, but NOT when the fd it was added with is closed while the description is still open through another fd.
+class EventPoll final : public File {
+public:
+    // The most events a single call to epoll_wait() will report.
+    static constexpr size_t max_events_per_wait = 1024;
+
+    static ErrorOr<NonnullRefPtr<EventPoll>> try_create();
+    virtual ~EventPoll() override;
+
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    // Can't write to an event poll.
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+    virtual ErrorOr<void> close() override;
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const&) const override;
+    virtual StringView class_name() const override { return "EventPoll"sv; }
+    virtual bool is_event_poll() const override { return true; }
+
+    ErrorOr<void> add_interest(OpenFileDescription&, int fd, u32 events, u64 data);
+    ErrorOr<void> modify_interest(OpenFileDescription&, int fd, u32 events, u64 data);
+    ErrorOr<void> remove_interest(OpenFileDescription&, int fd);
+
+    // Returns up to max_events events for interests whose files are ready, without blocking.
+    ErrorOr<Vector<epoll_event>> collect_ready_events(size_t max_events);
+
+    static void remove_interests_in_description(Badge<OpenFileDescription>, OpenFileDescription&);
+
+    void interest_state_changed(Badge<EventPollInterest>, EventPollInterest&);
+
+private:
+    EventPoll() = default;
+
+    struct InterestKey {
+        OpenFileDescription const* description { nullptr };
+        int fd { -1 };
+
+        bool operator==(InterestKey const&) const = default;
+    };
+
+    struct InterestKeyTraits : public DefaultTraits<InterestKey> {
+        static unsigned hash(InterestKey const& key) { return pair_int_hash(ptr_hash(key.description), key.fd); }
+    };
+
+    struct Interests {
+        HashMap<InterestKey, NonnullRefPtr<EventPollInterest>, InterestKeyTraits> by_key;
+        EventPollInterest::ReadyList ready_list;
+    };
+
+    static void unregister_interest(EventPollInterest::ReadyList&, EventPollInterest&);
+    // Unlinks an interest that has already been removed from our map from the file it watches.
+    static void forget_interest(EventPollInterest&);
+
+    mutable SpinlockProtected<Interests, LockRank::None> m_interests;
+};
+
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/AtomicRefCounted.h>
+#include <AK/Badge.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefPtr.h>
+#include <Kernel/Forward.h>
+
+namespace Kernel {
+
+class FileBlockerSet;
+
+// One file description that an EventPoll is interested in.
+//
+// An interest is linked into the blocker set of the file it watches, and gets told whenever that file's state changes.
+// It then puts itself on the ready list of its EventPoll, which only ever looks at interests on that list. This is
+// what makes waiting for events O(ready files) instead of O(watched files).
+class EventPollInterest final : public AtomicRefCounted<EventPollInterest> {
+public:
+    static ErrorOr<NonnullRefPtr<EventPollInterest>> try_create(EventPoll&, OpenFileDescription&, int fd, u32 events, u64 data);
+    ~EventPollInterest();
+
+    EventPoll& event_poll() { return *m_event_poll; }
+
+    // NOTE: The description unregisters all of its interests before it goes away, so this is always valid while
+    //       the interest is registered.
+    OpenFileDescription& description() { return m_description; }
+    OpenFileDescription const& description() const { return m_description; }
+    int fd() const { return m_fd; }
+    File& file() { return *m_file; }
+
+    void file_state_changed(Badge<FileBlockerSet>);
+
+private:
+    friend class EventPoll;
+
+    EventPollInterest(EventPoll&, OpenFileDescription&, int fd, u32 events, u64 data);
+
+    NonnullRefPtr<EventPoll> const m_event_poll;
+    OpenFileDescription& m_description;
+    // NOTE: We keep the watched file alive so we can always unlink ourselves from its blocker set, even if the
+    //       description is already going away.
+    NonnullRefPtr<File> const m_file;
+    int const m_fd { -1 };
+
+    // These are protected by the EventPoll's lock.
+    u32 m_events { 0 };
+    u64 m_data { 0 };
+    // Set while the interest is in the EventPoll's map.
+    bool m_is_registered { false };
+    // Cleared once an EPOLLONESHOT interest has reported an event, until it is modified again.
+    bool m_is_armed { true };
+    IntrusiveListNode<EventPollInterest> m_ready_list_node;
+
+    // This is protected by the lock of the watched file's blocker set.
+    IntrusiveListNode<EventPollInterest> m_file_list_node;
+
+public:
+    using ReadyList = IntrusiveList<&EventPollInterest::m_ready_list_node>;
+    using FileList = IntrusiveList<&EventPollInterest::m_file_list_node>;
+};
+
+}
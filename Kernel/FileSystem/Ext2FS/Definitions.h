@@ -732,4 +732,39 @@ struct mmp_struct {
  */
 #define EXT2_MMP_DEF_INTERVAL 5
 
+/*
+ * Extent tree of inodes with EXT4_EXTENTS_FL. The root lives in i_block,
+ * every other node fills a whole block. Each node starts with a header,
+ * followed by index entries (in interior nodes) or extents (in leaves).
+ */
+#define EXT3_EXT_MAGIC 0xf30a
+
+struct ext3_extent_header {
+    __u16 eh_magic;      /* probably will support different formats */
+    __u16 eh_entries;    /* number of valid entries */
+    __u16 eh_max;        /* capacity of store in entries */
+    __u16 eh_depth;      /* has tree real underlying blocks? */
+    __u32 eh_generation; /* generation of the tree */
+};
+
+struct ext3_extent {
+    __u32 ee_block;    /* first logical block extent covers */
+    __u16 ee_len;      /* number of blocks covered by extent */
+    __u16 ee_start_hi; /* high 16 bits of physical block */
+    __u32 ee_start;    /* low 32 bits of physical block */
+};
+
+struct ext3_extent_idx {
+    __u32 ei_block;   /* index covers logical blocks from 'block' */
+    __u32 ei_leaf;    /* pointer to the physical block of the next level */
+    __u16 ei_leaf_hi; /* high 16 bits of physical block */
+    __u16 ei_unused;
+};
+
+/*
+ * Extents longer than this are uninitialized (preallocated but never
+ * written), and cover ee_len - EXT_INIT_MAX_LEN blocks that read as zeroes.
+ */
+#define EXT_INIT_MAX_LEN (1UL << 15)
+
 #endif /* _LINUX_EXT2_FS_H */
@@ -116,7 +116,7 @@ ErrorOr<void> Ext2FS::initialize_while_locked()
     BlockIndex first_block_of_bgdt = first_block_of_block_group_descriptors();
     m_cached_group_descriptor_table = TRY(KBuffer::try_create_with_size("Ext2FS: Block group descriptors"sv, logical_block_size() * blocks_to_read, Memory::Region::Access::ReadWrite));
     auto buffer = UserOrKernelBuffer::for_kernel_buffer(m_cached_group_descriptor_table->data());
-    TRY(read_blocks(first_block_of_bgdt, blocks_to_read, buffer));
+    TRY(read_blocks(first_block_of_bgdt, blocks_to_read, &buffer));
 
     if constexpr (EXT2_DEBUG) {
         for (unsigned i = 1; i <= m_block_group_count; ++i) {
@@ -221,6 +221,11 @@ Ext2FS::FeaturesReadOnly Ext2FS::get_features_readonly() const
     return Ext2FS::FeaturesReadOnly::None;
 }
 
+bool Ext2FS::supports_extents() const
+{
+    return m_super_block.s_rev_level > 0 && (m_super_block.s_feature_incompat & EXT3_FEATURE_INCOMPAT_EXTENTS);
+}
+
 u64 Ext2FS::inodes_per_block() const
 {
     return EXT2_INODES_PER_BLOCK(&super_block());
@@ -250,9 +255,9 @@ ErrorOr<void> Ext2FS::write_ext2_inode(InodeIndex inode, ext2_inode const& e2ino
     return write_block(block_index, buffer, inode_size(), offset);
 }
 
-auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) -> ErrorOr<Vector<BlockIndex>>
+auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal) -> ErrorOr<Vector<BlockIndex>>
 {
-    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {})", preferred_group_index, count);
+    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {}, goal {})", preferred_group_index, count, goal);
     if (count == 0)
         return Vector<BlockIndex> {};
 
@@ -260,6 +265,32 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
     TRY(blocks.try_ensure_capacity(count));
 
     MutexLocker locker(m_lock);
+
+    // Try to continue right where the caller's blocks end, so that files stay contiguous as they grow.
+    if (goal.value() >= first_block_index().value() && goal.value() < super_block().s_blocks_count) {
+        auto goal_group_index = group_index_from_block_index(goal);
+        auto const& bgd = group_descriptor(goal_group_index);
+        if (bgd.bg_free_blocks_count) {
+            auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+            int blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count);
+            auto block_bitmap = cached_bitmap->bitmap(blocks_in_group);
+
+            BlockIndex first_block_in_group = first_block_of_group(goal_group_index);
+            // If the goal itself is taken, the next free range after it is still close by.
+            size_t first_unset_bit_index = goal.value() - first_block_in_group.value();
+            auto free_region_size = block_bitmap.find_next_range_of_unset_bits(first_unset_bit_index, 1, count);
+            if (free_region_size.has_value()) {
+                dbgln_if(EXT2_DEBUG, "Ext2FS: allocating free region of size: {} [{}] near goal", free_region_size.value(), goal_group_index);
+                for (size_t i = 0; i < free_region_size.value(); ++i) {
+                    BlockIndex block_index = (first_unset_bit_index + i) + first_block_in_group.value();
+                    TRY(set_block_allocation_state(block_index, true));
+                    blocks.unchecked_append(block_index);
+                }
+            }
+            preferred_group_index = goal_group_index;
+        }
+    }
+
     auto group_index = preferred_group_index;
 
     if (!group_descriptor(preferred_group_index).bg_free_blocks_count) {
@@ -529,6 +560,14 @@ ErrorOr<NonnullRefPtr<Inode>> Ext2FS::create_inode(Ext2FSInode& parent_inode, St
     else if (is_block_device(mode))
         e2inode.i_block[1] = dev;
 
+    // Regular files are mapped with extents when the file system supports them, as those describe contiguous files far more compactly.
+    if (is_regular_file(mode) && supports_extents()) {
+        e2inode.i_flags |= EXT4_EXTENTS_FL;
+        auto& header = *reinterpret_cast<ext3_extent_header*>(e2inode.i_block);
+        header.eh_magic = EXT3_EXT_MAGIC;
+        header.eh_max = (sizeof(e2inode.i_block) - sizeof(ext3_extent_header)) / sizeof(ext3_extent);
+    }
+
     auto inode_id = TRY(allocate_inode());
 
     dbgln_if(EXT2_DEBUG, "Ext2FS: writing initial metadata for inode {}", inode_id.value());
@@ -556,7 +595,23 @@ unsigned Ext2FS::total_block_count() const
 unsigned Ext2FS::free_block_count() const
 {
     MutexLocker locker(m_lock);
-    return super_block().s_free_blocks_count;
+    return super_block().s_free_blocks_count - m_reserved_block_count;
+}
+
+ErrorOr<void> Ext2FS::reserve_blocks(size_t count)
+{
+    MutexLocker locker(m_lock);
+    if (m_reserved_block_count + count > super_block().s_free_blocks_count)
+        return ENOSPC;
+    m_reserved_block_count += count;
+    return {};
+}
+
+void Ext2FS::unreserve_blocks(size_t count)
+{
+    MutexLocker locker(m_lock);
+    VERIFY(m_reserved_block_count >= count);
+    m_reserved_block_count -= count;
 }
 
 unsigned Ext2FS::total_inode_count() const
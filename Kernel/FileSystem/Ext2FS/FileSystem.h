@@ -44,6 +44,7 @@ public:
     virtual u8 internal_file_type_to_directory_entry_type(DirectoryEntryView const& entry) const override;
 
     FeaturesReadOnly get_features_readonly() const;
+    bool supports_extents() const;
 
     virtual StringView class_name() const override { return "Ext2FS"sv; }
     virtual Inode& root_inode() override;
@@ -82,7 +83,9 @@ private:
     BlockIndex first_block_index() const;
     BlockIndex first_block_of_block_group_descriptors() const;
     ErrorOr<InodeIndex> allocate_inode(GroupIndex preferred_group = 0);
-    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count);
+    ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count, BlockIndex goal = 0);
+    ErrorOr<void> reserve_blocks(size_t count);
+    void unreserve_blocks(size_t count);
     GroupIndex group_index_from_inode(InodeIndex) const;
     GroupIndex group_index_from_block_index(BlockIndex) const;
     BlockIndex first_block_of_group(GroupIndex) const;
@@ -111,6 +114,9 @@ private:
 
     mutable HashMap<InodeIndex, RefPtr<Ext2FSInode>> m_inode_cache;
 
+    // Blocks promised to data that inodes are holding back until it's written out.
+    size_t m_reserved_block_count { 0 };
+
     bool m_super_block_dirty { false };
     bool m_block_group_descriptors_dirty { false };
 
@@ -5,17 +5,33 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/MemoryStream.h>
+#include <AK/ScopeGuard.h>
 #include <Kernel/API/POSIX/errno.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/Ext2FS/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
+#include <Kernel/Library/KBuffer.h>
+#include <Kernel/Tasks/WorkQueue.h>
 #include <Kernel/UnixTypes.h>
 
 namespace Kernel {
 
 static constexpr size_t max_inline_symlink_length = 60;
 
+// Data appended to a regular file is kept in memory, up to this much, and only gets blocks once it's written back.
+// Allocating all of those blocks at once keeps the file contiguous, and the bitmaps and block list are updated only once.
+static constexpr size_t max_delayed_allocation_size = 2 * MiB;
+// The buffer for that data grows along with it. Once the buffers of all inodes together reach their limit,
+// appended data is written out right away instead.
+static constexpr size_t min_delayed_allocation_buffer_size = 64 * KiB;
+static constexpr size_t max_total_delayed_allocation_memory = 64 * MiB;
+static Atomic<size_t> s_total_delayed_allocation_memory { 0 };
+
+static constexpr size_t extents_in_inode = (sizeof(ext2_inode::i_block) - sizeof(ext3_extent_header)) / sizeof(ext3_extent);
+static constexpr u16 max_extent_tree_depth = 5;
+
 static u8 to_ext2_file_type(mode_t mode)
 {
     if (is_regular_file(mode))
@@ -203,6 +219,9 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
 {
     MutexLocker locker(m_inode_lock);
 
+    if (uses_extents())
+        return flush_extent_tree();
+
     if (m_block_list.is_empty()) {
         m_raw_inode.i_blocks = 0;
         memset(m_raw_inode.i_block, 0, sizeof(m_raw_inode.i_block));
@@ -211,7 +230,7 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
     }
 
     // NOTE: There is a mismatch between i_blocks and blocks.size() since i_blocks includes meta blocks and blocks.size() does not.
-    auto const old_block_count = ceil_div(size(), static_cast<u64>(fs().logical_block_size()));
+    auto const old_block_count = ceil_div(size_on_disk(), static_cast<u64>(fs().logical_block_size()));
 
     auto old_shape = fs().compute_block_list_shape(old_block_count);
     auto const new_shape = fs().compute_block_list_shape(m_block_list.size());
@@ -331,6 +350,113 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
     VERIFY_NOT_REACHED();
 }
 
+ErrorOr<void> Ext2FSInode::flush_extent_tree()
+{
+    VERIFY(m_inode_lock.is_locked());
+    auto const block_size = fs().logical_block_size();
+
+    // Runs of blocks that are next to each other both in the file and on disk become one extent.
+    Vector<ext3_extent> extents;
+    u64 data_block_count = 0;
+    for (size_t i = 0; i < m_block_list.size(); ++i) {
+        u64 block_index = m_block_list[i].value();
+        if (block_index == 0)
+            continue;
+        ++data_block_count;
+        if (!extents.is_empty()) {
+            auto& last = extents.last();
+            u64 last_start = static_cast<u64>(last.ee_start_hi) << 32 | last.ee_start;
+            if (last.ee_block + last.ee_len == i && last_start + last.ee_len == block_index && last.ee_len < EXT_INIT_MAX_LEN) {
+                ++last.ee_len;
+                continue;
+            }
+        }
+        ext3_extent extent {};
+        extent.ee_block = i;
+        extent.ee_len = 1;
+        extent.ee_start_hi = block_index >> 32;
+        extent.ee_start = block_index & 0xffffffff;
+        TRY(extents.try_append(extent));
+    }
+
+    // The blocks of the current tree are reused, as far as the new tree needs them.
+    Vector<Ext2FS::BlockIndex> tree_blocks;
+    TRY(collect_extent_tree_blocks({ reinterpret_cast<u8 const*>(m_raw_inode.i_block), sizeof(m_raw_inode.i_block) }, tree_blocks));
+
+    // Extents and index entries have the same size, and both start with the first logical block they cover,
+    // so every level of the tree can be built the same way from the entries of the level below it.
+    static_assert(sizeof(ext3_extent) == sizeof(ext3_extent_idx));
+    static_assert(__builtin_offsetof(ext3_extent, ee_block) == 0 && __builtin_offsetof(ext3_extent_idx, ei_block) == 0);
+    size_t const entry_size = sizeof(ext3_extent);
+    size_t const entries_per_node = (block_size - sizeof(ext3_extent_header)) / entry_size;
+
+    // Levels are added below the root until it has room for an index entry for each node of the topmost one.
+    u16 depth = 0;
+    size_t tree_block_count = 0;
+    for (size_t entry_count = extents.size(); entry_count > extents_in_inode; ++depth) {
+        if (depth == max_extent_tree_depth) {
+            dmesgln("Ext2FSInode[{}]::flush_extent_tree(): Too fragmented, {} extents don't fit into a tree of depth {}", identifier(), extents.size(), max_extent_tree_depth);
+            return EFBIG;
+        }
+        entry_count = ceil_div(entry_count, entries_per_node);
+        tree_block_count += entry_count;
+    }
+
+    if (tree_blocks.size() < tree_block_count) {
+        auto new_tree_blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), tree_block_count - tree_blocks.size()));
+        TRY(tree_blocks.try_extend(move(new_tree_blocks)));
+    }
+    while (tree_blocks.size() > tree_block_count)
+        TRY(fs().set_block_allocation_state(tree_blocks.take_last(), false));
+
+    ReadonlyBytes level_entries { extents.data(), extents.size() * entry_size };
+    Vector<ext3_extent_idx> indices;
+    size_t next_tree_block = 0;
+    if (depth > 0) {
+        auto node_contents = TRY(ByteBuffer::create_uninitialized(block_size));
+        for (u16 level = 0; level < depth; ++level) {
+            size_t const entry_count = level_entries.size() / entry_size;
+            Vector<ext3_extent_idx> parent_indices;
+            TRY(parent_indices.try_ensure_capacity(ceil_div(entry_count, entries_per_node)));
+            for (size_t first_entry = 0; first_entry < entry_count; first_entry += entries_per_node) {
+                auto node_entries = level_entries.slice(first_entry * entry_size, min(entries_per_node, entry_count - first_entry) * entry_size);
+                node_contents.zero_fill();
+                auto& header = *reinterpret_cast<ext3_extent_header*>(node_contents.data());
+                header.eh_magic = EXT3_EXT_MAGIC;
+                header.eh_entries = node_entries.size() / entry_size;
+                header.eh_max = entries_per_node;
+                header.eh_depth = level;
+                memcpy(&header + 1, node_entries.data(), node_entries.size());
+                auto node_block = tree_blocks[next_tree_block++];
+                auto buffer = UserOrKernelBuffer::for_kernel_buffer(node_contents.data());
+                TRY(fs().write_block(node_block, buffer, block_size));
+
+                ext3_extent_idx index {};
+                index.ei_block = *reinterpret_cast<u32 const*>(node_entries.data());
+                index.ei_leaf = node_block.value() & 0xffffffff;
+                index.ei_leaf_hi = node_block.value() >> 32;
+                parent_indices.unchecked_append(index);
+            }
+            indices = move(parent_indices);
+            level_entries = { indices.data(), indices.size() * entry_size };
+        }
+    }
+    VERIFY(next_tree_block == tree_block_count);
+    VERIFY(level_entries.size() <= extents_in_inode * entry_size);
+
+    memset(m_raw_inode.i_block, 0, sizeof(m_raw_inode.i_block));
+    auto& root = *reinterpret_cast<ext3_extent_header*>(m_raw_inode.i_block);
+    root.eh_magic = EXT3_EXT_MAGIC;
+    root.eh_max = extents_in_inode;
+    root.eh_entries = level_entries.size() / entry_size;
+    root.eh_depth = depth;
+    memcpy(&root + 1, level_entries.data(), level_entries.size());
+
+    m_raw_inode.i_blocks = (data_block_count + tree_block_count) * (block_size / 512);
+    set_metadata_dirty(true);
+    return {};
+}
+
 ErrorOr<Vector<Ext2FS::BlockIndex>> Ext2FSInode::compute_block_list() const
 {
     return compute_block_list_impl(false);
@@ -354,7 +480,7 @@ ErrorOr<Vector<Ext2FS::BlockIndex>> Ext2FSInode::compute_block_list_impl_interna
 {
     unsigned entries_per_block = EXT2_ADDR_PER_BLOCK(&fs().super_block());
 
-    unsigned block_count = ceil_div(size(), static_cast<u64>(fs().logical_block_size()));
+    unsigned block_count = ceil_div(size_on_disk(), static_cast<u64>(fs().logical_block_size()));
 
     // If we are handling a symbolic link, the path is stored in the 60 bytes in
     // the inode that are used for the 12 direct and 3 indirect block pointers,
@@ -366,6 +492,22 @@ ErrorOr<Vector<Ext2FS::BlockIndex>> Ext2FSInode::compute_block_list_impl_interna
 
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::block_list_for_inode(): i_size={}, i_blocks={}, block_count={}", identifier(), e2inode.i_size, e2inode.i_blocks, block_count);
 
+    if (e2inode.i_flags & EXT4_EXTENTS_FL) {
+        Vector<Ext2FS::BlockIndex> list;
+        TRY(list.try_resize(block_count));
+        Vector<Ext2FS::BlockIndex> tree_blocks;
+        Vector<ext3_extent> uninitialized_extents;
+        TRY(walk_extent_tree({ reinterpret_cast<u8 const*>(e2inode.i_block), sizeof(e2inode.i_block) }, list, include_block_list_blocks ? &tree_blocks : nullptr, include_block_list_blocks ? &uninitialized_extents : nullptr));
+        TRY(list.try_extend(move(tree_blocks)));
+        // Uninitialized extents aren't part of the block list, but their blocks still belong to the inode.
+        for (auto const& extent : uninitialized_extents) {
+            u64 first_block = static_cast<u64>(extent.ee_start_hi) << 32 | extent.ee_start;
+            for (u64 i = 0; i < extent.ee_len - EXT_INIT_MAX_LEN; ++i)
+                TRY(list.try_append(first_block + i));
+        }
+        return list;
+    }
+
     unsigned blocks_remaining = block_count;
 
     if (include_block_list_blocks) {
@@ -444,6 +586,105 @@ ErrorOr<Vector<Ext2FS::BlockIndex>> Ext2FSInode::compute_block_list_impl_interna
     return list;
 }
 
+static ErrorOr<ext3_extent_header const*> validate_extent_node(ReadonlyBytes node)
+{
+    if (node.size() < sizeof(ext3_extent_header))
+        return EIO;
+    auto const* header = reinterpret_cast<ext3_extent_header const*>(node.data());
+    if (header->eh_magic != EXT3_EXT_MAGIC || header->eh_depth > max_extent_tree_depth || header->eh_entries > header->eh_max)
+        return EIO;
+    if (sizeof(ext3_extent_header) + header->eh_entries * sizeof(ext3_extent) > node.size())
+        return EIO;
+    return header;
+}
+
+ErrorOr<void> Ext2FSInode::walk_extent_tree(ReadonlyBytes node, Vector<Ext2FS::BlockIndex>& block_list, Vector<Ext2FS::BlockIndex>* tree_blocks, Vector<ext3_extent>* uninitialized_extents) const
+{
+    auto header_or_error = validate_extent_node(node);
+    if (header_or_error.is_error()) {
+        dmesgln("Ext2FSInode[{}]::walk_extent_tree(): Corrupted extent tree node", identifier());
+        return header_or_error.release_error();
+    }
+    auto const& header = *header_or_error.value();
+
+    if (header.eh_depth == 0) {
+        auto const* extents = reinterpret_cast<ext3_extent const*>(&header + 1);
+        for (size_t i = 0; i < header.eh_entries; ++i) {
+            auto const& extent = extents[i];
+            // Uninitialized extents read as zeroes, which is what holes in the block list do as well.
+            if (extent.ee_len > EXT_INIT_MAX_LEN) {
+                if (uninitialized_extents)
+                    TRY(uninitialized_extents->try_append(extent));
+                continue;
+            }
+            u64 first_block = static_cast<u64>(extent.ee_start_hi) << 32 | extent.ee_start;
+            for (u64 j = 0; j < extent.ee_len && extent.ee_block + j < block_list.size(); ++j)
+                block_list[extent.ee_block + j] = first_block + j;
+        }
+        return {};
+    }
+
+    auto const* indices = reinterpret_cast<ext3_extent_idx const*>(&header + 1);
+    auto child_contents = TRY(ByteBuffer::create_uninitialized(fs().logical_block_size()));
+    for (size_t i = 0; i < header.eh_entries; ++i) {
+        Ext2FS::BlockIndex child = static_cast<u64>(indices[i].ei_leaf_hi) << 32 | indices[i].ei_leaf;
+        if (tree_blocks)
+            TRY(tree_blocks->try_append(child));
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(child_contents.data());
+        TRY(fs().read_block(child, &buffer, child_contents.size()));
+        if (reinterpret_cast<ext3_extent_header const*>(child_contents.data())->eh_depth != header.eh_depth - 1) {
+            dmesgln("Ext2FSInode[{}]::walk_extent_tree(): Extent tree node {} has the wrong depth", identifier(), child);
+            return EIO;
+        }
+        TRY(walk_extent_tree(child_contents.bytes(), block_list, tree_blocks, uninitialized_extents));
+    }
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::collect_extent_tree_blocks(ReadonlyBytes node, Vector<Ext2FS::BlockIndex>& tree_blocks) const
+{
+    auto const& header = *TRY(validate_extent_node(node));
+    if (header.eh_depth == 0)
+        return {};
+
+    // Leaves don't point to any more tree blocks, so only the interior nodes have to be read.
+    auto const* indices = reinterpret_cast<ext3_extent_idx const*>(&header + 1);
+    auto child_contents = TRY(ByteBuffer::create_uninitialized(fs().logical_block_size()));
+    for (size_t i = 0; i < header.eh_entries; ++i) {
+        Ext2FS::BlockIndex child = static_cast<u64>(indices[i].ei_leaf_hi) << 32 | indices[i].ei_leaf;
+        TRY(tree_blocks.try_append(child));
+        if (header.eh_depth > 1) {
+            auto buffer = UserOrKernelBuffer::for_kernel_buffer(child_contents.data());
+            TRY(fs().read_block(child, &buffer, child_contents.size()));
+            TRY(collect_extent_tree_blocks(child_contents.bytes(), tree_blocks));
+        }
+    }
+    return {};
+}
+
+ErrorOr<void> Ext2FSInode::ensure_extent_tree_is_writable()
+{
+    VERIFY(m_inode_lock.is_locked());
+    if (!uses_extents())
+        return {};
+
+    if (!m_has_uninitialized_extents.has_value()) {
+        // Nothing ends up in the empty block list, we only want to know about the uninitialized extents.
+        Vector<Ext2FS::BlockIndex> block_list;
+        Vector<ext3_extent> uninitialized_extents;
+        TRY(walk_extent_tree({ reinterpret_cast<u8 const*>(m_raw_inode.i_block), sizeof(m_raw_inode.i_block) }, block_list, nullptr, &uninitialized_extents));
+        m_has_uninitialized_extents = !uninitialized_extents.is_empty();
+    }
+
+    // FIXME: Writing into an uninitialized extent means splitting it, and rewriting the tree from the block list would drop it
+    //        (and leak its blocks), so files that have any are read-only for now. We never create such extents ourselves.
+    if (m_has_uninitialized_extents.value()) {
+        dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::ensure_extent_tree_is_writable(): Refusing to modify a file with uninitialized extents", identifier());
+        return ENOTSUP;
+    }
+    return {};
+}
+
 Ext2FSInode::Ext2FSInode(Ext2FS& fs, InodeIndex index)
     : Inode(fs, index)
 {
@@ -451,13 +692,23 @@ Ext2FSInode::Ext2FSInode(Ext2FS& fs, InodeIndex index)
 
 Ext2FSInode::~Ext2FSInode()
 {
-    if (m_raw_inode.i_links_count == 0) {
-        // Alas, we have nowhere to propagate any errors that occur here.
+    // Alas, we have nowhere to propagate any errors that occur here.
+    if (m_raw_inode.i_links_count == 0)
         (void)fs().free_inode(*this);
-    }
+    else if (m_delayed_size > 0)
+        (void)flush_metadata();
+
+    if (m_reserved_block_count > 0)
+        fs().unreserve_blocks(m_reserved_block_count);
+    release_delayed_data();
 }
 
 u64 Ext2FSInode::size() const
+{
+    return size_on_disk() + m_delayed_size;
+}
+
+u64 Ext2FSInode::size_on_disk() const
 {
     if (Kernel::is_regular_file(m_raw_inode.i_mode) && ((u32)fs().get_features_readonly() & (u32)Ext2FS::FeaturesReadOnly::FileSize64bits))
         return static_cast<u64>(m_raw_inode.i_dir_acl) << 32 | m_raw_inode.i_size;
@@ -498,6 +749,9 @@ ErrorOr<void> Ext2FSInode::flush_metadata()
         return {};
 
     dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::flush_metadata(): Flushing inode", identifier());
+    TRY(allocate_delayed_blocks());
+    // The file is probably done growing for now, so don't hold on to the memory.
+    release_delayed_data();
     TRY(fs().write_ext2_inode(index(), m_raw_inode));
     if (is_directory()) {
         // Unless we're about to go away permanently, invalidate the lookup cache.
@@ -527,12 +781,27 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
 {
     VERIFY(m_inode_lock.is_locked());
     VERIFY(offset >= 0);
-    if (m_raw_inode.i_size == 0)
+    if (size() == 0)
         return 0;
 
     if (static_cast<u64>(offset) >= size())
         return 0;
 
+    // Data that doesn't have blocks on disk yet comes straight out of memory.
+    auto const delayed_start = size_on_disk();
+    if (m_delayed_size > 0 && static_cast<u64>(offset) + count > delayed_start) {
+        size_t nread = 0;
+        if (static_cast<u64>(offset) < delayed_start) {
+            nread = TRY(read_bytes_locked(offset, delayed_start - offset, buffer, description));
+            if (nread < delayed_start - offset)
+                return nread;
+        }
+        u64 position = offset + nread;
+        size_t delayed_count = min<u64>(count - nread, size() - position);
+        TRY(buffer.write(m_delayed_data->data() + (position - delayed_start), nread, delayed_count));
+        return nread + delayed_count;
+    }
+
     // Symbolic links shorter than 60 characters are store inline inside the i_block array.
     // This avoids wasting an entire block on short links. (Most links are short.)
     if (is_symlink() && size() < max_inline_symlink_length) {
@@ -570,14 +839,26 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::read_bytes(): Reading up to {} bytes, {} bytes into inode to {}", identifier(), count, offset, buffer.user_or_kernel_ptr());
 
-    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
+    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index;) {
         auto block_index = m_block_list[bi.value()];
         size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
         size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
+        size_t blocks_read = 1;
         auto buffer_offset = buffer.offset(nread);
         if (block_index.value() == 0) {
             // This is a hole, act as if it's filled with zeroes.
             TRY(buffer_offset.memset(0, num_bytes_to_copy));
+        } else if (num_bytes_to_copy == static_cast<size_t>(block_size)) {
+            // Whole blocks that are next to each other on disk are read together.
+            while (bi.value() + blocks_read <= last_block_logical_index.value()
+                && static_cast<size_t>(remaining_count) >= (blocks_read + 1) * block_size
+                && m_block_list[bi.value() + blocks_read].value() == block_index.value() + blocks_read)
+                ++blocks_read;
+            if (auto result = fs().read_blocks(block_index, blocks_read, &buffer_offset, allow_cache); result.is_error()) {
+                dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read {} blocks at {} (index {})", identifier(), blocks_read, block_index.value(), bi);
+                return result.release_error();
+            }
+            num_bytes_to_copy = blocks_read * block_size;
         } else {
             if (auto result = fs().read_block(block_index, &buffer_offset, num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
                 dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read block {} (index {})", identifier(), block_index.value(), bi);
@@ -586,14 +867,58 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
         }
         remaining_count -= num_bytes_to_copy;
         nread += num_bytes_to_copy;
+        bi = bi.value() + blocks_read;
     }
 
     return nread;
 }
 
+void Ext2FSInode::readahead(u64 offset, size_t size)
+{
+    // If there is no memory for the work item, the data will simply be read when it's needed.
+    (void)g_readahead_work->try_queue([inode = NonnullRefPtr { *this }, offset, size] {
+        if (auto result = inode->read_ahead(offset, size); result.is_error())
+            dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::readahead(): Failed to read ahead: {}", inode->identifier(), result.error());
+    });
+}
+
+ErrorOr<void> Ext2FSInode::read_ahead(u64 offset, size_t size)
+{
+    struct BlockRun {
+        BlockBasedFileSystem::BlockIndex first_block;
+        unsigned length;
+    };
+    Vector<BlockRun> runs;
+    {
+        MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
+        if (is_symlink() || is_directory() || offset >= this->size())
+            return {};
+        TRY(compute_block_list_with_exclusive_locking());
+
+        u64 block_size = fs().logical_block_size();
+        u64 first_block_logical_index = offset / block_size;
+        u64 end_block_logical_index = min<u64>(ceil_div(offset + size, block_size), m_block_list.size());
+        for (auto bi = first_block_logical_index; bi < end_block_logical_index; ++bi) {
+            auto block_index = m_block_list[bi];
+            if (block_index.value() == 0)
+                continue;
+            if (!runs.is_empty() && runs.last().first_block.value() + runs.last().length == block_index.value())
+                ++runs.last().length;
+            else
+                TRY(runs.try_append({ block_index, 1 }));
+        }
+    }
+
+    // The inode may change while the blocks are being read, but they only end up in the cache, so that's harmless.
+    for (auto& run : runs)
+        TRY(fs().read_blocks(run.first_block, run.length, nullptr));
+    return {};
+}
+
 ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 {
-    auto old_size = size();
+    VERIFY(m_delayed_size == 0 || new_size <= size_on_disk());
+    auto old_size = size_on_disk();
     if (old_size == new_size)
         return {};
 
@@ -611,7 +936,7 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 
     if (blocks_needed_after > blocks_needed_before) {
         auto additional_blocks_needed = blocks_needed_after - blocks_needed_before;
-        if (additional_blocks_needed > fs().super_block().s_free_blocks_count)
+        if (additional_blocks_needed > fs().free_block_count())
             return ENOSPC;
     }
 
@@ -684,10 +1009,41 @@ ErrorOr<size_t> Ext2FSInode::write_bytes_locked(off_t offset, size_t count, User
         }
     }
 
+    TRY(ensure_extent_tree_is_writable());
+
     bool allow_cache = !description || !description->is_direct();
 
+    if (allow_cache && Kernel::is_regular_file(m_raw_inode.i_mode)) {
+        u64 block_size = fs().logical_block_size();
+        u64 delayed_start = ceil_div(size_on_disk(), block_size) * block_size;
+        if (static_cast<u64>(offset) + count > delayed_start && static_cast<u64>(offset) < delayed_start + max_delayed_allocation_size) {
+            // Only what lies past the blocks on disk is delayed, the rest is written as usual.
+            size_t nwritten = 0;
+            if (static_cast<u64>(offset) < delayed_start)
+                nwritten = TRY(write_bytes_locked(offset, delayed_start - offset, data, description));
+            nwritten += TRY(write_delayed(offset + nwritten, count - nwritten, data.offset(nwritten)));
+            if (nwritten < count)
+                nwritten += TRY(write_bytes_to_blocks(offset + nwritten, count - nwritten, data.offset(nwritten), allow_cache));
+            did_modify_contents();
+            return nwritten;
+        }
+    }
+
+    auto nwritten = TRY(write_bytes_to_blocks(offset, count, data, allow_cache));
+    did_modify_contents();
+    return nwritten;
+}
+
+ErrorOr<size_t> Ext2FSInode::write_bytes_to_blocks(off_t offset, size_t count, UserOrKernelBuffer const& data, bool allow_cache)
+{
+    VERIFY(m_inode_lock.is_locked());
+
+    // Anything that changes the blocks on disk has to see the delayed data in them first.
+    if (static_cast<u64>(offset) + count > size_on_disk())
+        TRY(allocate_delayed_blocks());
+
     auto const block_size = fs().logical_block_size();
-    auto new_size = max(static_cast<u64>(offset) + count, size());
+    auto new_size = max(static_cast<u64>(offset) + count, size_on_disk());
 
     TRY(resize(new_size));
 
@@ -723,12 +1079,173 @@ ErrorOr<size_t> Ext2FSInode::write_bytes_locked(off_t offset, size_t count, User
         nwritten += num_bytes_to_copy;
     }
 
-    did_modify_contents();
-
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): After write, i_size={}, i_blocks={} ({} blocks in list)", identifier(), size(), m_raw_inode.i_blocks, m_block_list.size());
     return nwritten;
 }
 
+ErrorOr<void> Ext2FSInode::ensure_delayed_data_capacity(size_t size)
+{
+    VERIFY(size <= max_delayed_allocation_size);
+    size_t old_capacity = m_delayed_data ? m_delayed_data->size() : 0;
+    if (size <= old_capacity)
+        return {};
+
+    size_t new_capacity = max(old_capacity, min_delayed_allocation_buffer_size);
+    while (new_capacity < size)
+        new_capacity *= 2;
+    new_capacity = min(new_capacity, max_delayed_allocation_size);
+
+    auto growth = new_capacity - old_capacity;
+    auto total = s_total_delayed_allocation_memory.load(AK::memory_order_relaxed);
+    do {
+        if (total + growth > max_total_delayed_allocation_memory)
+            return ENOMEM;
+    } while (!s_total_delayed_allocation_memory.compare_exchange_strong(total, total + growth, AK::memory_order_relaxed));
+
+    auto new_data_or_error = KBuffer::try_create_with_size("Ext2FS: Delayed allocation"sv, new_capacity);
+    if (new_data_or_error.is_error()) {
+        s_total_delayed_allocation_memory.fetch_sub(growth, AK::memory_order_relaxed);
+        return new_data_or_error.release_error();
+    }
+    auto new_data = new_data_or_error.release_value();
+    if (m_delayed_size > 0)
+        memcpy(new_data->data(), m_delayed_data->data(), m_delayed_size);
+    m_delayed_data = move(new_data);
+    return {};
+}
+
+void Ext2FSInode::release_delayed_data()
+{
+    if (!m_delayed_data)
+        return;
+    s_total_delayed_allocation_memory.fetch_sub(m_delayed_data->size(), AK::memory_order_relaxed);
+    m_delayed_data = nullptr;
+}
+
+ErrorOr<size_t> Ext2FSInode::write_delayed(u64 offset, size_t count, UserOrKernelBuffer const& data)
+{
+    VERIFY(m_inode_lock.is_locked());
+    u64 block_size = fs().logical_block_size();
+
+    if (!((u32)fs().get_features_readonly() & (u32)Ext2FS::FeaturesReadOnly::FileSize64bits) && (offset + count >= static_cast<u32>(-1)))
+        return ENOSPC;
+
+    size_t nwritten = 0;
+    while (nwritten < count) {
+        if (m_delayed_size == 0) {
+            // The delayed data starts at a block boundary, so the last block on disk has to be filled up first.
+            auto delayed_start = ceil_div(size_on_disk(), block_size) * block_size;
+            TRY(resize(delayed_start));
+        }
+
+        auto const delayed_start = size_on_disk();
+        VERIFY(delayed_start % block_size == 0);
+        u64 position = offset + nwritten;
+        VERIFY(position >= delayed_start);
+        u64 position_in_buffer = position - delayed_start;
+        size_t chunk_size = position_in_buffer < max_delayed_allocation_size ? min<u64>(count - nwritten, max_delayed_allocation_size - position_in_buffer) : 0;
+        u64 new_delayed_size = max(m_delayed_size, position_in_buffer + chunk_size);
+        if (chunk_size == 0)
+            new_delayed_size = max_delayed_allocation_size;
+
+        // Without the memory to hold more of it, the rest of the data is left to be written out right away.
+        // The buffer has to cover the whole last block, as it gets written out in blocks.
+        if (ensure_delayed_data_capacity(round_up_to_power_of_two(new_delayed_size, block_size)).is_error())
+            break;
+
+        // Make sure there will be room on disk for the data when it's written back, including the blocks that point to it.
+        size_t entries_per_block = EXT2_ADDR_PER_BLOCK(&fs().super_block());
+        size_t data_blocks = ceil_div(new_delayed_size, block_size);
+        size_t blocks_to_reserve = data_blocks + ceil_div(data_blocks, entries_per_block) + 2;
+        if (blocks_to_reserve > m_reserved_block_count) {
+            TRY(fs().reserve_blocks(blocks_to_reserve - m_reserved_block_count));
+            m_reserved_block_count = blocks_to_reserve;
+        }
+
+        // Anything between the end of the file and where the write begins reads as zeroes.
+        if (position_in_buffer > m_delayed_size)
+            memset(m_delayed_data->data() + m_delayed_size, 0, min<u64>(position_in_buffer, max_delayed_allocation_size) - m_delayed_size);
+        if (chunk_size > 0)
+            TRY(data.read(m_delayed_data->data() + position_in_buffer, nwritten, chunk_size));
+        m_delayed_size = new_delayed_size;
+        nwritten += chunk_size;
+        set_metadata_dirty(true);
+
+        // Once the buffer is full, its data gets blocks and the buffer moves on to what comes after it.
+        if (m_delayed_size == max_delayed_allocation_size)
+            TRY(allocate_delayed_blocks());
+    }
+    return nwritten;
+}
+
+ErrorOr<void> Ext2FSInode::allocate_delayed_blocks()
+{
+    VERIFY(m_inode_lock.is_locked());
+    if (m_delayed_size == 0)
+        return {};
+
+    u64 block_size = fs().logical_block_size();
+    auto const delayed_start = size_on_disk();
+    size_t block_count = ceil_div(m_delayed_size, block_size);
+
+    if (m_block_list.is_empty())
+        m_block_list = TRY(compute_block_list());
+    auto const original_block_list_size = m_block_list.size();
+    auto const original_raw_inode = m_raw_inode;
+
+    // The blocks set aside for this data are about to be allocated for real.
+    auto const reserved_block_count = exchange(m_reserved_block_count, 0);
+    fs().unreserve_blocks(reserved_block_count);
+
+    // If the data can't be written back, everything goes back to how it was. The data stays in memory,
+    // and writing it back is tried again later.
+    Vector<Ext2FS::BlockIndex> blocks;
+    ArmedScopeGuard undo_on_failure([&] {
+        for (auto block : blocks)
+            (void)fs().set_block_allocation_state(block, false);
+        m_block_list.shrink(original_block_list_size);
+        m_raw_inode = original_raw_inode;
+        if (!fs().reserve_blocks(reserved_block_count).is_error())
+            m_reserved_block_count = reserved_block_count;
+    });
+
+    // NOTE: Holes at the end of the file are missing from the computed block list.
+    while (m_block_list.size() < delayed_start / block_size)
+        TRY(m_block_list.try_append(0));
+
+    // Continue right after the last block of the file, so it stays contiguous on disk.
+    Ext2FS::BlockIndex goal = 0;
+    if (!m_block_list.is_empty() && m_block_list.last().value() != 0)
+        goal = m_block_list.last().value() + 1;
+    blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), block_count, goal));
+    auto first_new_block = m_block_list.size();
+    TRY(m_block_list.try_extend(blocks));
+
+    // The new blocks are written in runs of those that ended up next to each other.
+    memset(m_delayed_data->data() + m_delayed_size, 0, block_count * block_size - m_delayed_size);
+    for (size_t i = 0; i < block_count;) {
+        auto first_block = m_block_list[first_new_block + i];
+        size_t run_length = 1;
+        while (i + run_length < block_count && m_block_list[first_new_block + i + run_length].value() == first_block.value() + run_length)
+            ++run_length;
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(m_delayed_data->data() + i * block_size);
+        TRY(fs().write_blocks(first_block, run_length, buffer));
+        i += run_length;
+    }
+
+    // Only once the data is in its blocks does anything on disk point at them.
+    TRY(flush_block_list());
+    auto new_size = delayed_start + m_delayed_size;
+    m_raw_inode.i_size = new_size;
+    m_raw_inode.i_dir_acl = new_size >> 32;
+    TRY(fs().write_ext2_inode(index(), m_raw_inode));
+
+    undo_on_failure.disarm();
+    m_delayed_size = 0;
+    set_metadata_dirty(true);
+    return {};
+}
+
 ErrorOr<void> Ext2FSInode::traverse_as_directory(Function<ErrorOr<void>(FileSystem::DirectoryEntryView const&)> callback) const
 {
     MutexLocker locker(m_inode_lock);
@@ -764,6 +1281,7 @@ ErrorOr<void> Ext2FSInode::traverse_as_directory(Function<ErrorOr<void>(FileSyst
 ErrorOr<void> Ext2FSInode::write_directory(Vector<Ext2FSDirectoryEntry>& entries)
 {
     MutexLocker locker(m_inode_lock);
+    TRY(ensure_extent_tree_is_writable());
     auto block_size = fs().logical_block_size();
 
     // Calculate directory size and record length of entries so that
@@ -1067,6 +1585,8 @@ ErrorOr<void> Ext2FSInode::chown(UserID uid, GroupID gid)
 ErrorOr<void> Ext2FSInode::truncate(u64 size)
 {
     MutexLocker locker(m_inode_lock);
+    TRY(ensure_extent_tree_is_writable());
+    TRY(allocate_delayed_blocks());
     if (static_cast<u64>(m_raw_inode.i_size) == size)
         return {};
     TRY(resize(size));
@@ -1077,6 +1597,7 @@ ErrorOr<void> Ext2FSInode::truncate(u64 size)
 ErrorOr<int> Ext2FSInode::get_block_address(int index)
 {
     MutexLocker locker(m_inode_lock);
+    TRY(allocate_delayed_blocks());
 
     if (m_block_list.is_empty())
         m_block_list = TRY(compute_block_list());
@@ -24,10 +24,12 @@ public:
     u64 size() const;
     bool is_symlink() const { return Kernel::is_symlink(m_raw_inode.i_mode); }
     bool is_directory() const { return Kernel::is_directory(m_raw_inode.i_mode); }
+    bool uses_extents() const { return m_raw_inode.i_flags & EXT4_EXTENTS_FL; }
 
 private:
     // ^Inode
     virtual ErrorOr<size_t> read_bytes_locked(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const override;
+    virtual void readahead(u64, size_t) override;
     virtual InodeMetadata metadata() const override;
     virtual ErrorOr<void> traverse_as_directory(Function<ErrorOr<void>(FileSystem::DirectoryEntryView const&)>) const override;
     virtual ErrorOr<NonnullRefPtr<Inode>> lookup(StringView name) override;
@@ -54,12 +56,24 @@ private:
     ErrorOr<void> grow_triply_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, Span<BlockBasedFileSystem::BlockIndex>, Vector<BlockBasedFileSystem::BlockIndex>&, unsigned&);
     ErrorOr<void> shrink_triply_indirect_block(BlockBasedFileSystem::BlockIndex, size_t, size_t, unsigned&);
     ErrorOr<void> flush_block_list();
+    ErrorOr<void> flush_extent_tree();
+
+    ErrorOr<size_t> write_bytes_to_blocks(off_t offset, size_t count, UserOrKernelBuffer const& data, bool allow_cache);
+    ErrorOr<void> ensure_delayed_data_capacity(size_t);
+    void release_delayed_data();
+    ErrorOr<size_t> write_delayed(u64 offset, size_t count, UserOrKernelBuffer const& data);
+    ErrorOr<void> allocate_delayed_blocks();
+    u64 size_on_disk() const;
 
     ErrorOr<void> compute_block_list_with_exclusive_locking();
+    ErrorOr<void> read_ahead(u64 offset, size_t size);
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list() const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list_with_meta_blocks() const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list_impl(bool include_block_list_blocks) const;
     ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list_impl_internal(ext2_inode const&, bool include_block_list_blocks) const;
+    ErrorOr<void> walk_extent_tree(ReadonlyBytes node, Vector<BlockBasedFileSystem::BlockIndex>& block_list, Vector<BlockBasedFileSystem::BlockIndex>* tree_blocks, Vector<ext3_extent>* uninitialized_extents) const;
+    ErrorOr<void> ensure_extent_tree_is_writable();
+    ErrorOr<void> collect_extent_tree_blocks(ReadonlyBytes node, Vector<BlockBasedFileSystem::BlockIndex>& tree_blocks) const;
 
     Ext2FS& fs();
     Ext2FS const& fs() const;
@@ -68,6 +82,13 @@ private:
     Vector<BlockBasedFileSystem::BlockIndex> m_block_list;
     HashMap<NonnullOwnPtr<KString>, InodeIndex> m_lookup_cache;
     ext2_inode m_raw_inode {};
+    // Whether the extent tree has uninitialized extents, which we can't write back. Only known once a write needed it.
+    Optional<bool> m_has_uninitialized_extents;
+
+    // Data written past the blocks that are on disk, which doesn't get blocks of its own until it's written back.
+    OwnPtr<KBuffer> m_delayed_data;
+    u64 m_delayed_size { 0 };
+    size_t m_reserved_block_count { 0 };
 
     Mutex m_block_list_lock { "BlockList"sv };
 };
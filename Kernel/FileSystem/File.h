@@ -10,6 +10,7 @@
 #include <AK/Error.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
+#include <Kernel/FileSystem/EventPollInterest.h>
 #include <Kernel/Forward.h>
 #include <Kernel/Library/LockWeakable.h>
 #include <Kernel/Library/NonnullLockRefPtr.h>
@@ -40,7 +41,37 @@ public:
             auto& blocker = static_cast<Thread::FileBlocker&>(b);
             return blocker.unblock_if_conditions_are_met(false, data);
         });
+        for (auto& interest : m_event_poll_interests)
+            interest.file_state_changed({});
     }
+
+    void add_event_poll_interest(EventPollInterest& interest)
+    {
+        SpinlockLocker lock(m_lock);
+        m_event_poll_interests.append(interest);
+    }
+
+    void remove_event_poll_interest(EventPollInterest& interest)
+    {
+        SpinlockLocker lock(m_lock);
+        if (m_event_poll_interests.contains(interest))
+            m_event_poll_interests.remove(interest);
+    }
+
+    RefPtr<EventPollInterest> take_any_event_poll_interest_in(OpenFileDescription const& description)
+    {
+        SpinlockLocker lock(m_lock);
+        for (auto& interest : m_event_poll_interests) {
+            if (&interest.description() != &description)
+                continue;
+            m_event_poll_interests.remove(interest);
+            return interest;
+        }
+        return nullptr;
+    }
+
+private:
+    EventPollInterest::FileList m_event_poll_interests;
 };
 
 // File is the base class for anything that can be referenced by a OpenFileDescription.
@@ -114,6 +145,7 @@ public:
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
     virtual bool is_inode_watcher() const { return false; }
+    virtual bool is_event_poll() const { return false; }
     virtual bool is_mount_file() const { return false; }
 
     virtual bool is_regular_file() const { return false; }
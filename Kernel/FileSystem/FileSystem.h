@@ -53,6 +53,9 @@ public:
 
     virtual ErrorOr<void> flush_writes() { return {}; }
 
+    // Gives up to the given number of bytes of cache memory back to the system, and returns how much it actually gave back.
+    virtual size_t release_cache_memory(size_t) { return 0; }
+
     u64 logical_block_size() const { return m_logical_block_size; }
     size_t fragment_size() const { return m_fragment_size; }
 
@@ -56,6 +56,8 @@ public:
     ErrorOr<size_t> write_bytes(off_t, size_t, UserOrKernelBuffer const& data, OpenFileDescription*);
     ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const;
     ErrorOr<size_t> read_until_filled_or_end(off_t, size_t, UserOrKernelBuffer buffer, OpenFileDescription*) const;
+    // Starts reading the given range into the file system's cache in the background, as it is likely to be read soon.
+    virtual void readahead(u64, size_t) { }
 
     virtual ErrorOr<void> attach(OpenFileDescription&) { return {}; }
     virtual void detach(OpenFileDescription&) { }
@@ -94,7 +96,7 @@ public:
     LockRefPtr<Memory::SharedInodeVMObject> shared_vmobject() const;
 
     static void sync_all();
-    void sync();
+    ErrorOr<void> sync();
 
     bool has_watchers() const;
 
@@ -31,6 +31,8 @@ ErrorOr<size_t> InodeFile::read(OpenFileDescription& description, u64 offset, Us
 
     auto nread = TRY(m_inode->read_bytes(offset, count, buffer, &description));
     if (nread > 0) {
+        if (auto readahead = description.did_read(offset, nread); readahead.has_value())
+            m_inode->readahead(readahead->offset, readahead->size);
         Thread::current()->did_file_read(nread);
         evaluate_block_conditions();
     }
@@ -102,8 +104,7 @@ ErrorOr<void> InodeFile::truncate(u64 size)
 
 ErrorOr<void> InodeFile::sync()
 {
-    m_inode->sync();
-    return {};
+    return m_inode->sync();
 }
 
 ErrorOr<void> InodeFile::chown(Credentials const& credentials, OpenFileDescription& description, UserID uid, GroupID gid)
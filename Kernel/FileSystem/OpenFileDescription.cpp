@@ -11,6 +11,7 @@
 #include <Kernel/Devices/TTY/MasterPTY.h>
 #include <Kernel/Devices/TTY/TTY.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/EventPoll.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
@@ -53,6 +54,7 @@ OpenFileDescription::OpenFileDescription(File& file)
 
 OpenFileDescription::~OpenFileDescription()
 {
+    EventPoll::remove_interests_in_description({}, *this);
     m_file->detach(*this);
     // FIXME: Should this error path be observed somehow?
     (void)m_file->close();
@@ -191,6 +193,40 @@ ErrorOr<size_t> OpenFileDescription::write(UserOrKernelBuffer const& data, size_
     return nwritten;
 }
 
+// The readahead window starts out small, and doubles for every readahead as long as the reads stay sequential.
+static constexpr size_t initial_readahead_window = 32 * KiB;
+static constexpr size_t max_readahead_window = 512 * KiB;
+
+Optional<OpenFileDescription::ReadaheadRange> OpenFileDescription::did_read(u64 offset, size_t nread)
+{
+    return m_state.with([&](auto& state) -> Optional<ReadaheadRange> {
+        if (state.direct || nread == 0)
+            return {};
+
+        u64 end_of_read = offset + nread;
+        bool is_sequential = offset == state.sequential_read_offset;
+        state.sequential_read_offset = end_of_read;
+        if (!is_sequential) {
+            state.readahead_window = 0;
+            state.readahead_end = 0;
+            return {};
+        }
+
+        if (state.readahead_window == 0) {
+            state.readahead_window = clamp(round_up_to_power_of_two(nread * 2, PAGE_SIZE), initial_readahead_window, max_readahead_window);
+            state.readahead_end = end_of_read;
+        }
+        // Read ahead once less than half of the window is left, so the next batch arrives before the reader needs it.
+        if (state.readahead_end >= end_of_read + state.readahead_window / 2)
+            return {};
+
+        ReadaheadRange range { max(state.readahead_end, end_of_read), state.readahead_window };
+        state.readahead_end = range.offset + range.size;
+        state.readahead_window = min(state.readahead_window * 2, max_readahead_window);
+        return range;
+    });
+}
+
 bool OpenFileDescription::can_write() const
 {
     return m_file->can_write(*this, offset());
@@ -314,6 +350,25 @@ InodeWatcher* OpenFileDescription::inode_watcher()
     return static_cast<InodeWatcher*>(m_file.ptr());
 }
 
+bool OpenFileDescription::is_event_poll() const
+{
+    return m_file->is_event_poll();
+}
+
+EventPoll const* OpenFileDescription::event_poll() const
+{
+    if (!is_event_poll())
+        return nullptr;
+    return static_cast<EventPoll const*>(m_file.ptr());
+}
+
+EventPoll* OpenFileDescription::event_poll()
+{
+    if (!is_event_poll())
+        return nullptr;
+    return static_cast<EventPoll*>(m_file.ptr());
+}
+
 bool OpenFileDescription::is_mount_file() const
 {
     return m_file->is_mount_file();
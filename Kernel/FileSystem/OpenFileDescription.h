@@ -80,6 +80,10 @@ public:
     InodeWatcher const* inode_watcher() const;
     InodeWatcher* inode_watcher();
 
+    bool is_event_poll() const;
+    EventPoll const* event_poll() const;
+    EventPoll* event_poll();
+
     bool is_mount_file() const;
     MountFile const* mount_file() const;
     MountFile* mount_file();
@@ -131,6 +135,14 @@ public:
     ErrorOr<void> apply_flock(Process const&, Userspace<flock const*>, ShouldBlock);
     ErrorOr<void> get_flock(Userspace<flock*>) const;
 
+    struct ReadaheadRange {
+        u64 offset { 0 };
+        size_t size { 0 };
+    };
+    // Keeps track of whether the file is being read sequentially through this description,
+    // and returns what should be read ahead of the reader if the readahead window is running low.
+    Optional<ReadaheadRange> did_read(u64 offset, size_t nread);
+
 private:
     friend class VirtualFileSystem;
     explicit OpenFileDescription(File&);
@@ -157,6 +169,10 @@ private:
         bool should_append : 1 { false };
         bool direct : 1 { false };
         FIFO::Direction fifo_direction : 2 { FIFO::Direction::Neither };
+        // Where the next read has to start to count as sequential, and how far ahead of it was already read.
+        u64 sequential_read_offset { 0 };
+        u64 readahead_end { 0 };
+        size_t readahead_window { 0 };
     };
 
     SpinlockProtected<State, LockRank::None> m_state {};
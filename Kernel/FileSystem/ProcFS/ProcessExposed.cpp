@@ -326,6 +326,8 @@ ErrorOr<void> Process::procfs_get_virtual_memory_stats(KBufferBuilder& builder)
                     pagemap_builder.append('N');
                 else if (page->is_shared_zero_page() || page->is_lazy_committed_page())
                     pagemap_builder.append('Z');
+                else if (page->is_compressed_page())
+                    pagemap_builder.append('C');
                 else
                     pagemap_builder.append('P');
             }
@@ -11,6 +11,10 @@
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/CoredumpDirectory.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/Directory.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/DumpKmallocStack.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/LockContentionProfiling.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/LoopbackPacketLoss.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/SimulateMemoryPressure.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/TCPCongestionControl.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/UBSANDeadly.h>
 
 namespace Kernel {
@@ -23,6 +27,10 @@ UNMAP_AFTER_INIT NonnullRefPtr<SysFSKernelConfigurationDirectory> SysFSKernelCon
         list.append(SysFSDumpKmallocStacks::must_create(*global_variables_directory));
         list.append(SysFSUBSANDeadly::must_create(*global_variables_directory));
         list.append(SysFSCoredumpDirectory::must_create(*global_variables_directory));
+        list.append(SysFSTCPCongestionControl::must_create(*global_variables_directory));
+        list.append(SysFSLoopbackPacketLoss::must_create(*global_variables_directory));
+        list.append(SysFSLockContentionProfiling::must_create(*global_variables_directory));
+        list.append(SysFSSimulateMemoryPressure::must_create(*global_variables_directory));
         return {};
     }));
     return global_variables_directory;
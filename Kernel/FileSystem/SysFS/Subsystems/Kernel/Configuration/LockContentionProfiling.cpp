@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/LockContentionProfiling.h>
+#include <Kernel/Locking/LockContentionProfiler.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSLockContentionProfiling::SysFSLockContentionProfiling(SysFSDirectory const& parent_directory)
+    : SysFSSystemBooleanVariable(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSLockContentionProfiling> SysFSLockContentionProfiling::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSLockContentionProfiling(parent_directory)).release_nonnull();
+}
+
+bool SysFSLockContentionProfiling::value() const
+{
+    return LockContentionProfiler::is_enabled();
+}
+
+void SysFSLockContentionProfiling::set_value(bool new_value)
+{
+    LockContentionProfiler::set_enabled(new_value);
+}
+
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/LoopbackPacketLoss.h>
+#include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSLoopbackPacketLoss::SysFSLoopbackPacketLoss(SysFSDirectory const& parent_directory)
+    : SysFSSystemStringVariable(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSLoopbackPacketLoss> SysFSLoopbackPacketLoss::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSLoopbackPacketLoss(parent_directory)).release_nonnull();
+}
+
+ErrorOr<NonnullOwnPtr<KString>> SysFSLoopbackPacketLoss::value() const
+{
+    return KString::formatted("{}", LoopbackAdapter::packet_loss_percentage());
+}
+
+void SysFSLoopbackPacketLoss::set_value(NonnullOwnPtr<KString> new_value)
+{
+    auto percentage = new_value->view().to_number<u32>();
+    if (!percentage.has_value() || percentage.value() > 100) {
+        dbgln("SysFSLoopbackPacketLoss: Invalid packet loss percentage '{}'", new_value->view());
+        return;
+    }
+    LoopbackAdapter::set_packet_loss_percentage(percentage.value());
+}
+
+mode_t SysFSLoopbackPacketLoss::permissions() const
+{
+    // NOTE: Dropping packets on purpose is only meant for testing, so only the root user may turn it on.
+    return S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+}
+
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/SimulateMemoryPressure.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/SyncTask.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSSimulateMemoryPressure::SysFSSimulateMemoryPressure(SysFSDirectory const& parent_directory)
+    : SysFSSystemBooleanVariable(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSSimulateMemoryPressure> SysFSSimulateMemoryPressure::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSSimulateMemoryPressure(parent_directory)).release_nonnull();
+}
+
+bool SysFSSimulateMemoryPressure::value() const
+{
+    return SyncTask::is_simulating_memory_pressure();
+}
+
+void SysFSSimulateMemoryPressure::set_value(bool new_value)
+{
+    SyncTask::set_simulating_memory_pressure(new_value);
+}
+
+}
@@ -17,6 +17,8 @@
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Interrupts.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Jails.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Keymap.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/KmallocSlabs.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/LockContention.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Log.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/MemoryStatus.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Directory.h>
@@ -35,6 +37,8 @@ UNMAP_AFTER_INIT NonnullRefPtr<SysFSGlobalKernelStatsDirectory> SysFSGlobalKerne
     MUST(global_kernel_stats_directory->m_child_components.with([&](auto& list) -> ErrorOr<void> {
         list.append(SysFSDiskUsage::must_create(*global_kernel_stats_directory));
         list.append(SysFSMemoryStatus::must_create(*global_kernel_stats_directory));
+        list.append(SysFSKmallocSlabs::must_create(*global_kernel_stats_directory));
+        list.append(SysFSLockContention::must_create(*global_kernel_stats_directory));
         list.append(SysFSSystemStatistics::must_create(*global_kernel_stats_directory));
         list.append(SysFSOverallProcesses::must_create(*global_kernel_stats_directory));
         list.append(SysFSCPUInformation::must_create(*global_kernel_stats_directory));
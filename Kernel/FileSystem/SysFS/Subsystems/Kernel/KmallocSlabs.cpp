@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/KmallocSlabs.h>
+#include <Kernel/Heap/kmalloc.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSKmallocSlabs::SysFSKmallocSlabs(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSKmallocSlabs> SysFSKmallocSlabs::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSKmallocSlabs(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSKmallocSlabs::try_generate(KBufferBuilder& builder)
+{
+    // NOTE: We copy the statistics out first, as generating JSON will allocate from the very heaps we're looking at.
+    kmalloc_slabheap_stats stats[16];
+    auto count = get_kmalloc_slabheap_stats(stats, array_size(stats));
+
+    auto array = TRY(JsonArraySerializer<>::try_create(builder));
+    for (size_t i = 0; i < count; ++i) {
+        auto& slabheap = stats[i];
+        auto obj = TRY(array.add_object());
+        TRY(obj.add("slab_size"sv, slabheap.slab_size));
+        TRY(obj.add("block_count"sv, slabheap.block_count));
+        TRY(obj.add("allocated"sv, slabheap.bytes_allocated));
+        TRY(obj.add("available"sv, slabheap.bytes_free));
+        TRY(obj.add("in_magazines"sv, slabheap.bytes_in_magazines));
+        TRY(obj.add("slab_allocation_count"sv, slabheap.slab_allocation_count));
+        TRY(obj.add("magazine_hit_count"sv, slabheap.magazine_hit_count));
+        TRY(obj.finish());
+    }
+    TRY(array.finish());
+    return {};
+}
+
+}
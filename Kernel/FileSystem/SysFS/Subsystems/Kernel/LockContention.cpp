@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/LockContention.h>
+#include <Kernel/KSyms.h>
+#include <Kernel/Locking/LockContentionProfiler.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSLockContention::SysFSLockContention(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSLockContention> SysFSLockContention::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSLockContention(parent_directory)).release_nonnull();
+}
+
+mode_t SysFSLockContention::permissions() const
+{
+    // This gives away kernel addresses.
+    return S_IRUSR;
+}
+
+ErrorOr<void> SysFSLockContention::try_generate(KBufferBuilder& builder)
+{
+    // NOTE: We copy the statistics out first, as generating JSON takes Mutexes itself.
+    auto statistics = TRY(LockContentionProfiler::statistics());
+
+    auto array = TRY(JsonArraySerializer<>::try_create(builder));
+    for (auto& call_site : statistics) {
+        auto obj = TRY(array.add_object());
+        TRY(obj.add("lock"sv, StringView { call_site.lock_name, strlen(call_site.lock_name) }));
+        TRY(obj.add("call_site"sv, call_site.call_site));
+        auto const* symbol = symbolicate_kernel_address(call_site.call_site);
+        if (symbol) {
+            auto symbol_name = TRY(KString::formatted("{}+{:#x}", symbol->name, call_site.call_site - symbol->address));
+            TRY(obj.add("symbol"sv, symbol_name->view()));
+        } else {
+            TRY(obj.add("symbol"sv, ""sv));
+        }
+        TRY(obj.add("acquisitions"sv, call_site.acquisitions));
+        TRY(obj.add("contentions"sv, call_site.contentions));
+        TRY(obj.add("blocked_acquisitions"sv, call_site.blocked_acquisitions));
+        TRY(obj.add("total_wait_time_ns"sv, call_site.total_wait_time_ns));
+        TRY(obj.add("max_wait_time_ns"sv, call_site.max_wait_time_ns));
+        TRY(obj.add("exclusive_releases"sv, call_site.exclusive_releases));
+        TRY(obj.add("total_hold_time_ns"sv, call_site.total_hold_time_ns));
+        TRY(obj.add("max_hold_time_ns"sv, call_site.max_hold_time_ns));
+        TRY(obj.finish());
+    }
+    TRY(array.finish());
+    return {};
+}
+
+}
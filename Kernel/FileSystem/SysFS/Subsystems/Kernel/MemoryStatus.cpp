@@ -6,6 +6,8 @@
 
 #include <AK/JsonObjectSerializer.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/MemoryStatus.h>
+#include <Kernel/Memory/CompressedPageStore.h>
+#include <Kernel/Memory/InodeVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Sections.h>
 
@@ -28,6 +30,17 @@ ErrorOr<void> SysFSMemoryStatus::try_generate(KBufferBuilder& builder)
 
     auto system_memory = MM.get_system_memory_info();
 
+    size_t page_cache_pages = 0;
+    size_t page_cache_active_pages = 0;
+    Memory::MemoryManager::for_each_vmobject([&](Memory::VMObject& vmobject) {
+        if (!vmobject.is_inode())
+            return;
+        auto& inode_vmobject = static_cast<Memory::InodeVMObject&>(vmobject);
+        page_cache_pages += inode_vmobject.amount_clean() / PAGE_SIZE;
+        page_cache_active_pages += inode_vmobject.active_page_count();
+    });
+    auto page_cache_statistics = Memory::InodeVMObject::page_cache_statistics();
+
     auto json = TRY(JsonObjectSerializer<>::try_create(builder));
     TRY(json.add("kmalloc_allocated"sv, stats.bytes_allocated));
     TRY(json.add("kmalloc_available"sv, stats.bytes_free));
@@ -35,6 +48,17 @@ ErrorOr<void> SysFSMemoryStatus::try_generate(KBufferBuilder& builder)
     TRY(json.add("physical_available"sv, system_memory.physical_pages - system_memory.physical_pages_used));
     TRY(json.add("physical_committed"sv, system_memory.physical_pages_committed));
     TRY(json.add("physical_uncommitted"sv, system_memory.physical_pages_uncommitted));
+    auto& compressed_page_store = Memory::CompressedPageStore::the();
+    TRY(json.add("compressed_pages"sv, compressed_page_store.stored_page_count()));
+    TRY(json.add("compressed_bytes"sv, compressed_page_store.stored_bytes()));
+    TRY(json.add("compressed_storage_pages"sv, compressed_page_store.storage_page_count()));
+    TRY(json.add("page_cache_active"sv, page_cache_active_pages));
+    TRY(json.add("page_cache_inactive"sv, page_cache_pages - min(page_cache_pages, page_cache_active_pages)));
+    TRY(json.add("page_cache_hits"sv, page_cache_statistics.hits));
+    TRY(json.add("page_cache_misses"sv, page_cache_statistics.misses));
+    TRY(json.add("page_cache_activations"sv, page_cache_statistics.activations));
+    TRY(json.add("page_cache_deactivations"sv, page_cache_statistics.deactivations));
+    TRY(json.add("page_cache_reclaimed"sv, page_cache_statistics.reclaimed_pages));
     TRY(json.add("kmalloc_call_count"sv, stats.kmalloc_call_count));
     TRY(json.add("kfree_call_count"sv, stats.kfree_call_count));
     TRY(json.finish());
@@ -44,6 +44,8 @@ ErrorOr<void> SysFSNetworkAdaptersStats::try_generate(KBufferBuilder& builder)
         TRY(obj.add("link_speed"sv, adapter.link_speed()));
         TRY(obj.add("link_full_duplex"sv, adapter.link_full_duplex()));
         TRY(obj.add("mtu"sv, adapter.mtu()));
+        TRY(obj.add("checksum_offload"sv, adapter.has_offload(NetworkAdapter::Offload::TransmitChecksum)));
+        TRY(obj.add("segmentation_offload"sv, adapter.has_offload(NetworkAdapter::Offload::TCPSegmentation)));
         TRY(obj.finish());
         return {};
     }));
@@ -11,6 +11,7 @@
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Adapters.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Directory.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Local.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/ReceiveQueues.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Route.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/TCP.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/UDP.h>
@@ -23,6 +24,7 @@ UNMAP_AFTER_INIT NonnullRefPtr<SysFSGlobalNetworkStatsDirectory> SysFSGlobalNetw
     MUST(global_network_stats_directory->m_child_components.with([&](auto& list) -> ErrorOr<void> {
         list.append(SysFSNetworkAdaptersStats::must_create(*global_network_stats_directory));
         list.append(SysFSNetworkARPStats::must_create(*global_network_stats_directory));
+        list.append(SysFSNetworkReceiveQueuesStats::must_create(*global_network_stats_directory));
         list.append(SysFSNetworkRouteStats::must_create(*global_network_stats_directory));
         list.append(SysFSNetworkTCPStats::must_create(*global_network_stats_directory));
         list.append(SysFSLocalNetStats::must_create(*global_network_stats_directory));
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/ReceiveQueues.h>
+#include <Kernel/Net/NetworkTask.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSNetworkReceiveQueuesStats::SysFSNetworkReceiveQueuesStats(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSNetworkReceiveQueuesStats> SysFSNetworkReceiveQueuesStats::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSNetworkReceiveQueuesStats(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSNetworkReceiveQueuesStats::try_generate(KBufferBuilder& builder)
+{
+    auto array = TRY(JsonArraySerializer<>::try_create(builder));
+    TRY(NetworkTask::try_for_each_receive_queue([&array](auto& statistics) -> ErrorOr<void> {
+        auto obj = TRY(array.add_object());
+        TRY(obj.add("processor"sv, statistics.processor));
+        TRY(obj.add("packets"sv, statistics.packets));
+        TRY(obj.add("bytes"sv, statistics.bytes));
+        TRY(obj.add("dropped_packets"sv, statistics.dropped_packets));
+        TRY(obj.add("queued_packets"sv, statistics.queued_packets));
+        TRY(obj.add("max_queued_packets"sv, statistics.max_queued_packets));
+        TRY(obj.finish());
+        return {};
+    }));
+    TRY(array.finish());
+    return {};
+}
+
+}
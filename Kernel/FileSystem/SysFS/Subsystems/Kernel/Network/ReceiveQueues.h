@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/GlobalInformation.h>
+#include <Kernel/Library/KBufferBuilder.h>
+#include <Kernel/Library/UserOrKernelBuffer.h>
+
+namespace Kernel {
+
+class SysFSNetworkReceiveQueuesStats final : public SysFSGlobalInformation {
+public:
+    virtual StringView name() const override { return "receive_queues"sv; }
+    static NonnullRefPtr<SysFSNetworkReceiveQueuesStats> must_create(SysFSDirectory const&);
+
+private:
+    explicit SysFSNetworkReceiveQueuesStats(SysFSDirectory const&);
+    virtual ErrorOr<void> try_generate(KBufferBuilder& builder) override;
+};
+
+}
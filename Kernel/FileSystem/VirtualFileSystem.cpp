@@ -267,6 +267,21 @@ void VirtualFileSystem::sync_filesystems()
     }
 }
 
+void VirtualFileSystem::release_cache_memory_of_filesystems(size_t size)
+{
+    Vector<NonnullRefPtr<FileSystem>, 32> file_systems;
+    m_file_systems_list.with([&](auto const& list) {
+        for (auto& fs : list)
+            file_systems.append(fs);
+    });
+
+    for (auto& fs : file_systems) {
+        if (size == 0)
+            break;
+        size -= min(size, fs->release_cache_memory(size));
+    }
+}
+
 void VirtualFileSystem::lock_all_filesystems()
 {
     Vector<NonnullRefPtr<FileSystem>, 32> file_systems;
@@ -21,6 +21,8 @@ class Custody;
 class Device;
 class DiskCache;
 class DoubleBuffer;
+class EventPoll;
+class EventPollInterest;
 class File;
 class FATInode;
 class OpenFileDescription;
@@ -10,8 +10,10 @@
 #include <Kernel/Debug.h>
 #include <Kernel/Heap/Heap.h>
 #include <Kernel/Heap/kmalloc.h>
+#include <Kernel/Interrupts/InterruptDisabler.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Library/Panic.h>
+#include <Kernel/Library/ScopedCritical.h>
 #include <Kernel/Library/StdLib.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/MemoryManager.h>
@@ -96,6 +98,8 @@ public:
         return (m_slab_count - m_allocated_slabs) * m_slab_size;
     }
 
+    size_t slab_size() const { return m_slab_size; }
+
     IntrusiveListNode<KmallocSlabBlock> list_node;
     using List = IntrusiveList<&KmallocSlabBlock::list_node>;
 
@@ -123,6 +127,15 @@ public:
     size_t slab_size() const { return m_slab_size; }
 
     void* allocate(CallerWillInitializeMemory caller_will_initialize_memory)
+    {
+        auto* ptr = allocate_without_scrubbing();
+        if (ptr && caller_will_initialize_memory == CallerWillInitializeMemory::No) {
+            memset(ptr, KMALLOC_SCRUB_BYTE, m_slab_size);
+        }
+        return ptr;
+    }
+
+    void* allocate_without_scrubbing()
     {
         if (m_usable_blocks.is_empty()) {
             // FIXME: This allocation wastes `block_size` bytes due to the implementation of kmalloc_aligned().
@@ -134,22 +147,24 @@ public:
             }
             auto* block = new (slot) KmallocSlabBlock(m_slab_size);
             m_usable_blocks.append(*block);
+            ++m_block_count;
         }
         auto* block = m_usable_blocks.first();
         auto* ptr = block->allocate();
         if (block->is_full())
             m_full_blocks.append(*block);
-
-        if (caller_will_initialize_memory == CallerWillInitializeMemory::No) {
-            memset(ptr, KMALLOC_SCRUB_BYTE, m_slab_size);
-        }
+        ++m_allocation_count;
         return ptr;
     }
 
     void deallocate(void* ptr)
     {
         memset(ptr, KFREE_SCRUB_BYTE, m_slab_size);
+        deallocate_without_scrubbing(ptr);
+    }
 
+    void deallocate_without_scrubbing(void* ptr)
+    {
         auto* block = (KmallocSlabBlock*)((FlatPtr)ptr & KmallocSlabBlock::block_mask);
         bool block_was_full = block->is_full();
         block->deallocate(ptr);
@@ -192,14 +207,20 @@ public:
             block_to_remove.list_node.remove();
             block_to_remove.~KmallocSlabBlock();
             kfree_sized(&block_to_remove, KmallocSlabBlock::block_size);
+            --m_block_count;
 
             did_purge = true;
         }
         return did_purge;
     }
 
+    size_t block_count() const { return m_block_count; }
+    size_t allocation_count() const { return m_allocation_count; }
+
 private:
     size_t m_slab_size { 0 };
+    size_t m_block_count { 0 };
+    size_t m_allocation_count { 0 };
 
     KmallocSlabBlock::List m_usable_blocks;
     KmallocSlabBlock::List m_full_blocks;
@@ -221,6 +242,31 @@ struct KmallocGlobalData {
         subheaps.append(*subheap);
     }
 
+    static constexpr size_t slabheap_count = 6;
+
+    Optional<size_t> slabheap_index_for_allocation(size_t size, size_t alignment) const
+    {
+        for (size_t i = 0; i < slabheap_count; ++i) {
+            if (size <= slabheaps[i].slab_size() && alignment <= slabheaps[i].slab_size())
+                return i;
+        }
+        return {};
+    }
+
+    Optional<size_t> slabheap_index_for_slab(void* ptr, size_t size) const
+    {
+        if (size > slabheaps[slabheap_count - 1].slab_size())
+            return {};
+        // NOTE: The slab may have been allocated with a larger alignment than its size,
+        //       so ask the block which slabheap it actually came from.
+        auto* block = (KmallocSlabBlock*)((FlatPtr)ptr & KmallocSlabBlock::block_mask);
+        for (size_t i = 0; i < slabheap_count; ++i) {
+            if (slabheaps[i].slab_size() == block->slab_size())
+                return i;
+        }
+        VERIFY_NOT_REACHED();
+    }
+
     void* allocate(size_t size, size_t alignment, CallerWillInitializeMemory caller_will_initialize_memory)
     {
         VERIFY(!expansion_in_progress);
@@ -394,7 +440,7 @@ struct KmallocGlobalData {
 
     KmallocSubheap::List subheaps;
 
-    KmallocSlabheap slabheaps[6] = { 16, 32, 64, 128, 256, 512 };
+    KmallocSlabheap slabheaps[slabheap_count] = { 16, 32, 64, 128, 256, 512 };
 
     bool expansion_in_progress { false };
 };
@@ -402,14 +448,82 @@ struct KmallocGlobalData {
 READONLY_AFTER_INIT static KmallocGlobalData* g_kmalloc_global;
 alignas(KmallocGlobalData) static u8 g_kmalloc_global_heap[sizeof(KmallocGlobalData)];
 
-static size_t g_kmalloc_call_count;
-static size_t g_kfree_call_count;
+// Every processor keeps a magazine of free slabs for each slabheap. Small allocations and
+// deallocations are served from the current processor's magazine with interrupts disabled,
+// without touching s_lock. Slabs move between magazines and slabheaps in batches.
+static constexpr size_t KMALLOC_MAGAZINE_CAPACITY = 32;
+static constexpr size_t KMALLOC_MAGAZINE_BATCH_SIZE = KMALLOC_MAGAZINE_CAPACITY / 2;
+
+struct KmallocMagazine {
+    bool is_empty() const { return count == 0; }
+    bool is_full() const { return count == KMALLOC_MAGAZINE_CAPACITY; }
+
+    void push(void* ptr)
+    {
+        VERIFY(!is_full());
+        slabs[count++] = ptr;
+    }
+
+    void* pop()
+    {
+        VERIFY(!is_empty());
+        return slabs[--count];
+    }
+
+    size_t count { 0 };
+    size_t hit_count { 0 };
+    void* slabs[KMALLOC_MAGAZINE_CAPACITY];
+};
+
+struct KmallocProcessorData {
+    KmallocMagazine magazines[KmallocGlobalData::slabheap_count];
+    size_t nested_kfree_calls { 0 };
+};
+
+static Array<KmallocProcessorData, MAX_CPU_COUNT> s_processor_data;
+READONLY_AFTER_INIT static bool s_magazines_enabled;
+
+static Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> g_kmalloc_call_count;
+static Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> g_kfree_call_count;
 static size_t g_nested_kfree_calls;
 bool g_dump_kmalloc_stacks;
 
+static bool magazines_are_usable()
+{
+    // Magazines are indexed by processor, which can't be determined during early boot.
+    return s_magazines_enabled && !g_dump_kmalloc_stacks && Processor::is_initialized();
+}
+
+static KmallocMagazine& current_magazine(size_t slabheap_index)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    return s_processor_data[Processor::current_id()].magazines[slabheap_index];
+}
+
+// NOTE: s_lock must be held.
+static void refill_magazine(KmallocMagazine& magazine, size_t slabheap_index)
+{
+    auto& slabheap = g_kmalloc_global->slabheaps[slabheap_index];
+    while (magazine.count < KMALLOC_MAGAZINE_BATCH_SIZE) {
+        auto* ptr = slabheap.allocate_without_scrubbing();
+        if (!ptr)
+            break;
+        magazine.push(ptr);
+    }
+}
+
+// NOTE: s_lock must be held.
+static void drain_magazine(KmallocMagazine& magazine, size_t slabheap_index, size_t slabs_to_keep)
+{
+    auto& slabheap = g_kmalloc_global->slabheaps[slabheap_index];
+    while (magazine.count > slabs_to_keep)
+        slabheap.deallocate_without_scrubbing(magazine.pop());
+}
+
 void kmalloc_enable_expand()
 {
     g_kmalloc_global->enable_expansion();
+    s_magazines_enabled = true;
 }
 
 UNMAP_AFTER_INIT void kmalloc_init()
@@ -421,6 +535,21 @@ UNMAP_AFTER_INIT void kmalloc_init()
     s_lock.initialize();
 }
 
+static void notify_kmalloc(size_t size, void* ptr)
+{
+    ++g_kmalloc_call_count;
+
+    Thread* current_thread = Thread::current();
+    if (!current_thread)
+        current_thread = Processor::idle_thread();
+    if (current_thread) {
+        // FIXME: By the time we check this, we have already allocated above.
+        //        This means that in the case of an infinite recursion, we can't catch it this way.
+        VERIFY(current_thread->is_allocation_enabled());
+        PerformanceManager::add_kmalloc_perf_event(*current_thread, size, (FlatPtr)ptr);
+    }
+}
+
 static void* kmalloc_impl(size_t size, size_t alignment, CallerWillInitializeMemory caller_will_initialize_memory)
 {
     // Catch bad callers allocating under spinlock.
@@ -431,26 +560,53 @@ static void* kmalloc_impl(size_t size, size_t alignment, CallerWillInitializeMem
     // Alignment must be a power of two.
     VERIFY(is_power_of_two(alignment));
 
-    SpinlockLocker lock(s_lock);
-    ++g_kmalloc_call_count;
-
-    if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
-        dbgln("kmalloc({})", size);
-        Kernel::dump_backtrace();
+    Optional<size_t> slabheap_index;
+    if (magazines_are_usable())
+        slabheap_index = g_kmalloc_global->slabheap_index_for_allocation(size, alignment);
+
+    if (slabheap_index.has_value()) {
+        void* ptr = nullptr;
+        {
+            InterruptDisabler disabler;
+            auto& magazine = current_magazine(slabheap_index.value());
+            if (!magazine.is_empty()) {
+                ptr = magazine.pop();
+                ++magazine.hit_count;
+            }
+        }
+        if (ptr) {
+            if (caller_will_initialize_memory == CallerWillInitializeMemory::No)
+                memset(ptr, KMALLOC_SCRUB_BYTE, g_kmalloc_global->slabheaps[slabheap_index.value()].slab_size());
+            notify_kmalloc(size, ptr);
+            return ptr;
+        }
     }
 
-    void* ptr = g_kmalloc_global->allocate(size, alignment, caller_will_initialize_memory);
+    void* ptr = nullptr;
+    {
+        SpinlockLocker lock(s_lock);
 
-    Thread* current_thread = Thread::current();
-    if (!current_thread)
-        current_thread = Processor::idle_thread();
-    if (current_thread) {
-        // FIXME: By the time we check this, we have already allocated above.
-        //        This means that in the case of an infinite recursion, we can't catch it this way.
-        VERIFY(current_thread->is_allocation_enabled());
-        PerformanceManager::add_kmalloc_perf_event(*current_thread, size, (FlatPtr)ptr);
+        if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
+            dbgln("kmalloc({})", size);
+            Kernel::dump_backtrace();
+        }
+
+        if (slabheap_index.has_value()) {
+            // We have the lock anyway, so grab a batch of slabs for the next allocations on this processor.
+            auto& magazine = current_magazine(slabheap_index.value());
+            refill_magazine(magazine, slabheap_index.value());
+            if (!magazine.is_empty()) {
+                ptr = magazine.pop();
+                if (caller_will_initialize_memory == CallerWillInitializeMemory::No)
+                    memset(ptr, KMALLOC_SCRUB_BYTE, g_kmalloc_global->slabheaps[slabheap_index.value()].slab_size());
+            }
+        }
+
+        if (!ptr)
+            ptr = g_kmalloc_global->allocate(size, alignment, caller_will_initialize_memory);
     }
 
+    notify_kmalloc(size, ptr);
     return ptr;
 }
 
@@ -470,6 +626,34 @@ void* kcalloc(size_t count, size_t size)
     return ptr;
 }
 
+static bool try_kfree_into_magazine(void* ptr, size_t size)
+{
+    if (!magazines_are_usable())
+        return false;
+    VERIFY(g_kmalloc_global->is_valid_kmalloc_address(VirtualAddress { ptr }));
+    auto slabheap_index = g_kmalloc_global->slabheap_index_for_slab(ptr, size);
+    if (!slabheap_index.has_value())
+        return false;
+
+    memset(ptr, KFREE_SCRUB_BYTE, g_kmalloc_global->slabheaps[slabheap_index.value()].slab_size());
+
+    {
+        InterruptDisabler disabler;
+        auto& magazine = current_magazine(slabheap_index.value());
+        if (!magazine.is_full()) {
+            magazine.push(ptr);
+            return true;
+        }
+    }
+
+    // The magazine is full, hand half of it back to the slabheap.
+    SpinlockLocker lock(s_lock);
+    auto& magazine = current_magazine(slabheap_index.value());
+    drain_magazine(magazine, slabheap_index.value(), KMALLOC_MAGAZINE_CAPACITY - KMALLOC_MAGAZINE_BATCH_SIZE);
+    magazine.push(ptr);
+    return true;
+}
+
 void kfree_sized(void* ptr, size_t size)
 {
     if (!ptr)
@@ -482,6 +666,25 @@ void kfree_sized(void* ptr, size_t size)
         Processor::verify_no_spinlocks_held();
     }
 
+    if (try_kfree_into_magazine(ptr, size)) {
+        ++g_kfree_call_count;
+
+        // Recording the perf event may free memory itself, don't recurse into it.
+        ScopedCritical critical;
+        auto& processor_data = s_processor_data[Processor::current_id()];
+        if (++processor_data.nested_kfree_calls == 1) {
+            Thread* current_thread = Thread::current();
+            if (!current_thread)
+                current_thread = Processor::idle_thread();
+            if (current_thread) {
+                VERIFY(current_thread->is_allocation_enabled());
+                PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
+            }
+        }
+        --processor_data.nested_kfree_calls;
+        return;
+    }
+
     SpinlockLocker lock(s_lock);
     ++g_kfree_call_count;
     ++g_nested_kfree_calls;
@@ -587,3 +790,28 @@ void get_kmalloc_stats(kmalloc_stats& stats)
     stats.kmalloc_call_count = g_kmalloc_call_count;
     stats.kfree_call_count = g_kfree_call_count;
 }
+
+size_t get_kmalloc_slabheap_stats(kmalloc_slabheap_stats* stats, size_t max_count)
+{
+    SpinlockLocker lock(s_lock);
+    size_t count = min(max_count, KmallocGlobalData::slabheap_count);
+    for (size_t i = 0; i < count; ++i) {
+        auto const& slabheap = g_kmalloc_global->slabheaps[i];
+        auto& entry = stats[i];
+        entry.slab_size = slabheap.slab_size();
+        entry.block_count = slabheap.block_count();
+        entry.bytes_allocated = slabheap.allocated_bytes();
+        entry.bytes_free = slabheap.free_bytes();
+        entry.slab_allocation_count = slabheap.allocation_count();
+        entry.bytes_in_magazines = 0;
+        entry.magazine_hit_count = 0;
+        // NOTE: Other processors may be modifying their magazines while we look at them,
+        //       so these numbers are only approximations.
+        for (u32 cpu = 0; cpu < max(Processor::count(), 1u); ++cpu) {
+            auto const& magazine = s_processor_data[cpu].magazines[i];
+            entry.bytes_in_magazines += magazine.count * slabheap.slab_size();
+            entry.magazine_hit_count += magazine.hit_count;
+        }
+    }
+    return count;
+}
@@ -55,6 +55,17 @@ struct kmalloc_stats {
 };
 void get_kmalloc_stats(kmalloc_stats&);
 
+struct kmalloc_slabheap_stats {
+    size_t slab_size;
+    size_t block_count;
+    size_t bytes_allocated;
+    size_t bytes_free;
+    size_t bytes_in_magazines;
+    size_t slab_allocation_count;
+    size_t magazine_hit_count;
+};
+size_t get_kmalloc_slabheap_stats(kmalloc_slabheap_stats*, size_t max_count);
+
 extern bool g_dump_kmalloc_stacks;
 
 inline void* operator new(size_t, void* p) { return p; }
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/Atomic.h>
+#include <AK/HashFunctions.h>
+#include <Kernel/Locking/LockContentionProfiler.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+// Call sites are kept in a fixed open addressing table, as recording must not allocate from within Mutex::lock().
+// Once it is full, call sites that aren't in it yet are not recorded anymore.
+static constexpr size_t max_call_site_count = 512;
+
+static Atomic<bool> s_enabled { false };
+static Spinlock<LockRank::None> s_lock {};
+static Array<LockContentionStatistics, max_call_site_count> s_call_sites;
+static size_t s_call_site_count { 0 };
+
+static LockContentionStatistics* find_or_add_call_site(FlatPtr call_site, StringView lock_name)
+{
+    VERIFY(s_lock.is_locked());
+    VERIFY(call_site != 0);
+
+    for (size_t i = 0, index = ptr_hash(call_site) % max_call_site_count; i < max_call_site_count; ++i, index = (index + 1) % max_call_site_count) {
+        auto& entry = s_call_sites[index];
+        if (entry.call_site == call_site)
+            return &entry;
+        if (entry.call_site != 0)
+            continue;
+        if (s_call_site_count == max_call_site_count)
+            return nullptr;
+        entry.call_site = call_site;
+        // Long names are cut short, which is good enough to tell locks apart.
+        (void)lock_name.copy_characters_to_buffer(entry.lock_name, sizeof(entry.lock_name));
+        ++s_call_site_count;
+        return &entry;
+    }
+    return nullptr;
+}
+
+bool LockContentionProfiler::is_enabled()
+{
+    return s_enabled.load(AK::memory_order_relaxed);
+}
+
+void LockContentionProfiler::set_enabled(bool enabled)
+{
+    SpinlockLocker locker(s_lock);
+    if (enabled && !s_enabled.load(AK::memory_order_relaxed)) {
+        s_call_sites.fill({});
+        s_call_site_count = 0;
+    }
+    s_enabled.store(enabled, AK::memory_order_relaxed);
+}
+
+u64 LockContentionProfiler::current_time_ns()
+{
+    if (!TimeManagement::is_initialized())
+        return 0;
+    return TimeManagement::the().monotonic_time(TimePrecision::Precise).nanoseconds();
+}
+
+void LockContentionProfiler::did_acquire(FlatPtr call_site, StringView lock_name, Optional<u64> wait_time_ns, bool did_block)
+{
+    SpinlockLocker locker(s_lock);
+    auto* entry = find_or_add_call_site(call_site, lock_name);
+    if (!entry)
+        return;
+
+    ++entry->acquisitions;
+    if (!wait_time_ns.has_value())
+        return;
+    ++entry->contentions;
+    if (did_block)
+        ++entry->blocked_acquisitions;
+    entry->total_wait_time_ns += wait_time_ns.value();
+    entry->max_wait_time_ns = max(entry->max_wait_time_ns, wait_time_ns.value());
+}
+
+void LockContentionProfiler::did_release(FlatPtr call_site, StringView lock_name, u64 hold_time_ns)
+{
+    // The lock may have been taken before profiling was disabled.
+    if (!is_enabled())
+        return;
+
+    SpinlockLocker locker(s_lock);
+    auto* entry = find_or_add_call_site(call_site, lock_name);
+    if (!entry)
+        return;
+
+    ++entry->exclusive_releases;
+    entry->total_hold_time_ns += hold_time_ns;
+    entry->max_hold_time_ns = max(entry->max_hold_time_ns, hold_time_ns);
+}
+
+ErrorOr<Vector<LockContentionStatistics>> LockContentionProfiler::statistics()
+{
+    Vector<LockContentionStatistics> statistics;
+    TRY(statistics.try_ensure_capacity(max_call_site_count));
+
+    SpinlockLocker locker(s_lock);
+    for (auto& entry : s_call_sites) {
+        if (entry.call_site != 0)
+            statistics.unchecked_append(entry);
+    }
+    return statistics;
+}
+
+}
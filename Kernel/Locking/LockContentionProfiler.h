@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/Optional.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace Kernel {
+
+// How the Mutexes locked from one call site fared, while lock contention profiling was enabled.
+struct LockContentionStatistics {
+    FlatPtr call_site { 0 };
+    char lock_name[32] {};
+    u64 acquisitions { 0 };
+    // Acquisitions that found the lock held by another thread, and how many of them still had to block.
+    u64 contentions { 0 };
+    u64 blocked_acquisitions { 0 };
+    u64 total_wait_time_ns { 0 };
+    u64 max_wait_time_ns { 0 };
+    // Hold times are only known for exclusive locks, as shared ones don't track their holders.
+    u64 exclusive_releases { 0 };
+    u64 total_hold_time_ns { 0 };
+    u64 max_hold_time_ns { 0 };
+};
+
+class LockContentionProfiler {
+public:
+    static bool is_enabled();
+    // Enabling the profiler starts over with empty statistics.
+    static void set_enabled(bool);
+
+    // Returns 0 before there is a clock to read, which Mutex takes to mean that nothing should be recorded.
+    static u64 current_time_ns();
+
+    static void did_acquire(FlatPtr call_site, StringView lock_name, Optional<u64> wait_time_ns, bool did_block);
+    static void did_release(FlatPtr call_site, StringView lock_name, u64 hold_time_ns);
+
+    static ErrorOr<Vector<LockContentionStatistics>> statistics();
+};
+
+}
@@ -5,8 +5,10 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
 #include <Kernel/Debug.h>
 #include <Kernel/KSyms.h>
+#include <Kernel/Locking/LockContentionProfiler.h>
 #include <Kernel/Locking/LockLocation.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/Spinlock.h>
@@ -16,6 +18,11 @@ extern bool g_in_early_boot;
 
 namespace Kernel {
 
+// How long to wait for a holder running on another processor before blocking, in rounds of pauses.
+// Each round briefly drops m_lock, so that the holder is able to unlock.
+static constexpr size_t max_spin_rounds = 64;
+static constexpr size_t pauses_per_spin_round = 16;
+
 void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
 {
     // NOTE: This may be called from an interrupt handler (not an IRQ handler)
@@ -28,9 +35,24 @@ void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
     }
     VERIFY(mode != Mode::Unlocked);
     auto* current_thread = Thread::current();
+    // MutexLocker is always inlined, so this is where the lock is actually taken.
+    auto call_site = bit_cast<FlatPtr>(__builtin_return_address(0));
 
     SpinlockLocker lock(m_lock);
+    bool is_profiling = current_thread && m_behavior == MutexBehavior::Regular && LockContentionProfiler::is_enabled();
+    u64 contended_since_ns = 0;
+    if (current_thread && is_held_by_other_thread_for(*current_thread, mode)) {
+        if (is_profiling)
+            contended_since_ns = LockContentionProfiler::current_time_ns();
+        spin_while_holder_is_running(*current_thread, mode, lock);
+    }
+
     bool did_block = false;
+    ScopeGuard record_acquisition = [&] {
+        if (is_profiling)
+            did_acquire_for_profiling(*current_thread, call_site, contended_since_ns, did_block);
+    };
+
     Mode current_mode = m_mode;
     switch (current_mode) {
     case Mode::Unlocked: {
@@ -173,8 +195,13 @@ void Mutex::unlock()
     case Mode::Exclusive:
         VERIFY(m_holder == bit_cast<uintptr_t>(current_thread));
         VERIFY(m_shared_holders == 0);
-        if (m_times_locked == 0)
+        if (m_times_locked == 0) {
             m_holder = 0;
+            if (m_profiled_call_site != 0) {
+                LockContentionProfiler::did_release(m_profiled_call_site, m_name, LockContentionProfiler::current_time_ns() - m_profiled_acquisition_time_ns);
+                m_profiled_call_site = 0;
+            }
+        }
         break;
     case Mode::Shared: {
         VERIFY(!m_holder);
@@ -243,6 +270,61 @@ void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<Loc
     });
 }
 
+bool Mutex::is_held_by_other_thread_for(Thread const& current_thread, Mode mode) const
+{
+    VERIFY(m_lock.is_locked());
+    switch (m_mode) {
+    case Mode::Unlocked:
+        return false;
+    case Mode::Exclusive:
+        return m_holder != bit_cast<uintptr_t>(&current_thread);
+    case Mode::Shared:
+        return mode == Mode::Exclusive;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+void Mutex::spin_while_holder_is_running(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<LockRank::None>>& lock)
+{
+    // A holder that is running on another processor will most likely unlock soon, which is a lot cheaper
+    // to wait for than blocking and getting scheduled again. This only works for exclusive holders, as we
+    // don't know who holds a shared lock, and the big lock is held for far too long to be worth it.
+    // NOTE: unblock_waiters() hands the lock directly to a blocked thread, which won't be running yet.
+    //       So a spinning thread never gets to overtake the threads that are already waiting.
+    if (m_behavior != MutexBehavior::Regular || Processor::count() == 1)
+        return;
+
+    for (size_t round = 0; round < max_spin_rounds; ++round) {
+        if (m_mode != Mode::Exclusive || !is_held_by_other_thread_for(current_thread, mode))
+            return;
+        // The holder is only looked at while m_lock is held, so it can't have unlocked and gone away in the meantime.
+        auto* holder = bit_cast<Thread*>(m_holder);
+        if (holder->state() != Thread::State::Running)
+            return;
+
+        lock.unlock();
+        for (size_t i = 0; i < pauses_per_spin_round; ++i)
+            Processor::wait_check();
+        lock.lock();
+    }
+}
+
+void Mutex::did_acquire_for_profiling(Thread& current_thread, FlatPtr call_site, u64 contended_since_ns, bool did_block)
+{
+    auto now_ns = LockContentionProfiler::current_time_ns();
+    Optional<u64> wait_time_ns;
+    if (contended_since_ns != 0)
+        wait_time_ns = now_ns - contended_since_ns;
+    LockContentionProfiler::did_acquire(call_site, m_name, wait_time_ns, did_block);
+
+    // Recursive acquisitions don't start a new hold time.
+    if (now_ns != 0 && m_mode == Mode::Exclusive && m_times_locked == 1 && m_holder == bit_cast<uintptr_t>(&current_thread)) {
+        m_profiled_call_site = call_site;
+        m_profiled_acquisition_time_ns = now_ns;
+    }
+}
+
 void Mutex::unblock_waiters(Mode previous_mode)
 {
     VERIFY(m_times_locked == 0);
@@ -85,6 +85,9 @@ private:
     // FIXME: Allow any lock rank.
     void block(Thread&, Mode, SpinlockLocker<Spinlock<LockRank::None>>&, u32);
     void unblock_waiters(Mode);
+    bool is_held_by_other_thread_for(Thread const&, Mode) const;
+    void spin_while_holder_is_running(Thread&, Mode, SpinlockLocker<Spinlock<LockRank::None>>&);
+    void did_acquire_for_profiling(Thread&, FlatPtr call_site, u64 contended_since_ns, bool did_block);
 
     StringView m_name;
     Mode m_mode { Mode::Unlocked };
@@ -103,6 +106,10 @@ private:
     uintptr_t m_holder { 0 };
     size_t m_shared_holders { 0 };
 
+    // Where and when this lock was taken exclusively, if lock contention profiling was enabled at the time.
+    FlatPtr m_profiled_call_site { 0 };
+    u64 m_profiled_acquisition_time_ns { 0 };
+
     struct BlockedThreadLists {
         BlockedThreadList exclusive;
         BlockedThreadList shared;
@@ -54,6 +54,7 @@ ErrorOr<NonnullLockRefPtr<VMObject>> AnonymousVMObject::try_clone()
     auto new_shared_committed_cow_pages = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) SharedCommittedCowPages(move(committed_pages))));
     auto new_physical_pages = TRY(this->try_clone_physical_pages());
     auto clone = TRY(try_create_with_shared_cow(*this, *new_shared_committed_cow_pages, move(new_physical_pages)));
+    clone->m_compressed_pages = TRY(m_compressed_pages.clone());
 
     // Both original and clone become COW. So create a COW map for ourselves
     // or reset all pages to be copied again if we were previously cloned
@@ -143,11 +144,24 @@ ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> AnonymousVMObject::try_create_with
 AnonymousVMObject::AnonymousVMObject(FixedArray<RefPtr<PhysicalPage>>&& new_physical_pages, AllocationStrategy strategy, Optional<CommittedPhysicalPageSet> committed_pages)
     : VMObject(move(new_physical_pages))
     , m_unused_committed_pages(move(committed_pages))
+    , m_compressible(true)
 {
     if (strategy == AllocationStrategy::AllocateNow) {
         // Allocate all pages right now. We know we can get all because we committed the amount needed
-        for (size_t i = 0; i < page_count(); ++i)
-            physical_pages()[i] = m_unused_committed_pages->take_one();
+        // Whole large page sized chunks are taken as large pages if possible, so that they can be mapped as such.
+        bool large_pages_available = true;
+        size_t i = 0;
+        while (i < page_count()) {
+            if (large_pages_available && i % pages_per_large_page == 0 && page_count() - i >= pages_per_large_page) {
+                auto large_page = m_unused_committed_pages->try_take_large_page();
+                large_pages_available = !large_page.is_empty();
+                for (auto& page : large_page)
+                    physical_pages()[i++] = move(page);
+                if (large_pages_available)
+                    continue;
+            }
+            physical_pages()[i++] = m_unused_committed_pages->take_one();
+        }
     } else {
         auto& initial_page = (strategy == AllocationStrategy::Reserve) ? MM.lazy_committed_page() : MM.shared_zero_page();
         for (size_t i = 0; i < page_count(); ++i)
@@ -172,6 +186,7 @@ AnonymousVMObject::AnonymousVMObject(LockWeakPtr<AnonymousVMObject> other, Nonnu
     : VMObject(move(new_physical_pages))
     , m_cow_parent(move(other))
     , m_shared_committed_cow_pages(move(shared_committed_cow_pages))
+    , m_compressible(m_cow_parent.strong_ref()->m_compressible)
     , m_purgeable(m_cow_parent.strong_ref()->m_purgeable)
 {
 }
@@ -214,6 +229,112 @@ size_t AnonymousVMObject::purge()
     return total_pages_purged;
 }
 
+bool AnonymousVMObject::can_compress_page(size_t page_index) const
+{
+    // Pages that are shared with a clone have to stay where they are, as both of them have them mapped.
+    auto const& page = physical_pages()[page_index];
+    return page && !page->is_shared_zero_page() && !page->is_lazy_committed_page() && !page->is_compressed_page() && page->ref_count() == 1;
+}
+
+size_t AnonymousVMObject::compress_cold_pages(size_t max_page_count)
+{
+    Vector<size_t> cold_page_indices;
+    {
+        SpinlockLocker lock(m_lock);
+
+        // Purgeable memory can simply be purged, and the kernel can't take faults on its own memory at arbitrary points.
+        // Large pages would have to be split up first, which defeats the point of them.
+        if (!m_compressible || is_purgeable())
+            return 0;
+        bool has_regions = false;
+        bool has_unsuitable_regions = false;
+        for_each_region([&](Region& region) {
+            has_regions = true;
+            if (region.is_kernel() || region.prefers_large_pages())
+                has_unsuitable_regions = true;
+        });
+        if (!has_regions || has_unsuitable_regions)
+            return 0;
+
+        auto accessed_pages_or_error = Bitmap::create(page_count(), false);
+        if (accessed_pages_or_error.is_error())
+            return 0;
+        auto accessed_pages = accessed_pages_or_error.release_value();
+        for_each_region([&](Region& region) {
+            region.clear_accessed_bits(accessed_pages);
+        });
+
+        for (size_t i = 0; i < page_count() && cold_page_indices.size() < max_page_count; ++i) {
+            if (accessed_pages.get(i) || !can_compress_page(i))
+                continue;
+            if (cold_page_indices.try_append(i).is_error())
+                break;
+        }
+    }
+
+    // The lock is taken for one page at a time, so that page faults on the other pages don't have to wait for all of them.
+    size_t compressed_page_count = 0;
+    for (auto page_index : cold_page_indices) {
+        if (try_compress_page(page_index))
+            ++compressed_page_count;
+    }
+    return compressed_page_count;
+}
+
+bool AnonymousVMObject::try_compress_page(size_t page_index)
+{
+    SpinlockLocker lock(m_lock);
+
+    if (!can_compress_page(page_index))
+        return false;
+    if (m_compressed_pages.try_ensure_capacity(m_compressed_pages.size() + 1).is_error())
+        return false;
+
+    // Unmap the page everywhere first, so that nobody can write to it while it's being compressed.
+    // Anyone faulting on it in the meantime waits for our lock, and then finds either the page or its compressed copy.
+    auto& page_slot = physical_pages()[page_index];
+    NonnullRefPtr<PhysicalPage> page = *page_slot;
+    for_each_region([&](Region& region) {
+        (void)region.remap_vmobject_page(page_index, MM.compressed_page());
+    });
+
+    auto compressed_page = CompressedPageStore::the().try_store(page);
+    if (!compressed_page) {
+        for_each_region([&](Region& region) {
+            (void)region.remap_vmobject_page(page_index, page);
+        });
+        return false;
+    }
+
+    m_compressed_pages.set(page_index, compressed_page.release_nonnull());
+    page_slot = MM.compressed_page();
+    return true;
+}
+
+ErrorOr<void> AnonymousVMObject::decompress_page(size_t page_index)
+{
+    auto page = TRY(MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No));
+
+    SpinlockLocker lock(m_lock);
+
+    // Someone else may have faulted the page in while we were allocating, and then it's already mapped again.
+    auto& page_slot = physical_pages()[page_index];
+    if (!page_slot->is_compressed_page())
+        return {};
+
+    // The compressed page is only dropped once it was loaded, so that a failed fault doesn't lose it.
+    auto compressed_page = m_compressed_pages.get(page_index);
+    VERIFY(compressed_page.has_value());
+    TRY(CompressedPageStore::the().load(*compressed_page.value(), page));
+    m_compressed_pages.remove(page_index);
+    page_slot = page;
+
+    for_each_region([&](Region& region) {
+        (void)region.remap_vmobject_page(page_index, page);
+    });
+    return {};
+}
+
 ErrorOr<void> AnonymousVMObject::set_volatile(bool is_volatile, bool& was_purged)
 {
     VERIFY(is_purgeable());
@@ -276,6 +397,27 @@ NonnullRefPtr<PhysicalPage> AnonymousVMObject::allocate_committed_page(Badge<Reg
     return m_unused_committed_pages->take_one();
 }
 
+bool AnonymousVMObject::try_allocate_committed_large_page(Badge<Region>, size_t page_index)
+{
+    SpinlockLocker lock(m_lock);
+    if (!m_unused_committed_pages.has_value() || page_index + pages_per_large_page > page_count())
+        return false;
+
+    // Every lazily committed slot has a page set aside for it, so the large page comes out of those.
+    for (size_t i = 0; i < pages_per_large_page; ++i) {
+        auto const& page = physical_pages()[page_index + i];
+        if (!page || !page->is_lazy_committed_page())
+            return false;
+    }
+
+    auto large_page = m_unused_committed_pages->try_take_large_page();
+    if (large_page.is_empty())
+        return false;
+    for (size_t i = 0; i < pages_per_large_page; ++i)
+        physical_pages()[page_index + i] = move(large_page[i]);
+    return true;
+}
+
 ErrorOr<void> AnonymousVMObject::ensure_cow_map()
 {
     if (m_cow_map.is_null())
@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
 #include <Kernel/Memory/AllocationStrategy.h>
+#include <Kernel/Memory/CompressedPageStore.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PageFaultResponse.h>
 #include <Kernel/Memory/PhysicalAddress.h>
@@ -26,6 +28,8 @@ public:
     virtual ErrorOr<NonnullLockRefPtr<VMObject>> try_clone() override;
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> allocate_committed_page(Badge<Region>);
+    // Backs the lazily committed pages starting at page_index with one large page. Returns false and changes nothing if that isn't possible.
+    [[nodiscard]] bool try_allocate_committed_large_page(Badge<Region>, size_t page_index);
     PageFaultResponse handle_cow_fault(size_t, VirtualAddress);
     size_t cow_pages() const;
     bool should_cow(size_t page_index, bool) const;
@@ -38,6 +42,10 @@ public:
 
     size_t purge();
 
+    // Compresses up to max_page_count pages that weren't accessed since the previous call, and returns how many were compressed.
+    size_t compress_cold_pages(size_t max_page_count);
+    ErrorOr<void> decompress_page(size_t page_index);
+
 private:
     class SharedCommittedCowPages;
 
@@ -59,6 +67,9 @@ private:
     ErrorOr<void> ensure_cow_map();
     ErrorOr<void> ensure_or_reset_cow_map();
 
+    bool can_compress_page(size_t page_index) const;
+    bool try_compress_page(size_t page_index);
+
     Optional<CommittedPhysicalPageSet> m_unused_committed_pages;
     Bitmap m_cow_map;
 
@@ -85,6 +96,11 @@ private:
     LockWeakPtr<AnonymousVMObject> m_cow_parent;
     LockRefPtr<SharedCommittedCowPages> m_shared_committed_cow_pages;
 
+    // The compressed contents of the pages whose slot holds MM.compressed_page(). Clones share them until they are decompressed.
+    HashMap<size_t, NonnullRefPtr<CompressedPage>> m_compressed_pages;
+
+    // Only memory the kernel allocated itself can be compressed, not physical ranges or pages handed to devices.
+    bool m_compressible { false };
     bool m_purgeable { false };
     bool m_volatile { false };
     bool m_was_purged { false };
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/BuiltinWrappers.h>
+#include <AK/NumericLimits.h>
+#include <AK/Singleton.h>
+#include <Kernel/Memory/CompressedPageStore.h>
+#include <Kernel/Memory/MemoryManager.h>
+
+namespace Kernel::Memory {
+
+// Pages are compressed with a small LZ77 variant, laid out like LZ4 blocks:
+// Every sequence starts with a token holding the literal length in its upper and the match length minus 4 in its lower nibble.
+// A nibble of 15 is followed by bytes that are added to it, until one of them isn't 255.
+// The literals come next, then the 16-bit little endian match offset. The last sequence only has literals.
+static constexpr size_t min_match_length = 4;
+static constexpr size_t hash_table_bits = 10;
+
+static u32 read_u32(u8 const* data)
+{
+    u32 value;
+    __builtin_memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static size_t hash_sequence(u32 sequence)
+{
+    return (sequence * 2654435761u) >> (32 - hash_table_bits);
+}
+
+static bool write_length(u8*& out, u8 const* out_end, size_t length)
+{
+    for (; length >= 255; length -= 255) {
+        if (out == out_end)
+            return false;
+        *out++ = 255;
+    }
+    if (out == out_end)
+        return false;
+    *out++ = length;
+    return true;
+}
+
+static bool write_sequence(u8*& out, u8 const* out_end, ReadonlyBytes literals, Optional<size_t> match_offset, size_t match_length)
+{
+    if (out == out_end)
+        return false;
+    auto& token = *out++;
+    token = min<size_t>(literals.size(), 15) << 4;
+    if (literals.size() >= 15 && !write_length(out, out_end, literals.size() - 15))
+        return false;
+    if (static_cast<size_t>(out_end - out) < literals.size())
+        return false;
+    __builtin_memcpy(out, literals.data(), literals.size());
+    out += literals.size();
+
+    if (!match_offset.has_value())
+        return true;
+    if (out_end - out < 2)
+        return false;
+    *out++ = match_offset.value() & 0xff;
+    *out++ = match_offset.value() >> 8;
+    auto extra_match_length = match_length - min_match_length;
+    token |= min<size_t>(extra_match_length, 15);
+    if (extra_match_length >= 15 && !write_length(out, out_end, extra_match_length - 15))
+        return false;
+    return true;
+}
+
+// Returns the compressed size, or 0 if it doesn't fit into the output.
+static size_t compress(ReadonlyBytes input, Bytes output)
+{
+    u16 hash_table[1 << hash_table_bits] {};
+    auto* out = output.data();
+    auto const* out_end = output.data() + output.size();
+
+    size_t anchor = 0;
+    size_t position = 0;
+    while (position + min_match_length <= input.size()) {
+        auto sequence = read_u32(input.offset_pointer(position));
+        auto& entry = hash_table[hash_sequence(sequence)];
+        // Entries are stored off by one, so that zero means that there is none.
+        size_t candidate = entry;
+        entry = position + 1;
+        if (candidate == 0 || read_u32(input.offset_pointer(candidate - 1)) != sequence) {
+            ++position;
+            continue;
+        }
+        --candidate;
+
+        size_t match_length = min_match_length;
+        while (position + match_length < input.size() && input[candidate + match_length] == input[position + match_length])
+            ++match_length;
+
+        if (!write_sequence(out, out_end, input.slice(anchor, position - anchor), position - candidate, match_length))
+            return 0;
+        position += match_length;
+        anchor = position;
+    }
+
+    if (!write_sequence(out, out_end, input.slice(anchor), {}, 0))
+        return 0;
+    return out - output.data();
+}
+
+static bool read_length(u8 const*& in, u8 const* in_end, size_t& length)
+{
+    u8 byte;
+    do {
+        if (in == in_end)
+            return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+static bool decompress(ReadonlyBytes input, Bytes output)
+{
+    auto const* in = input.data();
+    auto const* in_end = input.data() + input.size();
+    size_t position = 0;
+
+    while (in < in_end) {
+        auto token = *in++;
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(in, in_end, literal_length))
+            return false;
+        if (static_cast<size_t>(in_end - in) < literal_length || output.size() - position < literal_length)
+            return false;
+        __builtin_memcpy(output.offset_pointer(position), in, literal_length);
+        in += literal_length;
+        position += literal_length;
+
+        if (in == in_end)
+            break;
+        if (in_end - in < 2)
+            return false;
+        size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+        size_t match_length = token & 0xf;
+        if (match_length == 15 && !read_length(in, in_end, match_length))
+            return false;
+        match_length += min_match_length;
+        if (offset == 0 || offset > position || output.size() - position < match_length)
+            return false;
+        // The match may overlap with what it produces, so this has to go byte by byte.
+        for (size_t i = 0; i < match_length; ++i, ++position)
+            output[position] = output[position - offset];
+    }
+
+    return position == output.size();
+}
+
+static Singleton<CompressedPageStore> s_the;
+
+CompressedPageStore& CompressedPageStore::the()
+{
+    return *s_the;
+}
+
+CompressedPageStore::CompressedPageStore() = default;
+
+RefPtr<CompressedPage> CompressedPageStore::try_store(PhysicalPage& page)
+{
+    SpinlockLocker locker(m_lock);
+
+    size_t compressed_size;
+    {
+        auto* page_data = MM.quickmap_page(page);
+        compressed_size = compress({ page_data, PAGE_SIZE }, m_buffer.span().trim(max_compressed_size));
+        MM.unquickmap_page();
+    }
+    if (compressed_size == 0)
+        return nullptr;
+
+    size_t size_class = ceil_div(compressed_size, slot_size_granularity) - 1;
+    auto& partial_storage_pages = m_partial_storage_pages[size_class];
+    if (partial_storage_pages.is_empty()) {
+        auto physical_page_or_error = MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No);
+        if (physical_page_or_error.is_error())
+            return nullptr;
+        auto* storage_page = new (nothrow) StoragePage { physical_page_or_error.release_value(), 0, static_cast<u8>(size_class), 0, {} };
+        if (!storage_page)
+            return nullptr;
+        storage_page->free_slots = NumericLimits<u32>::max() >> (32 - slots_per_page(size_class));
+        partial_storage_pages.append(*storage_page);
+        m_storage_page_count.fetch_add(1, AK::memory_order_relaxed);
+    }
+
+    auto& storage_page = *partial_storage_pages.first();
+    u8 slot = count_trailing_zeroes(storage_page.free_slots);
+    auto* compressed_page = new (nothrow) CompressedPage(storage_page, slot, compressed_size);
+    if (!compressed_page) {
+        if (storage_page.used_slot_count == 0) {
+            partial_storage_pages.remove(storage_page);
+            delete &storage_page;
+            m_storage_page_count.fetch_sub(1, AK::memory_order_relaxed);
+        }
+        return nullptr;
+    }
+
+    storage_page.free_slots &= ~(1u << slot);
+    ++storage_page.used_slot_count;
+    if (storage_page.free_slots == 0)
+        partial_storage_pages.remove(storage_page);
+
+    auto* storage_data = MM.quickmap_page(storage_page.physical_page);
+    __builtin_memcpy(storage_data + slot * slot_size(size_class), m_buffer.data(), compressed_size);
+    MM.unquickmap_page();
+
+    m_stored_page_count.fetch_add(1, AK::memory_order_relaxed);
+    m_stored_bytes.fetch_add(compressed_size, AK::memory_order_relaxed);
+    return adopt_ref(*compressed_page);
+}
+
+ErrorOr<void> CompressedPageStore::load(CompressedPage const& compressed_page, PhysicalPage& page)
+{
+    SpinlockLocker locker(m_lock);
+
+    auto& storage_page = compressed_page.m_storage_page;
+    auto* storage_data = MM.quickmap_page(storage_page.physical_page);
+    __builtin_memcpy(m_buffer.data(), storage_data + compressed_page.m_slot * slot_size(storage_page.size_class), compressed_page.compressed_size());
+    MM.unquickmap_page();
+
+    auto* page_data = MM.quickmap_page(page);
+    bool success = decompress(m_buffer.span().trim(compressed_page.compressed_size()), { page_data, PAGE_SIZE });
+    MM.unquickmap_page();
+    if (!success) {
+        dmesgln("CompressedPageStore: Failed to decompress a page of {} bytes", compressed_page.compressed_size());
+        return EIO;
+    }
+    return {};
+}
+
+void CompressedPageStore::release(CompressedPage& compressed_page)
+{
+    SpinlockLocker locker(m_lock);
+
+    auto& storage_page = compressed_page.m_storage_page;
+    auto& partial_storage_pages = m_partial_storage_pages[storage_page.size_class];
+    if (storage_page.free_slots == 0)
+        partial_storage_pages.append(storage_page);
+    storage_page.free_slots |= 1u << compressed_page.m_slot;
+    --storage_page.used_slot_count;
+
+    m_stored_page_count.fetch_sub(1, AK::memory_order_relaxed);
+    m_stored_bytes.fetch_sub(compressed_page.compressed_size(), AK::memory_order_relaxed);
+
+    if (storage_page.used_slot_count == 0) {
+        partial_storage_pages.remove(storage_page);
+        delete &storage_page;
+        m_storage_page_count.fetch_sub(1, AK::memory_order_relaxed);
+    }
+}
+
+CompressedPage::~CompressedPage()
+{
+    CompressedPageStore::the().release(*this);
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/AtomicRefCounted.h>
+#include <AK/IntrusiveList.h>
+#include <AK/RefPtr.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Memory/PhysicalPage.h>
+
+namespace Kernel::Memory {
+
+class CompressedPage;
+
+// Keeps compressed anonymous pages in memory, in place of the physical pages they were taken from.
+// Compressed pages are packed into physical pages of equally sized slots, one size class per physical page,
+// and a physical page is given back as soon as its last slot is free again.
+class CompressedPageStore {
+public:
+    CompressedPageStore();
+    static CompressedPageStore& the();
+
+    // Returns nullptr if the page didn't compress well enough to be worth keeping, or if there was no memory for it.
+    RefPtr<CompressedPage> try_store(PhysicalPage&);
+    // Fails with EIO if the compressed data turns out to be corrupted.
+    ErrorOr<void> load(CompressedPage const&, PhysicalPage&);
+
+    size_t stored_page_count() const { return m_stored_page_count.load(AK::memory_order_relaxed); }
+    size_t stored_bytes() const { return m_stored_bytes.load(AK::memory_order_relaxed); }
+    size_t storage_page_count() const { return m_storage_page_count.load(AK::memory_order_relaxed); }
+
+private:
+    friend class CompressedPage;
+
+    static constexpr size_t slot_size_granularity = 128;
+    // Pages that don't shrink by at least a quarter are cheaper to just keep around.
+    static constexpr size_t max_compressed_size = PAGE_SIZE / 4 * 3;
+    static constexpr size_t size_class_count = max_compressed_size / slot_size_granularity;
+
+    struct StoragePage {
+        NonnullRefPtr<PhysicalPage> physical_page;
+        u32 free_slots { 0 };
+        u8 size_class { 0 };
+        u8 used_slot_count { 0 };
+        IntrusiveListNode<StoragePage> list_node;
+    };
+    using StoragePageList = IntrusiveList<&StoragePage::list_node>;
+
+    static size_t slot_size(size_t size_class) { return (size_class + 1) * slot_size_granularity; }
+    static size_t slots_per_page(size_t size_class) { return PAGE_SIZE / slot_size(size_class); }
+
+    void release(CompressedPage&);
+
+    Spinlock<LockRank::None> m_lock {};
+    // Pages are compressed into this buffer first, as only one page can be quickmapped at a time.
+    Array<u8, PAGE_SIZE> m_buffer;
+    // Storage pages that still have free slots, for each size class.
+    Array<StoragePageList, size_class_count> m_partial_storage_pages;
+
+    Atomic<size_t> m_stored_page_count { 0 };
+    Atomic<size_t> m_stored_bytes { 0 };
+    Atomic<size_t> m_storage_page_count { 0 };
+};
+
+// A compressed copy of an anonymous page that was taken out of memory.
+// The slot it occupies in the CompressedPageStore is given back when the last reference goes away.
+class CompressedPage final : public AtomicRefCounted<CompressedPage> {
+    AK_MAKE_NONCOPYABLE(CompressedPage);
+    AK_MAKE_NONMOVABLE(CompressedPage);
+    friend class CompressedPageStore;
+
+public:
+    ~CompressedPage();
+
+    size_t compressed_size() const { return m_compressed_size; }
+
+private:
+    CompressedPage(CompressedPageStore::StoragePage& storage_page, u8 slot, u16 compressed_size)
+        : m_storage_page(storage_page)
+        , m_slot(slot)
+        , m_compressed_size(compressed_size)
+    {
+    }
+
+    CompressedPageStore::StoragePage& m_storage_page;
+    u8 m_slot { 0 };
+    u16 m_compressed_size { 0 };
+};
+
+}
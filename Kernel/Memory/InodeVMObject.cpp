@@ -4,11 +4,18 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Memory/InodeVMObject.h>
 
 namespace Kernel::Memory {
 
+static Atomic<u64> s_page_cache_hits;
+static Atomic<u64> s_page_cache_misses;
+static Atomic<u64> s_page_cache_activations;
+static Atomic<u64> s_page_cache_deactivations;
+static Atomic<u64> s_page_cache_reclaimed_pages;
+
 InodeVMObject::InodeVMObject(Inode& inode, FixedArray<RefPtr<PhysicalPage>>&& new_physical_pages, Bitmap dirty_pages)
     : VMObject(move(new_physical_pages))
     , m_inode(inode)
@@ -55,7 +62,7 @@ int InodeVMObject::release_all_clean_pages()
     int count = 0;
     for (size_t i = 0; i < page_count(); ++i) {
         if (!m_dirty_pages.get(i) && m_physical_pages[i]) {
-            m_physical_pages[i] = nullptr;
+            forget_page(i);
             ++count;
         }
     }
@@ -74,10 +81,11 @@ int InodeVMObject::try_release_clean_pages(int page_amount)
     int count = 0;
     for (size_t i = 0; i < page_count() && count < page_amount; ++i) {
         if (!m_dirty_pages.get(i) && m_physical_pages[i]) {
-            m_physical_pages[i] = nullptr;
+            forget_page(i);
             ++count;
         }
     }
+    s_page_cache_reclaimed_pages.fetch_add(count, AK::memory_order_relaxed);
     if (count) {
         for_each_region([](auto& region) {
             region.remap();
@@ -86,6 +94,128 @@ int InodeVMObject::try_release_clean_pages(int page_amount)
     return count;
 }
 
+ErrorOr<void> InodeVMObject::try_allocate_page_cache_bitmaps()
+{
+    m_active_pages = TRY(Bitmap::create(page_count(), false));
+    m_referenced_pages = TRY(Bitmap::create(page_count(), false));
+    m_accessed_pages = TRY(Bitmap::create(page_count(), false));
+    return {};
+}
+
+void InodeVMObject::forget_page(size_t page_index)
+{
+    m_physical_pages[page_index] = nullptr;
+    // Whatever gets read into this slot next starts out as a new inactive page.
+    m_active_pages.set(page_index, false);
+    m_referenced_pages.set(page_index, false);
+}
+
+void InodeVMObject::mark_page_accessed(size_t page_index)
+{
+    VERIFY(m_lock.is_locked_by_current_processor());
+    s_page_cache_hits.fetch_add(1, AK::memory_order_relaxed);
+
+    if (m_active_pages.get(page_index))
+        return;
+    if (m_referenced_pages.get(page_index)) {
+        m_referenced_pages.set(page_index, false);
+        m_active_pages.set(page_index, true);
+        s_page_cache_activations.fetch_add(1, AK::memory_order_relaxed);
+        return;
+    }
+    m_referenced_pages.set(page_index, true);
+}
+
+size_t InodeVMObject::scan_and_reclaim_clean_pages(size_t max_page_count)
+{
+    SpinlockLocker locker(m_lock);
+
+    // Writes through a writable mapping don't mark pages dirty, so the pages may hold data that isn't on disk yet.
+    // Those have to stay around until the mapping is written back and gone.
+    bool has_been_mapped_writable = false;
+    for_each_region([&](Region& region) {
+        if (region.has_been_writable())
+            has_been_mapped_writable = true;
+    });
+    if (has_been_mapped_writable)
+        return 0;
+
+    m_accessed_pages.fill(false);
+    for_each_region([&](Region& region) {
+        region.clear_accessed_bits(m_accessed_pages);
+    });
+
+    size_t activation_count = 0;
+    size_t deactivation_count = 0;
+    size_t reclaimed_page_count = 0;
+    for (size_t i = 0; i < page_count(); ++i) {
+        if (!m_physical_pages[i] || m_dirty_pages.get(i))
+            continue;
+        bool was_accessed = m_accessed_pages.get(i);
+
+        if (m_active_pages.get(i)) {
+            if (!was_accessed) {
+                m_active_pages.set(i, false);
+                ++deactivation_count;
+            }
+            continue;
+        }
+
+        if (was_accessed) {
+            if (m_referenced_pages.get(i)) {
+                m_referenced_pages.set(i, false);
+                m_active_pages.set(i, true);
+                ++activation_count;
+            } else {
+                m_referenced_pages.set(i, true);
+            }
+            continue;
+        }
+
+        // Pages that were used once get one more scan to be used again before they go.
+        if (m_referenced_pages.get(i)) {
+            m_referenced_pages.set(i, false);
+            continue;
+        }
+        if (reclaimed_page_count < max_page_count) {
+            forget_page(i);
+            ++reclaimed_page_count;
+        }
+    }
+
+    s_page_cache_activations.fetch_add(activation_count, AK::memory_order_relaxed);
+    s_page_cache_deactivations.fetch_add(deactivation_count, AK::memory_order_relaxed);
+    s_page_cache_reclaimed_pages.fetch_add(reclaimed_page_count, AK::memory_order_relaxed);
+    if (reclaimed_page_count) {
+        for_each_region([](auto& region) {
+            region.remap();
+        });
+    }
+    return reclaimed_page_count;
+}
+
+size_t InodeVMObject::active_page_count() const
+{
+    SpinlockLocker locker(m_lock);
+    return m_active_pages.count_slow(true);
+}
+
+InodeVMObject::PageCacheStatistics InodeVMObject::page_cache_statistics()
+{
+    return {
+        .hits = s_page_cache_hits.load(AK::memory_order_relaxed),
+        .misses = s_page_cache_misses.load(AK::memory_order_relaxed),
+        .activations = s_page_cache_activations.load(AK::memory_order_relaxed),
+        .deactivations = s_page_cache_deactivations.load(AK::memory_order_relaxed),
+        .reclaimed_pages = s_page_cache_reclaimed_pages.load(AK::memory_order_relaxed),
+    };
+}
+
+void InodeVMObject::did_miss_page_cache()
+{
+    s_page_cache_misses.fetch_add(1, AK::memory_order_relaxed);
+}
+
 u32 InodeVMObject::writable_mappings() const
 {
     u32 count = 0;
@@ -25,6 +25,24 @@ public:
     int release_all_clean_pages();
     int try_release_clean_pages(int page_amount);
 
+    // The page cache keeps clean pages on an active and an inactive LRU list, tracked with one bit per page.
+    // Pages come in as inactive, and are activated when they are used again while inactive. Pages that aren't
+    // used between two scans are deactivated again, and unused inactive pages are reclaimed when memory runs low.
+    // VMObjects that have been mapped writable are left alone, as their pages may have been written to.
+    void mark_page_accessed(size_t page_index);
+    size_t scan_and_reclaim_clean_pages(size_t max_page_count);
+    size_t active_page_count() const;
+
+    struct PageCacheStatistics {
+        u64 hits { 0 };
+        u64 misses { 0 };
+        u64 activations { 0 };
+        u64 deactivations { 0 };
+        u64 reclaimed_pages { 0 };
+    };
+    static PageCacheStatistics page_cache_statistics();
+    static void did_miss_page_cache();
+
     u32 writable_mappings() const;
 
 protected:
@@ -37,8 +55,20 @@ protected:
 
     virtual bool is_inode() const final { return true; }
 
+    // NOTE: This has to be called by the factory functions, as the bitmaps can't be allocated with m_lock held.
+    ErrorOr<void> try_allocate_page_cache_bitmaps();
+
     NonnullRefPtr<Inode> const m_inode;
     Bitmap m_dirty_pages;
+
+private:
+    void forget_page(size_t page_index);
+
+    Bitmap m_active_pages;
+    // Inactive pages that were used once already, and get activated the next time they are.
+    Bitmap m_referenced_pages;
+    // Scratch space for the page cache scan, to collect which pages were accessed since the last one.
+    Bitmap m_accessed_pages;
 };
 
 }
@@ -25,6 +25,7 @@
 #include <Kernel/Prekernel/Prekernel.h>
 #include <Kernel/Sections.h>
 #include <Kernel/Tasks/Process.h>
+#include <Kernel/Tasks/SyncTask.h>
 
 extern u8 start_of_kernel_image[];
 extern u8 end_of_kernel_image[];
@@ -91,8 +92,8 @@ UNMAP_AFTER_INIT MemoryManager::MemoryManager()
     activate_kernel_page_directory(kernel_page_directory());
     protect_kernel_image();
 
-    // We're temporarily "committing" to two pages that we need to allocate below
-    auto committed_pages = commit_physical_pages(2).release_value();
+    // We're temporarily "committing" to three pages that we need to allocate below
+    auto committed_pages = commit_physical_pages(3).release_value();
 
     m_shared_zero_page = committed_pages.take_one();
 
@@ -103,6 +104,9 @@ UNMAP_AFTER_INIT MemoryManager::MemoryManager()
     // By using a tag we don't have to query the VMObject for every page
     // whether it was committed or not
     m_lazy_committed_page = committed_pages.take_one();
+
+    // Another tag, for pages of anonymous memory that are only kept compressed in the CompressedPageStore right now.
+    m_compressed_page = committed_pages.take_one();
 }
 
 UNMAP_AFTER_INIT MemoryManager::~MemoryManager() = default;
@@ -604,6 +608,11 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
     PageDirectoryEntry const& pde = pd[page_directory_index];
     if (!pde.is_present())
         return nullptr;
+#if ARCH(X86_64)
+    // There's no page table behind a large page.
+    if (pde.is_huge())
+        return nullptr;
+#endif
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
@@ -618,7 +627,11 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     auto& pde = pd[page_directory_index];
-    if (pde.is_present())
+    bool is_large_page = false;
+#if ARCH(X86_64)
+    is_large_page = pde.is_present() && pde.is_huge();
+#endif
+    if (pde.is_present() && !is_large_page)
         return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 
     bool did_purge = false;
@@ -635,8 +648,30 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pd = quickmap_pd(page_directory, page_directory_table_index);
         VERIFY(&pde == &pd[page_directory_index]); // Sanity check
 
-        VERIFY(!pde.is_present()); // Should have not changed
+        VERIFY(pde.is_present() == is_large_page); // Should have not changed
+    }
+
+#if ARCH(X86_64)
+    if (is_large_page) {
+        // Someone wants to change a single page inside a large page, so split it into a page table that maps
+        // the same memory with the same permissions first.
+        auto* split_page_table = quickmap_pt(page_table->paddr());
+        for (u32 i = 0; i <= 0x1ff; ++i) {
+            auto& pte = split_page_table[i];
+            pte.set_physical_page_base(pde.large_page_base() + i * PAGE_SIZE);
+            pte.set_user_allowed(pde.is_user_allowed());
+            pte.set_writable(pde.is_writable());
+            pte.set_write_through(pde.is_write_through());
+            pte.set_cache_disabled(pde.is_cache_disabled());
+            pte.set_pat(pde.is_large_page_pat());
+            pte.set_global(pde.is_global());
+            pte.set_execute_disabled(pde.is_execute_disabled());
+            pte.set_present(true);
+        }
+        pde.clear();
     }
+#endif
+
     pde.set_page_table_base(page_table->paddr().get());
     pde.set_user_allowed(true);
     pde.set_present(true);
@@ -659,6 +694,13 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+#if ARCH(X86_64)
+    if (pde.is_present() && pde.is_huge()) {
+        // Large pages are only ever mapped for whole 2 MiB chunks of a region, so the region is going away entirely.
+        pde.clear();
+        return;
+    }
+#endif
     if (pde.is_present()) {
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
@@ -682,6 +724,28 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
     }
 }
 
+PageDirectoryEntry* MemoryManager::large_page_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    VERIFY(vaddr.get() % large_page_size == 0);
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+#if ARCH(X86_64)
+    if (pde.is_present() && !pde.is_huge()) {
+        // The large page replaces all 512 entries, which all belonged to the caller's region.
+        get_physical_page_entry(PhysicalAddress { pde.page_table_base() }).allocated.physical_page.unref();
+    }
+#else
+    VERIFY_NOT_REACHED();
+#endif
+    pde.clear();
+    return &pde;
+}
+
 UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
 {
     dmesgln("Initialize MMU");
@@ -860,7 +924,9 @@ ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_kernel_region(size_t size
         name_kstring = TRY(KString::try_create(name));
     auto vmobject = TRY(AnonymousVMObject::try_create_with_size(size, strategy));
     auto region = TRY(Region::create_unplaced(move(vmobject), 0, move(name_kstring), access, cacheable));
-    TRY(m_global_data.with([&](auto& global_data) { return global_data.region_tree.place_anywhere(*region, RandomizeVirtualAddress::No, size); }));
+    // Big allocations that are backed right away get a large page aligned address, so that they can be mapped with large pages.
+    size_t alignment = (strategy == AllocationStrategy::AllocateNow && size >= large_page_size) ? large_page_size : PAGE_SIZE;
+    TRY(m_global_data.with([&](auto& global_data) { return global_data.region_tree.place_anywhere(*region, RandomizeVirtualAddress::No, size, alignment); }));
     TRY(region->map(kernel_page_directory()));
     return region;
 }
@@ -873,20 +939,28 @@ ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_kernel_region(PhysicalAdd
     if (!name.is_null())
         name_kstring = TRY(KString::try_create(name));
     auto region = TRY(Region::create_unplaced(move(vmobject), 0, move(name_kstring), access, cacheable));
-    TRY(m_global_data.with([&](auto& global_data) { return global_data.region_tree.place_anywhere(*region, RandomizeVirtualAddress::No, size, PAGE_SIZE); }));
+    // Physical ranges like the framebuffer can be mapped with large pages if both addresses line up.
+    size_t alignment = (paddr.get() % large_page_size == 0 && size >= large_page_size) ? large_page_size : PAGE_SIZE;
+    TRY(m_global_data.with([&](auto& global_data) { return global_data.region_tree.place_anywhere(*region, RandomizeVirtualAddress::No, size, alignment); }));
     TRY(region->map(kernel_page_directory()));
     return region;
 }
 
 ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_kernel_region_with_vmobject(VMObject& vmobject, size_t size, StringView name, Region::Access access, Region::Cacheable cacheable)
 {
+    return allocate_kernel_region_with_vmobject(vmobject, 0, size, name, access, cacheable);
+}
+
+ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_kernel_region_with_vmobject(VMObject& vmobject, size_t offset_in_vmobject, size_t size, StringView name, Region::Access access, Region::Cacheable cacheable)
+{
+    VERIFY(!(offset_in_vmobject % PAGE_SIZE));
     VERIFY(!(size % PAGE_SIZE));
 
     OwnPtr<KString> name_kstring;
     if (!name.is_null())
         name_kstring = TRY(KString::try_create(name));
 
-    auto region = TRY(Region::create_unplaced(vmobject, 0, move(name_kstring), access, cacheable));
+    auto region = TRY(Region::create_unplaced(vmobject, offset_in_vmobject, move(name_kstring), access, cacheable));
     TRY(m_global_data.with([&](auto& global_data) { return global_data.region_tree.place_anywhere(*region, RandomizeVirtualAddress::No, size); }));
     TRY(region->map(kernel_page_directory()));
     return region;
@@ -898,6 +972,7 @@ ErrorOr<CommittedPhysicalPageSet> MemoryManager::commit_physical_pages(size_t pa
     auto result = m_global_data.with([&](auto& global_data) -> ErrorOr<CommittedPhysicalPageSet> {
         if (global_data.system_memory_info.physical_pages_uncommitted < page_count) {
             dbgln("MM: Unable to commit {} pages, have only {}", page_count, global_data.system_memory_info.physical_pages_uncommitted);
+            SyncTask::notify_memory_pressure();
             return ENOMEM;
         }
 
@@ -1004,6 +1079,30 @@ NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_physical_page(Badg
     return page.release_nonnull();
 }
 
+Vector<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_committed_large_physical_page(Badge<CommittedPhysicalPageSet>)
+{
+    Vector<NonnullRefPtr<PhysicalPage>> physical_pages;
+    m_global_data.with([&](auto& global_data) {
+        VERIFY(global_data.system_memory_info.physical_pages_committed >= pages_per_large_page);
+        for (auto& region : global_data.physical_regions) {
+            physical_pages = region->take_large_page();
+            if (!physical_pages.is_empty()) {
+                global_data.system_memory_info.physical_pages_committed -= pages_per_large_page;
+                global_data.system_memory_info.physical_pages_used += pages_per_large_page;
+                break;
+            }
+        }
+    });
+
+    InterruptDisabler disabler;
+    for (auto& page : physical_pages) {
+        auto* ptr = quickmap_page(*page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+    }
+    return physical_pages;
+}
+
 ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
     return m_global_data.with([&](auto&) -> ErrorOr<NonnullRefPtr<PhysicalPage>> {
@@ -1046,6 +1145,7 @@ ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_physical_page(Shoul
         }
         if (!page) {
             dmesgln("MM: no physical pages available");
+            SyncTask::notify_memory_pressure();
             return ENOMEM;
         }
 
@@ -1061,6 +1161,52 @@ ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_physical_page(Shoul
     });
 }
 
+size_t MemoryManager::reclaim_page_cache(size_t page_count)
+{
+    Vector<NonnullLockRefPtr<InodeVMObject>> vmobjects;
+    for_each_vmobject([&](VMObject& vmobject) {
+        if (!vmobject.is_inode())
+            return IterationDecision::Continue;
+        if (vmobjects.try_append(static_cast<InodeVMObject&>(vmobject)).is_error())
+            return IterationDecision::Break;
+        return IterationDecision::Continue;
+    });
+
+    // Every VMObject is scanned, even once enough pages were reclaimed, so that all of them age at the same rate.
+    size_t reclaimed_page_count = 0;
+    for (auto& vmobject : vmobjects)
+        reclaimed_page_count += vmobject->scan_and_reclaim_clean_pages(page_count - reclaimed_page_count);
+    if (reclaimed_page_count > 0)
+        dbgln("MM: Reclaimed {} inactive pages from the page cache", reclaimed_page_count);
+    return reclaimed_page_count;
+}
+
+size_t MemoryManager::compress_cold_anonymous_pages(size_t page_count)
+{
+    // Compressing takes locks that must not be taken while holding the VMObject list lock, so collect the candidates first.
+    Vector<NonnullLockRefPtr<AnonymousVMObject>> vmobjects;
+    for_each_vmobject([&](VMObject& vmobject) {
+        if (!vmobject.is_anonymous())
+            return IterationDecision::Continue;
+        auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject);
+        if (anonymous_vmobject.is_purgeable())
+            return IterationDecision::Continue;
+        if (vmobjects.try_append(anonymous_vmobject).is_error())
+            return IterationDecision::Break;
+        return IterationDecision::Continue;
+    });
+
+    size_t compressed_page_count = 0;
+    for (auto& vmobject : vmobjects) {
+        if (compressed_page_count >= page_count)
+            break;
+        compressed_page_count += vmobject->compress_cold_pages(page_count - compressed_page_count);
+    }
+    if (compressed_page_count > 0)
+        dbgln("MM: Compressed {} cold anonymous pages", compressed_page_count);
+    return compressed_page_count;
+}
+
 ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> MemoryManager::allocate_contiguous_physical_pages(size_t size)
 {
     VERIFY(!(size % PAGE_SIZE));
@@ -1246,6 +1392,16 @@ NonnullRefPtr<PhysicalPage> CommittedPhysicalPageSet::take_one()
     return MM.allocate_committed_physical_page({}, MemoryManager::ShouldZeroFill::Yes);
 }
 
+Vector<NonnullRefPtr<PhysicalPage>> CommittedPhysicalPageSet::try_take_large_page()
+{
+    if (m_page_count < pages_per_large_page)
+        return {};
+    auto physical_pages = MM.allocate_committed_large_physical_page({});
+    if (!physical_pages.is_empty())
+        m_page_count -= pages_per_large_page;
+    return physical_pages;
+}
+
 void CommittedPhysicalPageSet::uncommit_one()
 {
     VERIFY(m_page_count > 0);
@@ -34,6 +34,10 @@ constexpr FlatPtr page_round_down(FlatPtr x)
     return ((FlatPtr)(x)) & ~(PAGE_SIZE - 1);
 }
 
+// A large page is mapped by a single page directory entry instead of a page table full of 4 KiB pages.
+constexpr size_t large_page_size = 2 * MiB;
+constexpr size_t pages_per_large_page = large_page_size / PAGE_SIZE;
+
 inline FlatPtr virtual_to_low_physical(FlatPtr virtual_)
 {
     return virtual_ - physical_to_virtual_offset;
@@ -114,6 +118,8 @@ public:
     size_t page_count() const { return m_page_count; }
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
+    // Takes pages_per_large_page physically contiguous pages that start on a large page boundary, or nothing if there are none left.
+    [[nodiscard]] Vector<NonnullRefPtr<PhysicalPage>> try_take_large_page();
     void uncommit_one();
 
     void operator=(CommittedPhysicalPageSet&&) = delete;
@@ -125,6 +131,7 @@ private:
 class MemoryManager {
     friend class PageDirectory;
     friend class AnonymousVMObject;
+    friend class CompressedPageStore;
     friend class Region;
     friend class RegionTree;
     friend class VMObject;
@@ -164,10 +171,16 @@ public:
     void uncommit_physical_pages(Badge<CommittedPhysicalPageSet>, size_t page_count);
 
     NonnullRefPtr<PhysicalPage> allocate_committed_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill = ShouldZeroFill::Yes);
+    Vector<NonnullRefPtr<PhysicalPage>> allocate_committed_large_physical_page(Badge<CommittedPhysicalPageSet>);
     ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
     ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> allocate_contiguous_physical_pages(size_t size);
     void deallocate_physical_page(PhysicalAddress);
 
+    // Ages the page cache of all file-backed VMObjects, and reclaims up to page_count unused inactive pages.
+    size_t reclaim_page_cache(size_t page_count);
+    // Compresses anonymous pages that weren't accessed since the previous call, until page_count of them are compressed.
+    size_t compress_cold_anonymous_pages(size_t page_count);
+
     ErrorOr<NonnullOwnPtr<Region>> allocate_contiguous_kernel_region(size_t, StringView name, Region::Access access, Region::Cacheable = Region::Cacheable::Yes);
     ErrorOr<NonnullOwnPtr<Memory::Region>> allocate_dma_buffer_page(StringView name, Memory::Region::Access access, RefPtr<Memory::PhysicalPage>& dma_buffer_page);
     ErrorOr<NonnullOwnPtr<Memory::Region>> allocate_dma_buffer_page(StringView name, Memory::Region::Access access);
@@ -176,6 +189,7 @@ public:
     ErrorOr<NonnullOwnPtr<Region>> allocate_kernel_region(size_t, StringView name, Region::Access access, AllocationStrategy strategy = AllocationStrategy::Reserve, Region::Cacheable = Region::Cacheable::Yes);
     ErrorOr<NonnullOwnPtr<Region>> allocate_kernel_region(PhysicalAddress, size_t, StringView name, Region::Access access, Region::Cacheable = Region::Cacheable::Yes);
     ErrorOr<NonnullOwnPtr<Region>> allocate_kernel_region_with_vmobject(VMObject&, size_t, StringView name, Region::Access access, Region::Cacheable = Region::Cacheable::Yes);
+    ErrorOr<NonnullOwnPtr<Region>> allocate_kernel_region_with_vmobject(VMObject&, size_t offset_in_vmobject, size_t, StringView name, Region::Access access, Region::Cacheable = Region::Cacheable::Yes);
     ErrorOr<NonnullOwnPtr<Region>> allocate_unbacked_region_anywhere(size_t size, size_t alignment);
     ErrorOr<NonnullOwnPtr<Region>> create_identity_mapped_region(PhysicalAddress, size_t);
 
@@ -184,6 +198,9 @@ public:
         PhysicalSize physical_pages_used { 0 };
         PhysicalSize physical_pages_committed { 0 };
         PhysicalSize physical_pages_uncommitted { 0 };
+
+        // Caches stop growing when fewer pages than this are left, and are shrunk to get back above it.
+        PhysicalSize low_watermark() const { return physical_pages / 32; }
     };
 
     SystemMemoryInfo get_system_memory_info();
@@ -216,6 +233,7 @@ public:
 
     PhysicalPage& shared_zero_page() { return *m_shared_zero_page; }
     PhysicalPage& lazy_committed_page() { return *m_lazy_committed_page; }
+    PhysicalPage& compressed_page() { return *m_compressed_page; }
 
     PageDirectory& kernel_page_directory() { return *m_kernel_page_directory; }
 
@@ -264,6 +282,8 @@ private:
 
     PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry* ensure_pte(PageDirectory&, VirtualAddress);
+    // Returns a cleared page directory entry for the caller to map a large page at vaddr, dropping any page table that was there.
+    PageDirectoryEntry* large_page_pde(PageDirectory&, VirtualAddress);
     enum class IsLastPTERelease {
         Yes,
         No
@@ -276,6 +296,7 @@ private:
     LockRefPtr<PageDirectory> m_kernel_page_directory;
     RefPtr<PhysicalPage> m_shared_zero_page;
     RefPtr<PhysicalPage> m_lazy_committed_page;
+    RefPtr<PhysicalPage> m_compressed_page;
 
     // NOTE: These are outside of GlobalData as they are initialized on startup,
     //       and then never change.
@@ -310,6 +331,11 @@ inline bool PhysicalPage::is_lazy_committed_page() const
     return this == &MM.lazy_committed_page();
 }
 
+inline bool PhysicalPage::is_compressed_page() const
+{
+    return this == &MM.compressed_page();
+}
+
 inline ErrorOr<Memory::VirtualRange> expand_range_to_page_boundaries(FlatPtr address, size_t size)
 {
     if ((address + size) < address)
@@ -42,6 +42,7 @@ public:
 
     bool is_shared_zero_page() const;
     bool is_lazy_committed_page() const;
+    bool is_compressed_page() const;
 
 private:
     explicit PhysicalPage(MayReturnToFreeList may_return_to_freelist);
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/BinarySearch.h>
 #include <AK/BuiltinWrappers.h>
 #include <Kernel/Library/Assertions.h>
 #include <Kernel/Memory/MemoryManager.h>
@@ -39,6 +40,24 @@ void PhysicalRegion::initialize_zones()
     size_t remaining_pages = m_pages;
     auto base_address = m_lower;
 
+    // Zones are naturally aligned to their own size, so that large pages can be carved out of them.
+    // If the region doesn't start on a large page boundary, fill the gap with smaller zones first.
+    if (m_lower.get() % large_page_size != 0) {
+        auto bytes_to_boundary = large_page_size - (m_lower.get() % large_page_size);
+        if (remaining_pages >= bytes_to_boundary / PAGE_SIZE + large_page_size / PAGE_SIZE) {
+            size_t zone_count = 0;
+            while (base_address.get() % large_page_size != 0) {
+                size_t pages_in_zone = 1 << count_trailing_zeroes(base_address.get() / PAGE_SIZE);
+                m_zones.append(adopt_nonnull_own_or_enomem(new (nothrow) PhysicalZone(base_address, pages_in_zone)).release_value_but_fixme_should_propagate_errors());
+                m_usable_zones.append(*m_zones.last());
+                base_address = base_address.offset(pages_in_zone * PAGE_SIZE);
+                remaining_pages -= pages_in_zone;
+                ++zone_count;
+            }
+            dmesgln(" * {}x PhysicalZone (alignment) @ {:016x}-{:016x}", zone_count, m_lower.get(), base_address.get() - 1);
+        }
+    }
+
     auto make_zones = [&](size_t zone_size) -> size_t {
         size_t pages_per_zone = zone_size / PAGE_SIZE;
         size_t zone_count = 0;
@@ -56,7 +75,7 @@ void PhysicalRegion::initialize_zones()
     };
 
     // First make 16 MiB zones (with 4096 pages each)
-    m_large_zones = make_zones(large_zone_size);
+    make_zones(large_zone_size);
 
     // Then divide any remaining space into 1 MiB zones (with 256 pages each)
     make_zones(small_zone_size);
@@ -102,6 +121,33 @@ Vector<NonnullRefPtr<PhysicalPage>> PhysicalRegion::take_contiguous_free_pages(s
     return physical_pages;
 }
 
+Vector<NonnullRefPtr<PhysicalPage>> PhysicalRegion::take_large_page()
+{
+    constexpr size_t order = count_trailing_zeroes(pages_per_large_page);
+
+    Optional<PhysicalAddress> page_base;
+    for (auto& zone : m_usable_zones) {
+        // A zone's blocks are aligned relative to its base, so only zones on a large page boundary can hand out large pages.
+        if (zone.base().get() % large_page_size != 0 || zone.available() < pages_per_large_page)
+            continue;
+        page_base = zone.allocate_block(order);
+        if (page_base.has_value()) {
+            if (zone.is_empty())
+                m_full_zones.append(zone);
+            break;
+        }
+    }
+
+    if (!page_base.has_value())
+        return {};
+
+    Vector<NonnullRefPtr<PhysicalPage>> physical_pages;
+    physical_pages.ensure_capacity(pages_per_large_page);
+    for (size_t i = 0; i < pages_per_large_page; ++i)
+        physical_pages.unchecked_append(PhysicalPage::create(page_base.value().offset(i * PAGE_SIZE)));
+    return physical_pages;
+}
+
 RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
 {
     if (m_usable_zones.is_empty())
@@ -121,17 +167,16 @@ RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
 
 void PhysicalRegion::return_page(PhysicalAddress paddr)
 {
-    auto large_zone_base = lower().get();
-    auto small_zone_base = lower().get() + (m_large_zones * large_zone_size);
-
-    size_t zone_index;
-    if (paddr.get() < small_zone_base)
-        zone_index = (paddr.get() - large_zone_base) / large_zone_size;
-    else
-        zone_index = m_large_zones + (paddr.get() - small_zone_base) / small_zone_size;
-
-    auto& zone = m_zones[zone_index];
-    VERIFY(zone->contains(paddr));
+    auto* zone_entry = binary_search(m_zones, paddr, nullptr, [](PhysicalAddress paddr, NonnullOwnPtr<PhysicalZone> const& zone) -> int {
+        if (paddr < zone->base())
+            return -1;
+        if (zone->contains(paddr))
+            return 0;
+        return 1;
+    });
+
+    VERIFY(zone_entry);
+    auto& zone = *zone_entry;
     zone->deallocate_block(paddr, 0);
     if (m_full_zones.contains(*zone))
         m_usable_zones.append(*zone);
@@ -36,6 +36,7 @@ public:
 
     RefPtr<PhysicalPage> take_free_page();
     Vector<NonnullRefPtr<PhysicalPage>> take_contiguous_free_pages(size_t count);
+    Vector<NonnullRefPtr<PhysicalPage>> take_large_page();
     void return_page(PhysicalAddress);
 
 private:
@@ -44,10 +45,9 @@ private:
     static constexpr size_t large_zone_size = 16 * MiB;
     static constexpr size_t small_zone_size = 1 * MiB;
 
+    // Sorted by base address.
     Vector<NonnullOwnPtr<PhysicalZone>> m_zones;
 
-    size_t m_large_zones { 0 };
-
     PhysicalZone::List m_usable_zones;
     PhysicalZone::List m_full_zones;
 
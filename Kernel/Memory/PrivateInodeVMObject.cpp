@@ -24,14 +24,18 @@ ErrorOr<NonnullLockRefPtr<PrivateInodeVMObject>> PrivateInodeVMObject::try_creat
     VERIFY(size > 0);
     auto new_physical_pages = TRY(VMObject::try_create_physical_pages(size));
     auto dirty_pages = TRY(Bitmap::create(new_physical_pages.size(), false));
-    return adopt_nonnull_lock_ref_or_enomem(new (nothrow) PrivateInodeVMObject(inode, move(new_physical_pages), move(dirty_pages)));
+    auto vmobject = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) PrivateInodeVMObject(inode, move(new_physical_pages), move(dirty_pages))));
+    TRY(vmobject->try_allocate_page_cache_bitmaps());
+    return vmobject;
 }
 
 ErrorOr<NonnullLockRefPtr<VMObject>> PrivateInodeVMObject::try_clone()
 {
     auto new_physical_pages = TRY(this->try_clone_physical_pages());
     auto dirty_pages = TRY(Bitmap::create(new_physical_pages.size(), false));
-    return adopt_nonnull_lock_ref_or_enomem<VMObject>(new (nothrow) PrivateInodeVMObject(*this, move(new_physical_pages), move(dirty_pages)));
+    auto vmobject = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) PrivateInodeVMObject(*this, move(new_physical_pages), move(dirty_pages))));
+    TRY(vmobject->try_allocate_page_cache_bitmaps());
+    return vmobject;
 }
 
 PrivateInodeVMObject::PrivateInodeVMObject(Inode& inode, FixedArray<RefPtr<PhysicalPage>>&& new_physical_pages, Bitmap dirty_pages)
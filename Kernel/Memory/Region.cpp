@@ -21,6 +21,12 @@
 
 namespace Kernel::Memory {
 
+// How far ahead of the faulting page sequentially faulted regions read.
+static constexpr size_t sequential_readahead_pages = 64;
+
+// Inode faults populate and map the whole aligned window of pages around the faulting page.
+static constexpr size_t fault_around_pages = 16;
+
 Region::Region()
     : m_range(VirtualRange({}, 0))
 {
@@ -117,6 +123,7 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
         region->set_mmap(m_mmap, m_mmapped_from_readable, m_mmapped_from_writable);
         region->set_shared(m_shared);
         region->set_syscall_region(is_syscall_region());
+        region->set_prefers_large_pages(m_prefers_large_pages);
         return region;
     }
 
@@ -142,6 +149,7 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
     }
     clone_region->set_syscall_region(is_syscall_region());
     clone_region->set_mmap(m_mmap, m_mmapped_from_readable, m_mmapped_from_writable);
+    clone_region->set_prefers_large_pages(m_prefers_large_pages);
     return clone_region;
 }
 
@@ -173,7 +181,7 @@ size_t Region::amount_resident() const
     size_t bytes = 0;
     for (size_t i = 0; i < page_count(); ++i) {
         auto page = physical_page(i);
-        if (page && !page->is_shared_zero_page() && !page->is_lazy_committed_page())
+        if (page && !page->is_shared_zero_page() && !page->is_lazy_committed_page() && !page->is_compressed_page())
             bytes += PAGE_SIZE;
     }
     return bytes;
@@ -184,7 +192,7 @@ size_t Region::amount_shared() const
     size_t bytes = 0;
     for (size_t i = 0; i < page_count(); ++i) {
         auto page = physical_page(i);
-        if (page && page->ref_count() > 1 && !page->is_shared_zero_page() && !page->is_lazy_committed_page())
+        if (page && page->ref_count() > 1 && !page->is_shared_zero_page() && !page->is_lazy_committed_page() && !page->is_compressed_page())
             bytes += PAGE_SIZE;
     }
     return bytes;
@@ -225,7 +233,8 @@ bool Region::map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage> pa
     if (!pte)
         return false;
 
-    if (!page || (!is_readable() && !is_writable())) {
+    // Compressed pages are decompressed by the fault on the next access.
+    if (!page || page->is_compressed_page() || (!is_readable() && !is_writable())) {
         pte->clear();
         return true;
     }
@@ -246,6 +255,51 @@ bool Region::map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage> pa
     return true;
 }
 
+bool Region::map_large_page_impl(size_t page_index)
+{
+#if ARCH(X86_64)
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+
+    // Only whole large pages of anonymous memory that are physically contiguous and aligned can be mapped this way.
+    // Everything else, including pages that still have to be faulted in or copied on write, needs individual pages.
+    auto page_vaddr = vaddr_from_page_index(page_index);
+    if (page_vaddr.get() % large_page_size != 0 || page_index + pages_per_large_page > page_count())
+        return false;
+    if (!vmobject().is_anonymous() || (!is_readable() && !is_writable()))
+        return false;
+
+    PhysicalAddress large_page_paddr;
+    {
+        SpinlockLocker vmobject_locker(vmobject().m_lock);
+        auto pages = vmobject().physical_pages().slice(first_page_index() + page_index, pages_per_large_page);
+        if (!pages[0] || pages[0]->paddr().get() % large_page_size != 0)
+            return false;
+        large_page_paddr = pages[0]->paddr();
+        for (size_t i = 0; i < pages_per_large_page; ++i) {
+            if (!pages[i] || pages[i]->paddr() != large_page_paddr.offset(i * PAGE_SIZE) || should_cow(page_index + i))
+                return false;
+        }
+    }
+
+    bool user_allowed = page_vaddr.get() >= USER_RANGE_BASE && is_user_address(page_vaddr);
+    auto* pde = MM.large_page_pde(*m_page_directory, page_vaddr);
+    pde->set_page_table_base(large_page_paddr.get());
+    pde->set_huge(true);
+    pde->set_cache_disabled(!m_cacheable);
+    pde->set_writable(is_writable());
+    if (Processor::current().has_nx())
+        pde->set_execute_disabled(!is_executable());
+    if (Processor::current().has_pat())
+        pde->set_large_page_pat(is_write_combine());
+    pde->set_user_allowed(user_allowed);
+    pde->set_present(true);
+    return true;
+#else
+    (void)page_index;
+    return false;
+#endif
+}
+
 bool Region::map_individual_page_impl(size_t page_index)
 {
     RefPtr<PhysicalPage> page;
@@ -310,6 +364,10 @@ ErrorOr<void> Region::map(PageDirectory& page_directory, ShouldFlushTLB should_f
     set_page_directory(page_directory);
     size_t page_index = 0;
     while (page_index < page_count()) {
+        if (map_large_page_impl(page_index)) {
+            page_index += pages_per_large_page;
+            continue;
+        }
         if (!map_individual_page_impl(page_index))
             break;
         ++page_index;
@@ -356,6 +414,36 @@ void Region::clear_to_zero()
     }
 }
 
+static bool test_and_clear_accessed_bit(PageTableEntry& pte)
+{
+#if ARCH(X86_64)
+    bool accessed = pte.is_accessed();
+    pte.set_accessed(false);
+    return accessed;
+#else
+    // FIXME: Look at the accessed bits on other architectures as well, until then all pages count as recently used.
+    (void)pte;
+    return true;
+#endif
+}
+
+void Region::clear_accessed_bits(Bitmap& accessed_vmobject_pages)
+{
+    if (!m_page_directory)
+        return;
+
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    for (size_t i = 0; i < page_count(); ++i) {
+        // Without a page table entry, the page can't have been accessed through this region.
+        // The exception are large pages, which only anonymous memory uses, and those are never considered unused.
+        auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(i));
+        if (pte ? test_and_clear_accessed_bit(*pte) : vmobject().is_anonymous())
+            accessed_vmobject_pages.set(first_page_index() + i, true);
+    }
+    // The CPU only sets the accessed bit again when it has to walk the page tables, so drop what it has cached.
+    MemoryManager::flush_tlb(m_page_directory, vaddr(), page_count());
+}
+
 PageFaultResponse Region::handle_fault(PageFault const& fault)
 {
     auto page_index_in_region = page_index_from_address(fault.vaddr());
@@ -383,6 +471,11 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
                 return PageFaultResponse::OutOfMemory;
             return PageFaultResponse::Continue;
         }
+        if (page_slot->is_compressed_page()) {
+            vmobject_locker.unlock();
+            dbgln_if(PAGE_FAULT_DEBUG, "NP(compressed) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
+            return handle_compressed_fault(page_index_in_region);
+        }
         dbgln("BUG! Unexpected NP fault at {}", fault.vaddr());
         dbgln("     - Physical page slot pointer: {:p}", page_slot.ptr());
         if (page_slot) {
@@ -416,6 +509,9 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
     if (current_thread != nullptr)
         current_thread->did_zero_fault();
 
+    if (m_prefers_large_pages && page_in_slot_at_time_of_fault.is_lazy_committed_page() && try_handle_large_zero_fault(page_index_in_region))
+        return PageFaultResponse::Continue;
+
     RefPtr<PhysicalPage> new_physical_page;
 
     if (page_in_slot_at_time_of_fault.is_lazy_committed_page()) {
@@ -454,6 +550,51 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
     return PageFaultResponse::Continue;
 }
 
+bool Region::try_handle_large_zero_fault(size_t page_index_in_region)
+{
+#if ARCH(X86_64)
+    // Fault in the whole large page around the faulting address, as long as it's entirely inside this region.
+    auto large_page_vaddr = VirtualAddress { vaddr_from_page_index(page_index_in_region).get() & ~(FlatPtr)(large_page_size - 1) };
+    if (!range().contains(large_page_vaddr, large_page_size))
+        return false;
+    auto first_page_index_in_region = (large_page_vaddr - vaddr()).get() / PAGE_SIZE;
+
+    if (!static_cast<AnonymousVMObject&>(vmobject()).try_allocate_committed_large_page({}, translate_to_vmobject_page(first_page_index_in_region)))
+        return false;
+
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    if (!map_large_page_impl(first_page_index_in_region)) {
+        // The pages may still have to be copied on write, so map them one by one.
+        // If we run out of page tables on the way, the regular zero fault path will find the new page and try again.
+        for (size_t i = 0; i < pages_per_large_page; ++i) {
+            if (!map_individual_page_impl(first_page_index_in_region + i))
+                return false;
+        }
+    }
+    MemoryManager::flush_tlb(m_page_directory, large_page_vaddr, pages_per_large_page);
+    return true;
+#else
+    (void)page_index_in_region;
+    return false;
+#endif
+}
+
+PageFaultResponse Region::handle_compressed_fault(size_t page_index_in_region)
+{
+    VERIFY(vmobject().is_anonymous());
+
+    auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
+    if (auto result = static_cast<AnonymousVMObject&>(vmobject()).decompress_page(page_index_in_vmobject); result.is_error()) {
+        if (result.error().code() == ENOMEM) {
+            dmesgln("MM: handle_compressed_fault was unable to allocate a physical page");
+            return PageFaultResponse::OutOfMemory;
+        }
+        dmesgln("MM: handle_compressed_fault was unable to decompress the page: {}", result.error());
+        return PageFaultResponse::BusError;
+    }
+    return PageFaultResponse::Continue;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     auto current_thread = Thread::current();
@@ -470,6 +611,31 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
     return response;
 }
 
+// Reads a page of the inode into a new physical page, or returns nullptr if the page is past the end of the file.
+ErrorOr<RefPtr<PhysicalPage>> Region::read_page_from_inode(Inode& inode, size_t page_index_in_vmobject)
+{
+    u8 page_buffer[PAGE_SIZE];
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
+    auto nread = TRY(inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr));
+    if (nread == 0)
+        return nullptr;
+
+    if (nread < PAGE_SIZE) {
+        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+    }
+
+    // Allocate a new physical page, and copy the read inode contents into it.
+    auto new_physical_page = TRY(MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No));
+    {
+        InterruptDisabler disabler;
+        u8* dest_ptr = MM.quickmap_page(*new_physical_page);
+        memcpy(dest_ptr, page_buffer, PAGE_SIZE);
+        MM.unquickmap_page();
+    }
+    return new_physical_page;
+}
+
 PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
 {
     VERIFY(vmobject().is_inode());
@@ -480,6 +646,7 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
     auto& vmobject_physical_page_slot = inode_vmobject.physical_pages()[page_index_in_vmobject];
 
+    bool already_faulted_in = false;
     {
         // NOTE: The VMObject lock is required when manipulating the VMObject's physical page slot.
         SpinlockLocker locker(inode_vmobject.m_lock);
@@ -487,9 +654,15 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
             dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Page faulted in by someone else before reading, remapping.");
             if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
                 return PageFaultResponse::OutOfMemory;
-            return PageFaultResponse::Continue;
+            inode_vmobject.mark_page_accessed(page_index_in_vmobject);
+            already_faulted_in = true;
         }
     }
+    if (already_faulted_in) {
+        // Another region of a shared file mapping most likely faulted in its neighbors as well.
+        fault_around(page_index_in_region);
+        return PageFaultResponse::Continue;
+    }
 
     dbgln_if(PAGE_FAULT_DEBUG, "Inode fault in {} page index: {}", name(), page_index_in_region);
 
@@ -497,41 +670,30 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     if (current_thread)
         current_thread->did_inode_fault();
 
-    u8 page_buffer[PAGE_SIZE];
     auto& inode = inode_vmobject.inode();
-
-    auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
-    auto result = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, buffer, nullptr);
-
-    if (result.is_error()) {
-        dmesgln("handle_inode_fault: Error ({}) while reading from inode", result.error());
+    auto new_physical_page_or_error = read_page_from_inode(inode, page_index_in_vmobject);
+    if (new_physical_page_or_error.is_error()) {
+        if (new_physical_page_or_error.error().code() == ENOMEM) {
+            dmesgln("MM: handle_inode_fault was unable to allocate a physical page");
+            return PageFaultResponse::OutOfMemory;
+        }
+        dmesgln("handle_inode_fault: Error ({}) while reading from inode", new_physical_page_or_error.error());
         return PageFaultResponse::ShouldCrash;
     }
 
-    auto nread = result.value();
-    // Note: If we received 0, it means we are at the end of file or after it,
+    // Note: If we received nothing, it means we are at the end of file or after it,
     // which means we should return bus error.
-    if (nread == 0)
+    auto new_physical_page = new_physical_page_or_error.release_value();
+    if (!new_physical_page)
         return PageFaultResponse::BusError;
+    InodeVMObject::did_miss_page_cache();
 
-    if (nread < PAGE_SIZE) {
-        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
-        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
-    }
-
-    // Allocate a new physical page, and copy the read inode contents into it.
-    auto new_physical_page_or_error = MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No);
-    if (new_physical_page_or_error.is_error()) {
-        dmesgln("MM: handle_inode_fault was unable to allocate a physical page");
-        return PageFaultResponse::OutOfMemory;
-    }
-    auto new_physical_page = new_physical_page_or_error.release_value();
-    {
-        InterruptDisabler disabler;
-        u8* dest_ptr = MM.quickmap_page(*new_physical_page);
-        memcpy(dest_ptr, page_buffer, PAGE_SIZE);
-        MM.unquickmap_page();
-    }
+    // Faults that keep moving forward through the file (or a MADV_SEQUENTIAL hint) keep the inode's next pages
+    // in the file system's cache ahead of the faults, which the file system reads in asynchronously.
+    bool is_sequential = m_access_pattern == AccessPattern::Sequential
+        || (m_access_pattern == AccessPattern::Normal && page_index_in_vmobject == m_next_sequential_fault_page_index);
+    if (is_sequential && page_index_in_vmobject % sequential_readahead_pages < fault_around_pages)
+        inode.readahead((page_index_in_vmobject + 1) * PAGE_SIZE, 2 * sequential_readahead_pages * PAGE_SIZE);
 
     {
         // NOTE: The VMObject lock is required when manipulating the VMObject's physical page slot.
@@ -552,9 +714,53 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
         return PageFaultResponse::OutOfMemory;
 
+    fault_around(page_index_in_region);
     return PageFaultResponse::Continue;
 }
 
+void Region::fault_around(size_t page_index_in_region)
+{
+    // Randomly accessed regions only get the pages they actually touch.
+    if (m_access_pattern == AccessPattern::Random)
+        return;
+
+    auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
+    size_t first_page_index = page_index_in_region - (page_index_in_region % fault_around_pages);
+    size_t end_page_index = min(first_page_index + fault_around_pages, page_count());
+
+    // Map the pages of the window that are already in the VMObject in one go, which is a lot cheaper than taking
+    // a fault for each of them. Faults must not wait for the disk on behalf of their neighbors, so the pages that
+    // nobody has read in yet are only read into the file system's cache asynchronously, ahead of their own faults.
+    Optional<size_t> first_missing_page_index;
+    size_t end_missing_page_index = 0;
+    {
+        SpinlockLocker page_lock(m_page_directory->get_lock());
+        for (size_t i = first_page_index; i < end_page_index; ++i) {
+            if (i == page_index_in_region)
+                continue;
+            if (physical_page(i).is_null()) {
+                if (!first_missing_page_index.has_value())
+                    first_missing_page_index = i;
+                end_missing_page_index = i + 1;
+                continue;
+            }
+            auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(i));
+            if (pte && pte->is_present())
+                continue;
+            if (!map_individual_page_impl(i))
+                break;
+        }
+        MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(first_page_index), end_page_index - first_page_index);
+    }
+
+    if (first_missing_page_index.has_value()) {
+        auto first_missing_page_index_in_vmobject = translate_to_vmobject_page(first_missing_page_index.value());
+        inode_vmobject.inode().readahead(first_missing_page_index_in_vmobject * PAGE_SIZE, (end_missing_page_index - first_missing_page_index.value()) * PAGE_SIZE);
+    }
+
+    m_next_sequential_fault_page_index = translate_to_vmobject_page(end_page_index);
+}
+
 RefPtr<PhysicalPage> Region::physical_page(size_t index) const
 {
     SpinlockLocker vmobject_locker(vmobject().m_lock);
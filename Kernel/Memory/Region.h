@@ -33,6 +33,7 @@ enum class ShouldFlushTLB {
 class Region final
     : public LockWeakable<Region> {
     friend class AddressSpace;
+    friend class AnonymousVMObject;
     friend class MemoryManager;
     friend class RegionTree;
 
@@ -55,6 +56,13 @@ public:
         Yes,
     };
 
+    // How userspace expects to access the region, as told by madvise().
+    enum class AccessPattern : u8 {
+        Normal,
+        Sequential,
+        Random,
+    };
+
     static ErrorOr<NonnullOwnPtr<Region>> try_create_user_accessible(VirtualRange const&, NonnullLockRefPtr<VMObject>, size_t offset_in_vmobject, OwnPtr<KString> name, Region::Access access, Cacheable, bool shared);
     static ErrorOr<NonnullOwnPtr<Region>> create_unbacked();
     static ErrorOr<NonnullOwnPtr<Region>> create_unplaced(NonnullLockRefPtr<VMObject>, size_t offset_in_vmobject, OwnPtr<KString> name, Region::Access access, Cacheable = Cacheable::Yes, bool shared = false);
@@ -104,11 +112,18 @@ public:
     [[nodiscard]] bool is_write_combine() const { return m_write_combine; }
     ErrorOr<void> set_write_combine(bool);
 
+    // Lazily committed memory is faulted in a large page at a time, instead of one page at a time.
+    [[nodiscard]] bool prefers_large_pages() const { return m_prefers_large_pages; }
+    void set_prefers_large_pages(bool prefers_large_pages) { m_prefers_large_pages = prefers_large_pages; }
+
     [[nodiscard]] bool is_user() const { return !is_kernel(); }
     [[nodiscard]] bool is_kernel() const { return vaddr().get() < USER_RANGE_BASE || vaddr().get() >= kernel_mapping_base; }
 
     PageFaultResponse handle_fault(PageFault const&);
 
+    // Clears the accessed bits of all pages, and marks the ones that had it set in the given bitmap of VMObject pages.
+    void clear_accessed_bits(Bitmap& accessed_vmobject_pages);
+
     ErrorOr<NonnullOwnPtr<Region>> try_clone();
 
     [[nodiscard]] bool contains(VirtualAddress vaddr) const
@@ -204,6 +219,9 @@ public:
     [[nodiscard]] bool is_syscall_region() const { return m_syscall_region; }
     void set_syscall_region(bool b) { m_syscall_region = b; }
 
+    [[nodiscard]] AccessPattern access_pattern() const { return m_access_pattern; }
+    void set_access_pattern(AccessPattern access_pattern) { m_access_pattern = access_pattern; }
+
     [[nodiscard]] bool mmapped_from_readable() const { return m_mmapped_from_readable; }
     [[nodiscard]] bool mmapped_from_writable() const { return m_mmapped_from_writable; }
 
@@ -227,10 +245,15 @@ private:
 
     [[nodiscard]] PageFaultResponse handle_cow_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_inode_fault(size_t page_index);
+    void fault_around(size_t page_index);
+    static ErrorOr<RefPtr<PhysicalPage>> read_page_from_inode(Inode&, size_t page_index_in_vmobject);
     [[nodiscard]] PageFaultResponse handle_zero_fault(size_t page_index, PhysicalPage& page_in_slot_at_time_of_fault);
+    [[nodiscard]] PageFaultResponse handle_compressed_fault(size_t page_index);
+    [[nodiscard]] bool try_handle_large_zero_fault(size_t page_index);
 
     [[nodiscard]] bool map_individual_page_impl(size_t page_index);
     [[nodiscard]] bool map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage>);
+    [[nodiscard]] bool map_large_page_impl(size_t page_index);
 
     LockRefPtr<PageDirectory> m_page_directory;
     VirtualRange m_range;
@@ -238,6 +261,8 @@ private:
     LockRefPtr<VMObject> m_vmobject;
     OwnPtr<KString> m_name;
     Atomic<u32> m_in_progress_page_faults;
+    // Where the next inode fault is expected if this region is being faulted in front to back.
+    size_t m_next_sequential_fault_page_index { 0 };
     u8 m_access { Region::None };
     bool m_shared : 1 { false };
     bool m_cacheable : 1 { false };
@@ -248,6 +273,8 @@ private:
     bool m_write_combine : 1 { false };
     bool m_mmapped_from_readable : 1 { false };
     bool m_mmapped_from_writable : 1 { false };
+    bool m_prefers_large_pages : 1 { false };
+    AccessPattern m_access_pattern : 2 { AccessPattern::Normal };
 
     IntrusiveRedBlackTreeNode<FlatPtr, Region, RawPtr<Region>> m_tree_node;
     IntrusiveListNode<Region> m_vmobject_list_node;
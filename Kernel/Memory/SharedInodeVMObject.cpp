@@ -28,6 +28,7 @@ ErrorOr<NonnullLockRefPtr<SharedInodeVMObject>> SharedInodeVMObject::try_create_
     auto new_physical_pages = TRY(VMObject::try_create_physical_pages(size));
     auto dirty_pages = TRY(Bitmap::create(new_physical_pages.size(), false));
     auto vmobject = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) SharedInodeVMObject(inode, move(new_physical_pages), move(dirty_pages))));
+    TRY(vmobject->try_allocate_page_cache_bitmaps());
     TRY(vmobject->inode().set_shared_vmobject(*vmobject));
     return vmobject;
 }
@@ -36,7 +37,9 @@ ErrorOr<NonnullLockRefPtr<VMObject>> SharedInodeVMObject::try_clone()
 {
     auto new_physical_pages = TRY(this->try_clone_physical_pages());
     auto dirty_pages = TRY(Bitmap::create(new_physical_pages.size(), false));
-    return adopt_nonnull_lock_ref_or_enomem<VMObject>(new (nothrow) SharedInodeVMObject(*this, move(new_physical_pages), move(dirty_pages)));
+    auto vmobject = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) SharedInodeVMObject(*this, move(new_physical_pages), move(dirty_pages))));
+    TRY(vmobject->try_allocate_page_cache_bitmaps());
+    return vmobject;
 }
 
 SharedInodeVMObject::SharedInodeVMObject(Inode& inode, FixedArray<RefPtr<PhysicalPage>>&& new_physical_pages, Bitmap dirty_pages)
@@ -38,7 +38,7 @@ MutexProtected<IPv4Socket::List>& IPv4Socket::all_sockets()
 
 ErrorOr<NonnullOwnPtr<DoubleBuffer>> IPv4Socket::try_create_receive_buffer()
 {
-    return DoubleBuffer::try_create("IPv4Socket: Receive buffer"sv, 256 * KiB);
+    return DoubleBuffer::try_create("IPv4Socket: Receive buffer"sv, receive_buffer_size);
 }
 
 ErrorOr<NonnullRefPtr<Socket>> IPv4Socket::create(int type, int protocol)
@@ -427,8 +427,12 @@ bool IPv4Socket::did_receive(IPv4Address const& source_address, u16 source_port,
     if (buffer_mode() == BufferMode::Bytes) {
         VERIFY(m_receive_buffer);
 
+        // NOTE: Only the payload ends up in the buffer, and TCP advertises its window based on exactly that.
+        auto payload_size_or_error = protocol_size(packet);
+        if (payload_size_or_error.is_error())
+            return false;
         size_t space_in_receive_buffer = m_receive_buffer->space_for_writing();
-        if (packet_size > space_in_receive_buffer) {
+        if (payload_size_or_error.value() > space_in_receive_buffer) {
             dbgln("IPv4Socket({}): did_receive refusing packet since buffer is full.", this);
             VERIFY(m_can_read);
             return false;
@@ -899,4 +903,11 @@ void IPv4Socket::drop_receive_buffer()
     m_receive_buffer = nullptr;
 }
 
+size_t IPv4Socket::receive_buffer_space() const
+{
+    if (!m_receive_buffer)
+        return 0;
+    return m_receive_buffer->space_for_writing();
+}
+
 }
@@ -67,6 +67,8 @@ public:
     };
     BufferMode buffer_mode() const { return m_buffer_mode; }
 
+    static constexpr size_t receive_buffer_size = 256 * KiB;
+
 protected:
     IPv4Socket(int type, int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, OwnPtr<KBuffer> optional_scratch_buffer);
     virtual StringView class_name() const override { return "IPv4Socket"sv; }
@@ -89,6 +91,7 @@ protected:
 
     static ErrorOr<NonnullOwnPtr<DoubleBuffer>> try_create_receive_buffer();
     void drop_receive_buffer();
+    size_t receive_buffer_space() const;
 
 private:
     virtual bool is_ipv4() const override { return true; }
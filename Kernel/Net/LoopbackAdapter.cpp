@@ -4,12 +4,15 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/Singleton.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Security/Random.h>
 
 namespace Kernel {
 
 static bool s_loopback_initialized = false;
+static Atomic<u32, AK::MemoryOrder::memory_order_relaxed> s_packet_loss_percentage { 0 };
 
 ErrorOr<NonnullRefPtr<LoopbackAdapter>> LoopbackAdapter::try_create()
 {
@@ -26,6 +29,7 @@ LoopbackAdapter::LoopbackAdapter(StringView interface_name)
     // by the data-link (Ethernet in this case) or physical layers, we need to subtract it from the MTU.
     set_mtu(65536 - sizeof(EthernetFrameHeader));
     set_mac_address({ 19, 85, 2, 9, 0x55, 0xaa });
+    set_offloads(Offload::TransmitChecksum);
 }
 
 LoopbackAdapter::~LoopbackAdapter() = default;
@@ -33,7 +37,29 @@ LoopbackAdapter::~LoopbackAdapter() = default;
 void LoopbackAdapter::send_raw(ReadonlyBytes payload)
 {
     dbgln_if(LOOPBACK_DEBUG, "LoopbackAdapter: Sending {} byte(s) to myself.", payload.size());
+    auto packet_loss_percentage = s_packet_loss_percentage.load();
+    if (packet_loss_percentage > 0 && get_fast_random<u32>() % 100 < packet_loss_percentage) {
+        dbgln_if(LOOPBACK_DEBUG, "LoopbackAdapter: Dropping {} byte(s).", payload.size());
+        return;
+    }
     did_receive(payload);
 }
 
+void LoopbackAdapter::send_raw_with_offload(ReadonlyBytes payload, TransmitOffload const&)
+{
+    // NOTE: Packets never leave memory, so there is no need to checksum them at all.
+    send_raw(payload);
+}
+
+u32 LoopbackAdapter::packet_loss_percentage()
+{
+    return s_packet_loss_percentage.load();
+}
+
+void LoopbackAdapter::set_packet_loss_percentage(u32 percentage)
+{
+    VERIFY(percentage <= 100);
+    s_packet_loss_percentage.store(percentage);
+}
+
 }
@@ -21,11 +21,16 @@ public:
     virtual ErrorOr<void> initialize(Badge<NetworkingManagement>) override { VERIFY_NOT_REACHED(); }
 
     virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offload(ReadonlyBytes, TransmitOffload const&) override;
     virtual StringView class_name() const override { return "LoopbackAdapter"sv; }
     virtual Type adapter_type() const override { return Type::Loopback; }
     virtual bool link_up() override { return true; }
     virtual bool link_full_duplex() override { return true; }
     virtual int link_speed() override { return 1000; }
+
+    // Drops a share of the packets sent through the adapter, to test how protocols deal with loss.
+    static u32 packet_loss_percentage();
+    static void set_packet_loss_percentage(u32);
 };
 
 }
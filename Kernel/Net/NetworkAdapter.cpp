@@ -5,7 +5,6 @@
  */
 
 #include <Kernel/Heap/kmalloc.h>
-#include <Kernel/Interrupts/InterruptDisabler.h>
 #include <Kernel/Library/StdLib.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/NetworkAdapter.h>
@@ -28,6 +27,19 @@ void NetworkAdapter::send_packet(ReadonlyBytes packet)
     send_raw(packet);
 }
 
+void NetworkAdapter::send_packet(ReadonlyBytes packet, TransmitOffload const& offload)
+{
+    if (!offload.needs_checksum && offload.segment_size == 0) {
+        send_packet(packet);
+        return;
+    }
+    VERIFY(!offload.needs_checksum || has_offload(Offload::TransmitChecksum));
+    VERIFY(offload.segment_size == 0 || has_offload(Offload::TCPSegmentation));
+    m_packets_out++;
+    m_bytes_out += packet.size();
+    send_raw_with_offload(packet, offload);
+}
+
 void NetworkAdapter::send(MACAddress const& destination, ARPPacket const& packet)
 {
     size_t size_in_bytes = sizeof(EthernetFrameHeader) + sizeof(ARPPacket);
@@ -47,7 +59,7 @@ void NetworkAdapter::send(MACAddress const& destination, ARPPacket const& packet
 void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Address const& source_ipv4, MACAddress const& destination_mac, IPv4Address const& destination_ipv4, IPv4Protocol protocol, size_t payload_size, u8 type_of_service, u8 ttl)
 {
     size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
-    VERIFY(ipv4_packet_size <= mtu());
+    VERIFY(ipv4_packet_size <= max_send_size());
 
     size_t ethernet_frame_size = ipv4_payload_offset() + payload_size;
     VERIFY(packet.buffer->size() == ethernet_frame_size);
@@ -71,15 +83,9 @@ void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Addres
 
 void NetworkAdapter::did_receive(ReadonlyBytes payload)
 {
-    InterruptDisabler disabler;
     m_packets_in++;
     m_bytes_in += payload.size();
 
-    if (m_packet_queue_size == max_packet_buffers) {
-        // FIXME: Keep track of the number of dropped packets
-        return;
-    }
-
     auto packet = acquire_packet_buffer(payload.size());
     if (!packet) {
         dbgln("Discarding packet because we're out of memory");
@@ -88,27 +94,31 @@ void NetworkAdapter::did_receive(ReadonlyBytes payload)
 
     memcpy(packet->buffer->data(), payload.data(), payload.size());
 
-    m_packet_queue.append(*packet);
-    m_packet_queue_size++;
+    bool was_queued = m_packet_queue.with([&](auto& queue) {
+        if (queue.size == max_packet_buffers)
+            return false;
+        queue.packets.append(*packet);
+        queue.size++;
+        return true;
+    });
+    if (!was_queued) {
+        // FIXME: Keep track of the number of dropped packets
+        release_packet_buffer(*packet);
+        return;
+    }
 
     if (on_receive)
         on_receive();
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, UnixDateTime& packet_timestamp)
+RefPtr<PacketWithTimestamp> NetworkAdapter::dequeue_packet()
 {
-    InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
-        return 0;
-    auto packet_with_timestamp = m_packet_queue.take_first();
-    m_packet_queue_size--;
-    packet_timestamp = packet_with_timestamp->timestamp;
-    auto& packet_buffer = packet_with_timestamp->buffer;
-    size_t packet_size = packet_buffer->size();
-    VERIFY(packet_size <= buffer_size);
-    memcpy(buffer, packet_buffer->data(), packet_size);
-    release_packet_buffer(*packet_with_timestamp);
-    return packet_size;
+    return m_packet_queue.with([](auto& queue) -> RefPtr<PacketWithTimestamp> {
+        if (queue.packets.is_empty())
+            return nullptr;
+        queue.size--;
+        return queue.packets.take_first();
+    });
 }
 
 RefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
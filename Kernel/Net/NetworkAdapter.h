@@ -8,9 +8,11 @@
 
 #include <AK/AtomicRefCounted.h>
 #include <AK/ByteBuffer.h>
+#include <AK/EnumBits.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
 #include <AK/MACAddress.h>
+#include <AK/NumericLimits.h>
 #include <AK/Types.h>
 #include <Kernel/Bus/PCI/Definitions.h>
 #include <Kernel/Library/KBuffer.h>
@@ -42,6 +44,17 @@ struct PacketWithTimestamp final : public AtomicRefCounted<PacketWithTimestamp>
     IntrusiveListNode<PacketWithTimestamp, RefPtr<PacketWithTimestamp>> packet_node;
 };
 
+// What an adapter should still do to a packet while sending it, instead of the network stack.
+struct TransmitOffload {
+    // The adapter stores the checksum of everything from checksum_start to the end of the packet at checksum_start + checksum_offset.
+    // The stack has only put the sum of the pseudo-header there.
+    bool needs_checksum { false };
+    u16 checksum_start { 0 };
+    u16 checksum_offset { 0 };
+    // A TCP packet that is larger than the MTU, which the adapter splits into segments with this much payload each.
+    u16 segment_size { 0 };
+};
+
 class NetworkingManagement;
 class NetworkAdapter
     : public AtomicRefCounted<NetworkAdapter>
@@ -52,6 +65,13 @@ public:
         Ethernet
     };
 
+    enum class Offload : u8 {
+        None = 0,
+        TransmitChecksum = 1 << 0,
+        TCPSegmentation = 1 << 1,
+    };
+    AK_ENUM_BITWISE_FRIEND_OPERATORS(Offload);
+
     static constexpr i32 LINKSPEED_INVALID = -1;
 
     virtual ~NetworkAdapter();
@@ -79,13 +99,22 @@ public:
     void send(MACAddress const&, ARPPacket const&);
     void fill_in_ipv4_header(PacketWithTimestamp&, IPv4Address const&, MACAddress const&, IPv4Address const&, IPv4Protocol, size_t, u8 type_of_service, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size, UnixDateTime& packet_timestamp);
+    // Hands out the oldest received packet, which should be given back with release_packet_buffer() once it was handled.
+    RefPtr<PacketWithTimestamp> dequeue_packet();
 
-    bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
+    bool has_queued_packets() const
+    {
+        return m_packet_queue.with([](auto& queue) { return !queue.packets.is_empty(); });
+    }
 
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
 
+    Offload offloads() const { return m_offloads; }
+    bool has_offload(Offload offload) const { return has_flag(m_offloads, offload); }
+    // With segmentation offload, TCP packets can be as large as IPv4 allows, no matter the MTU.
+    size_t max_send_size() const { return has_offload(Offload::TCPSegmentation) ? NumericLimits<u16>::max() : mtu(); }
+
     u32 packets_in() const { return m_packets_in; }
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
@@ -100,12 +129,16 @@ public:
     Function<void()> on_receive;
 
     void send_packet(ReadonlyBytes);
+    void send_packet(ReadonlyBytes, TransmitOffload const&);
 
 protected:
     NetworkAdapter(StringView);
     void set_mac_address(MACAddress const& mac_address) { m_mac_address = mac_address; }
     void did_receive(ReadonlyBytes);
+    void set_offloads(Offload offloads) { m_offloads = offloads; }
     virtual void send_raw(ReadonlyBytes) = 0;
+    // Only used for the offloads the adapter has advertised.
+    virtual void send_raw_with_offload(ReadonlyBytes, TransmitOffload const&) { VERIFY_NOT_REACHED(); }
 
 private:
     MACAddress m_mac_address;
@@ -117,8 +150,13 @@ private:
 
     using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
 
-    PacketList m_packet_queue;
-    size_t m_packet_queue_size { 0 };
+    struct PacketQueue {
+        PacketList packets;
+        size_t size { 0 };
+    };
+
+    // NOTE: Packets are queued from interrupt handlers, and taken off the queue by the network task.
+    SpinlockProtected<PacketQueue, LockRank::None> m_packet_queue {};
     SpinlockProtected<PacketList, LockRank::None> m_unused_packets {};
     FixedStringBuffer<IFNAMSIZ> m_name;
     u32 m_packets_in { 0 };
@@ -126,6 +164,7 @@ private:
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
     u32 m_mtu { 1500 };
+    Offload m_offloads { Offload::None };
 };
 
 }
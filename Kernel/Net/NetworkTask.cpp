@@ -4,15 +4,20 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/AnyOf.h>
+#include <AK/CircularQueue.h>
+#include <Kernel/Arch/Processor.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/MutexProtected.h>
+#include <Kernel/Locking/SpinlockProtected.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/IPv4SocketTuple.h>
 #include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Net/NetworkingManagement.h>
@@ -25,6 +30,9 @@
 
 namespace Kernel {
 
+struct NetworkWorker;
+
+static void handle_frame(ReadonlyBytes frame, UnixDateTime const& packet_timestamp);
 static void handle_arp(EthernetFrameHeader const&, size_t frame_size);
 static void handle_ipv4(EthernetFrameHeader const&, size_t frame_size, UnixDateTime const& packet_timestamp);
 static void handle_icmp(EthernetFrameHeader const&, IPv4Packet const&, UnixDateTime const& packet_timestamp);
@@ -32,13 +40,44 @@ static void handle_udp(IPv4Packet const&, UnixDateTime const& packet_timestamp);
 static void handle_tcp(IPv4Packet const&, UnixDateTime const& packet_timestamp);
 static void send_delayed_tcp_ack(TCPSocket& socket);
 static void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, RefPtr<NetworkAdapter> adapter);
-static void flush_delayed_tcp_acks();
-static void retransmit_tcp_packets();
+static void flush_delayed_tcp_acks(NetworkWorker&);
+static void retransmit_tcp_packets(NetworkWorker&);
+
+// Received frames are spread over one worker per processor by the flow they belong to.
+// All frames of a flow end up with the same worker, so a connection still sees its segments in order,
+// while different connections are handled in parallel.
+struct NetworkWorker {
+    struct Frame {
+        NonnullRefPtr<NetworkAdapter> adapter;
+        NonnullRefPtr<PacketWithTimestamp> packet;
+    };
+
+    // FIXME: Make this configurable
+    static constexpr size_t max_queued_frames = 512;
+
+    struct FrameQueue {
+        CircularQueue<Frame, max_queued_frames> frames;
+        size_t max_size { 0 };
+    };
+
+    u32 processor { 0 };
+    Thread* thread { nullptr };
+    WaitQueue wait_queue;
+    SpinlockProtected<FrameQueue, LockRank::None> queue {};
+
+    // Only ever touched by the worker itself.
+    HashTable<NonnullRefPtr<TCPSocket>> delayed_ack_sockets;
+
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> packets { 0 };
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> bytes { 0 };
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> dropped_packets { 0 };
+};
 
 static Thread* network_task = nullptr;
-static HashTable<NonnullRefPtr<TCPSocket>>* delayed_ack_sockets;
+static Atomic<Vector<NonnullOwnPtr<NetworkWorker>>*> s_workers { nullptr };
 
 [[noreturn]] static void NetworkTask_main(void*);
+[[noreturn]] static void NetworkWorker_main(void*);
 
 void NetworkTask::spawn()
 {
@@ -48,15 +87,98 @@ void NetworkTask::spawn()
 
 bool NetworkTask::is_current()
 {
-    return Thread::current() == network_task;
+    auto* current_thread = Thread::current();
+    if (current_thread == network_task)
+        return true;
+    auto* workers = s_workers.load();
+    if (!workers)
+        return false;
+    return any_of(*workers, [current_thread](auto& worker) { return worker->thread == current_thread; });
 }
 
-void NetworkTask_main(void*)
+ErrorOr<void> NetworkTask::try_for_each_receive_queue(Function<ErrorOr<void>(ReceiveQueueStatistics const&)> callback)
+{
+    auto* workers = s_workers.load();
+    if (!workers)
+        return {};
+    for (auto& worker : *workers) {
+        ReceiveQueueStatistics statistics;
+        statistics.processor = worker->processor;
+        statistics.packets = worker->packets.load();
+        statistics.bytes = worker->bytes.load();
+        statistics.dropped_packets = worker->dropped_packets.load();
+        worker->queue.with([&](auto& queue) {
+            statistics.queued_packets = queue.frames.size();
+            statistics.max_queued_packets = queue.max_size;
+        });
+        TRY(callback(statistics));
+    }
+    return {};
+}
+
+static NetworkWorker* current_worker()
+{
+    auto* current_thread = Thread::current();
+    for (auto& worker : *s_workers.load()) {
+        if (worker->thread == current_thread)
+            return worker.ptr();
+    }
+    return nullptr;
+}
+
+static NetworkWorker& worker_for_flow(u32 flow_hash)
 {
-    delayed_ack_sockets = new HashTable<NonnullRefPtr<TCPSocket>>;
+    auto& workers = *s_workers.load();
+    return *workers[flow_hash % workers.size()];
+}
+
+// NOTE: The hash is the same as the one of the receiving socket's IPv4SocketTuple, so a connection's
+//       retransmissions and delayed acknowledgements are handled by the worker that receives its segments.
+static u32 flow_hash_for_frame(ReadonlyBytes frame)
+{
+    // Anything that isn't IPv4, like ARP, is handled by the first worker.
+    if (frame.size() < sizeof(EthernetFrameHeader) + sizeof(IPv4Packet))
+        return 0;
+    auto& eth = *reinterpret_cast<EthernetFrameHeader const*>(frame.data());
+    if (eth.ether_type() != EtherType::IPv4)
+        return 0;
+    auto& ipv4_packet = *static_cast<IPv4Packet const*>(eth.payload());
+
+    u16 source_port = 0;
+    u16 destination_port = 0;
+    // Both TCP and UDP headers start with the source and destination port.
+    auto protocol = static_cast<IPv4Protocol>(ipv4_packet.protocol());
+    bool has_ports = protocol == IPv4Protocol::TCP || protocol == IPv4Protocol::UDP;
+    if (has_ports && frame.size() >= sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + 2 * sizeof(u16)) {
+        auto const* ports = static_cast<NetworkOrdered<u16> const*>(ipv4_packet.payload());
+        source_port = ports[0];
+        destination_port = ports[1];
+    }
+    return Traits<IPv4SocketTuple>::hash({ ipv4_packet.destination(), destination_port, ipv4_packet.source(), source_port });
+}
+
+static void dispatch_frame(NetworkAdapter& adapter, NonnullRefPtr<PacketWithTimestamp> packet)
+{
+    auto& worker = worker_for_flow(flow_hash_for_frame(packet->bytes()));
+    bool was_queued = worker.queue.with([&](auto& queue) {
+        if (queue.frames.size() == queue.frames.capacity())
+            return false;
+        queue.frames.enqueue(NetworkWorker::Frame { adapter, packet });
+        queue.max_size = max(queue.max_size, queue.frames.size());
+        return true;
+    });
+    if (!was_queued) {
+        dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dropping packet, queue of worker for CPU #{} is full", worker.processor);
+        worker.dropped_packets++;
+        adapter.release_packet_buffer(*packet);
+        return;
+    }
+    worker.wait_queue.wake_all();
+}
 
+void NetworkTask_main(void*)
+{
     WaitQueue packet_wait_queue;
-    int pending_packets = 0;
     NetworkingManagement::the().for_each([&](auto& adapter) {
         dmesgln("NetworkTask: {} network adapter found: hw={}", adapter.class_name(), adapter.mac_address().to_string());
 
@@ -66,68 +188,96 @@ void NetworkTask_main(void*)
         }
 
         adapter.on_receive = [&]() {
-            pending_packets++;
             packet_wait_queue.wake_all();
         };
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, UnixDateTime& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
-        NetworkingManagement::the().for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
-                return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
-            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
-        });
-        return packet_size;
-    };
-
-    size_t buffer_size = 64 * KiB;
-    auto region_or_error = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer"sv, Memory::Region::Access::ReadWrite);
-    if (region_or_error.is_error())
-        TODO();
-    auto buffer_region = region_or_error.release_value();
-    auto buffer = (u8*)buffer_region->vaddr().get();
-    UnixDateTime packet_timestamp;
+    auto* workers = new Vector<NonnullOwnPtr<NetworkWorker>>;
+    for (u32 processor = 0; processor < Processor::count(); ++processor) {
+        auto worker = MUST(adopt_nonnull_own_or_enomem(new (nothrow) NetworkWorker));
+        worker->processor = processor;
+        MUST(workers->try_append(move(worker)));
+    }
+    // NOTE: The workers must all exist before any of them starts looking itself up.
+    s_workers.store(workers);
+    for (auto& worker : *workers) {
+        auto name = MUST(KString::formatted("Network Worker #{}", worker->processor));
+        worker->thread = MUST(Process::current().create_kernel_thread(NetworkWorker_main, worker.ptr(), THREAD_PRIORITY_NORMAL, name->view(), 1 << worker->processor, false));
+    }
 
+    // This thread only hands the received packets to the workers, which do the actual work.
     while (!Process::current().is_dying()) {
-        flush_delayed_tcp_acks();
-        retransmit_tcp_packets();
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
-        if (!packet_size) {
+        bool dispatched_any_packets = false;
+        NetworkingManagement::the().for_each([&](auto& adapter) {
+            while (auto packet = adapter.dequeue_packet()) {
+                dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet->buffer->size());
+                dispatch_frame(adapter, packet.release_nonnull());
+                dispatched_any_packets = true;
+            }
+        });
+        if (!dispatched_any_packets) {
             auto timeout_time = Duration::from_milliseconds(500);
             auto timeout = Thread::BlockTimeout { false, &timeout_time };
             [[maybe_unused]] auto result = packet_wait_queue.wait_on(timeout, "NetworkTask"sv);
-            continue;
         }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
+    }
+    Process::current().sys$exit(0);
+    VERIFY_NOT_REACHED();
+}
+
+void NetworkWorker_main(void* data)
+{
+    auto& worker = *static_cast<NetworkWorker*>(data);
+    while (!Process::current().is_dying()) {
+        flush_delayed_tcp_acks(worker);
+        retransmit_tcp_packets(worker);
+
+        auto frame = worker.queue.with([](auto& queue) -> Optional<NetworkWorker::Frame> {
+            if (queue.frames.is_empty())
+                return {};
+            return queue.frames.dequeue();
+        });
+        if (!frame.has_value()) {
+            auto timeout_time = Duration::from_milliseconds(500);
+            auto timeout = Thread::BlockTimeout { false, &timeout_time };
+            [[maybe_unused]] auto result = worker.wait_queue.wait_on(timeout, "NetworkWorker"sv);
             continue;
         }
-        auto& eth = *(EthernetFrameHeader const*)buffer;
-        dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
-
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
-            break;
-        case EtherType::IPv6:
-            // ignore
-            break;
-        default:
-            dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
-        }
+
+        auto& packet = *frame->packet;
+        worker.packets++;
+        worker.bytes += packet.buffer->size();
+        handle_frame(packet.bytes(), packet.timestamp);
+        frame->adapter->release_packet_buffer(packet);
     }
-    Process::current().sys$exit(0);
+    Thread::current()->exit();
     VERIFY_NOT_REACHED();
 }
 
+void handle_frame(ReadonlyBytes frame, UnixDateTime const& packet_timestamp)
+{
+    if (frame.size() < sizeof(EthernetFrameHeader)) {
+        dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", frame.size());
+        return;
+    }
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), frame.size());
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, frame.size());
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(eth, frame.size(), packet_timestamp);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
+    }
+}
+
 void handle_arp(EthernetFrameHeader const& eth, size_t frame_size)
 {
     constexpr size_t minimum_arp_frame_size = sizeof(EthernetFrameHeader) + sizeof(ARPPacket);
@@ -308,13 +458,16 @@ void send_delayed_tcp_ack(TCPSocket& socket)
         return;
     }
 
-    delayed_ack_sockets->set(move(socket));
+    auto* worker = current_worker();
+    VERIFY(worker);
+    worker->delayed_ack_sockets.set(move(socket));
 }
 
-void flush_delayed_tcp_acks()
+void flush_delayed_tcp_acks(NetworkWorker& worker)
 {
+    auto& delayed_ack_sockets = worker.delayed_ack_sockets;
     Vector<NonnullRefPtr<TCPSocket>, 32> remaining_sockets;
-    for (auto& socket : *delayed_ack_sockets) {
+    for (auto& socket : delayed_ack_sockets) {
         MutexLocker locker(socket->mutex());
         if (socket->should_delay_next_ack()) {
             MUST(remaining_sockets.try_append(*socket));
@@ -323,12 +476,12 @@ void flush_delayed_tcp_acks()
         [[maybe_unused]] auto result = socket->send_ack();
     }
 
-    if (remaining_sockets.size() != delayed_ack_sockets->size()) {
-        delayed_ack_sockets->clear();
+    if (remaining_sockets.size() != delayed_ack_sockets.size()) {
+        delayed_ack_sockets.clear();
         if (remaining_sockets.size() > 0)
             dbgln("flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
         for (auto&& socket : remaining_sockets)
-            delayed_ack_sockets->set(move(socket));
+            delayed_ack_sockets.set(move(socket));
     }
 }
 
@@ -379,6 +532,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
     size_t maximum_tcp_header_size = 15 * sizeof(u32);
     if (tcp_packet.header_size() < minimum_tcp_header_size || tcp_packet.header_size() > maximum_tcp_header_size) {
         dbgln("handle_tcp: TCP packet header has invalid size {}", tcp_packet.header_size());
+        return;
     }
 
     if (ipv4_packet.payload_size() < tcp_packet.header_size()) {
@@ -457,6 +611,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
             dbgln_if(TCP_DEBUG, "handle_tcp: created new client socket with tuple {}", client->tuple().to_string());
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->apply_syn_options(tcp_packet);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -470,11 +625,13 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
         switch (tcp_packet.flags()) {
         case TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->apply_syn_options(tcp_packet);
             (void)socket->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             socket->set_state(TCPSocket::State::SynReceived);
             return;
         case TCPFlags::ACK | TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->apply_syn_options(tcp_packet);
             (void)socket->send_ack(true);
             socket->set_state(TCPSocket::State::Established);
             socket->set_setup_state(Socket::SetupState::Completed);
@@ -618,17 +775,21 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
         }
 
         if (tcp_packet.sequence_number() != socket->ack_number()) {
-            dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
-            if (socket->duplicate_acks() < TCPSocket::maximum_duplicate_acks) {
+            // Data past a gap is kept around, so only the missing part has to be sent again.
+            if (payload_size > 0 && !tcp_packet.has_fin() && tcp_sequence_is_before(socket->ack_number(), tcp_packet.sequence_number())) {
+                dbgln_if(TCP_DEBUG, "Queueing out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
+                socket->queue_out_of_order_segment(ipv4_packet, tcp_packet, payload_size, packet_timestamp);
+            } else {
+                dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
+            }
+            // RFC 5681, 4.2: An out-of-order segment is acknowledged immediately, which lets the peer detect the loss.
+            if (payload_size > 0 || tcp_packet.has_fin()) {
                 dbgln_if(TCP_DEBUG, "Sending ACK with same ack number to trigger fast retransmission");
-                socket->set_duplicate_acks(socket->duplicate_acks() + 1);
                 [[maybe_unused]] auto result = socket->send_ack(true);
             }
             return;
         }
 
-        socket->set_duplicate_acks(0);
-
         if (tcp_packet.has_fin()) {
             if (payload_size != 0)
                 socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp);
@@ -645,18 +806,25 @@ void handle_tcp(IPv4Packet const& ipv4_packet, UnixDateTime const& packet_timest
                 socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
                 dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
                     tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
-                send_delayed_tcp_ack(*socket);
+                // RFC 5681, 4.2: Filling in a gap is acknowledged immediately, so the peer can leave loss recovery.
+                if (socket->deliver_out_of_order_segments())
+                    (void)socket->send_ack();
+                else
+                    send_delayed_tcp_ack(*socket);
             }
         }
     }
 }
 
-void retransmit_tcp_packets()
+void retransmit_tcp_packets(NetworkWorker& worker)
 {
     // We must keep the sockets alive until after we've unlocked the hash table
     // in case retransmit_packets() realizes that it wants to close the socket.
     Vector<NonnullRefPtr<TCPSocket>, 16> sockets;
     TCPSocket::sockets_for_retransmit().for_each_shared([&](auto const& socket) {
+        // Each socket is looked after by the worker that receives its segments.
+        if (&worker_for_flow(Traits<IPv4SocketTuple>::hash(socket.tuple())) != &worker)
+            return;
         // We ignore allocation failures above the first 16 guaranteed socket slots, as
         // we will just retransmit their packets the next time around
         (void)sockets.try_append(socket);
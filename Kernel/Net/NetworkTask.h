@@ -6,10 +6,26 @@
 
 #pragma once
 
+#include <AK/Error.h>
+#include <AK/Function.h>
+#include <AK/Types.h>
+
 namespace Kernel {
 class NetworkTask {
 public:
+    struct ReceiveQueueStatistics {
+        u32 processor { 0 };
+        u64 packets { 0 };
+        u64 bytes { 0 };
+        u64 dropped_packets { 0 };
+        size_t queued_packets { 0 };
+        size_t max_queued_packets { 0 };
+    };
+
     static void spawn();
     static bool is_current();
+
+    // There is one receive queue per processor, whose worker handles the packets of the flows hashed to it.
+    static ErrorOr<void> try_for_each_receive_queue(Function<ErrorOr<void>(ReceiveQueueStatistics const&)>);
 };
 }
@@ -6,6 +6,9 @@
 
 #pragma once
 
+#include <AK/Array.h>
+#include <AK/Optional.h>
+#include <AK/Span.h>
 #include <Kernel/Net/IPv4.h>
 
 namespace Kernel {
@@ -21,6 +24,20 @@ struct TCPFlags {
     };
 };
 
+// Sequence numbers wrap around, so they can only be compared relative to each other.
+constexpr bool tcp_sequence_is_before(u32 a, u32 b) { return static_cast<i32>(a - b) < 0; }
+constexpr bool tcp_sequence_is_before_or_equal(u32 a, u32 b) { return static_cast<i32>(a - b) <= 0; }
+
+enum class TCPOptionKind : u8 {
+    End = 0,
+    NoOperation = 1,
+    MaximumSegmentSize = 2,
+    WindowScale = 3,
+    SACKPermitted = 4,
+    SACK = 5,
+    Timestamp = 8,
+};
+
 class [[gnu::packed]] TCPOptionMSS {
 public:
     TCPOptionMSS(u16 value)
@@ -31,13 +48,65 @@ public:
     u16 value() const { return m_value; }
 
 private:
-    u8 m_option_kind { 0x02 };
+    u8 m_option_kind { to_underlying(TCPOptionKind::MaximumSegmentSize) };
     u8 m_option_length { sizeof(TCPOptionMSS) };
     NetworkOrdered<u16> m_value;
 };
 
 static_assert(AssertSize<TCPOptionMSS, 4>());
 
+// RFC 7323, 2.2. Window Scale Option
+class [[gnu::packed]] TCPOptionWindowScale {
+public:
+    TCPOptionWindowScale(u8 shift_count)
+        : m_shift_count(shift_count)
+    {
+    }
+
+private:
+    u8 m_option_kind { to_underlying(TCPOptionKind::WindowScale) };
+    u8 m_option_length { sizeof(TCPOptionWindowScale) };
+    u8 m_shift_count { 0 };
+};
+
+static_assert(AssertSize<TCPOptionWindowScale, 3>());
+
+// RFC 2018, 2. Sack-Permitted Option
+class [[gnu::packed]] TCPOptionSACKPermitted {
+private:
+    u8 m_option_kind { to_underlying(TCPOptionKind::SACKPermitted) };
+    u8 m_option_length { sizeof(TCPOptionSACKPermitted) };
+};
+
+static_assert(AssertSize<TCPOptionSACKPermitted, 2>());
+
+// RFC 7323, 3.2. Timestamps Option
+class [[gnu::packed]] TCPOptionTimestamp {
+public:
+    TCPOptionTimestamp(u32 value, u32 echo_reply)
+        : m_value(value)
+        , m_echo_reply(echo_reply)
+    {
+    }
+
+    void set_value(u32 value) { m_value = value; }
+    void set_echo_reply(u32 echo_reply) { m_echo_reply = echo_reply; }
+
+private:
+    u8 m_option_kind { to_underlying(TCPOptionKind::Timestamp) };
+    u8 m_option_length { sizeof(TCPOptionTimestamp) };
+    NetworkOrdered<u32> m_value;
+    NetworkOrdered<u32> m_echo_reply;
+};
+
+static_assert(AssertSize<TCPOptionTimestamp, 10>());
+
+// RFC 2018, 3. Sack Option Format
+struct TCPSACKBlock {
+    u32 left_edge { 0 };
+    u32 right_edge { 0 };
+};
+
 class [[gnu::packed]] TCPPacket {
 public:
     TCPPacket() = default;
@@ -80,6 +149,12 @@ public:
     void const* payload() const { return ((u8 const*)this) + header_size(); }
     void* payload() { return ((u8*)this) + header_size(); }
 
+    static constexpr size_t maximum_options_size = 40;
+    // Where the checksum is in the header, for adapters that fill it in.
+    static constexpr u16 checksum_offset = 16;
+    ReadonlyBytes options() const { return { ((u8 const*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) }; }
+    Bytes options() { return { ((u8*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) }; }
+
 private:
     NetworkOrdered<u16> m_source_port;
     NetworkOrdered<u16> m_destination_port;
@@ -94,4 +169,75 @@ private:
 
 static_assert(AssertSize<TCPPacket, 20>());
 
+struct TCPOptions {
+    static constexpr size_t maximum_sack_blocks = 4;
+
+    Optional<u16> maximum_segment_size;
+    Optional<u8> window_scale;
+    bool sack_permitted { false };
+    bool has_timestamp { false };
+    u32 timestamp_value { 0 };
+    u32 timestamp_echo_reply { 0 };
+    Array<TCPSACKBlock, maximum_sack_blocks> sack_blocks;
+    size_t sack_block_count { 0 };
+
+    ReadonlySpan<TCPSACKBlock> sacks() const { return sack_blocks.span().trim(sack_block_count); }
+
+    // Malformed options are ignored, as the packet itself may still be perfectly usable.
+    static TCPOptions parse(TCPPacket const& packet)
+    {
+        TCPOptions options;
+        auto bytes = packet.options();
+
+        auto read_u32 = [&](size_t offset) -> u32 {
+            return (bytes[offset] << 24) | (bytes[offset + 1] << 16) | (bytes[offset + 2] << 8) | bytes[offset + 3];
+        };
+
+        size_t offset = 0;
+        while (offset < bytes.size()) {
+            auto kind = static_cast<TCPOptionKind>(bytes[offset]);
+            if (kind == TCPOptionKind::End)
+                break;
+            if (kind == TCPOptionKind::NoOperation) {
+                ++offset;
+                continue;
+            }
+            if (offset + 1 >= bytes.size())
+                break;
+            size_t length = bytes[offset + 1];
+            if (length < 2 || offset + length > bytes.size())
+                break;
+
+            switch (kind) {
+            case TCPOptionKind::MaximumSegmentSize:
+                if (length == sizeof(TCPOptionMSS))
+                    options.maximum_segment_size = (bytes[offset + 2] << 8) | bytes[offset + 3];
+                break;
+            case TCPOptionKind::WindowScale:
+                if (length == sizeof(TCPOptionWindowScale))
+                    options.window_scale = bytes[offset + 2];
+                break;
+            case TCPOptionKind::SACKPermitted:
+                options.sack_permitted = length == sizeof(TCPOptionSACKPermitted);
+                break;
+            case TCPOptionKind::SACK:
+                for (size_t block_offset = offset + 2; block_offset + 8 <= offset + length && options.sack_block_count < maximum_sack_blocks; block_offset += 8)
+                    options.sack_blocks[options.sack_block_count++] = { read_u32(block_offset), read_u32(block_offset + 4) };
+                break;
+            case TCPOptionKind::Timestamp:
+                if (length == sizeof(TCPOptionTimestamp)) {
+                    options.has_timestamp = true;
+                    options.timestamp_value = read_u32(offset + 2);
+                    options.timestamp_echo_reply = read_u32(offset + 6);
+                }
+                break;
+            default:
+                break;
+            }
+            offset += length;
+        }
+        return options;
+    }
+};
+
 }
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <Kernel/Net/TCPCongestionControl.h>
+
+namespace Kernel {
+
+static Atomic<TCPCongestionControl::Algorithm> s_default_algorithm { TCPCongestionControl::Algorithm::Cubic };
+
+StringView TCPCongestionControl::to_string(Algorithm algorithm)
+{
+    switch (algorithm) {
+    case Algorithm::NewReno:
+        return "newreno"sv;
+    case Algorithm::Cubic:
+        return "cubic"sv;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+Optional<TCPCongestionControl::Algorithm> TCPCongestionControl::algorithm_from_name(StringView name)
+{
+    if (name == "newreno"sv || name == "reno"sv)
+        return Algorithm::NewReno;
+    if (name == "cubic"sv)
+        return Algorithm::Cubic;
+    return {};
+}
+
+TCPCongestionControl::Algorithm TCPCongestionControl::default_algorithm()
+{
+    return s_default_algorithm.load();
+}
+
+void TCPCongestionControl::set_default_algorithm(Algorithm algorithm)
+{
+    s_default_algorithm.store(algorithm);
+}
+
+ErrorOr<NonnullOwnPtr<TCPCongestionControl>> TCPCongestionControl::try_create(Algorithm algorithm, u32 maximum_segment_size)
+{
+    switch (algorithm) {
+    case Algorithm::NewReno:
+        return TRY(adopt_nonnull_own_or_enomem(new (nothrow) NewRenoCongestionControl(maximum_segment_size)));
+    case Algorithm::Cubic:
+        return TRY(adopt_nonnull_own_or_enomem(new (nothrow) CubicCongestionControl(maximum_segment_size)));
+    }
+    VERIFY_NOT_REACHED();
+}
+
+TCPCongestionControl::TCPCongestionControl(u32 maximum_segment_size)
+{
+    set_maximum_segment_size(maximum_segment_size);
+}
+
+void TCPCongestionControl::set_maximum_segment_size(u32 maximum_segment_size)
+{
+    m_maximum_segment_size = max(maximum_segment_size, 1u);
+    // RFC 6928: "min (10*MSS, max (2*MSS, 14600))"
+    m_congestion_window = min(10 * m_maximum_segment_size, max(2 * m_maximum_segment_size, 14600u));
+}
+
+void TCPCongestionControl::slow_start(u32 acknowledged_bytes)
+{
+    // RFC 5681, 3.1: "cwnd += min (N, SMSS)"
+    u64 window = static_cast<u64>(m_congestion_window) + min(acknowledged_bytes, m_maximum_segment_size);
+    m_congestion_window = min(window, NumericLimits<u32>::max());
+}
+
+void TCPCongestionControl::on_retransmit_timeout(u32 bytes_in_flight, MonotonicTime)
+{
+    // RFC 5681, 3.1: "ssthresh = max (FlightSize / 2, 2*SMSS)", and the window shrinks to the loss window of one segment.
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_maximum_segment_size);
+    m_congestion_window = m_maximum_segment_size;
+}
+
+void NewRenoCongestionControl::on_ack(u32 acknowledged_bytes, Duration, MonotonicTime)
+{
+    if (is_in_slow_start()) {
+        slow_start(acknowledged_bytes);
+        return;
+    }
+
+    // Congestion avoidance: grow by one segment per window's worth of acknowledged data (RFC 5681, 3.1).
+    m_bytes_acknowledged += acknowledged_bytes;
+    if (m_bytes_acknowledged >= m_congestion_window) {
+        m_bytes_acknowledged -= m_congestion_window;
+        if (m_congestion_window <= NumericLimits<u32>::max() - m_maximum_segment_size)
+            m_congestion_window += m_maximum_segment_size;
+    }
+}
+
+void NewRenoCongestionControl::on_loss(u32 bytes_in_flight, MonotonicTime)
+{
+    // NOTE: There's no window inflation during recovery, since the socket counts what's in flight with SACK in mind.
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_maximum_segment_size);
+    m_congestion_window = m_slow_start_threshold;
+    m_bytes_acknowledged = 0;
+}
+
+// The kernel can't use floating point, so the constants are kept as fractions.
+// C = 0.4 segments per second cubed, beta = 0.7
+static constexpr u64 cubic_beta_numerator = 7;
+static constexpr u64 cubic_beta_denominator = 10;
+
+static u64 integer_cube_root(u64 value)
+{
+    u64 low = 0;
+    u64 high = 2642245; // The largest value whose cube fits into a u64.
+    while (low < high) {
+        u64 middle = (low + high + 1) / 2;
+        if (middle * middle * middle <= value)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
+}
+
+u64 CubicCongestionControl::cubic_window_at(i64 milliseconds_since_epoch_start) const
+{
+    // RFC 9438, 4.2: W_cubic(t) = C * (t - K)^3 + W_max
+    // With t in milliseconds and the window in bytes, that is W_max + 0.4 * MSS * (t - K)^3 / 10^9.
+    static constexpr i64 limit = 1 << 20;
+    i64 offset = clamp(milliseconds_since_epoch_start - m_time_to_origin_in_milliseconds, -limit, limit);
+    i64 cube = offset * offset * offset;
+    i64 delta = (cube / 1'000'000) * 2 * static_cast<i64>(m_maximum_segment_size) / 5'000;
+    i64 window = static_cast<i64>(m_window_before_reduction) + delta;
+    return window < 0 ? 0 : static_cast<u64>(window);
+}
+
+void CubicCongestionControl::on_ack(u32 acknowledged_bytes, Duration smoothed_rtt, MonotonicTime now)
+{
+    if (is_in_slow_start()) {
+        slow_start(acknowledged_bytes);
+        return;
+    }
+
+    if (!m_epoch_start.has_value()) {
+        m_epoch_start = now;
+        m_reno_friendly_window = m_congestion_window;
+        if (m_window_before_reduction > m_congestion_window) {
+            // K = cbrt((W_max - cwnd_epoch) / C), which in milliseconds is cbrt((W_max - cwnd_epoch) / MSS * 2.5 * 10^9).
+            u64 difference = m_window_before_reduction - m_congestion_window;
+            m_time_to_origin_in_milliseconds = integer_cube_root(difference * 2'500'000'000 / m_maximum_segment_size);
+        } else {
+            m_window_before_reduction = m_congestion_window;
+            m_time_to_origin_in_milliseconds = 0;
+        }
+    }
+
+    // RFC 9438, 4.3: W_est grows like Reno would, with alpha_cubic = 3 * (1 - beta) / (1 + beta) = 9 / 17.
+    m_reno_friendly_window += static_cast<u64>(acknowledged_bytes) * m_maximum_segment_size * 9 / (17 * static_cast<u64>(m_congestion_window));
+
+    auto elapsed = (now - m_epoch_start.value()).to_milliseconds();
+    u64 window;
+    if (cubic_window_at(elapsed) < m_reno_friendly_window) {
+        window = m_reno_friendly_window;
+    } else {
+        // RFC 9438, 4.4: Grow towards where the cubic function will be one RTT from now, but by at most half the window.
+        u64 target = clamp(cubic_window_at(elapsed + smoothed_rtt.to_milliseconds()), static_cast<u64>(m_congestion_window), static_cast<u64>(m_congestion_window) * 3 / 2);
+        window = m_congestion_window + (target - m_congestion_window) * acknowledged_bytes / m_congestion_window;
+    }
+    m_congestion_window = min(max(window, static_cast<u64>(m_congestion_window)), NumericLimits<u32>::max());
+}
+
+void CubicCongestionControl::reduce_window()
+{
+    // RFC 9438, 4.7: Fast convergence lets a new flow take bandwidth from established ones more quickly.
+    if (m_congestion_window < m_previous_window_before_reduction)
+        m_window_before_reduction = static_cast<u64>(m_congestion_window) * (cubic_beta_denominator + cubic_beta_numerator) / (2 * cubic_beta_denominator);
+    else
+        m_window_before_reduction = m_congestion_window;
+    m_previous_window_before_reduction = m_window_before_reduction;
+
+    u64 reduced_window = static_cast<u64>(m_congestion_window) * cubic_beta_numerator / cubic_beta_denominator;
+    m_slow_start_threshold = static_cast<u32>(max(reduced_window, 2 * static_cast<u64>(m_maximum_segment_size)));
+    m_epoch_start.clear();
+}
+
+void CubicCongestionControl::on_loss(u32, MonotonicTime)
+{
+    reduce_window();
+    m_congestion_window = m_slow_start_threshold;
+}
+
+void CubicCongestionControl::on_retransmit_timeout(u32, MonotonicTime)
+{
+    reduce_window();
+    m_congestion_window = m_maximum_segment_size;
+}
+
+}
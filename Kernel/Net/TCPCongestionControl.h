@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/NumericLimits.h>
+#include <AK/Optional.h>
+#include <AK/StringView.h>
+#include <AK/Time.h>
+
+namespace Kernel {
+
+// Decides how much unacknowledged data a TCP connection may have in flight.
+// The socket tells the algorithm about acknowledgements and losses, and only ever asks it for the congestion window.
+class TCPCongestionControl {
+public:
+    enum class Algorithm {
+        NewReno,
+        Cubic,
+    };
+
+    static StringView to_string(Algorithm);
+    static Optional<Algorithm> algorithm_from_name(StringView);
+
+    // The algorithm used by new sockets, can be changed through /sys/kernel/conf/tcp_congestion_control.
+    static Algorithm default_algorithm();
+    static void set_default_algorithm(Algorithm);
+
+    static ErrorOr<NonnullOwnPtr<TCPCongestionControl>> try_create(Algorithm, u32 maximum_segment_size);
+    virtual ~TCPCongestionControl() = default;
+
+    virtual Algorithm algorithm() const = 0;
+
+    u32 maximum_segment_size() const { return m_maximum_segment_size; }
+    u32 congestion_window() const { return m_congestion_window; }
+    u32 slow_start_threshold() const { return m_slow_start_threshold; }
+    bool is_in_slow_start() const { return m_congestion_window < m_slow_start_threshold; }
+
+    // Resets the window to its initial size, which depends on the segment size.
+    void set_maximum_segment_size(u32);
+
+    // New data was acknowledged while not recovering from a loss.
+    virtual void on_ack(u32 acknowledged_bytes, Duration smoothed_rtt, MonotonicTime now) = 0;
+    // A loss was detected through duplicate acknowledgements or SACK, and fast recovery is starting.
+    virtual void on_loss(u32 bytes_in_flight, MonotonicTime now) = 0;
+    // The retransmission timer expired, so everything in flight is presumed lost.
+    virtual void on_retransmit_timeout(u32 bytes_in_flight, MonotonicTime now);
+
+protected:
+    explicit TCPCongestionControl(u32 maximum_segment_size);
+
+    void slow_start(u32 acknowledged_bytes);
+
+    u32 m_maximum_segment_size { 0 };
+    u32 m_congestion_window { 0 };
+    u32 m_slow_start_threshold { NumericLimits<u32>::max() };
+};
+
+// RFC 5681 and RFC 6582
+class NewRenoCongestionControl final : public TCPCongestionControl {
+public:
+    explicit NewRenoCongestionControl(u32 maximum_segment_size)
+        : TCPCongestionControl(maximum_segment_size)
+    {
+    }
+
+    virtual Algorithm algorithm() const override { return Algorithm::NewReno; }
+
+    virtual void on_ack(u32 acknowledged_bytes, Duration smoothed_rtt, MonotonicTime now) override;
+    virtual void on_loss(u32 bytes_in_flight, MonotonicTime now) override;
+
+private:
+    u32 m_bytes_acknowledged { 0 };
+};
+
+// RFC 9438
+class CubicCongestionControl final : public TCPCongestionControl {
+public:
+    explicit CubicCongestionControl(u32 maximum_segment_size)
+        : TCPCongestionControl(maximum_segment_size)
+    {
+    }
+
+    virtual Algorithm algorithm() const override { return Algorithm::Cubic; }
+
+    virtual void on_ack(u32 acknowledged_bytes, Duration smoothed_rtt, MonotonicTime now) override;
+    virtual void on_loss(u32 bytes_in_flight, MonotonicTime now) override;
+    virtual void on_retransmit_timeout(u32 bytes_in_flight, MonotonicTime now) override;
+
+private:
+    void reduce_window();
+    u64 cubic_window_at(i64 milliseconds_since_epoch_start) const;
+
+    // All windows are in bytes, and the cubic function is scaled accordingly.
+    u64 m_window_before_reduction { 0 };
+    u64 m_previous_window_before_reduction { 0 };
+    u64 m_reno_friendly_window { 0 };
+    i64 m_time_to_origin_in_milliseconds { 0 };
+    Optional<MonotonicTime> m_epoch_start;
+};
+
+}
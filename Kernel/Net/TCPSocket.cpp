@@ -132,6 +132,9 @@ ErrorOr<NonnullRefPtr<TCPSocket>> TCPSocket::try_create_client(IPv4Address const
 
         auto receive_buffer = TRY(try_create_receive_buffer());
         auto client = TRY(TCPSocket::try_create(protocol(), move(receive_buffer)));
+        // Connections accepted by a listening socket use the congestion control it was configured with.
+        if (client->m_congestion_control->algorithm() != m_congestion_control->algorithm())
+            client->m_congestion_control = TRY(TCPCongestionControl::try_create(m_congestion_control->algorithm(), m_peer_maximum_segment_size));
 
         client->set_setup_state(SetupState::InProgress);
         client->set_local_address(new_local_address);
@@ -164,8 +167,9 @@ void TCPSocket::release_for_accept(NonnullRefPtr<TCPSocket> socket)
     [[maybe_unused]] auto rc = queue_connection_from(move(socket));
 }
 
-TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer)
+TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl> congestion_control)
     : IPv4Socket(SOCK_STREAM, protocol, move(receive_buffer), move(scratch_buffer))
+    , m_congestion_control(move(congestion_control))
     , m_last_ack_sent_time(TimeManagement::the().monotonic_time())
     , m_last_retransmit_time(TimeManagement::the().monotonic_time())
 {
@@ -182,7 +186,8 @@ ErrorOr<NonnullRefPtr<TCPSocket>> TCPSocket::try_create(int protocol, NonnullOwn
 {
     // Note: Scratch buffer is only used for SOCK_STREAM sockets.
     auto scratch_buffer = TRY(KBuffer::try_create_with_size("TCPSocket: Scratch buffer"sv, 65536));
-    return adopt_nonnull_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer)));
+    auto congestion_control = TRY(TCPCongestionControl::try_create(TCPCongestionControl::default_algorithm(), 536));
+    return adopt_nonnull_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer), move(congestion_control)));
 }
 
 ErrorOr<size_t> TCPSocket::protocol_size(ReadonlyBytes raw_ipv4_packet)
@@ -203,13 +208,19 @@ ErrorOr<size_t> TCPSocket::protocol_receive(ReadonlyBytes raw_ipv4_packet, UserO
     return payload_size;
 }
 
+u32 TCPSocket::maximum_segment_size(RoutingDecision const& routing_decision) const
+{
+    u32 route_maximum_segment_size = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    return min(route_maximum_segment_size, static_cast<u32>(m_peer_maximum_segment_size));
+}
+
 ErrorOr<size_t> TCPSocket::protocol_send(UserOrKernelBuffer const& data, size_t data_length)
 {
     auto adapter = bound_interface().with([](auto& bound_device) -> RefPtr<NetworkAdapter> { return bound_device; });
     RoutingDecision routing_decision = route_to(peer_address(), local_address(), adapter);
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
-    size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    size_t mss = maximum_segment_size(routing_decision) - options_overhead_for_data();
 
     if (!m_no_delay) {
         // RFC 896 (Nagle’s algorithm): https://www.ietf.org/rfc/rfc0896
@@ -223,7 +234,19 @@ ErrorOr<size_t> TCPSocket::protocol_send(UserOrKernelBuffer const& data, size_t
             return set_so_error(EAGAIN);
     }
 
-    data_length = min(data_length, mss);
+    // Only send as much as both the peer and the network can take right now.
+    auto available_window = available_send_window();
+    if (available_window == 0)
+        return set_so_error(EAGAIN);
+
+    // With segmentation offload, the adapter splits large packets into segments, so hand it as many full segments as fit.
+    size_t max_payload_size = mss;
+    if (routing_decision.adapter->has_offload(NetworkAdapter::Offload::TCPSegmentation)) {
+        size_t max_tcp_payload_size = routing_decision.adapter->max_send_size() - sizeof(IPv4Packet) - sizeof(TCPPacket) - options_overhead_for_data();
+        max_payload_size = max(mss, max_tcp_payload_size / mss * mss);
+    }
+
+    data_length = min(data_length, min(max_payload_size, static_cast<size_t>(available_window)));
     TRY(send_tcp_packet(TCPFlags::PSH | TCPFlags::ACK, &data, data_length, &routing_decision));
     return data_length;
 }
@@ -235,6 +258,128 @@ ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
     return send_tcp_packet(TCPFlags::ACK);
 }
 
+// RFC 7323, 5.4: The timestamp clock has to tick between once per second and once per millisecond.
+static u32 current_timestamp_value()
+{
+    return static_cast<u32>(TimeManagement::the().monotonic_time().milliseconds());
+}
+
+// The largest window we can advertise has to cover the whole receive buffer.
+static constexpr u8 receive_window_scale_to_offer = [] {
+    u8 shift = 0;
+    while ((IPv4Socket::receive_buffer_size >> shift) > NumericLimits<u16>::max())
+        ++shift;
+    return shift;
+}();
+
+u16 TCPSocket::advertise_receive_window(bool is_syn)
+{
+    // RFC 7323, 2.2: "The window field in a segment where the SYN bit is set (i.e., a <SYN> or <SYN,ACK>) MUST NOT be scaled."
+    u8 scale = is_syn ? 0 : m_receive_window_scale;
+    u32 window = min(static_cast<u32>(receive_buffer_space() >> scale), static_cast<u32>(NumericLimits<u16>::max()));
+    m_last_advertised_window = window << scale;
+    return window;
+}
+
+size_t TCPSocket::collect_sack_blocks(Span<TCPSACKBlock> blocks) const
+{
+    auto for_each_block = [&](auto callback) {
+        Optional<TCPSACKBlock> current;
+        for (auto const& segment : m_out_of_order_segments) {
+            if (current.has_value() && current->right_edge == segment.sequence_number) {
+                current->right_edge += segment.payload_size;
+                continue;
+            }
+            if (current.has_value())
+                callback(*current);
+            current = TCPSACKBlock { segment.sequence_number, segment.sequence_number + segment.payload_size };
+        }
+        if (current.has_value())
+            callback(*current);
+    };
+    auto contains_latest_segment = [&](TCPSACKBlock const& block) {
+        return tcp_sequence_is_before_or_equal(block.left_edge, m_last_out_of_order_sequence_number)
+            && tcp_sequence_is_before(m_last_out_of_order_sequence_number, block.right_edge);
+    };
+
+    // RFC 2018, 4: "The first SACK block (i.e., the one immediately following the kind and length fields in the option)
+    //               MUST specify the contiguous block of data containing the segment which triggered this ACK"
+    size_t count = 0;
+    for_each_block([&](auto const& block) {
+        if (count == 0 && contains_latest_segment(block))
+            blocks[count++] = block;
+    });
+    for_each_block([&](auto const& block) {
+        if (count < blocks.size() && !contains_latest_segment(block))
+            blocks[count++] = block;
+    });
+    return count;
+}
+
+size_t TCPSocket::write_options(u16 flags, size_t payload_size, u16 maximum_segment_size, Bytes buffer) const
+{
+    size_t size = 0;
+    auto append = [&](auto const& option) {
+        VERIFY(size + sizeof(option) <= buffer.size());
+        memcpy(buffer.offset_pointer(size), &option, sizeof(option));
+        size += sizeof(option);
+    };
+    // Options are padded with NOPs so that the multi-byte fields inside them stay aligned.
+    auto append_padding = [&](size_t count) {
+        VERIFY(size + count <= buffer.size());
+        for (size_t i = 0; i < count; ++i)
+            buffer[size++] = to_underlying(TCPOptionKind::NoOperation);
+    };
+
+    if (flags & TCPFlags::SYN) {
+        // When answering a SYN, we may only use the options the peer offered in it.
+        bool is_active_open = !(flags & TCPFlags::ACK);
+        bool use_sack = is_active_open || m_sack_permitted;
+        bool use_timestamps = is_active_open || m_timestamps_enabled;
+        bool use_window_scale = is_active_open || m_window_scaling_enabled;
+        TCPOptionTimestamp timestamp_option { current_timestamp_value(), is_active_open ? 0 : m_recent_timestamp };
+
+        append(TCPOptionMSS { maximum_segment_size });
+        if (use_sack && use_timestamps) {
+            append(TCPOptionSACKPermitted {});
+            append(timestamp_option);
+        } else if (use_sack) {
+            append_padding(2);
+            append(TCPOptionSACKPermitted {});
+        } else if (use_timestamps) {
+            append_padding(2);
+            append(timestamp_option);
+        }
+        if (use_window_scale) {
+            append_padding(1);
+            append(TCPOptionWindowScale { is_active_open ? receive_window_scale_to_offer : m_receive_window_scale });
+        }
+        return size;
+    }
+
+    if (m_timestamps_enabled) {
+        append_padding(2);
+        append(TCPOptionTimestamp { current_timestamp_value(), m_recent_timestamp });
+    }
+
+    // NOTE: Only pure acknowledgements carry SACK blocks, so that segments with data never exceed the MSS.
+    if ((flags & TCPFlags::ACK) && payload_size == 0 && m_sack_permitted && !m_out_of_order_segments.is_empty()) {
+        Array<TCPSACKBlock, TCPOptions::maximum_sack_blocks> blocks;
+        size_t maximum_block_count = min((buffer.size() - size - 4) / sizeof(TCPSACKBlock), blocks.size());
+        size_t block_count = collect_sack_blocks(blocks.span().trim(maximum_block_count));
+        if (block_count > 0) {
+            append_padding(2);
+            buffer[size++] = to_underlying(TCPOptionKind::SACK);
+            buffer[size++] = 2 + block_count * sizeof(TCPSACKBlock);
+            for (size_t i = 0; i < block_count; ++i) {
+                NetworkOrdered<u32> edges[] = { blocks[i].left_edge, blocks[i].right_edge };
+                append(edges);
+            }
+        }
+    }
+    return size;
+}
+
 ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* payload, size_t payload_size, RoutingDecision* user_routing_decision)
 {
     auto adapter = bound_interface().with([](auto& bound_device) -> RefPtr<NetworkAdapter> { return bound_device; });
@@ -244,8 +389,10 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
     auto ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
 
-    bool const has_mss_option = flags == TCPFlags::SYN;
-    const size_t options_size = has_mss_option ? sizeof(TCPOptionMSS) : 0;
+    u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    Array<u8, TCPPacket::maximum_options_size> options;
+    const size_t options_size = write_options(flags, payload_size, mss, options);
+    VERIFY(options_size % sizeof(u32) == 0);
     const size_t tcp_header_size = sizeof(TCPPacket) + options_size;
     const size_t buffer_size = ipv4_payload_offset + tcp_header_size + payload_size;
     auto packet = routing_decision.adapter->acquire_packet_buffer(buffer_size);
@@ -259,10 +406,11 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
     VERIFY(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(NumericLimits<u16>::max());
+    tcp_packet.set_window_size(advertise_receive_window(flags & TCPFlags::SYN));
     tcp_packet.set_sequence_number(m_sequence_number);
     tcp_packet.set_data_offset(tcp_header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
+    memcpy(tcp_packet.options().data(), options.data(), options_size);
 
     if (payload) {
         if (auto result = payload->read(tcp_packet.payload(), payload_size); result.is_error()) {
@@ -271,37 +419,41 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
         }
     }
 
+    auto now = TimeManagement::the().monotonic_time();
     if (flags & TCPFlags::ACK) {
         m_last_ack_number_sent = m_ack_number;
-        m_last_ack_sent_time = TimeManagement::the().monotonic_time();
+        m_last_ack_sent_time = now;
         tcp_packet.set_ack_number(m_ack_number);
     }
 
+    u32 sequence_number = m_sequence_number;
     if (flags & TCPFlags::SYN) {
         ++m_sequence_number;
     } else {
         m_sequence_number += payload_size;
     }
 
-    if (has_mss_option) {
-        u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-        TCPOptionMSS mss_option { mss };
-        VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + sizeof(mss_option));
-        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), &mss_option, sizeof(mss_option));
+    auto offload = fill_in_checksum(*routing_decision.adapter, tcp_packet, ipv4_payload_offset, payload_size);
+    u32 segment_size = maximum_segment_size(routing_decision) - options_overhead_for_data();
+    if (payload_size > segment_size) {
+        VERIFY(routing_decision.adapter->has_offload(NetworkAdapter::Offload::TCPSegmentation));
+        offload.segment_size = segment_size;
     }
 
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
-
     bool expect_ack { tcp_packet.has_syn() || payload_size > 0 };
     if (expect_ack) {
         bool append_failed { false };
         m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            auto result = unacked_packets.packets.try_append({ m_sequence_number, packet, ipv4_payload_offset, *routing_decision.adapter });
+            // RFC 6298, 5.1: Start the retransmission timer if it isn't already running.
+            bool timer_was_running = !unacked_packets.packets.is_empty();
+            auto result = unacked_packets.packets.try_append({ sequence_number, m_sequence_number, packet, ipv4_payload_offset, *routing_decision.adapter, 0, now, offload.segment_size });
             if (result.is_error()) {
                 dbgln("TCPSocket: Dropped outbound packet because try_append() failed");
                 append_failed = true;
                 return;
             }
+            if (!timer_was_running)
+                m_last_retransmit_time = now;
             unacked_packets.size += payload_size;
             enqueue_for_retransmit();
         });
@@ -311,56 +463,376 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
     m_packets_out++;
     m_bytes_out += buffer_size;
-    routing_decision.adapter->send_packet(packet->bytes());
+    routing_decision.adapter->send_packet(packet->bytes(), offload);
     if (!expect_ack)
         routing_decision.adapter->release_packet_buffer(*packet);
 
     return {};
 }
 
+void TCPSocket::apply_syn_options(TCPPacket const& packet)
+{
+    auto options = TCPOptions::parse(packet);
+
+    // A tiny MSS would only make us flood the peer with headers.
+    if (options.maximum_segment_size.has_value())
+        m_peer_maximum_segment_size = max(options.maximum_segment_size.value(), static_cast<u16>(64));
+
+    m_window_scaling_enabled = options.window_scale.has_value();
+    if (m_window_scaling_enabled) {
+        // RFC 7323, 2.3: "If a Window Scale option is received with a shift.cnt value larger than 14,
+        //                 the TCP SHOULD log the error but MUST use 14 instead of the specified value."
+        m_send_window_scale = min(options.window_scale.value(), static_cast<u8>(14));
+        m_receive_window_scale = receive_window_scale_to_offer;
+    } else {
+        m_send_window_scale = 0;
+        m_receive_window_scale = 0;
+    }
+
+    m_sack_permitted = options.sack_permitted;
+    m_timestamps_enabled = options.has_timestamp;
+    if (m_timestamps_enabled)
+        m_recent_timestamp = options.timestamp_value;
+
+    m_send_window_size = packet.window_size();
+    m_send_window_update_sequence_number = packet.sequence_number();
+    m_send_window_update_ack_number = packet.ack_number();
+    m_congestion_control->set_maximum_segment_size(m_peer_maximum_segment_size - options_overhead_for_data());
+}
+
 void TCPSocket::receive_tcp_packet(TCPPacket const& packet, u16 size)
 {
-    if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+    auto options = TCPOptions::parse(packet);
+    size_t payload_size = size - packet.header_size();
+
+    // RFC 7323, 4.3: Remember the newest timestamp of a segment we're acknowledging, so we can echo it back.
+    if (m_timestamps_enabled && options.has_timestamp
+        && tcp_sequence_is_before_or_equal(m_recent_timestamp, options.timestamp_value)
+        && tcp_sequence_is_before_or_equal(packet.sequence_number(), m_last_ack_number_sent)) {
+        m_recent_timestamp = options.timestamp_value;
+    }
+
+    if (packet.has_ack())
+        process_ack(packet, options, payload_size);
 
-        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+    m_packets_in++;
+    m_bytes_in += packet.header_size() + size;
+}
+
+void TCPSocket::process_ack(TCPPacket const& packet, TCPOptions const& options, size_t payload_size)
+{
+    u32 ack_number = packet.ack_number();
+    auto now = TimeManagement::the().monotonic_time();
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+
+    // RFC 9293, 3.10.7.4: Only a segment at least as new as the one that last set the window may update it,
+    //                     so that a reordered old segment can't bring back a stale window.
+    bool window_changed = false;
+    if (tcp_sequence_is_before(m_send_window_update_sequence_number, packet.sequence_number())
+        || (m_send_window_update_sequence_number == packet.sequence_number() && tcp_sequence_is_before_or_equal(m_send_window_update_ack_number, ack_number))) {
+        u32 window_size = packet.has_syn() ? packet.window_size() : static_cast<u32>(packet.window_size()) << m_send_window_scale;
+        window_changed = window_size != m_send_window_size;
+        m_send_window_size = window_size;
+        m_send_window_update_sequence_number = packet.sequence_number();
+        m_send_window_update_ack_number = ack_number;
+    }
+
+    u32 acknowledged_bytes = 0;
+    bool is_duplicate_ack = false;
+    Optional<Duration> rtt_sample;
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        bool had_unacked_packets = !unacked_packets.packets.is_empty();
 
         int removed = 0;
-        m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            while (!unacked_packets.packets.is_empty()) {
-                auto& packet = unacked_packets.packets.first();
-
-                dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
-
-                if (packet.ack_number <= ack_number) {
-                    auto old_adapter = packet.adapter.strong_ref();
-                    if (old_adapter)
-                        old_adapter->release_packet_buffer(*packet.buffer);
-                    TCPPacket& tcp_packet = *(TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                    if (m_send_window_size != tcp_packet.window_size()) {
-                        m_send_window_size = tcp_packet.window_size();
-                    }
-                    auto payload_size = packet.buffer->buffer->data() + packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
-                    unacked_packets.size -= payload_size;
-                    evaluate_block_conditions();
-                    unacked_packets.packets.take_first();
-                    removed++;
-                } else {
-                    break;
-                }
-            }
+        while (!unacked_packets.packets.is_empty()) {
+            auto& outgoing_packet = unacked_packets.packets.first();
+
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", outgoing_packet.ack_number);
+
+            if (tcp_sequence_is_before(ack_number, outgoing_packet.ack_number))
+                break;
+
+            // Karn's algorithm: The round trip of a packet that was sent more than once is ambiguous.
+            if (outgoing_packet.tx_counter == 0)
+                rtt_sample = now - outgoing_packet.last_sent_time;
+
+            auto old_adapter = outgoing_packet.adapter.strong_ref();
+            if (old_adapter)
+                old_adapter->release_packet_buffer(*outgoing_packet.buffer);
+            TCPPacket& tcp_packet = *(TCPPacket*)(outgoing_packet.buffer->buffer->data() + outgoing_packet.ipv4_payload_offset);
+            auto outgoing_payload_size = outgoing_packet.buffer->buffer->data() + outgoing_packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
+            unacked_packets.size -= outgoing_payload_size;
+            acknowledged_bytes += outgoing_packet.sequence_length();
+            unacked_packets.packets.take_first();
+            removed++;
+        }
 
-            if (unacked_packets.packets.is_empty()) {
-                m_retransmit_attempts = 0;
-                dequeue_for_retransmit();
+        // RFC 2018: The peer already has whatever it reports in SACK blocks, so we won't send it again.
+        for (auto const& block : options.sacks()) {
+            for (auto& outgoing_packet : unacked_packets.packets) {
+                if (tcp_sequence_is_before_or_equal(block.left_edge, outgoing_packet.sequence_number)
+                    && tcp_sequence_is_before_or_equal(outgoing_packet.ack_number, block.right_edge))
+                    outgoing_packet.is_sacked = true;
             }
+        }
 
-            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
-        });
+        // RFC 5681, 2: A duplicate acknowledgement acknowledges nothing new, carries no data and doesn't change the window.
+        is_duplicate_ack = had_unacked_packets && acknowledged_bytes == 0 && payload_size == 0
+            && !window_changed && !packet.has_syn() && !packet.has_fin();
+
+        if (unacked_packets.packets.is_empty()) {
+            m_retransmit_attempts = 0;
+            dequeue_for_retransmit();
+        }
+
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
+    });
+
+    if (acknowledged_bytes > 0) {
+        m_duplicate_acks = 0;
+        m_retransmit_attempts = 0;
+        // RFC 6298, 5.3: Restart the retransmission timer whenever new data is acknowledged.
+        m_last_retransmit_time = now;
+
+        // RFC 7323, 4.1: The echoed timestamp measures the round trip even for retransmitted packets.
+        if (m_timestamps_enabled && options.has_timestamp && options.timestamp_echo_reply != 0)
+            rtt_sample = Duration::from_milliseconds(current_timestamp_value() - options.timestamp_echo_reply);
+        if (rtt_sample.has_value())
+            update_rtt(rtt_sample.value());
+
+        bool is_past_recovery_point = !tcp_sequence_is_before(ack_number, m_recovery_point);
+        if (m_is_recovering_from_timeout && is_past_recovery_point)
+            m_is_recovering_from_timeout = false;
+        if (m_is_in_recovery && is_past_recovery_point)
+            m_is_in_recovery = false;
+        else if (!m_is_in_recovery)
+            m_congestion_control->on_ack(acknowledged_bytes, m_smoothed_rtt, now);
+    } else if (is_duplicate_ack) {
+        ++m_duplicate_acks;
     }
 
-    m_packets_in++;
-    m_bytes_in += packet.header_size() + size;
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        if (unacked_packets.packets.is_empty())
+            return;
+
+        // RFC 6582, 3.2: A partial acknowledgement during recovery means the next hole was lost as well.
+        if (m_is_in_recovery && acknowledged_bytes > 0)
+            unacked_packets.packets.first().is_lost = true;
+
+        mark_lost_packets(unacked_packets);
+
+        // Losses of packets sent before the window was last reduced don't reduce it again.
+        if (m_is_in_recovery || m_is_recovering_from_timeout)
+            return;
+        if (m_duplicate_acks < duplicate_ack_threshold && !unacked_packets.packets.first().is_lost)
+            return;
+
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) entering loss recovery at {}", this, ack_number);
+
+        unacked_packets.packets.first().is_lost = true;
+        m_is_in_recovery = true;
+        m_recovery_point = m_sequence_number;
+        m_congestion_control->on_loss(unacked_packets.size, now);
+    });
+
+    send_lost_packets();
+
+    // With nothing in flight, no acknowledgement will tell us when the peer's window opens again, so we have to probe for it.
+    if (m_send_window_size == 0)
+        enqueue_for_retransmit();
+
+    if (acknowledged_bytes > 0 || window_changed)
+        evaluate_block_conditions();
+}
+
+void TCPSocket::mark_lost_packets(UnackedPackets& unacked_packets)
+{
+    // RFC 6675, 4: A packet is lost once enough packets sent after it made it to the peer.
+    u32 sacked_packets_after = 0;
+    for (auto const& packet : unacked_packets.packets) {
+        if (packet.is_sacked)
+            ++sacked_packets_after;
+    }
+
+    for (auto& packet : unacked_packets.packets) {
+        if (sacked_packets_after < duplicate_ack_threshold)
+            break;
+        if (packet.is_sacked) {
+            --sacked_packets_after;
+            continue;
+        }
+        if (!packet.is_lost) {
+            packet.is_lost = true;
+            packet.is_retransmitted = false;
+        }
+    }
+}
+
+u32 TCPSocket::bytes_in_flight(UnackedPackets const& unacked_packets)
+{
+    // RFC 6675, 4: "pipe", the packets that are believed to still be in the network.
+    u32 bytes = 0;
+    for (auto const& packet : unacked_packets.packets) {
+        if (packet.is_sacked)
+            continue;
+        if (packet.is_lost && !packet.is_retransmitted)
+            continue;
+        bytes += packet.sequence_length();
+    }
+    return bytes;
+}
+
+u32 TCPSocket::available_send_window() const
+{
+    return m_unacked_packets.with_shared([&](auto const& unacked_packets) -> u32 {
+        // The peer's window is counted from the oldest unacknowledged byte, the congestion window from what's in flight.
+        u32 peer_window = m_send_window_size > unacked_packets.size ? m_send_window_size - unacked_packets.size : 0;
+        u32 in_flight = bytes_in_flight(unacked_packets);
+        u32 congestion_window = m_congestion_control->congestion_window();
+        u32 network_window = congestion_window > in_flight ? congestion_window - in_flight : 0;
+        return min(peer_window, network_window);
+    });
+}
+
+void TCPSocket::send_lost_packets()
+{
+    auto adapter = bound_interface().with([](auto& bound_device) -> RefPtr<NetworkAdapter> { return bound_device; });
+    auto routing_decision = route_to(peer_address(), local_address(), adapter);
+    if (routing_decision.is_zero())
+        return;
+
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        u32 in_flight = bytes_in_flight(unacked_packets);
+        for (auto& packet : unacked_packets.packets) {
+            if (!packet.is_lost || packet.is_sacked || packet.is_retransmitted)
+                continue;
+            // Retransmissions are subject to the congestion window like any other packet, but we always send at least one.
+            if (in_flight > 0 && in_flight + packet.sequence_length() > m_congestion_control->congestion_window())
+                break;
+            packet.is_retransmitted = true;
+            in_flight += packet.sequence_length();
+            resend_packet(packet, routing_decision);
+        }
+    });
+}
+
+// Rewrites the timestamp option of a packet we're about to send again.
+static void update_timestamp_option(TCPPacket& packet, u32 value, u32 echo_reply)
+{
+    auto bytes = packet.options();
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        auto kind = static_cast<TCPOptionKind>(bytes[offset]);
+        if (kind == TCPOptionKind::End)
+            return;
+        if (kind == TCPOptionKind::NoOperation) {
+            ++offset;
+            continue;
+        }
+        if (offset + 1 >= bytes.size())
+            return;
+        size_t length = bytes[offset + 1];
+        if (length < 2 || offset + length > bytes.size())
+            return;
+        if (kind == TCPOptionKind::Timestamp && length == sizeof(TCPOptionTimestamp)) {
+            TCPOptionTimestamp option { value, echo_reply };
+            memcpy(bytes.offset_pointer(offset), &option, sizeof(option));
+            return;
+        }
+        offset += length;
+    }
+}
+
+void TCPSocket::resend_packet(OutgoingPacket& packet, RoutingDecision const& routing_decision)
+{
+    packet.tx_counter++;
+    packet.last_sent_time = TimeManagement::the().monotonic_time();
+    ++m_retransmitted_packets;
+
+    auto& tcp_packet = *(TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
+    if constexpr (TCP_SOCKET_DEBUG) {
+        dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            local_address(), local_port(),
+            peer_address(), peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    }
+
+    size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
+    if (ipv4_payload_offset != packet.ipv4_payload_offset) {
+        // FIXME: Add support for this. This can happen if after a route change
+        // we ended up on another adapter which doesn't have the same layer 2 type
+        // like the previous adapter.
+        VERIFY_NOT_REACHED();
+    }
+    if (packet.segment_size != 0 && !routing_decision.adapter->has_offload(NetworkAdapter::Offload::TCPSegmentation)) {
+        // FIXME: Split the packet ourselves when the route changed to an adapter that can't.
+        dbgln("TCPSocket: Can't resend a packet of {} bytes through {}", packet.buffer->buffer->size(), routing_decision.adapter->name());
+        return;
+    }
+
+    // What we acknowledge and advertise may have changed since the packet was first sent.
+    if (tcp_packet.has_ack()) {
+        m_last_ack_number_sent = m_ack_number;
+        m_last_ack_sent_time = packet.last_sent_time;
+        tcp_packet.set_ack_number(m_ack_number);
+    }
+    tcp_packet.set_window_size(advertise_receive_window(tcp_packet.has_syn()));
+    update_timestamp_option(tcp_packet, current_timestamp_value(), m_recent_timestamp);
+
+    auto packet_buffer = packet.buffer->bytes();
+    u16 payload_size = packet_buffer.data() + packet_buffer.size() - (u8 const*)tcp_packet.payload();
+    auto offload = fill_in_checksum(*routing_decision.adapter, tcp_packet, ipv4_payload_offset, payload_size);
+    offload.segment_size = packet.segment_size;
+
+    routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
+        local_address(), routing_decision.next_hop, peer_address(),
+        IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
+    routing_decision.adapter->send_packet(packet_buffer, offload);
+    m_packets_out++;
+    m_bytes_out += packet_buffer.size();
+}
+
+void TCPSocket::update_rtt(Duration sample)
+{
+    if (sample.is_negative())
+        return;
+
+    // RFC 6298, 2: Keep a smoothed round-trip time and its variation, from which the retransmission timeout follows.
+    i64 sample_microseconds = sample.to_microseconds();
+    i64 smoothed_microseconds = m_smoothed_rtt.to_microseconds();
+    i64 variance_microseconds = m_rtt_variance.to_microseconds();
+    if (!m_has_rtt_sample) {
+        smoothed_microseconds = sample_microseconds;
+        variance_microseconds = sample_microseconds / 2;
+        m_has_rtt_sample = true;
+    } else {
+        // alpha = 1/8, beta = 1/4
+        i64 difference = smoothed_microseconds - sample_microseconds;
+        variance_microseconds = (3 * variance_microseconds + (difference < 0 ? -difference : difference)) / 4;
+        smoothed_microseconds = (7 * smoothed_microseconds + sample_microseconds) / 8;
+    }
+    m_smoothed_rtt = Duration::from_microseconds(smoothed_microseconds);
+    m_rtt_variance = Duration::from_microseconds(variance_microseconds);
+
+    // RTO = SRTT + max (G, K*RTTVAR), with a clock granularity G of one millisecond.
+    auto timeout = Duration::from_microseconds(smoothed_microseconds + max(4 * variance_microseconds, static_cast<i64>(1000)));
+    m_retransmit_timeout = clamp(timeout, minimum_retransmit_timeout, maximum_retransmit_timeout);
+}
+
+Duration TCPSocket::current_retransmit_timeout() const
+{
+    // RFC 6298, 5.5: Back off exponentially with every retransmission that went unanswered.
+    auto timeout = m_retransmit_timeout;
+    for (u32 i = 0; i < m_retransmit_attempts && timeout < maximum_retransmit_timeout; ++i)
+        timeout = timeout + timeout;
+    return min(timeout, maximum_retransmit_timeout);
 }
 
 bool TCPSocket::should_delay_next_ack() const
@@ -379,7 +851,22 @@ bool TCPSocket::should_delay_next_ack() const
     return true;
 }
 
-NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(IPv4Address const& source, IPv4Address const& destination, TCPPacket const& packet, u16 payload_size)
+TransmitOffload TCPSocket::fill_in_checksum(NetworkAdapter const& adapter, TCPPacket& tcp_packet, size_t ipv4_payload_offset, u16 payload_size) const
+{
+    TransmitOffload offload;
+    tcp_packet.set_checksum(0);
+    if (!adapter.has_offload(NetworkAdapter::Offload::TransmitChecksum)) {
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+        return offload;
+    }
+    offload.needs_checksum = true;
+    offload.checksum_start = ipv4_payload_offset;
+    offload.checksum_offset = TCPPacket::checksum_offset;
+    tcp_packet.set_checksum(compute_tcp_pseudo_header_checksum(local_address(), peer_address(), tcp_packet.header_size() + payload_size));
+    return offload;
+}
+
+static u32 sum_tcp_pseudo_header(IPv4Address const& source, IPv4Address const& destination, u16 tcp_length)
 {
     union PseudoHeader {
         struct [[gnu::packed]] {
@@ -393,11 +880,7 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(IPv4Address const& source, I
     };
     static_assert(sizeof(PseudoHeader) == 12);
 
-    Checked<u16> packet_size = packet.header_size();
-    packet_size += payload_size;
-    VERIFY(!packet_size.has_overflow());
-
-    PseudoHeader pseudo_header { .header = { source, destination, 0, (u8)IPv4Protocol::TCP, packet_size.value() } };
+    PseudoHeader pseudo_header { .header = { source, destination, 0, (u8)IPv4Protocol::TCP, tcp_length } };
 
     u32 checksum = 0;
     auto* raw_pseudo_header = pseudo_header.raw;
@@ -406,6 +889,22 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(IPv4Address const& source, I
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
+    return checksum;
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_pseudo_header_checksum(IPv4Address const& source, IPv4Address const& destination, u16 tcp_length)
+{
+    // NOTE: Unlike the complete checksum, this isn't inverted, as the adapter adds it to the sum of the rest.
+    return sum_tcp_pseudo_header(source, destination, tcp_length) & 0xffff;
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(IPv4Address const& source, IPv4Address const& destination, TCPPacket const& packet, u16 payload_size)
+{
+    Checked<u16> packet_size = packet.header_size();
+    packet_size += payload_size;
+    VERIFY(!packet_size.has_overflow());
+
+    u32 checksum = sum_tcp_pseudo_header(source, destination, packet_size.value());
     auto* raw_packet = bit_cast<u16*>(&packet);
     for (size_t i = 0; i < packet.header_size() / sizeof(u16); ++i) {
         checksum += AK::convert_between_host_and_network_endian(raw_packet[i]);
@@ -428,6 +927,9 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(IPv4Address const& source, I
     return ~(checksum & 0xffff);
 }
 
+// Like on other systems, congestion control algorithms are named by strings of at most 16 bytes.
+static constexpr socklen_t tcp_congestion_name_size = 16;
+
 ErrorOr<void> TCPSocket::setsockopt(int level, int option, Userspace<void const*> user_value, socklen_t user_value_size)
 {
     if (level != IPPROTO_TCP)
@@ -445,6 +947,17 @@ ErrorOr<void> TCPSocket::setsockopt(int level, int option, Userspace<void const*
             return EINVAL;
         m_no_delay = value;
         return {};
+    case TCP_CONGESTION: {
+        if (user_value_size == 0 || user_value_size > tcp_congestion_name_size)
+            return EINVAL;
+        auto name = TRY(try_copy_kstring_from_user(static_ptr_cast<char const*>(user_value), user_value_size));
+        auto algorithm = TCPCongestionControl::algorithm_from_name(name->view().substring_view(0, name->view().find('\0').value_or(name->length())));
+        if (!algorithm.has_value())
+            return ENOENT;
+        if (algorithm.value() != m_congestion_control->algorithm())
+            m_congestion_control = TRY(TCPCongestionControl::try_create(algorithm.value(), m_congestion_control->maximum_segment_size()));
+        return {};
+    }
     default:
         dbgln("setsockopt({}) at IPPROTO_TCP not implemented.", option);
         return ENOPROTOOPT;
@@ -470,6 +983,16 @@ ErrorOr<void> TCPSocket::getsockopt(OpenFileDescription& description, int level,
         size = sizeof(nodelay);
         return copy_to_user(value_size, &size);
     }
+    case TCP_CONGESTION: {
+        auto name = TCPCongestionControl::to_string(m_congestion_control->algorithm());
+        if (size <= name.length())
+            return EINVAL;
+        // NOTE: The names are string literals, so they are followed by a null terminator.
+        auto length = name.length() + 1;
+        TRY(copy_to_user(static_ptr_cast<char*>(value), name.characters_without_null_termination(), length));
+        size = length;
+        return copy_to_user(value_size, &size);
+    }
     default:
         dbgln("getsockopt({}) at IPPROTO_TCP not implemented.", option);
         return ENOPROTOOPT;
@@ -646,18 +1169,33 @@ void TCPSocket::dequeue_for_retransmit()
     });
 }
 
+void TCPSocket::send_window_probe()
+{
+    // RFC 9293, 3.8.6.1: A segment with an old sequence number makes the peer answer with its current window.
+    --m_sequence_number;
+    [[maybe_unused]] auto result = send_tcp_packet(TCPFlags::ACK);
+    ++m_sequence_number;
+}
+
 void TCPSocket::retransmit_packets()
 {
     auto now = TimeManagement::the().monotonic_time();
 
-    // RFC6298 says we should have at least one second between retransmits. According to
-    // RFC1122 we must do exponential backoff - even for SYN packets.
-    i64 retransmit_interval = 1;
-    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts; i++)
-        retransmit_interval *= 2;
+    // RFC1122 says we must do exponential backoff - even for SYN packets.
+    if (m_last_retransmit_time > now - current_retransmit_timeout())
+        return;
 
-    if (m_last_retransmit_time > now - Duration::from_seconds(retransmit_interval))
+    bool has_unacked_packets = m_unacked_packets.with_shared([](auto const& unacked_packets) { return !unacked_packets.packets.is_empty(); });
+    if (!has_unacked_packets) {
+        // We're only still queued because the peer's window was closed while we had data to send.
+        if (m_send_window_size > 0 || m_state != State::Established) {
+            dequeue_for_retransmit();
+            return;
+        }
+        m_last_retransmit_time = now;
+        send_window_probe();
         return;
+    }
 
     dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) handling retransmit", this);
 
@@ -671,62 +1209,101 @@ void TCPSocket::retransmit_packets()
         return;
     }
 
-    auto adapter = bound_interface().with([](auto& bound_device) -> RefPtr<NetworkAdapter> { return bound_device; });
-    auto routing_decision = route_to(peer_address(), local_address(), adapter);
-    if (routing_decision.is_zero())
-        return;
-
+    // RFC 5681, 3.1 and RFC 6675, 5.1: Everything in flight is presumed lost and sent again, starting with a window of one segment.
     m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        m_congestion_control->on_retransmit_timeout(unacked_packets.size, now);
         for (auto& packet : unacked_packets.packets) {
-            packet.tx_counter++;
-
-            if constexpr (TCP_SOCKET_DEBUG) {
-                auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                    local_address(), local_port(),
-                    peer_address(), peer_port(),
-                    (tcp_packet.has_syn() ? "SYN " : ""),
-                    (tcp_packet.has_ack() ? "ACK " : ""),
-                    (tcp_packet.has_fin() ? "FIN " : ""),
-                    (tcp_packet.has_rst() ? "RST " : ""),
-                    tcp_packet.sequence_number(),
-                    tcp_packet.ack_number(),
-                    packet.tx_counter);
-            }
-
-            size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
-            if (ipv4_payload_offset != packet.ipv4_payload_offset) {
-                // FIXME: Add support for this. This can happen if after a route change
-                // we ended up on another adapter which doesn't have the same layer 2 type
-                // like the previous adapter.
-                VERIFY_NOT_REACHED();
-            }
-
-            auto packet_buffer = packet.buffer->bytes();
-
-            routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
-                local_address(), routing_decision.next_hop, peer_address(),
-                IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
-            routing_decision.adapter->send_packet(packet_buffer);
-            m_packets_out++;
-            m_bytes_out += packet_buffer.size();
+            // RFC 2018, 8: The peer may have thrown away data it reported through SACK, so we can't rely on it anymore.
+            packet.is_sacked = false;
+            packet.is_lost = true;
+            packet.is_retransmitted = false;
         }
     });
+    m_is_in_recovery = false;
+    m_is_recovering_from_timeout = true;
+    m_recovery_point = m_sequence_number;
+    m_duplicate_acks = 0;
+
+    send_lost_packets();
 }
 
-bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 size) const
+bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 offset) const
 {
-    if (!IPv4Socket::can_write(file_description, size))
+    if (!IPv4Socket::can_write(file_description, offset))
         return false;
 
     if (m_state == State::SynSent || m_state == State::SynReceived)
         return false;
 
-    if (!file_description.is_blocking())
-        return true;
+    return available_send_window() > 0;
+}
 
-    return m_unacked_packets.with_shared([&](auto& unacked_packets) {
-        return unacked_packets.size + size <= m_send_window_size;
-    });
+ErrorOr<size_t> TCPSocket::recvfrom(OpenFileDescription& description, UserOrKernelBuffer& buffer, size_t buffer_length, int flags, Userspace<sockaddr*> user_addr, Userspace<socklen_t*> user_addr_length, UnixDateTime& packet_timestamp, bool blocking)
+{
+    auto nreceived = TRY(IPv4Socket::recvfrom(description, buffer, buffer_length, flags, user_addr, user_addr_length, packet_timestamp, blocking));
+
+    MutexLocker locker(mutex());
+    if (m_state != State::Established && m_state != State::FinWait1 && m_state != State::FinWait2)
+        return nreceived;
+
+    // RFC 9293, 3.8.6.2.2: Let the peer know once a meaningful amount of room opened up in the receive buffer,
+    // as it may be waiting for that before sending any more data.
+    size_t space = receive_buffer_space();
+    size_t threshold = min(receive_buffer_size / 2, static_cast<size_t>(m_congestion_control->maximum_segment_size()));
+    if (space >= m_last_advertised_window + threshold)
+        (void)send_ack(true);
+    return nreceived;
+}
+
+void TCPSocket::queue_out_of_order_segment(IPv4Packet const& ipv4_packet, TCPPacket const& packet, size_t payload_size, UnixDateTime const& packet_timestamp)
+{
+    u32 sequence_number = packet.sequence_number();
+    u32 end_sequence_number = sequence_number + payload_size;
+
+    // Anything beyond the window we advertised wouldn't fit into the receive buffer once the gap is filled.
+    if (end_sequence_number - m_ack_number > receive_buffer_space())
+        return;
+
+    auto it = m_out_of_order_segments.begin();
+    for (; !it.is_end(); ++it) {
+        if (tcp_sequence_is_before_or_equal(end_sequence_number, it->sequence_number))
+            break;
+        // NOTE: A segment overlapping one we already have is most likely a duplicate, so we don't bother merging them.
+        if (tcp_sequence_is_before(sequence_number, it->sequence_number + it->payload_size))
+            return;
+    }
+
+    auto buffer_or_error = KBuffer::try_create_with_bytes("TCPSocket: Out of order segment"sv, { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() });
+    if (buffer_or_error.is_error())
+        return;
+    OutOfOrderSegment segment { sequence_number, static_cast<u32>(payload_size), packet_timestamp, buffer_or_error.release_value() };
+    auto result = it.is_end() ? m_out_of_order_segments.try_append(move(segment)) : m_out_of_order_segments.try_insert_before(it, move(segment));
+    if (result.is_error())
+        return;
+
+    m_out_of_order_bytes += payload_size;
+    m_last_out_of_order_sequence_number = sequence_number;
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) queued out of order segment {}-{}, {} bytes queued", this, sequence_number, end_sequence_number, m_out_of_order_bytes);
 }
+
+bool TCPSocket::deliver_out_of_order_segments()
+{
+    bool had_segments = !m_out_of_order_segments.is_empty();
+    while (!m_out_of_order_segments.is_empty()) {
+        auto& segment = m_out_of_order_segments.first();
+        if (tcp_sequence_is_before(m_ack_number, segment.sequence_number))
+            break;
+
+        // Segments that are already covered by what we received in order are simply dropped.
+        if (segment.sequence_number == m_ack_number) {
+            if (!did_receive(peer_address(), peer_port(), segment.ipv4_packet->bytes(), segment.timestamp))
+                break;
+            m_ack_number += segment.payload_size;
+        }
+        m_out_of_order_bytes -= segment.payload_size;
+        m_out_of_order_segments.take_first();
+    }
+    return had_segments;
+}
+
 }
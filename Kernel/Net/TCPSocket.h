@@ -14,6 +14,8 @@
 #include <Kernel/Library/LockWeakPtr.h>
 #include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Net/TCPCongestionControl.h>
 
 namespace Kernel {
 
@@ -134,16 +136,28 @@ public:
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
+    u32 retransmitted_packets() const { return m_retransmitted_packets; }
 
-    // FIXME: Make this configurable?
-    static constexpr u32 maximum_duplicate_acks = 5;
-    void set_duplicate_acks(u32 acks) { m_duplicate_acks = acks; }
-    u32 duplicate_acks() const { return m_duplicate_acks; }
+    TCPCongestionControl const& congestion_control() const { return *m_congestion_control; }
+    Duration smoothed_rtt() const { return m_smoothed_rtt; }
+    Duration retransmit_timeout() const { return m_retransmit_timeout; }
+    u32 send_window_size() const { return m_send_window_size; }
+
+    // How many duplicate acknowledgements make us consider a segment lost (RFC 5681, 3.2).
+    static constexpr u32 duplicate_ack_threshold = 3;
 
     ErrorOr<void> send_ack(bool allow_duplicate = false);
     ErrorOr<void> send_tcp_packet(u16 flags, UserOrKernelBuffer const* = nullptr, size_t = 0, RoutingDecision* = nullptr);
     void receive_tcp_packet(TCPPacket const&, u16 size);
 
+    // Takes note of the options the peer sent with its SYN, which decide what this connection can use.
+    void apply_syn_options(TCPPacket const&);
+
+    // Holds on to a segment that arrived ahead of a gap, so it doesn't have to be sent again once the gap is filled.
+    void queue_out_of_order_segment(IPv4Packet const&, TCPPacket const&, size_t payload_size, UnixDateTime const& packet_timestamp);
+    // Hands queued segments that are now in order over to the receive buffer, and returns whether there were any queued.
+    bool deliver_out_of_order_segments();
+
     bool should_delay_next_ack() const;
 
     static MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
@@ -162,8 +176,11 @@ public:
     virtual ErrorOr<void> close() override;
 
     virtual bool can_write(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> recvfrom(OpenFileDescription&, UserOrKernelBuffer&, size_t, int flags, Userspace<sockaddr*>, Userspace<socklen_t*>, UnixDateTime&, bool blocking) override;
 
     static NetworkOrdered<u16> compute_tcp_checksum(IPv4Address const& source, IPv4Address const& destination, TCPPacket const&, u16 payload_size);
+    // Only sums up the pseudo-header, which is what adapters with checksum offload expect to find in the checksum field.
+    static NetworkOrdered<u16> compute_tcp_pseudo_header_checksum(IPv4Address const& source, IPv4Address const& destination, u16 tcp_length);
 
     virtual ErrorOr<void> setsockopt(int level, int option, Userspace<void const*>, socklen_t) override;
     virtual ErrorOr<void> getsockopt(OpenFileDescription&, int level, int option, Userspace<void*>, Userspace<socklen_t*>) override;
@@ -172,7 +189,7 @@ protected:
     void set_direction(Direction direction) { m_direction = direction; }
 
 private:
-    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer);
+    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl>);
     virtual StringView class_name() const override { return "TCPSocket"sv; }
 
     virtual void shut_down_for_writing() override;
@@ -188,6 +205,26 @@ private:
     void enqueue_for_retransmit();
     void dequeue_for_retransmit();
 
+    struct OutgoingPacket;
+    struct UnackedPackets;
+
+    size_t write_options(u16 flags, size_t payload_size, u16 maximum_segment_size, Bytes) const;
+    size_t options_overhead_for_data() const { return m_timestamps_enabled ? 12 : 0; }
+    u16 advertise_receive_window(bool is_syn);
+    size_t collect_sack_blocks(Span<TCPSACKBlock>) const;
+    u32 maximum_segment_size(RoutingDecision const&) const;
+    TransmitOffload fill_in_checksum(NetworkAdapter const&, TCPPacket&, size_t ipv4_payload_offset, u16 payload_size) const;
+
+    void process_ack(TCPPacket const&, TCPOptions const&, size_t payload_size);
+    void update_rtt(Duration sample);
+    Duration current_retransmit_timeout() const;
+    static u32 bytes_in_flight(UnackedPackets const&);
+    u32 available_send_window() const;
+    void mark_lost_packets(UnackedPackets&);
+    void send_lost_packets();
+    void resend_packet(OutgoingPacket&, RoutingDecision const&);
+    void send_window_probe();
+
     LockWeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>> m_pending_release_for_accept;
     Direction m_direction { Direction::Unspecified };
@@ -202,11 +239,23 @@ private:
     u32 m_bytes_out { 0 };
 
     struct OutgoingPacket {
+        u32 sequence_number { 0 };
+        // The sequence number that acknowledges this packet.
         u32 ack_number { 0 };
         RefPtr<PacketWithTimestamp> buffer;
         size_t ipv4_payload_offset;
         LockWeakPtr<NetworkAdapter> adapter;
         int tx_counter { 0 };
+        MonotonicTime last_sent_time;
+        // The payload size of the segments the adapter splits this packet into, 0 if it's sent as is.
+        u16 segment_size { 0 };
+        // The peer told us it has this packet through SACK.
+        bool is_sacked { false };
+        // We believe this packet is lost and should send it again.
+        bool is_lost { false };
+        bool is_retransmitted { false };
+
+        u32 sequence_length() const { return ack_number - sequence_number; }
     };
 
     struct UnackedPackets {
@@ -216,19 +265,65 @@ private:
 
     MutexProtected<UnackedPackets> m_unacked_packets;
 
+    struct OutOfOrderSegment {
+        u32 sequence_number { 0 };
+        u32 payload_size { 0 };
+        UnixDateTime timestamp;
+        NonnullOwnPtr<KBuffer> ipv4_packet;
+    };
+
+    // Ordered by sequence number, and never overlapping.
+    SinglyLinkedList<OutOfOrderSegment> m_out_of_order_segments;
+    size_t m_out_of_order_bytes { 0 };
+    u32 m_last_out_of_order_sequence_number { 0 };
+
+    NonnullOwnPtr<TCPCongestionControl> m_congestion_control;
     u32 m_duplicate_acks { 0 };
+    bool m_is_in_recovery { false };
+    // After a retransmission timeout, everything up to the recovery point is being sent again in slow start.
+    bool m_is_recovering_from_timeout { false };
+    // Recovery is over once everything that was sent before it started is acknowledged (RFC 6582, 3.2).
+    u32 m_recovery_point { 0 };
 
     u32 m_last_ack_number_sent { 0 };
     MonotonicTime m_last_ack_sent_time;
+    u32 m_last_advertised_window { 0 };
+
+    // RFC 6298: The retransmission timeout is derived from the measured round-trip time.
+    static constexpr Duration initial_retransmit_timeout = Duration::from_seconds(1);
+    // NOTE: RFC 6298 asks for at least a second, but like other systems we use a lower bound that suits fast links.
+    static constexpr Duration minimum_retransmit_timeout = Duration::from_milliseconds(200);
+    static constexpr Duration maximum_retransmit_timeout = Duration::from_seconds(60);
+    bool m_has_rtt_sample { false };
+    Duration m_smoothed_rtt;
+    Duration m_rtt_variance;
+    Duration m_retransmit_timeout { initial_retransmit_timeout };
 
     // FIXME: Make this configurable (sysctl)
     static constexpr u32 maximum_retransmits = 5;
     MonotonicTime m_last_retransmit_time;
     u32 m_retransmit_attempts { 0 };
+    u32 m_retransmitted_packets { 0 };
 
-    // Default to maximum window size. receive_tcp_packet() will update from the
-    // peer's advertised window size.
+    // Until the handshake tells us better, assume the peer accepts as much as fits into an unscaled window.
+    // receive_tcp_packet() will update from the peer's advertised window size.
     u32 m_send_window_size { 64 * KiB };
+    // RFC 9293, 3.3.1: SND.WL1 and SND.WL2, the sequence and acknowledgement numbers of the segment that last updated the send window.
+    u32 m_send_window_update_sequence_number { 0 };
+    u32 m_send_window_update_ack_number { 0 };
+
+    // RFC 9293, 3.7.1: "If an MSS Option is not received at connection setup, TCP implementations MUST assume a default send MSS of 536"
+    u16 m_peer_maximum_segment_size { 536 };
+
+    // RFC 7323: Window scaling and timestamps are only used when both sides offer them in their SYN.
+    bool m_window_scaling_enabled { false };
+    u8 m_send_window_scale { 0 };
+    u8 m_receive_window_scale { 0 };
+    bool m_timestamps_enabled { false };
+    u32 m_recent_timestamp { 0 };
+
+    // RFC 2018: We may only send SACK blocks if the peer said it understands them.
+    bool m_sack_permitted { false };
 
     bool m_no_delay { false };
 
@@ -4,6 +4,9 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
+#include <Kernel/Arch/Delay.h>
+#include <Kernel/Arch/Processor.h>
 #include <Kernel/Bus/PCI/IDs.h>
 #include <Kernel/Bus/VirtIO/Transport/PCIe/TransportLink.h>
 #include <Kernel/Net/NetworkingManagement.h>
@@ -80,16 +83,30 @@ struct [[gnu::packed]] VirtIONetHdr {
     u8 frame[0];
 };
 
+static constexpr u8 VIRTIO_NET_OK = 0;
+static constexpr u8 VIRTIO_NET_CTRL_MQ = 4;
+static constexpr u8 VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET = 0;
+
+struct [[gnu::packed]] VirtIONetCtrlMQ {
+    u8 net_class;
+    u8 command;
+    LittleEndian<u16> virtqueue_pairs;
+};
+
 }
 
 using namespace VirtIO;
 
-static constexpr u16 RECEIVEQ = 0;
-static constexpr u16 TRANSMITQ = 1;
+// Receive and transmit queues come in pairs, and the control queue comes after all of them.
+static constexpr u16 receiveq(u16 queue_pair) { return queue_pair * 2; }
+static constexpr u16 transmitq(u16 queue_pair) { return queue_pair * 2 + 1; }
 
-static constexpr size_t MAX_RX_FRAME_SIZE = 1514; // Non-jumbo Ethernet frame limit.
-static constexpr size_t RX_BUFFER_SIZE = sizeof(VirtIONetHdr) * MAX_RX_FRAME_SIZE;
+// FIXME: Make this configurable
+static constexpr u16 MAX_QUEUE_PAIRS = 8;
 static constexpr u16 MAX_INFLIGHT_PACKETS = 128;
+// Room for a few dozen of the largest TCP segments we hand to the device.
+static constexpr size_t TX_BUFFER_SIZE = 2 * MiB;
+static constexpr size_t CONTROL_COMMAND_TIMEOUT_IN_MICROSECONDS = 10000;
 
 UNMAP_AFTER_INIT ErrorOr<bool> VirtIONetworkAdapter::probe(PCI::DeviceIdentifier const& pci_device_identifier)
 {
@@ -115,9 +132,6 @@ UNMAP_AFTER_INIT VirtIONetworkAdapter::VirtIONetworkAdapter(StringView interface
 
 UNMAP_AFTER_INIT ErrorOr<void> VirtIONetworkAdapter::initialize(Badge<NetworkingManagement>)
 {
-    m_rx_buffers = TRY(Memory::RingBuffer::try_create("VirtIONetworkAdapter Rx buffer"sv, RX_BUFFER_SIZE * MAX_INFLIGHT_PACKETS));
-    m_tx_buffers = TRY(Memory::RingBuffer::try_create("VirtIONetworkAdapter Tx buffer"sv, RX_BUFFER_SIZE * MAX_INFLIGHT_PACKETS));
-
     return initialize_virtio_resources();
 }
 
@@ -137,30 +151,118 @@ UNMAP_AFTER_INIT ErrorOr<void> VirtIONetworkAdapter::initialize_virtio_resources
             negotiated |= VIRTIO_NET_F_SPEED_DUPLEX;
         if (is_feature_set(supported_features, VIRTIO_NET_F_MTU))
             negotiated |= VIRTIO_NET_F_MTU;
+        // Segmentation offload needs the device to fill in the checksums of the segments it makes.
+        if (is_feature_set(supported_features, VIRTIO_NET_F_CSUM)) {
+            negotiated |= VIRTIO_NET_F_CSUM;
+            if (is_feature_set(supported_features, VIRTIO_NET_F_HOST_TSO4))
+                negotiated |= VIRTIO_NET_F_HOST_TSO4;
+        }
+        // NOTE: This allows the device to hand us packets with only a partial checksum, which is fine as we don't verify them.
+        if (is_feature_set(supported_features, VIRTIO_NET_F_GUEST_CSUM))
+            negotiated |= VIRTIO_NET_F_GUEST_CSUM;
+        if (is_feature_set(supported_features, VIRTIO_NET_F_CTRL_VQ)) {
+            negotiated |= VIRTIO_NET_F_CTRL_VQ;
+            if (is_feature_set(supported_features, VIRTIO_NET_F_MQ))
+                negotiated |= VIRTIO_NET_F_MQ;
+        }
         return negotiated;
     }));
 
     TRY(handle_device_config_change());
-    TRY(setup_queues(2)); // receive & transmit
+
+    u16 device_queue_pairs = 1;
+    if (is_feature_accepted(VIRTIO_NET_F_MQ))
+        device_queue_pairs = max(transport_entity().config_read16(*m_device_config, offsetof(VirtIONetConfig, max_virtqueue_pairs)), 1);
+    u16 queue_pairs = min(device_queue_pairs, min(Processor::count(), MAX_QUEUE_PAIRS));
+
+    // NOTE: The control queue comes after all of the device's queue pairs, even the ones we don't use.
+    if (is_feature_accepted(VIRTIO_NET_F_CTRL_VQ)) {
+        m_control_queue_index = device_queue_pairs * 2;
+        m_control_buffer = TRY(MM.allocate_contiguous_kernel_region(PAGE_SIZE, "VirtIONetworkAdapter Control buffer"sv, Memory::Region::Access::ReadWrite));
+        TRY(setup_queues(device_queue_pairs * 2 + 1));
+    } else {
+        TRY(setup_queues(2)); // receive & transmit
+    }
+
+    m_rx_buffer_size = sizeof(VirtIONetHdr) + sizeof(EthernetFrameHeader) + mtu();
+    for (u16 i = 0; i < queue_pairs; ++i) {
+        QueuePair queue_pair;
+        queue_pair.rx_buffers = TRY(Memory::RingBuffer::try_create("VirtIONetworkAdapter Rx buffer"sv, m_rx_buffer_size * MAX_INFLIGHT_PACKETS));
+        queue_pair.tx_buffers = TRY(Memory::RingBuffer::try_create("VirtIONetworkAdapter Tx buffer"sv, TX_BUFFER_SIZE));
+        TRY(m_queue_pairs.try_append(move(queue_pair)));
+    }
 
     finish_init();
 
-    {
-        // Supply receive buffers.
-        auto& rx_queue = get_queue(RECEIVEQ);
-        SpinlockLocker queue_lock(rx_queue.lock());
-        VirtIO::QueueChain chain(rx_queue);
-        while (m_rx_buffers->available_bytes() > RX_BUFFER_SIZE) {
-            // We know that the RingBuffer will not wraparound in this loop. But it's still awkward.
-            auto buffer_start = MUST(m_rx_buffers->reserve_space(RX_BUFFER_SIZE));
-            VERIFY(chain.add_buffer_to_chain(buffer_start, RX_BUFFER_SIZE, VirtIO::BufferType::DeviceWritable));
-            supply_chain_and_notify(RECEIVEQ, chain);
+    if (m_queue_pairs.size() > 1) {
+        if (auto result = set_queue_pair_count(m_queue_pairs.size()); result.is_error()) {
+            dmesgln("VirtIONetworkAdapter: Failed to enable {} queue pairs: {}", m_queue_pairs.size(), result.error());
+            m_queue_pairs.shrink(1);
         }
     }
+    dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: Using {} queue pairs", m_queue_pairs.size());
+
+    auto offloads = Offload::None;
+    if (is_feature_accepted(VIRTIO_NET_F_CSUM))
+        offloads |= Offload::TransmitChecksum;
+    if (is_feature_accepted(VIRTIO_NET_F_HOST_TSO4))
+        offloads |= Offload::TCPSegmentation;
+    set_offloads(offloads);
+
+    for (u16 i = 0; i < m_queue_pairs.size(); ++i)
+        supply_receive_buffers(i);
 
     return {};
 }
 
+UNMAP_AFTER_INIT void VirtIONetworkAdapter::supply_receive_buffers(u16 queue_pair)
+{
+    auto& rx_buffers = *m_queue_pairs[queue_pair].rx_buffers;
+    auto& rx_queue = get_queue(receiveq(queue_pair));
+    SpinlockLocker queue_lock(rx_queue.lock());
+    VirtIO::QueueChain chain(rx_queue);
+    while (rx_buffers.available_bytes() > m_rx_buffer_size) {
+        // We know that the RingBuffer will not wraparound in this loop. But it's still awkward.
+        auto buffer_start = MUST(rx_buffers.reserve_space(m_rx_buffer_size));
+        VERIFY(chain.add_buffer_to_chain(buffer_start, m_rx_buffer_size, VirtIO::BufferType::DeviceWritable));
+        supply_chain_and_notify(receiveq(queue_pair), chain);
+    }
+}
+
+UNMAP_AFTER_INIT ErrorOr<void> VirtIONetworkAdapter::set_queue_pair_count(u16 count)
+{
+    VERIFY(m_control_queue_index.has_value());
+    auto control_queue_index = m_control_queue_index.value();
+
+    auto& command = *reinterpret_cast<VirtIONetCtrlMQ*>(m_control_buffer->vaddr().as_ptr());
+    command.net_class = VIRTIO_NET_CTRL_MQ;
+    command.command = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+    command.virtqueue_pairs = count;
+    auto* ack = reinterpret_cast<u8 volatile*>(m_control_buffer->vaddr().offset(sizeof(command)).as_ptr());
+    *ack = ~VIRTIO_NET_OK;
+
+    // The device handles control commands right away, so we just wait for it.
+    auto& queue = get_queue(control_queue_index);
+    queue.disable_interrupts();
+    SpinlockLocker lock(queue.lock());
+    VirtIO::QueueChain chain { queue };
+    auto buffer_start = m_control_buffer->physical_page(0)->paddr();
+    VERIFY(chain.add_buffer_to_chain(buffer_start, sizeof(command), VirtIO::BufferType::DeviceReadable));
+    VERIFY(chain.add_buffer_to_chain(buffer_start.offset(sizeof(command)), sizeof(*ack), VirtIO::BufferType::DeviceWritable));
+    supply_chain_and_notify(control_queue_index, chain);
+    full_memory_barrier();
+
+    ScopeGuard clear_used_buffers([&] {
+        queue.discard_used_buffers();
+    });
+    for (size_t i = 0; i < CONTROL_COMMAND_TIMEOUT_IN_MICROSECONDS; ++i) {
+        if (queue.new_data_available())
+            return *ack == VIRTIO_NET_OK ? ErrorOr<void> {} : Error::from_errno(EIO);
+        microseconds_delay(1);
+    }
+    return Error::from_errno(EBUSY);
+}
+
 ErrorOr<void> VirtIONetworkAdapter::handle_device_config_change()
 {
     dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: handle_device_config_change");
@@ -196,9 +298,20 @@ void VirtIONetworkAdapter::handle_queue_update(u16 queue_index)
 {
     dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: handle_queue_update {}", queue_index);
 
-    if (queue_index == RECEIVEQ) {
+    // NOTE: The control queue is polled while waiting for a command to finish.
+    if (queue_index == m_control_queue_index)
+        return;
+
+    u16 queue_pair = queue_index / 2;
+    if (queue_pair >= m_queue_pairs.size()) {
+        dmesgln("VirtIONetworkAdapter: unexpected update for queue {}", queue_index);
+        return;
+    }
+
+    if (queue_index == receiveq(queue_pair)) {
         // FIXME: Disable interrupts while receiving as recommended by the spec.
-        auto& queue = get_queue(RECEIVEQ);
+        auto& rx_buffers = *m_queue_pairs[queue_pair].rx_buffers;
+        auto& queue = get_queue(queue_index);
         SpinlockLocker queue_lock(queue.lock());
         size_t used;
         VirtIO::QueueChain popped_chain = queue.pop_used_buffer_chain(used);
@@ -206,30 +319,29 @@ void VirtIONetworkAdapter::handle_queue_update(u16 queue_index)
         while (!popped_chain.is_empty()) {
             VERIFY(popped_chain.length() == 1);
             popped_chain.for_each([&](PhysicalAddress addr, size_t length) {
-                size_t offset = addr.as_ptr() - m_rx_buffers->start_of_region().as_ptr();
-                auto* message = reinterpret_cast<VirtIONetHdr*>(m_rx_buffers->vaddr().offset(offset).as_ptr());
+                size_t offset = addr.as_ptr() - rx_buffers.start_of_region().as_ptr();
+                auto* message = reinterpret_cast<VirtIONetHdr*>(rx_buffers.vaddr().offset(offset).as_ptr());
                 did_receive({ message->frame, length - sizeof(VirtIONetHdr) });
             });
 
-            supply_chain_and_notify(RECEIVEQ, popped_chain);
+            supply_chain_and_notify(queue_index, popped_chain);
             popped_chain = queue.pop_used_buffer_chain(used);
         }
-    } else if (queue_index == TRANSMITQ) {
-        auto& queue = get_queue(TRANSMITQ);
+    } else {
+        auto& tx_buffers = *m_queue_pairs[queue_pair].tx_buffers;
+        auto& queue = get_queue(queue_index);
         SpinlockLocker queue_lock(queue.lock());
-        SpinlockLocker ringbuffer_lock(m_tx_buffers->lock());
+        SpinlockLocker ringbuffer_lock(tx_buffers.lock());
 
         size_t used;
         VirtIO::QueueChain popped_chain = queue.pop_used_buffer_chain(used);
         do {
-            popped_chain.for_each([this](PhysicalAddress address, size_t length) {
-                m_tx_buffers->reclaim_space(address, length);
+            popped_chain.for_each([&tx_buffers](PhysicalAddress address, size_t length) {
+                tx_buffers.reclaim_space(address, length);
             });
             popped_chain.release_buffer_slots_to_queue();
             popped_chain = queue.pop_used_buffer_chain(used);
         } while (!popped_chain.is_empty());
-    } else {
-        dmesgln("VirtIONetworkAdapter: unexpected update for queue {}", queue_index);
     }
 }
 
@@ -253,26 +365,54 @@ static bool copy_data_to_chain(VirtIO::QueueChain& chain, Memory::RingBuffer& ri
 }
 
 void VirtIONetworkAdapter::send_raw(ReadonlyBytes payload)
+{
+    VirtIONetHdr hdr {};
+    send_with_header(payload, hdr);
+}
+
+void VirtIONetworkAdapter::send_raw_with_offload(ReadonlyBytes payload, TransmitOffload const& offload)
+{
+    VirtIONetHdr hdr {};
+    if (offload.needs_checksum) {
+        hdr.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        hdr.csum_start = offload.checksum_start;
+        hdr.csum_offset = offload.checksum_offset;
+    }
+    if (offload.segment_size != 0) {
+        // The device can only make segments of TCP packets whose checksum it fills in.
+        VERIFY(offload.needs_checksum);
+        hdr.gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+        hdr.gso_size = offload.segment_size;
+        // This is how much of the packet gets copied into every segment, up to the end of the TCP header.
+        u8 tcp_data_offset = payload[offload.checksum_start + 12] >> 4;
+        hdr.hdr_len = offload.checksum_start + tcp_data_offset * sizeof(u32);
+    }
+    send_with_header(payload, hdr);
+}
+
+void VirtIONetworkAdapter::send_with_header(ReadonlyBytes payload, VirtIONetHdr const& hdr)
 {
     dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: send_raw length={}", payload.size());
 
-    auto& queue = get_queue(TRANSMITQ);
+    // Processors send on different queues where possible, so they don't have to wait for each other.
+    u16 queue_pair = Processor::current_id() % m_queue_pairs.size();
+    auto& tx_buffers = *m_queue_pairs[queue_pair].tx_buffers;
+    auto& queue = get_queue(transmitq(queue_pair));
     SpinlockLocker queue_lock(queue.lock());
     VirtIO::QueueChain chain(queue);
 
-    SpinlockLocker ringbuffer_lock(m_tx_buffers->lock());
-    if (m_tx_buffers->available_bytes() < sizeof(VirtIONetHdr) + payload.size()) {
+    SpinlockLocker ringbuffer_lock(tx_buffers.lock());
+    if (tx_buffers.available_bytes() < sizeof(VirtIONetHdr) + payload.size()) {
         // We can drop packets that don't fit to apply back pressure on eager senders.
         dmesgln("VirtIONetworkAdapter: not enough space in the buffer. Dropping packet");
         return;
     }
 
     // FIXME: Handle errors from pushing to the chain and rewind the RingBuffer.
-    VirtIONetHdr hdr {};
-    VERIFY(copy_data_to_chain(chain, *m_tx_buffers, reinterpret_cast<u8*>(&hdr), sizeof(hdr)));
-    VERIFY(copy_data_to_chain(chain, *m_tx_buffers, payload.data(), payload.size()));
+    VERIFY(copy_data_to_chain(chain, tx_buffers, reinterpret_cast<u8 const*>(&hdr), sizeof(hdr)));
+    VERIFY(copy_data_to_chain(chain, tx_buffers, payload.data(), payload.size()));
 
-    supply_chain_and_notify(TRANSMITQ, chain);
+    supply_chain_and_notify(transmitq(queue_pair), chain);
 }
 
 }
@@ -12,6 +12,10 @@
 
 namespace Kernel {
 
+namespace VirtIO {
+struct VirtIONetHdr;
+}
+
 class VirtIONetworkAdapter
     : public VirtIO::Device
     , public NetworkAdapter {
@@ -42,6 +46,11 @@ private:
 
     // NetworkAdapter
     virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offload(ReadonlyBytes, TransmitOffload const&) override;
+
+    void send_with_header(ReadonlyBytes, VirtIO::VirtIONetHdr const&);
+    void supply_receive_buffers(u16 queue_pair);
+    ErrorOr<void> set_queue_pair_count(u16);
 
 private:
     VirtIO::Configuration const* m_device_config { nullptr };
@@ -52,8 +61,16 @@ private:
     i32 m_link_speed { LINKSPEED_INVALID };
     bool m_link_duplex { false };
 
-    OwnPtr<Memory::RingBuffer> m_rx_buffers;
-    OwnPtr<Memory::RingBuffer> m_tx_buffers;
+    // Every processor sends on its own transmit queue, and the device steers the replies to the receive queue next to it.
+    struct QueuePair {
+        OwnPtr<Memory::RingBuffer> rx_buffers;
+        OwnPtr<Memory::RingBuffer> tx_buffers;
+    };
+    Vector<QueuePair> m_queue_pairs;
+    size_t m_rx_buffer_size { 0 };
+
+    Optional<u16> m_control_queue_index;
+    OwnPtr<Memory::Region> m_control_buffer;
 };
 
 }
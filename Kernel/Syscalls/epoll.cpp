@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <AK/Time.h>
+#include <Kernel/API/POSIX/sys/epoll.h>
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+static constexpr u32 valid_epoll_events = EPOLLIN | EPOLLPRI | EPOLLOUT | EPOLLERR | EPOLLHUP | EPOLLWRBAND | EPOLLRDHUP | EPOLLET | EPOLLONESHOT;
+
+ErrorOr<FlatPtr> Process::sys$epoll_create(u32 flags)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    if (flags & ~EPOLL_CLOEXEC)
+        return EINVAL;
+
+    auto event_poll = TRY(EventPoll::try_create());
+    auto description = TRY(OpenFileDescription::try_create(move(event_poll)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        auto fd_allocation = TRY(fds.allocate());
+        fds[fd_allocation.fd].set(move(description));
+
+        if (flags & EPOLL_CLOEXEC)
+            fds[fd_allocation.fd].set_flags(fds[fd_allocation.fd].flags() | FD_CLOEXEC);
+
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_ctl(int epoll_fd, int op, int fd, Userspace<epoll_event const*> user_event)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto epoll_description = TRY(open_file_description(epoll_fd));
+    auto description = TRY(open_file_description(fd));
+    if (!epoll_description->is_event_poll())
+        return EINVAL;
+    // FIXME: Support watching other epoll instances.
+    if (description->is_event_poll())
+        return EINVAL;
+    auto& event_poll = *epoll_description->event_poll();
+
+    if (op == EPOLL_CTL_DEL) {
+        TRY(event_poll.remove_interest(*description, fd));
+        return 0;
+    }
+
+    auto event = TRY(copy_typed_from_user(user_event));
+    if (event.events & ~valid_epoll_events)
+        return EINVAL;
+
+    switch (op) {
+    case EPOLL_CTL_ADD:
+        TRY(event_poll.add_interest(*description, fd, event.events, event.data.u64));
+        return 0;
+    case EPOLL_CTL_MOD:
+        TRY(event_poll.modify_interest(*description, fd, event.events, event.data.u64));
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_wait(Userspace<Syscall::SC_epoll_wait_params const*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto params = TRY(copy_typed_from_user(user_params));
+    if (params.max_events <= 0)
+        return EINVAL;
+
+    auto description = TRY(open_file_description(params.epoll_fd));
+    if (!description->is_event_poll())
+        return EINVAL;
+    auto& event_poll = *description->event_poll();
+
+    Thread::BlockTimeout timeout;
+    bool should_block = true;
+    if (params.timeout) {
+        auto timeout_time = TRY(copy_time_from_user(params.timeout));
+        timeout = Thread::BlockTimeout(false, &timeout_time);
+        should_block = !timeout_time.is_zero();
+    }
+
+    sigset_t sigmask = {};
+    if (params.sigmask)
+        TRY(copy_from_user(&sigmask, params.sigmask));
+
+    auto* current_thread = Thread::current();
+
+    u32 previous_signal_mask = 0;
+    if (params.sigmask)
+        previous_signal_mask = current_thread->update_signal_mask(sigmask);
+    ScopeGuard rollback_signal_mask([&]() {
+        if (params.sigmask)
+            current_thread->update_signal_mask(previous_signal_mask);
+    });
+
+    Vector<epoll_event> events;
+    for (;;) {
+        events = TRY(event_poll.collect_ready_events(params.max_events));
+        if (!events.is_empty() || !should_block)
+            break;
+
+        // NOTE: The timeout is converted to an absolute deadline once, so spurious wakeups don't extend it.
+        auto unblock_flags = BlockFlags::None;
+        auto result = current_thread->block<Thread::ReadBlocker>(timeout, *description, unblock_flags);
+        if (result.was_interrupted())
+            return EINTR;
+        if (result == Thread::BlockResult::InterruptedByTimeout)
+            should_block = false;
+    }
+
+    if (!events.is_empty())
+        TRY(copy_n_to_user(params.events, events.data(), events.size()));
+
+    return events.size();
+}
+
+}
@@ -172,6 +172,7 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
     bool map_noreserve = flags & MAP_NORESERVE;
     bool map_randomized = flags & MAP_RANDOMIZED;
     bool map_fixed_noreplace = flags & MAP_FIXED_NOREPLACE;
+    bool map_hugetlb = flags & MAP_HUGETLB;
 
     if (map_shared && map_private)
         return EINVAL;
@@ -187,6 +188,13 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
     if (map_stack && (!map_private || !map_anonymous))
         return EINVAL;
 
+    if (map_hugetlb && !map_anonymous)
+        return EINVAL;
+
+    // Large pages can only be used for the parts of a region that line up with them.
+    if (map_hugetlb && rounded_size >= Memory::large_page_size)
+        alignment = max(alignment, Memory::large_page_size);
+
     Memory::VirtualRange requested_range { VirtualAddress { addr }, rounded_size };
     if (addr && !(map_fixed || map_fixed_noreplace)) {
         // If there's an address but MAP_FIXED wasn't specified, the address is just a hint.
@@ -257,6 +265,8 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
             region->set_shared(true);
         if (map_stack)
             region->set_stack(true);
+        if (map_hugetlb)
+            region->set_prefers_large_pages(true);
         if (name)
             region->set_name(move(name));
 
@@ -435,6 +445,25 @@ ErrorOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, int
             TRY(vmobject.set_volatile(advice == MADV_SET_VOLATILE, was_purged));
             return was_purged ? 1 : 0;
         }
+        switch (advice) {
+        case MADV_NORMAL:
+            region->set_access_pattern(Memory::Region::AccessPattern::Normal);
+            return 0;
+        case MADV_SEQUENTIAL:
+            region->set_access_pattern(Memory::Region::AccessPattern::Sequential);
+            return 0;
+        case MADV_RANDOM:
+            region->set_access_pattern(Memory::Region::AccessPattern::Random);
+            return 0;
+        case MADV_WILLNEED:
+            // Only file-backed memory has anything to read ahead of time.
+            if (region->vmobject().is_inode()) {
+                auto& inode = static_cast<Memory::InodeVMObject&>(region->vmobject()).inode();
+                auto offset_in_region = range_to_madvise.base().get() - region->vaddr().get();
+                inode.readahead(region->offset_in_vmobject() + offset_in_region, range_to_madvise.size());
+            }
+            return 0;
+        }
         return EINVAL;
     });
 }
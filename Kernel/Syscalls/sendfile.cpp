@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Library/KBuffer.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/SharedInodeVMObject.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+// How much of the file we map into the kernel at a time.
+static constexpr size_t sendfile_window_size = 1 * MiB;
+// How much we read at a time when the file can't be sent from its pages directly.
+static constexpr size_t sendfile_read_buffer_size = 64 * KiB;
+
+ErrorOr<FlatPtr> Process::sys$sendfile(int out_fd, int in_fd, Userspace<off_t*> user_offset, size_t count)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    if (count > NumericLimits<ssize_t>::max())
+        return EINVAL;
+
+    auto in_description = TRY(open_file_description(in_fd));
+    auto out_description = TRY(open_file_description(out_fd));
+    if (!in_description->is_readable() || !out_description->is_writable())
+        return EBADF;
+    // FIXME: Support sending to other kinds of files, like pipes.
+    if (!in_description->file().is_regular_file() || !out_description->is_socket())
+        return EINVAL;
+    auto& inode = *in_description->inode();
+
+    off_t offset = 0;
+    if (user_offset)
+        TRY(copy_from_user(&offset, user_offset));
+    else
+        offset = in_description->offset();
+    if (offset < 0)
+        return EINVAL;
+
+    size_t total_nsent = 0;
+    auto file_size = inode.size();
+    if (count > 0 && static_cast<u64>(offset) < static_cast<u64>(file_size)) {
+        count = min<u64>(count, static_cast<u64>(file_size) - offset);
+
+        // Returns whether the next chunk should be sent as well.
+        auto send_chunk = [&](UserOrKernelBuffer const& buffer, size_t chunk_size) -> ErrorOr<bool> {
+            auto nsent_or_error = do_write(*out_description, buffer, chunk_size);
+            if (nsent_or_error.is_error()) {
+                if (total_nsent == 0)
+                    return nsent_or_error.release_error();
+                return false;
+            }
+            total_nsent += nsent_or_error.value();
+            // A non-blocking socket may not have room for all of it.
+            return nsent_or_error.value() == chunk_size;
+        };
+
+        // The file's pages are sent straight from a shared VMObject, the same pages that back any mmap() of it.
+        // This way, the data is only copied once, into the outgoing packets, instead of into and out of a userspace buffer.
+        // NOTE: The pages of an existing shared VMObject are not kept in sync with write(), and it may have been created
+        //       while the file was still smaller, so in that case we fall back to reading from the inode.
+        LockRefPtr<Memory::SharedInodeVMObject> vmobject;
+        if (!inode.shared_vmobject())
+            vmobject = TRY(Memory::SharedInodeVMObject::try_create_with_inode_and_range(inode, 0, file_size));
+
+        if (vmobject && static_cast<u64>(offset) < vmobject->size()) {
+            count = min<u64>(count, vmobject->size() - offset);
+            while (total_nsent < count) {
+                u64 position = offset + total_nsent;
+                u64 window_offset = Memory::page_round_down(position);
+                size_t window_size = min<u64>(sendfile_window_size, vmobject->size() - window_offset);
+                auto window = TRY(MM.allocate_kernel_region_with_vmobject(*vmobject, window_offset, window_size, "sendfile"sv, Memory::Region::Access::Read));
+
+                size_t chunk_size = min<u64>(count - total_nsent, window_offset + window_size - position);
+                auto buffer = UserOrKernelBuffer::for_kernel_buffer(window->vaddr().offset(position - window_offset).as_ptr());
+                if (!TRY(send_chunk(buffer, chunk_size)))
+                    break;
+            }
+        } else {
+            auto data = TRY(KBuffer::try_create_with_size("sendfile"sv, min(count, sendfile_read_buffer_size)));
+            auto buffer = UserOrKernelBuffer::for_kernel_buffer(data->data());
+            while (total_nsent < count) {
+                auto nread_or_error = inode.read_bytes(offset + total_nsent, min(count - total_nsent, data->size()), buffer, in_description);
+                if (nread_or_error.is_error()) {
+                    if (total_nsent == 0)
+                        return nread_or_error.release_error();
+                    break;
+                }
+                // The file may have been truncated in the meantime.
+                if (nread_or_error.value() == 0 || !TRY(send_chunk(buffer, nread_or_error.value())))
+                    break;
+            }
+        }
+    }
+
+    if (user_offset) {
+        off_t new_offset = offset + total_nsent;
+        TRY(copy_to_user(user_offset, &new_offset));
+    } else {
+        TRY(in_description->seek(offset + total_nsent, SEEK_SET));
+    }
+    return total_nsent;
+}
+
+}
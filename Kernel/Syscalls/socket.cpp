@@ -8,6 +8,7 @@
 #include <Kernel/FileSystem/OpenFileDescription.h>
 #include <Kernel/Net/LocalSocket.h>
 #include <Kernel/Tasks/Process.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/UnixTypes.h>
 
 namespace Kernel {
@@ -179,12 +180,8 @@ ErrorOr<FlatPtr> Process::sys$shutdown(int sockfd, int how)
     return 0;
 }
 
-ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*> user_msg, int flags)
+ErrorOr<size_t> Process::do_sendmsg(OpenFileDescription& description, struct msghdr& msg, int flags)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
-    TRY(require_promise(Pledge::stdio));
-    auto msg = TRY(copy_typed_from_user(user_msg));
-
     if (msg.msg_iovlen != 1)
         return ENOTSUP; // FIXME: Support this :)
     Vector<iovec, 1> iovs;
@@ -196,11 +193,10 @@ ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*
     Userspace<sockaddr const*> user_addr((FlatPtr)msg.msg_name);
     socklen_t addr_length = msg.msg_namelen;
 
-    auto description = TRY(open_file_description(sockfd));
-    if (!description->is_socket())
+    if (!description.is_socket())
         return ENOTSOCK;
 
-    auto& socket = *description->socket();
+    auto& socket = *description.socket();
     if (socket.is_shut_down_for_writing()) {
         if ((flags & MSG_NOSIGNAL) == 0)
             Thread::current()->send_signal(SIGPIPE, &Process::current());
@@ -218,7 +214,7 @@ ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*
                 int* fds = (int*)CMSG_DATA(cmsg);
                 size_t nfds = (cmsg->cmsg_len - CMSG_ALIGN(sizeof(struct cmsghdr))) / sizeof(int);
                 for (size_t i = 0; i < nfds; ++i) {
-                    TRY(local_socket.sendfd(*description, TRY(open_file_description(fds[i]))));
+                    TRY(local_socket.sendfd(description, TRY(open_file_description(fds[i]))));
                 }
             }
         }
@@ -227,19 +223,19 @@ ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*
     auto data_buffer = TRY(UserOrKernelBuffer::for_user_buffer((u8*)iovs[0].iov_base, iovs[0].iov_len));
 
     while (true) {
-        while (!description->can_write()) {
-            if (!description->is_blocking()) {
+        while (!description.can_write()) {
+            if (!description.is_blocking()) {
                 return EAGAIN;
             }
 
             auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
-            if (Thread::current()->block<Thread::WriteBlocker>({}, *description, unblock_flags).was_interrupted()) {
+            if (Thread::current()->block<Thread::WriteBlocker>({}, description, unblock_flags).was_interrupted()) {
                 return EINTR;
             }
             // TODO: handle exceptions in unblock_flags
         }
 
-        auto bytes_sent_or_error = socket.sendto(*description, data_buffer, iovs[0].iov_len, flags, user_addr, addr_length);
+        auto bytes_sent_or_error = socket.sendto(description, data_buffer, iovs[0].iov_len, flags, user_addr, addr_length);
         if (bytes_sent_or_error.is_error()) {
             if ((flags & MSG_NOSIGNAL) == 0 && bytes_sent_or_error.error().code() == EPIPE)
                 Thread::current()->send_signal(SIGPIPE, &Process::current());
@@ -252,11 +248,46 @@ ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*
     }
 }
 
-ErrorOr<FlatPtr> Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user_msg, int flags)
+ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*> user_msg, int flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto msg = TRY(copy_typed_from_user(user_msg));
+    auto description = TRY(open_file_description(sockfd));
+    return TRY(do_sendmsg(*description, msg, flags));
+}
+
+ErrorOr<FlatPtr> Process::sys$sendmmsg(int sockfd, Userspace<struct mmsghdr*> user_msgvec, unsigned int vlen, int flags)
 {
     VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
     TRY(require_promise(Pledge::stdio));
+    if (vlen > IOV_MAX)
+        vlen = IOV_MAX;
+
+    auto description = TRY(open_file_description(sockfd));
+    if (!description->is_socket())
+        return ENOTSOCK;
 
+    unsigned int nsent = 0;
+    for (; nsent < vlen; ++nsent) {
+        auto* user_mmsg = user_msgvec.unsafe_userspace_ptr() + nsent;
+        struct msghdr msg;
+        TRY(copy_from_user(&msg, &user_mmsg->msg_hdr));
+        // Only the first message may fail the whole call, after that we report how many made it out.
+        auto bytes_sent_or_error = do_sendmsg(*description, msg, flags);
+        if (bytes_sent_or_error.is_error()) {
+            if (nsent == 0)
+                return bytes_sent_or_error.release_error();
+            break;
+        }
+        unsigned int msg_len = bytes_sent_or_error.value();
+        TRY(copy_to_user(&user_mmsg->msg_len, &msg_len));
+    }
+    return nsent;
+}
+
+ErrorOr<size_t> Process::do_recvmsg(OpenFileDescription& description, Userspace<struct msghdr*> user_msg, int flags)
+{
     struct msghdr msg;
     TRY(copy_from_user(&msg, user_msg));
 
@@ -269,18 +300,17 @@ ErrorOr<FlatPtr> Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user
     Userspace<sockaddr*> user_addr((FlatPtr)msg.msg_name);
     Userspace<socklen_t*> user_addr_length(msg.msg_name ? (FlatPtr)&user_msg.unsafe_userspace_ptr()->msg_namelen : 0);
 
-    auto description = TRY(open_file_description(sockfd));
-    if (!description->is_socket())
+    if (!description.is_socket())
         return ENOTSOCK;
-    auto& socket = *description->socket();
+    auto& socket = *description.socket();
 
     if (socket.is_shut_down_for_reading())
         return 0;
 
     auto data_buffer = TRY(UserOrKernelBuffer::for_user_buffer((u8*)iovs[0].iov_base, iovs[0].iov_len));
     UnixDateTime timestamp {};
-    bool blocking = (flags & MSG_DONTWAIT) ? false : description->is_blocking();
-    auto result = socket.recvfrom(*description, data_buffer, iovs[0].iov_len, flags, user_addr, user_addr_length, timestamp, blocking);
+    bool blocking = (flags & MSG_DONTWAIT) ? false : description.is_blocking();
+    auto result = socket.recvfrom(description, data_buffer, iovs[0].iov_len, flags, user_addr, user_addr_length, timestamp, blocking);
 
     if (result.is_error())
         return result.release_error();
@@ -331,6 +361,60 @@ ErrorOr<FlatPtr> Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user
     return result.value();
 }
 
+ErrorOr<FlatPtr> Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user_msg, int flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto description = TRY(open_file_description(sockfd));
+    return TRY(do_recvmsg(*description, user_msg, flags));
+}
+
+ErrorOr<FlatPtr> Process::sys$recvmmsg(Userspace<Syscall::SC_recvmmsg_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+    auto vlen = min(params.vlen, static_cast<unsigned int>(IOV_MAX));
+
+    // Like on other systems, the timeout is only checked after each message, so it doesn't bound a blocking receive.
+    Optional<MonotonicTime> deadline;
+    if (params.timeout) {
+        auto timeout = TRY(copy_time_from_user(params.timeout));
+        if (timeout.is_negative())
+            return EINVAL;
+        deadline = TimeManagement::the().monotonic_time() + timeout;
+    }
+
+    auto description = TRY(open_file_description(params.sockfd));
+    if (!description->is_socket())
+        return ENOTSOCK;
+
+    int flags = params.flags & ~MSG_WAITFORONE;
+    unsigned int nreceived = 0;
+    while (nreceived < vlen) {
+        auto* user_mmsg = params.msgvec + nreceived;
+        Userspace<struct msghdr*> user_msg((FlatPtr)&user_mmsg->msg_hdr);
+        auto bytes_received_or_error = do_recvmsg(*description, user_msg, flags);
+        if (bytes_received_or_error.is_error()) {
+            if (nreceived == 0)
+                return bytes_received_or_error.release_error();
+            break;
+        }
+        unsigned int msg_len = bytes_received_or_error.value();
+        TRY(copy_to_user(&user_mmsg->msg_len, &msg_len));
+        ++nreceived;
+
+        // A datagram socket that was shut down reads as zero-length, so don't spin on it.
+        if (msg_len == 0 && description->socket()->is_shut_down_for_reading())
+            break;
+        if (params.flags & MSG_WAITFORONE)
+            flags |= MSG_DONTWAIT;
+        if (deadline.has_value() && TimeManagement::the().monotonic_time() >= deadline.value())
+            break;
+    }
+    return nreceived;
+}
+
 template<Process::SockOrPeerName sock_or_peer_name, typename Params>
 ErrorOr<void> Process::get_sock_or_peer_name(Params const& params)
 {
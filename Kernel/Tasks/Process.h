@@ -310,6 +310,9 @@ public:
     void tracer_trap(Thread&, RegisterState const&);
 
     ErrorOr<FlatPtr> sys$emuctl();
+    ErrorOr<FlatPtr> sys$epoll_create(u32 flags);
+    ErrorOr<FlatPtr> sys$epoll_ctl(int epoll_fd, int op, int fd, Userspace<epoll_event const*>);
+    ErrorOr<FlatPtr> sys$epoll_wait(Userspace<Syscall::SC_epoll_wait_params const*>);
     ErrorOr<FlatPtr> sys$yield();
     ErrorOr<FlatPtr> sys$sync();
     ErrorOr<FlatPtr> sys$beep(int tone);
@@ -423,6 +426,8 @@ public:
     ErrorOr<FlatPtr> sys$shutdown(int sockfd, int how);
     ErrorOr<FlatPtr> sys$sendmsg(int sockfd, Userspace<const struct msghdr*>, int flags);
     ErrorOr<FlatPtr> sys$recvmsg(int sockfd, Userspace<struct msghdr*>, int flags);
+    ErrorOr<FlatPtr> sys$sendmmsg(int sockfd, Userspace<struct mmsghdr*>, unsigned int vlen, int flags);
+    ErrorOr<FlatPtr> sys$recvmmsg(Userspace<Syscall::SC_recvmmsg_params const*>);
     ErrorOr<FlatPtr> sys$getsockopt(Userspace<Syscall::SC_getsockopt_params const*>);
     ErrorOr<FlatPtr> sys$setsockopt(Userspace<Syscall::SC_setsockopt_params const*>);
     ErrorOr<FlatPtr> sys$getsockname(Userspace<Syscall::SC_getsockname_params const*>);
@@ -453,6 +458,7 @@ public:
     ErrorOr<FlatPtr> sys$get_stack_bounds(Userspace<FlatPtr*> stack_base, Userspace<size_t*> stack_size);
     ErrorOr<FlatPtr> sys$ptrace(Userspace<Syscall::SC_ptrace_params const*>);
     ErrorOr<FlatPtr> sys$sendfd(int sockfd, int fd);
+    ErrorOr<FlatPtr> sys$sendfile(int out_fd, int in_fd, Userspace<off_t*> offset, size_t count);
     ErrorOr<FlatPtr> sys$recvfd(int sockfd, int options);
     ErrorOr<FlatPtr> sys$sysconf(int name);
     ErrorOr<FlatPtr> sys$disown(ProcessID);
@@ -666,6 +672,8 @@ private:
 
     ErrorOr<void> do_exec(NonnullRefPtr<OpenFileDescription> main_program_description, Vector<NonnullOwnPtr<KString>> arguments, Vector<NonnullOwnPtr<KString>> environment, RefPtr<OpenFileDescription> interpreter_description, Thread*& new_main_thread, InterruptsState& previous_interrupts_state, Elf_Ehdr const& main_program_header, Optional<size_t> minimum_stack_size = {});
     ErrorOr<FlatPtr> do_write(OpenFileDescription&, UserOrKernelBuffer const&, size_t, Optional<off_t> = {});
+    ErrorOr<size_t> do_sendmsg(OpenFileDescription&, struct msghdr&, int flags);
+    ErrorOr<size_t> do_recvmsg(OpenFileDescription&, Userspace<struct msghdr*>, int flags);
 
     ErrorOr<FlatPtr> do_statvfs(FileSystem const& path, Custody const*, statvfs* buf);
 
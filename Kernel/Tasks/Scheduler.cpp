@@ -44,9 +44,77 @@ struct ThreadReadyQueues {
     u32 mask {};
     static constexpr size_t count = sizeof(mask) * 8;
     Array<ThreadReadyQueue, count> queues;
+
+    // Returns the highest priority thread that may be scheduled on a processor with the given affinity mask,
+    // only looking at priorities above the given limit.
+    Thread* find_runnable_thread(u32 affinity_mask, u32 priority_limit = count)
+    {
+        auto priority_mask = mask;
+        if (priority_limit < count)
+            priority_mask &= (1u << priority_limit) - 1;
+        while (priority_mask != 0) {
+            auto priority = bit_scan_forward(priority_mask);
+            VERIFY(priority > 0);
+            --priority;
+            for (auto& thread : queues[priority].thread_list) {
+                VERIFY(thread.m_runnable_priority == (int)priority);
+                if (thread.is_active())
+                    continue;
+                if (!(thread.affinity() & affinity_mask))
+                    continue;
+                return &thread;
+            }
+            priority_mask &= ~(1u << priority);
+        }
+        return nullptr;
+    }
+
+    void append(Thread& thread, u32 priority)
+    {
+        VERIFY(thread.m_runnable_priority < 0);
+        thread.m_runnable_priority = (int)priority;
+        VERIFY(!thread.m_ready_queue_node.is_in_list());
+        auto& ready_queue = queues[priority];
+        bool was_empty = ready_queue.thread_list.is_empty();
+        ready_queue.thread_list.append(thread);
+        if (was_empty)
+            mask |= (1u << priority);
+    }
+
+    void remove(Thread& thread)
+    {
+        auto priority = thread.m_runnable_priority;
+        VERIFY(priority >= 0);
+        VERIFY(mask & (1u << priority));
+        auto& ready_queue = queues[priority];
+        thread.m_runnable_priority = -1;
+        ready_queue.thread_list.remove(thread);
+        if (ready_queue.thread_list.is_empty())
+            mask &= ~(1u << priority);
+    }
 };
 
-static Singleton<SpinlockProtected<ThreadReadyQueues, LockRank::None>> g_ready_queues;
+// Every processor owns a set of ready queues, each protected by its own lock alone. Threads
+// are queued on the processor they last ran on (if their affinity allows it) to keep their
+// caches warm, and processors that run out of local work steal runnable threads from their peers.
+using ProcessorReadyQueues = SpinlockProtected<ThreadReadyQueues, LockRank::None>;
+static Singleton<Array<ProcessorReadyQueues, MAX_CPU_COUNT>> g_ready_queues;
+
+// A copy of the mask of every processor's ready queues, so that other processors can check for more important
+// work there without taking the lock. It's only updated while holding the lock, and may be stale when read.
+static Array<Atomic<u32>, MAX_CPU_COUNT> g_ready_queue_masks;
+
+static void publish_ready_queue_mask(u32 cpu, ThreadReadyQueues const& queues)
+{
+    g_ready_queue_masks[cpu].store(queues.mask, AK::memory_order_relaxed);
+}
+
+// Returns the index of the highest priority that has queued threads on the given processor, lower is more important.
+static u32 highest_queued_priority(u32 cpu)
+{
+    auto mask = g_ready_queue_masks[cpu].load(AK::memory_order_relaxed);
+    return mask == 0 ? ThreadReadyQueues::count : bit_scan_forward(mask) - 1;
+}
 
 static SpinlockProtected<TotalTimeScheduled, LockRank::None> g_total_time_scheduled {};
 
@@ -64,73 +132,127 @@ static inline u32 thread_priority_to_priority_index(u32 thread_priority)
     return priority_bucket;
 }
 
-Thread& Scheduler::pull_next_runnable_thread()
+static inline u32 ready_queue_processor_count()
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    // NOTE: Processor::count() may be zero on platforms that never record it.
+    return clamp(Processor::count(), 1u, static_cast<u32>(MAX_CPU_COUNT));
+}
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread& {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                thread.m_runnable_priority = -1;
-                ready_queue.thread_list.remove(thread);
-                if (ready_queue.thread_list.is_empty())
-                    ready_queues.mask &= ~(1u << priority);
-                // Mark it as active because we are using this thread. This is similar
-                // to comparing it with Processor::current_thread, but when there are
-                // multiple processors there's no easy way to check whether the thread
-                // is actually still needed. This prevents accidental finalization when
-                // a thread is no longer in Running state, but running on another core.
-
-                // We need to mark it active here so that this thread won't be
-                // scheduled on another core if it were to be queued before actually
-                // switching to it.
-                // FIXME: Figure out a better way maybe?
-                thread.set_active(true);
-                return thread;
-            }
-            priority_mask &= ~(1u << priority);
-        }
+static u32 select_ready_queue_for(Thread const& thread)
+{
+    auto processor_count = ready_queue_processor_count();
+    auto affinity = thread.affinity();
+
+    // Prefer the processor the thread last ran on, its caches are most likely still warm.
+    auto last_cpu = thread.cpu();
+    if (thread.times_scheduled() > 0 && last_cpu < processor_count && (affinity & (1u << last_cpu)))
+        return last_cpu;
 
-        auto* idle_thread = Processor::idle_thread();
-        idle_thread->set_active(true);
-        return *idle_thread;
+    auto current_cpu = Processor::current_id();
+    if (current_cpu < processor_count && (affinity & (1u << current_cpu)))
+        return current_cpu;
+
+    for (u32 cpu = 0; cpu < processor_count; ++cpu) {
+        if (affinity & (1u << cpu))
+            return cpu;
+    }
+
+    // Nobody can run this thread, leave it on the current processor's queue
+    // so that it still shows up as runnable.
+    return current_cpu < processor_count ? current_cpu : 0;
+}
+
+// Takes the highest priority thread that may run on the current processor out of the given processor's queues.
+static Thread* take_runnable_thread(u32 cpu, u32 affinity_mask, u32 priority_limit = ThreadReadyQueues::count)
+{
+    return (*g_ready_queues)[cpu].with([&](auto& queues) -> Thread* {
+        auto* thread = queues.find_runnable_thread(affinity_mask, priority_limit);
+        if (!thread)
+            return nullptr;
+        queues.remove(*thread);
+        publish_ready_queue_mask(cpu, queues);
+
+        // Mark it as active because we are using this thread. This is similar
+        // to comparing it with Processor::current_thread, but when there are
+        // multiple processors there's no easy way to check whether the thread
+        // is actually still needed. This prevents accidental finalization when
+        // a thread is no longer in Running state, but running on another core.
+
+        // We need to mark it active before letting go of the queue lock so that
+        // this thread won't be picked by another core as well, or scheduled on
+        // another core if it were to be queued before actually switching to it.
+        // FIXME: Figure out a better way maybe?
+        thread->set_active(true);
+        return thread;
+    });
+}
+
+// Calls the callback with every other processor that has queued threads of a priority above the given limit,
+// starting with the one after the current processor so that stealing spreads out, until it returns a thread.
+template<typename Callback>
+static Thread* find_thread_in_peer_ready_queues(u32 priority_limit, Callback callback)
+{
+    auto current_cpu = Processor::current_id();
+    auto processor_count = ready_queue_processor_count();
+    for (u32 i = 1; i < processor_count; ++i) {
+        auto cpu = (current_cpu + i) % processor_count;
+        if (highest_queued_priority(cpu) >= priority_limit)
+            continue;
+        if (auto* thread = callback(cpu))
+            return thread;
+    }
+    return nullptr;
+}
+
+static Thread* steal_runnable_thread(u32 affinity_mask, u32 priority_limit)
+{
+    return find_thread_in_peer_ready_queues(priority_limit, [&](u32 cpu) {
+        auto* stolen_thread = take_runnable_thread(cpu, affinity_mask, priority_limit);
+        if (stolen_thread)
+            dbgln_if(SCHEDULER_DEBUG, "Scheduler[{}]: Stole {} from processor {}", Processor::current_id(), *stolen_thread, cpu);
+        return stolen_thread;
     });
 }
 
+Thread& Scheduler::pull_next_runnable_thread()
+{
+    auto current_cpu = Processor::current_id();
+    auto affinity_mask = 1u << current_cpu;
+
+    // A thread waiting on a busy peer is taken over if it's more important than anything queued here.
+    // Otherwise, peers are only stolen from once there's nothing left to run locally.
+    auto* thread = steal_runnable_thread(affinity_mask, highest_queued_priority(current_cpu));
+    if (!thread)
+        thread = take_runnable_thread(current_cpu, affinity_mask);
+    if (!thread)
+        thread = steal_runnable_thread(affinity_mask, ThreadReadyQueues::count);
+    if (thread)
+        return *thread;
+
+    auto* idle_thread = Processor::idle_thread();
+    idle_thread->set_active(true);
+    return *idle_thread;
+}
+
 Thread* Scheduler::peek_next_runnable_thread()
 {
+    // Unlike in pull_next_runnable_thread() we don't want to fall back to
+    // the idle thread. We just want to see if we have any other thread ready
+    // to be scheduled. A busy processor only looks at the threads of its peers
+    // that are more important than its current one, an idle one takes any.
     auto affinity_mask = 1u << Processor::current_id();
+    auto* thread = (*g_ready_queues)[Processor::current_id()].with([&](auto& queues) {
+        return queues.find_runnable_thread(affinity_mask);
+    });
+    if (thread)
+        return thread;
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread* {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                return &thread;
-            }
-            priority_mask &= ~(1u << priority);
-        }
-
-        // Unlike in pull_next_runnable_thread() we don't want to fall back to
-        // the idle thread. We just want to see if we have any other thread ready
-        // to be scheduled.
-        return nullptr;
+    auto* current_thread = Thread::current();
+    auto priority_limit = current_thread->is_idle_thread() ? ThreadReadyQueues::count : thread_priority_to_priority_index(current_thread->priority());
+    return find_thread_in_peer_ready_queues(priority_limit, [&](u32 cpu) {
+        return (*g_ready_queues)[cpu].with([&](auto& queues) {
+            return queues.find_runnable_thread(affinity_mask, priority_limit);
+        });
     });
 }
 
@@ -139,43 +261,47 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
     if (thread.is_idle_thread())
         return true;
 
-    return g_ready_queues->with([&](auto& ready_queues) {
-        auto priority = thread.m_runnable_priority;
-        if (priority < 0) {
-            VERIFY(!thread.m_ready_queue_node.is_in_list());
-            return false;
-        }
+    if (check_affinity && !(thread.affinity() & (1 << Processor::current_id())))
+        return false;
 
-        if (check_affinity && !(thread.affinity() & (1 << Processor::current_id())))
-            return false;
-
-        VERIFY(ready_queues.mask & (1u << priority));
-        auto& ready_queue = ready_queues.queues[priority];
-        thread.m_runnable_priority = -1;
-        ready_queue.thread_list.remove(thread);
-        if (ready_queue.thread_list.is_empty())
-            ready_queues.mask &= ~(1u << priority);
-        return true;
-    });
+    // The thread's queue can only be trusted while holding its lock, so make sure
+    // it didn't move to another processor's queue before we got there.
+    for (;;) {
+        auto cpu = AK::atomic_load(&thread.m_ready_queue_cpu, AK::memory_order_relaxed);
+        auto result = (*g_ready_queues)[cpu].with([&](auto& ready_queues) -> Optional<bool> {
+            // Only the lock of the queue the thread is on protects its queue state, so check that we hold that one first.
+            if (AK::atomic_load(&thread.m_ready_queue_cpu, AK::memory_order_relaxed) != cpu)
+                return {};
+            if (thread.m_runnable_priority < 0) {
+                VERIFY(!thread.m_ready_queue_node.is_in_list());
+                return false;
+            }
+            ready_queues.remove(thread);
+            publish_ready_queue_mask(cpu, ready_queues);
+            return true;
+        });
+        if (result.has_value())
+            return result.value();
+    }
 }
 
 void Scheduler::enqueue_runnable_thread(Thread& thread)
 {
-    VERIFY(g_scheduler_lock.is_locked_by_current_processor());
     if (thread.is_idle_thread())
         return;
     auto priority = thread_priority_to_priority_index(thread.priority());
+    auto cpu = select_ready_queue_for(thread);
 
-    g_ready_queues->with([&](auto& ready_queues) {
-        VERIFY(thread.m_runnable_priority < 0);
-        thread.m_runnable_priority = (int)priority;
-        VERIFY(!thread.m_ready_queue_node.is_in_list());
-        auto& ready_queue = ready_queues.queues[priority];
-        bool was_empty = ready_queue.thread_list.is_empty();
-        ready_queue.thread_list.append(thread);
-        if (was_empty)
-            ready_queues.mask |= (1u << priority);
+    (*g_ready_queues)[cpu].with([&](auto& ready_queues) {
+        AK::atomic_store(&thread.m_ready_queue_cpu, cpu, AK::memory_order_relaxed);
+        ready_queues.append(thread, priority);
+        publish_ready_queue_mask(cpu, ready_queues);
     });
+
+    // Wake up the processor we queued the thread on if it's idle. Otherwise, it may be a while until it
+    // gets to the thread, so wake up an idle processor that can run it instead, which will steal it.
+    if (!Processor::smp_wake_idle_processor(1u << cpu))
+        Processor::smp_wake_idle_processor(thread.affinity());
 }
 
 UNMAP_AFTER_INIT void Scheduler::start()
@@ -483,7 +609,9 @@ void Scheduler::idle_loop(void*)
         proc.wait_for_interrupt();
         proc.idle_end();
         VERIFY_INTERRUPTS_ENABLED();
-        yield();
+        // Only take the scheduler lock if there is something to switch to.
+        if (peek_next_runnable_thread())
+            yield();
     }
 }
 
@@ -4,7 +4,10 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
+#include <AK/NumericLimits.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Sections.h>
 #include <Kernel/Tasks/Process.h>
 #include <Kernel/Tasks/SyncTask.h>
@@ -12,12 +15,59 @@
 
 namespace Kernel {
 
+static Atomic<bool> s_memory_pressure { false };
+static Atomic<bool> s_simulating_memory_pressure { false };
+
+void SyncTask::notify_memory_pressure()
+{
+    s_memory_pressure.store(true);
+}
+
+bool SyncTask::is_simulating_memory_pressure()
+{
+    return s_simulating_memory_pressure.load();
+}
+
+void SyncTask::set_simulating_memory_pressure(bool simulating)
+{
+    s_simulating_memory_pressure.store(simulating);
+}
+
+static void release_cache_memory_if_needed()
+{
+    bool is_simulated = s_simulating_memory_pressure.load();
+    auto memory_info = MM.get_system_memory_info();
+    bool is_memory_low = memory_info.physical_pages_uncommitted < memory_info.low_watermark();
+    if (!s_memory_pressure.exchange(false) && !is_memory_low && !is_simulated)
+        return;
+
+    // Aim for twice the low watermark, so this doesn't have to happen again right away.
+    auto target = memory_info.low_watermark() * 2;
+    auto missing_pages = max(target - min(target, memory_info.physical_pages_uncommitted), memory_info.low_watermark());
+    VirtualFileSystem::the().release_cache_memory_of_filesystems(missing_pages * PAGE_SIZE);
+
+    // Next are clean file-backed pages that haven't been used for a while, as those can simply be read in again.
+    memory_info = MM.get_system_memory_info();
+    if (is_simulated)
+        MM.reclaim_page_cache(NumericLimits<size_t>::max());
+    else if (memory_info.physical_pages_uncommitted < target)
+        MM.reclaim_page_cache(target - memory_info.physical_pages_uncommitted);
+
+    // If dropping caches wasn't enough, move anonymous memory that hasn't been used since the last time we got here into the CompressedPageStore.
+    memory_info = MM.get_system_memory_info();
+    if (is_simulated)
+        MM.compress_cold_anonymous_pages(NumericLimits<size_t>::max());
+    else if (memory_info.physical_pages_uncommitted < memory_info.low_watermark())
+        MM.compress_cold_anonymous_pages(target - memory_info.physical_pages_uncommitted);
+}
+
 UNMAP_AFTER_INIT void SyncTask::spawn()
 {
     MUST(Process::create_kernel_process("VFS Sync Task"sv, [] {
         dbgln("VFS SyncTask is running");
         while (!Process::current().is_dying()) {
             VirtualFileSystem::sync();
+            release_cache_memory_if_needed();
             (void)Thread::current()->sleep(Duration::from_seconds(1));
         }
         Process::current().sys$exit(0);
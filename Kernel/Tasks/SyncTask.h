@@ -10,5 +10,13 @@ namespace Kernel {
 class SyncTask {
 public:
     static void spawn();
+
+    // Makes the next round shrink the file system caches, even if there seems to be plenty of memory left.
+    // NOTE: This only sets a flag, so it can be called while holding the MemoryManager's locks.
+    static void notify_memory_pressure();
+
+    // While this is set, every round reclaims as much memory as it can, as if there was none left. This is meant for testing.
+    static bool is_simulating_memory_pressure();
+    static void set_simulating_memory_pressure(bool);
 };
 }
@@ -61,6 +61,7 @@ class Thread
     friend class Process;
     friend class Scheduler;
     friend struct ThreadReadyQueue;
+    friend struct ThreadReadyQueues;
 
 public:
     static Thread* current()
@@ -1092,6 +1093,7 @@ private:
 
     IntrusiveListNode<Thread> m_process_thread_list_node;
     int m_runnable_priority { -1 };
+    u32 m_ready_queue_cpu { 0 };
 
     friend class WaitQueue;
 
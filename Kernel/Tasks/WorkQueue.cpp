@@ -15,11 +15,14 @@ namespace Kernel {
 
 WorkQueue* g_io_work;
 WorkQueue* g_ata_work;
+WorkQueue* g_readahead_work;
 
 UNMAP_AFTER_INIT void WorkQueue::initialize()
 {
     g_io_work = new WorkQueue("IO WorkQueue Task"sv);
     g_ata_work = new WorkQueue("ATA WorkQueue Task"sv);
+    // Readahead waits for disk reads, which g_io_work may be needed to complete, so it gets its own queue.
+    g_readahead_work = new WorkQueue("Readahead WorkQueue Task"sv);
 }
 
 UNMAP_AFTER_INIT WorkQueue::WorkQueue(StringView name)
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteString.h>
+#include <AK/ScopeGuard.h>
+#include <AK/StringView.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Each page of the mapping gets contents that take a different path through the compressor.
+enum class Pattern {
+    Zeroes,
+    Random,
+    LongMatches,
+    OverlappingMatches,
+    ShortRuns,
+    HalfRandom,
+    __Count,
+};
+
+static constexpr size_t page_count = static_cast<size_t>(Pattern::__Count);
+static constexpr size_t mapping_size = page_count * PAGE_SIZE;
+
+static u64 read_memstat_counter(StringView name)
+{
+    int fd = open("/sys/kernel/memstat", O_RDONLY);
+    VERIFY(fd >= 0);
+    char buffer[4 * KiB];
+    auto nread = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    VERIFY(nread > 0);
+    buffer[nread] = '\0';
+
+    auto memstat = StringView { buffer, static_cast<size_t>(nread) };
+    auto key = ByteString::formatted("\"{}\":", name);
+    auto position = memstat.find(key);
+    VERIFY(position.has_value());
+    return strtoull(buffer + position.value() + key.length(), nullptr, 10);
+}
+
+static bool set_simulated_memory_pressure(bool enabled)
+{
+    int fd = open("/sys/kernel/conf/simulate_memory_pressure", O_WRONLY | O_TRUNC);
+    if (fd < 0)
+        return false;
+    bool success = write(fd, enabled ? "1" : "0", 1) == 1;
+    close(fd);
+    return success;
+}
+
+static u8 expected_byte(Pattern pattern, size_t offset)
+{
+    // A small xorshift generator, so that the random bytes don't compress but are the same every time.
+    auto random_byte = [](size_t offset) {
+        u32 state = static_cast<u32>(offset) * 2654435761u + 1;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<u8>(state >> 24);
+    };
+
+    switch (pattern) {
+    case Pattern::Zeroes:
+        return 0;
+    case Pattern::Random:
+        return random_byte(offset);
+    case Pattern::LongMatches:
+        // One match that covers nearly all of the page, so its length needs many extra length bytes.
+        return "0123456789abcdef"[offset % 16];
+    case Pattern::OverlappingMatches:
+        // Matches at offsets 1 and 2 overlap with the bytes they produce.
+        return offset < PAGE_SIZE / 2 ? 0x5a : (offset % 2 ? 'a' : 'b');
+    case Pattern::ShortRuns:
+        // Runs that are barely long enough to be worth a match, with literals in between.
+        return (offset % 7) < 5 ? static_cast<u8>(offset / 7) : 0xff;
+    case Pattern::HalfRandom:
+        return offset < PAGE_SIZE / 2 ? random_byte(offset) : static_cast<u8>(offset / 64);
+    case Pattern::__Count:
+        break;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+static void fill_pages(u8* data)
+{
+    for (size_t page = 0; page < page_count; ++page) {
+        for (size_t offset = 0; offset < PAGE_SIZE; ++offset)
+            data[page * PAGE_SIZE + offset] = expected_byte(static_cast<Pattern>(page), offset);
+    }
+}
+
+static bool pages_are_intact(u8 const* data)
+{
+    for (size_t page = 0; page < page_count; ++page) {
+        for (size_t offset = 0; offset < PAGE_SIZE; ++offset) {
+            if (data[page * PAGE_SIZE + offset] != expected_byte(static_cast<Pattern>(page), offset)) {
+                warnln("Page {} differs at offset {}", page, offset);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Waits until the store grew by the given number of pages, without touching our own memory, so that it stays cold.
+static bool wait_for_compressed_pages(u64 compressed_pages_before, size_t expected_page_count)
+{
+    for (size_t attempt = 0; attempt < 100; ++attempt) {
+        if (read_memstat_counter("compressed_pages"sv) >= compressed_pages_before + expected_page_count)
+            return true;
+        struct timespec delay { 0, 100'000'000 };
+        nanosleep(&delay, nullptr);
+    }
+    return false;
+}
+
+static u8* map_and_compress_pages()
+{
+    auto* data = static_cast<u8*>(mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+    VERIFY(data != MAP_FAILED);
+    fill_pages(data);
+
+    // Only the random page is too big to be kept compressed, everything else should go into the store.
+    auto compressed_pages_before = read_memstat_counter("compressed_pages"sv);
+    EXPECT(wait_for_compressed_pages(compressed_pages_before, page_count - 1));
+    return data;
+}
+
+TEST_CASE(compressed_pages_round_trip)
+{
+    if (!set_simulated_memory_pressure(true)) {
+        warnln("Can't simulate memory pressure, skipping");
+        return;
+    }
+    ScopeGuard stop_simulating = [] { set_simulated_memory_pressure(false); };
+
+    auto* data = map_and_compress_pages();
+    EXPECT(pages_are_intact(data));
+
+    // Once they were faulted in, the pages get cold and are compressed again.
+    EXPECT(wait_for_compressed_pages(read_memstat_counter("compressed_pages"sv), page_count - 1));
+    EXPECT(pages_are_intact(data));
+
+    EXPECT_EQ(munmap(data, mapping_size), 0);
+}
+
+TEST_CASE(compressed_pages_are_shared_with_forked_children)
+{
+    if (!set_simulated_memory_pressure(true)) {
+        warnln("Can't simulate memory pressure, skipping");
+        return;
+    }
+    ScopeGuard stop_simulating = [] { set_simulated_memory_pressure(false); };
+
+    auto* data = map_and_compress_pages();
+
+    pid_t pid = fork();
+    EXPECT(pid >= 0);
+    if (pid == 0) {
+        // The child faults the pages in from the store first, then writes to its own copy of them.
+        if (!pages_are_intact(data))
+            _exit(1);
+        memset(data, 0xcc, mapping_size);
+        _exit(0);
+    }
+
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    // The child's writes must not have reached the parent, whose pages may still be in the store.
+    EXPECT(pages_are_intact(data));
+
+    EXPECT_EQ(munmap(data, mapping_size), 0);
+}
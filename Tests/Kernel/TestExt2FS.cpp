@@ -4,10 +4,20 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Time.h>
 #include <LibTest/TestCase.h>
 #include <fcntl.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
+static u8 pattern_byte(size_t offset)
+{
+    return static_cast<u8>((offset * 13) ^ (offset >> 12));
+}
+
 TEST_CASE(test_uid_and_gid_high_bits_are_set)
 {
     static constexpr auto TEST_FILE_PATH = "/home/anon/.ext2_test";
@@ -29,3 +39,137 @@ TEST_CASE(test_uid_and_gid_high_bits_are_set)
     EXPECT_EQ(st.st_uid, 65536u);
     EXPECT_EQ(st.st_gid, 65536u);
 }
+
+TEST_CASE(sequential_writes_are_contiguous)
+{
+    static constexpr auto TEST_FILE_PATH = "/home/anon/.ext2_sequential_test";
+    static constexpr size_t file_size = 8 * MiB;
+
+    auto fd = open(TEST_FILE_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    EXPECT(fd >= 0);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(fd);
+        unlink(TEST_FILE_PATH);
+    });
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    u8 buffer[4 * KiB];
+    for (size_t offset = 0; offset < file_size; offset += sizeof(buffer)) {
+        for (size_t i = 0; i < sizeof(buffer); ++i)
+            buffer[i] = pattern_byte(offset + i);
+        EXPECT_EQ(write(fd, buffer, sizeof(buffer)), static_cast<ssize_t>(sizeof(buffer)));
+    }
+    EXPECT_EQ(fsync(fd), 0);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    auto milliseconds = max((Duration::from_timespec(end) - Duration::from_timespec(start)).to_milliseconds(), static_cast<i64>(1));
+    outln("Wrote {} KiB in {} ms, {} KiB/s", file_size / KiB, milliseconds, file_size / KiB * 1000 / milliseconds);
+
+    EXPECT_EQ(lseek(fd, 0, SEEK_SET), 0);
+    bool data_is_intact = true;
+    for (size_t offset = 0; offset < file_size; offset += sizeof(buffer)) {
+        EXPECT_EQ(read(fd, buffer, sizeof(buffer)), static_cast<ssize_t>(sizeof(buffer)));
+        for (size_t i = 0; i < sizeof(buffer) && data_is_intact; ++i)
+            data_is_intact = buffer[i] == pattern_byte(offset + i);
+    }
+    EXPECT(data_is_intact);
+
+    // Count how many pieces the file ended up in on disk, which needs root.
+    struct stat st;
+    EXPECT_EQ(fstat(fd, &st), 0);
+    size_t block_count = file_size / st.st_blksize;
+    size_t fragments = 0;
+    int previous_block = 0;
+    for (size_t i = 0; i < block_count; ++i) {
+        int block = static_cast<int>(i);
+        if (ioctl(fd, FIBMAP, &block) < 0) {
+            warnln("Skipping fragmentation check, unable to map blocks");
+            return;
+        }
+        if (i == 0 || block != previous_block + 1)
+            ++fragments;
+        previous_block = block;
+    }
+    outln("{} blocks in {} fragments", block_count, fragments);
+    // Without delayed allocation, every indirect block would split the file, so this is quite generous.
+    EXPECT(fragments <= block_count / 64);
+}
+
+TEST_CASE(read_back_before_sync)
+{
+    static constexpr auto TEST_FILE_PATH = "/home/anon/.ext2_read_back_test";
+
+    auto fd = open(TEST_FILE_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    EXPECT(fd >= 0);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(fd);
+        unlink(TEST_FILE_PATH);
+    });
+
+    u8 buffer[3000];
+    for (size_t i = 0; i < sizeof(buffer); ++i)
+        buffer[i] = pattern_byte(i);
+    EXPECT_EQ(write(fd, buffer, sizeof(buffer)), static_cast<ssize_t>(sizeof(buffer)));
+
+    struct stat st;
+    EXPECT_EQ(fstat(fd, &st), 0);
+    EXPECT_EQ(st.st_size, static_cast<off_t>(sizeof(buffer)));
+
+    u8 read_buffer[sizeof(buffer)];
+    EXPECT_EQ(pread(fd, read_buffer, sizeof(read_buffer), 0), static_cast<ssize_t>(sizeof(read_buffer)));
+    EXPECT_EQ(memcmp(buffer, read_buffer, sizeof(buffer)), 0);
+
+    // Overwriting data that isn't on disk yet must not grow the file.
+    EXPECT_EQ(pwrite(fd, "x", 1, 100), 1);
+    EXPECT_EQ(fstat(fd, &st), 0);
+    EXPECT_EQ(st.st_size, static_cast<off_t>(sizeof(buffer)));
+    EXPECT_EQ(pread(fd, read_buffer, 1, 100), 1);
+    EXPECT_EQ(read_buffer[0], 'x');
+
+    EXPECT_EQ(ftruncate(fd, 1000), 0);
+    EXPECT_EQ(fstat(fd, &st), 0);
+    EXPECT_EQ(st.st_size, 1000);
+    EXPECT_EQ(pread(fd, read_buffer, sizeof(read_buffer), 0), 1000);
+    EXPECT_EQ(memcmp(buffer, read_buffer, 100), 0);
+}
+
+TEST_CASE(write_past_end_leaves_zeroes)
+{
+    static constexpr auto TEST_FILE_PATH = "/home/anon/.ext2_gap_test";
+
+    auto fd = open(TEST_FILE_PATH, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    EXPECT(fd >= 0);
+    auto cleanup_guard = ScopeGuard([&] {
+        close(fd);
+        unlink(TEST_FILE_PATH);
+    });
+
+    EXPECT_EQ(write(fd, "hello", 5), 5);
+    EXPECT_EQ(pwrite(fd, "world", 5, 10000), 5);
+
+    struct stat st;
+    EXPECT_EQ(fstat(fd, &st), 0);
+    EXPECT_EQ(st.st_size, 10005);
+
+    char buffer[10005];
+    EXPECT_EQ(pread(fd, buffer, sizeof(buffer), 0), 10005);
+    EXPECT_EQ(memcmp(buffer, "hello", 5), 0);
+    bool gap_is_zeroed = true;
+    for (size_t i = 5; i < 10000; ++i)
+        gap_is_zeroed = gap_is_zeroed && buffer[i] == 0;
+    EXPECT(gap_is_zeroed);
+    EXPECT_EQ(memcmp(buffer + 10000, "world", 5), 0);
+
+    // The same must still hold once the data has been given blocks on disk.
+    EXPECT_EQ(fsync(fd), 0);
+    memset(buffer, 0xff, sizeof(buffer));
+    EXPECT_EQ(pread(fd, buffer, sizeof(buffer), 0), 10005);
+    EXPECT_EQ(memcmp(buffer, "hello", 5), 0);
+    for (size_t i = 5; i < 10000; ++i)
+        gap_is_zeroed = gap_is_zeroed && buffer[i] == 0;
+    EXPECT(gap_is_zeroed);
+    EXPECT_EQ(memcmp(buffer + 10000, "world", 5), 0);
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Time.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr size_t large_page_size = 2 * MiB;
+static constexpr size_t benchmark_size = 64 * MiB;
+static constexpr size_t benchmark_accesses = 4 * MiB;
+
+static u64 random_access_checksum(u8* memory, size_t size)
+{
+    // A simple xorshift walk that touches a different page on pretty much every access.
+    u64 state = 0x2545f4914f6cdd1dULL;
+    u64 checksum = 0;
+    for (size_t i = 0; i < benchmark_accesses; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        auto& byte = memory[state % size];
+        checksum += byte;
+        byte = static_cast<u8>(state);
+    }
+    return checksum;
+}
+
+static void run_random_access_benchmark(int extra_flags, StringView description)
+{
+    auto* memory = static_cast<u8*>(mmap(nullptr, benchmark_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | extra_flags, -1, 0));
+    EXPECT_NE(memory, MAP_FAILED);
+    if (memory == MAP_FAILED)
+        return;
+
+    // Fault everything in first, so that only the TLB behavior is measured.
+    for (size_t offset = 0; offset < benchmark_size; offset += PAGE_SIZE)
+        memory[offset] = 1;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    auto checksum = random_access_checksum(memory, benchmark_size);
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    auto elapsed = Duration::from_timespec(end) - Duration::from_timespec(start);
+    outln("{}: {} random accesses over {} MiB in {} ms (checksum {})", description, benchmark_accesses, benchmark_size / MiB, elapsed.to_milliseconds(), checksum);
+
+    EXPECT_EQ(munmap(memory, benchmark_size), 0);
+}
+
+TEST_CASE(hugetlb_requires_anonymous_mapping)
+{
+    int fd = open("/bin/sh", O_RDONLY);
+    EXPECT(fd >= 0);
+    auto* memory = mmap(nullptr, PAGE_SIZE, PROT_READ, MAP_PRIVATE | MAP_HUGETLB, fd, 0);
+    EXPECT_EQ(memory, MAP_FAILED);
+    EXPECT_EQ(errno, EINVAL);
+    close(fd);
+}
+
+TEST_CASE(hugetlb_mapping_is_large_page_aligned)
+{
+    auto* memory = static_cast<u8*>(mmap(nullptr, 3 * large_page_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB, -1, 0));
+    EXPECT_NE(memory, MAP_FAILED);
+    EXPECT_EQ(reinterpret_cast<FlatPtr>(memory) % large_page_size, 0u);
+
+    // Faulting in one byte makes the whole large page around it available, and it starts out zeroed.
+    memory[large_page_size + 12345] = 0x42;
+    for (size_t offset = large_page_size; offset < 2 * large_page_size; offset += PAGE_SIZE)
+        EXPECT_EQ(memory[offset], 0);
+    EXPECT_EQ(memory[large_page_size + 12345], 0x42);
+
+    EXPECT_EQ(munmap(memory, 3 * large_page_size), 0);
+}
+
+TEST_CASE(partial_munmap_and_mprotect_split_large_pages)
+{
+    auto* memory = static_cast<u8*>(mmap(nullptr, 2 * large_page_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB, -1, 0));
+    EXPECT_NE(memory, MAP_FAILED);
+
+    for (size_t offset = 0; offset < 2 * large_page_size; ++offset)
+        memory[offset] = static_cast<u8>(offset * 7);
+
+    // Punch a hole into the middle of the first large page, and make part of the second one read-only.
+    EXPECT_EQ(munmap(memory + 64 * KiB, 64 * KiB), 0);
+    EXPECT_EQ(mprotect(memory + large_page_size + 256 * KiB, 128 * KiB, PROT_READ), 0);
+
+    bool data_is_intact = true;
+    for (size_t offset = 0; offset < 2 * large_page_size && data_is_intact; ++offset) {
+        if (offset >= 64 * KiB && offset < 128 * KiB)
+            continue;
+        data_is_intact = memory[offset] == static_cast<u8>(offset * 7);
+    }
+    EXPECT(data_is_intact);
+
+    // Everything outside the read-only part must still be writable.
+    memory[0] = 1;
+    memory[large_page_size] = 2;
+    memory[2 * large_page_size - 1] = 3;
+    EXPECT_EQ(memory[0], 1);
+    EXPECT_EQ(memory[large_page_size], 2);
+    EXPECT_EQ(memory[2 * large_page_size - 1], 3);
+
+    EXPECT_EQ(munmap(memory, 64 * KiB), 0);
+    EXPECT_EQ(munmap(memory + 128 * KiB, 2 * large_page_size - 128 * KiB), 0);
+}
+
+TEST_CASE(fork_copies_large_pages_on_write)
+{
+    auto* memory = static_cast<u8*>(mmap(nullptr, large_page_size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB, -1, 0));
+    EXPECT_NE(memory, MAP_FAILED);
+    memset(memory, 0x11, large_page_size);
+
+    pid_t pid = fork();
+    EXPECT(pid >= 0);
+    if (pid == 0) {
+        memory[PAGE_SIZE] = 0x22;
+        _exit(memory[0] == 0x11 && memory[PAGE_SIZE] == 0x22 ? 0 : 1);
+    }
+
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT_EQ(memory[PAGE_SIZE], 0x11);
+
+    EXPECT_EQ(munmap(memory, large_page_size), 0);
+}
+
+TEST_CASE(random_access_benchmark)
+{
+    run_random_access_benchmark(0, "4 KiB pages"sv);
+    run_random_access_benchmark(MAP_HUGETLB, "2 MiB pages"sv);
+}
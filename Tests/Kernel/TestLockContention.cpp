@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/StringView.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+static constexpr size_t thread_count = 4;
+static constexpr size_t iterations_per_thread = 2000;
+
+static bool set_lock_contention_profiling(bool enabled)
+{
+    int fd = open("/sys/kernel/conf/lock_contention_profiling", O_WRONLY | O_TRUNC);
+    if (fd < 0)
+        return false;
+    bool success = write(fd, enabled ? "1" : "0", 1) == 1;
+    close(fd);
+    return success;
+}
+
+static void* open_the_same_directory(void*)
+{
+    // Every lookup goes through the same Inode and custody locks.
+    for (size_t i = 0; i < iterations_per_thread; ++i) {
+        int fd = open("/usr/lib", O_RDONLY | O_DIRECTORY);
+        if (fd >= 0)
+            close(fd);
+    }
+    return nullptr;
+}
+
+TEST_CASE(profiling_records_mutex_call_sites)
+{
+    // This needs root, as profiling slows down every Mutex in the system.
+    if (!set_lock_contention_profiling(true)) {
+        warnln("Skipping, unable to enable lock contention profiling");
+        return;
+    }
+
+    pthread_t threads[thread_count];
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_create(&thread, nullptr, open_the_same_directory, nullptr), 0);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+
+    int fd = open("/sys/kernel/lock_contention", O_RDONLY);
+    EXPECT(fd >= 0);
+    char buffer[4 * KiB];
+    auto nread = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    EXPECT(nread > 0);
+
+    auto statistics = StringView { buffer, static_cast<size_t>(max(nread, static_cast<ssize_t>(0))) };
+    EXPECT(statistics.starts_with('['));
+    EXPECT(statistics.contains("\"acquisitions\":"sv));
+    EXPECT(statistics.contains("\"max_hold_time_ns\":"sv));
+
+    EXPECT(set_lock_contention_profiling(false));
+}
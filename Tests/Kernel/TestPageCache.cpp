@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteString.h>
+#include <AK/Function.h>
+#include <AK/ScopeGuard.h>
+#include <AK/StringView.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr auto test_file_path = "/home/anon/.page_cache_test";
+static constexpr size_t file_size = 256 * KiB;
+static constexpr size_t file_page_count = file_size / PAGE_SIZE;
+
+static u64 read_memstat_counter(StringView name)
+{
+    int fd = open("/sys/kernel/memstat", O_RDONLY);
+    VERIFY(fd >= 0);
+    char buffer[4 * KiB];
+    auto nread = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    VERIFY(nread > 0);
+    buffer[nread] = '\0';
+
+    auto memstat = StringView { buffer, static_cast<size_t>(nread) };
+    auto key = ByteString::formatted("\"{}\":", name);
+    auto position = memstat.find(key);
+    VERIFY(position.has_value());
+    return strtoull(buffer + position.value() + key.length(), nullptr, 10);
+}
+
+static void create_test_file()
+{
+    int fd = open(test_file_path, O_CREAT | O_TRUNC | O_WRONLY, 0600);
+    VERIFY(fd >= 0);
+    u8 buffer[4 * KiB];
+    for (size_t offset = 0; offset < file_size; offset += sizeof(buffer)) {
+        for (size_t i = 0; i < sizeof(buffer); ++i)
+            buffer[i] = static_cast<u8>((offset + i) * 7);
+        VERIFY(write(fd, buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer)));
+    }
+    close(fd);
+}
+
+static bool touch_all_pages(u8 const* data)
+{
+    for (size_t offset = 0; offset < file_size; offset += PAGE_SIZE) {
+        if (data[offset] != static_cast<u8>(offset * 7))
+            return false;
+    }
+    return true;
+}
+
+static bool all_bytes_are_intact(u8 const* data)
+{
+    for (size_t offset = 0; offset < file_size; ++offset) {
+        if (data[offset] != static_cast<u8>(offset * 7)) {
+            warnln("File contents differ at offset {}", offset);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool set_simulated_memory_pressure(bool enabled)
+{
+    int fd = open("/sys/kernel/conf/simulate_memory_pressure", O_WRONLY | O_TRUNC);
+    if (fd < 0)
+        return false;
+    bool success = write(fd, enabled ? "1" : "0", 1) == 1;
+    close(fd);
+    return success;
+}
+
+// The page cache is scanned once a second while memory pressure is simulated, so this gives it about ten scans.
+// If given, the callback runs between two checks, e.g. to keep pages in use.
+static bool wait_for_counter(StringView name, u64 target, Function<void()> between_checks = nullptr)
+{
+    for (size_t attempt = 0; attempt < 100; ++attempt) {
+        if (read_memstat_counter(name) >= target)
+            return true;
+        if (between_checks)
+            between_checks();
+        struct timespec delay { 0, 100'000'000 };
+        nanosleep(&delay, nullptr);
+    }
+    return false;
+}
+
+TEST_CASE(shared_file_mappings_hit_the_page_cache)
+{
+    create_test_file();
+    ScopeGuard remove_file = [] { unlink(test_file_path); };
+
+    int fd = open(test_file_path, O_RDONLY);
+    EXPECT(fd >= 0);
+    auto* first_mapping = static_cast<u8*>(mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0));
+    EXPECT_NE(first_mapping, MAP_FAILED);
+    auto* second_mapping = static_cast<u8*>(mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0));
+    EXPECT_NE(second_mapping, MAP_FAILED);
+    close(fd);
+
+    // The first mapping has to read the pages in, the second one finds them in the shared VMObject.
+    auto misses_before = read_memstat_counter("page_cache_misses"sv);
+    EXPECT(touch_all_pages(first_mapping));
+    EXPECT(read_memstat_counter("page_cache_misses"sv) > misses_before);
+
+    auto hits_before = read_memstat_counter("page_cache_hits"sv);
+    EXPECT(touch_all_pages(second_mapping));
+    EXPECT(read_memstat_counter("page_cache_hits"sv) > hits_before);
+
+    EXPECT_EQ(munmap(first_mapping, file_size), 0);
+    EXPECT_EQ(munmap(second_mapping, file_size), 0);
+}
+
+TEST_CASE(cold_pages_are_reclaimed_and_read_again)
+{
+    if (!set_simulated_memory_pressure(true)) {
+        warnln("Can't simulate memory pressure, skipping");
+        return;
+    }
+    ScopeGuard stop_simulating = [] { set_simulated_memory_pressure(false); };
+
+    create_test_file();
+    ScopeGuard remove_file = [] { unlink(test_file_path); };
+
+    int fd = open(test_file_path, O_RDONLY);
+    EXPECT(fd >= 0);
+    auto* data = static_cast<u8*>(mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0));
+    EXPECT_NE(data, MAP_FAILED);
+    close(fd);
+
+    // Other files age at the same time, so these only tell us that at least our pages went through each step.
+    auto activations_before = read_memstat_counter("page_cache_activations"sv);
+    auto deactivations_before = read_memstat_counter("page_cache_deactivations"sv);
+    auto reclaimed_before = read_memstat_counter("page_cache_reclaimed"sv);
+
+    // Pages that are used across two scans become active.
+    EXPECT(wait_for_counter("page_cache_activations"sv, activations_before + file_page_count, [&] { EXPECT(touch_all_pages(data)); }));
+
+    // Once we stop using them, they age out of the active list and are reclaimed after that.
+    EXPECT(wait_for_counter("page_cache_deactivations"sv, deactivations_before + file_page_count));
+    EXPECT(wait_for_counter("page_cache_reclaimed"sv, reclaimed_before + file_page_count));
+
+    // Every page has to be read in again, and must come back with the same contents.
+    auto misses_before = read_memstat_counter("page_cache_misses"sv);
+    EXPECT(all_bytes_are_intact(data));
+    EXPECT(read_memstat_counter("page_cache_misses"sv) >= misses_before + file_page_count);
+
+    EXPECT_EQ(munmap(data, file_size), 0);
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <AK/Time.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr auto test_file_path = "/home/anon/.readahead_test";
+static constexpr size_t file_size = 4 * MiB;
+
+static u8 pattern_byte(size_t offset)
+{
+    return static_cast<u8>((offset * 13) ^ (offset >> 12));
+}
+
+static void create_test_file()
+{
+    int fd = open(test_file_path, O_CREAT | O_TRUNC | O_WRONLY, 0600);
+    VERIFY(fd >= 0);
+    u8 buffer[16 * KiB];
+    for (size_t offset = 0; offset < file_size; offset += sizeof(buffer)) {
+        for (size_t i = 0; i < sizeof(buffer); ++i)
+            buffer[i] = pattern_byte(offset + i);
+        VERIFY(write(fd, buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer)));
+    }
+    VERIFY(fsync(fd) == 0);
+    close(fd);
+}
+
+static bool matches_pattern(u8 const* data, size_t offset, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        if (data[i] != pattern_byte(offset + i))
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(sequential_and_random_reads)
+{
+    create_test_file();
+    ScopeGuard remove_file = [] { unlink(test_file_path); };
+
+    int fd = open(test_file_path, O_RDONLY);
+    EXPECT(fd >= 0);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Small sequential reads are what the readahead window grows for.
+    u8 buffer[4 * KiB];
+    size_t offset = 0;
+    bool data_is_intact = true;
+    while (offset < file_size) {
+        ssize_t nread = read(fd, buffer, sizeof(buffer));
+        if (nread <= 0)
+            break;
+        data_is_intact = data_is_intact && matches_pattern(buffer, offset, nread);
+        offset += nread;
+    }
+    EXPECT_EQ(offset, file_size);
+    EXPECT(data_is_intact);
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    auto elapsed = Duration::from_timespec(end) - Duration::from_timespec(start);
+    outln("Read {} KiB sequentially in {} ms", file_size / KiB, elapsed.to_milliseconds());
+
+    // Jumping around resets the window, but must of course still return the right data.
+    for (size_t i = 0; i < 64; ++i) {
+        size_t random_offset = (i * 7919 * KiB + i * 123) % (file_size - sizeof(buffer));
+        EXPECT_EQ(pread(fd, buffer, sizeof(buffer), random_offset), static_cast<ssize_t>(sizeof(buffer)));
+        EXPECT(matches_pattern(buffer, random_offset, sizeof(buffer)));
+    }
+
+    close(fd);
+}
+
+TEST_CASE(madvise_access_patterns_on_file_mapping)
+{
+    create_test_file();
+    ScopeGuard remove_file = [] { unlink(test_file_path); };
+
+    int fd = open(test_file_path, O_RDONLY);
+    EXPECT(fd >= 0);
+    auto* data = static_cast<u8*>(mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0));
+    EXPECT_NE(data, MAP_FAILED);
+
+    EXPECT_EQ(madvise(data, file_size, MADV_WILLNEED), 0);
+    EXPECT_EQ(madvise(data, file_size, MADV_SEQUENTIAL), 0);
+    bool data_is_intact = true;
+    for (size_t offset = 0; offset < file_size; offset += PAGE_SIZE)
+        data_is_intact = data_is_intact && matches_pattern(data + offset, offset, PAGE_SIZE);
+    EXPECT(data_is_intact);
+
+    EXPECT_EQ(madvise(data, file_size, MADV_RANDOM), 0);
+    EXPECT_EQ(madvise(data, file_size, MADV_NORMAL), 0);
+    // Unknown advice is still rejected.
+    EXPECT_EQ(madvise(data, file_size, 0x100), -1);
+
+    EXPECT_EQ(munmap(data, file_size), 0);
+    close(fd);
+}
+
+TEST_CASE(fault_around_on_private_file_mapping)
+{
+    create_test_file();
+    ScopeGuard remove_file = [] { unlink(test_file_path); };
+
+    // Leave a partial page at the end, which must come out zero-filled past the end of the file.
+    static constexpr size_t truncated_size = file_size - 1000;
+    EXPECT_EQ(truncate(test_file_path, truncated_size), 0);
+
+    int fd = open(test_file_path, O_RDONLY);
+    EXPECT(fd >= 0);
+    auto* data = static_cast<u8*>(mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0));
+    EXPECT_NE(data, MAP_FAILED);
+
+    // Touch the pages back to front and out of order, so that most of them are mapped by a neighbor's fault.
+    bool data_is_intact = true;
+    for (size_t page = file_size / PAGE_SIZE; page > 0; page -= 3) {
+        size_t offset = (page - 1) * PAGE_SIZE;
+        data_is_intact = data_is_intact && matches_pattern(data + offset, offset, min(PAGE_SIZE, truncated_size - offset));
+        if (page < 3)
+            break;
+    }
+    EXPECT(data_is_intact);
+    data_is_intact = matches_pattern(data, 0, truncated_size);
+    EXPECT(data_is_intact);
+    for (size_t offset = truncated_size; offset < file_size; ++offset)
+        EXPECT_EQ(data[offset], 0);
+
+    // Writes stay private to the mapping, also for pages that were mapped around another fault.
+    data[PAGE_SIZE + 1] = ~pattern_byte(PAGE_SIZE + 1);
+    u8 byte = 0;
+    EXPECT_EQ(pread(fd, &byte, 1, PAGE_SIZE + 1), 1);
+    EXPECT_EQ(byte, pattern_byte(PAGE_SIZE + 1));
+
+    EXPECT_EQ(munmap(data, file_size), 0);
+
+    // Randomly accessed mappings only fault in what they touch, but must still see the right data.
+    data = static_cast<u8*>(mmap(nullptr, truncated_size, PROT_READ, MAP_PRIVATE, fd, 0));
+    EXPECT_NE(data, MAP_FAILED);
+    EXPECT_EQ(madvise(data, truncated_size, MADV_RANDOM), 0);
+    for (size_t i = 0; i < 64; ++i) {
+        size_t offset = (i * 7919 * KiB + i * 123) % truncated_size;
+        EXPECT_EQ(data[offset], pattern_byte(offset));
+    }
+    EXPECT_EQ(munmap(data, truncated_size), 0);
+
+    close(fd);
+}
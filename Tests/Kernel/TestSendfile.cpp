@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static constexpr auto test_file_path = "/tmp/.sendfile_test";
+
+static void write_pattern(int fd, size_t size, u8 seed)
+{
+    u8 buffer[4 * KiB];
+    for (size_t offset = 0; offset < size; offset += sizeof(buffer)) {
+        for (size_t i = 0; i < sizeof(buffer); ++i)
+            buffer[i] = static_cast<u8>((offset + i) * 7 + seed);
+        VERIFY(write(fd, buffer, sizeof(buffer)) == static_cast<ssize_t>(sizeof(buffer)));
+    }
+}
+
+static bool receive_pattern(int fd, size_t size, u8 seed)
+{
+    u8 buffer[4 * KiB];
+    size_t offset = 0;
+    while (offset < size) {
+        auto nread = read(fd, buffer, min(sizeof(buffer), size - offset));
+        if (nread <= 0)
+            return false;
+        for (ssize_t i = 0; i < nread; ++i) {
+            if (buffer[i] != static_cast<u8>((offset + i) * 7 + seed))
+                return false;
+        }
+        offset += nread;
+    }
+    return true;
+}
+
+TEST_CASE(sendfile_past_the_end_of_an_older_mapping)
+{
+    int fd = open(test_file_path, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    EXPECT(fd >= 0);
+    ScopeGuard remove_file = [] { unlink(test_file_path); };
+    write_pattern(fd, 16 * KiB, 0);
+
+    // The mapping keeps a shared VMObject around that only covers the first 16 KiB.
+    auto* mapping = mmap(nullptr, 16 * KiB, PROT_READ, MAP_SHARED, fd, 0);
+    EXPECT_NE(mapping, MAP_FAILED);
+    write_pattern(fd, 16 * KiB, 0);
+
+    int sockets[2];
+    EXPECT_EQ(socketpair(AF_LOCAL, SOCK_STREAM, 0, sockets), 0);
+
+    off_t offset = 24 * KiB;
+    EXPECT_EQ(sendfile(sockets[0], fd, &offset, 8 * KiB), static_cast<ssize_t>(8 * KiB));
+    EXPECT_EQ(offset, static_cast<off_t>(32 * KiB));
+    // The second half of the file repeats the pattern, offset by 16 KiB.
+    EXPECT(receive_pattern(sockets[1], 8 * KiB, static_cast<u8>(8 * KiB * 7)));
+
+    EXPECT_EQ(munmap(mapping, 16 * KiB), 0);
+    close(sockets[0]);
+    close(sockets[1]);
+    close(fd);
+}
+
+TEST_CASE(sendfile_sees_data_written_after_mapping)
+{
+    int fd = open(test_file_path, O_CREAT | O_TRUNC | O_RDWR, 0600);
+    EXPECT(fd >= 0);
+    ScopeGuard remove_file = [] { unlink(test_file_path); };
+    write_pattern(fd, 16 * KiB, 0);
+
+    auto* mapping = static_cast<u8 const*>(mmap(nullptr, 16 * KiB, PROT_READ, MAP_SHARED, fd, 0));
+    EXPECT_NE(mapping, MAP_FAILED);
+    // Fault the pages in, then overwrite the file behind the mapping's back.
+    EXPECT_EQ(mapping[0], 0);
+    EXPECT_EQ(lseek(fd, 0, SEEK_SET), 0);
+    write_pattern(fd, 16 * KiB, 1);
+
+    int sockets[2];
+    EXPECT_EQ(socketpair(AF_LOCAL, SOCK_STREAM, 0, sockets), 0);
+
+    off_t offset = 0;
+    EXPECT_EQ(sendfile(sockets[0], fd, &offset, 16 * KiB), static_cast<ssize_t>(16 * KiB));
+    EXPECT(receive_pattern(sockets[1], 16 * KiB, 1));
+
+    EXPECT_EQ(munmap(const_cast<u8*>(mapping), 16 * KiB), 0);
+    close(sockets[0]);
+    close(sockets[1]);
+    close(fd);
+}
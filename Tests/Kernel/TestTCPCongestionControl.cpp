@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Time.h>
+#include <LibTest/TestCase.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr size_t transfer_size = 8 * MiB;
+
+static bool set_loopback_packet_loss(StringView percentage)
+{
+    int fd = open("/sys/kernel/conf/loopback_packet_loss", O_WRONLY | O_TRUNC);
+    if (fd < 0)
+        return false;
+    bool success = write(fd, percentage.characters_without_null_termination(), percentage.length()) == static_cast<ssize_t>(percentage.length());
+    close(fd);
+    return success;
+}
+
+static int listen_on_loopback(u16& port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    VERIFY(fd >= 0);
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    VERIFY(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    VERIFY(listen(fd, 1) == 0);
+
+    socklen_t address_length = sizeof(address);
+    VERIFY(getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_length) == 0);
+    port = ntohs(address.sin_port);
+    return fd;
+}
+
+static u8 pattern_byte(size_t offset)
+{
+    return static_cast<u8>((offset * 7) ^ (offset >> 11));
+}
+
+struct Sender {
+    u16 port { 0 };
+    char const* algorithm { nullptr };
+    bool success { false };
+};
+
+static void* send_pattern(void* argument)
+{
+    auto& sender = *static_cast<Sender*>(argument);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return nullptr;
+    if (setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, sender.algorithm, strlen(sender.algorithm)) < 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(sender.port);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return nullptr;
+    }
+
+    u8 buffer[16 * KiB];
+    size_t offset = 0;
+    while (offset < transfer_size) {
+        size_t chunk_size = min(sizeof(buffer), transfer_size - offset);
+        for (size_t i = 0; i < chunk_size; ++i)
+            buffer[i] = pattern_byte(offset + i);
+        ssize_t nwritten = write(fd, buffer, chunk_size);
+        if (nwritten <= 0)
+            break;
+        offset += nwritten;
+    }
+
+    close(fd);
+    sender.success = offset == transfer_size;
+    return nullptr;
+}
+
+static void transfer_with_algorithm(char const* algorithm)
+{
+    u16 port = 0;
+    int listen_fd = listen_on_loopback(port);
+
+    Sender sender { port, algorithm, false };
+    pthread_t thread;
+    EXPECT_EQ(pthread_create(&thread, nullptr, send_pattern, &sender), 0);
+
+    int fd = accept(listen_fd, nullptr, nullptr);
+    EXPECT(fd >= 0);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    u8 buffer[16 * KiB];
+    size_t offset = 0;
+    bool data_is_intact = true;
+    while (offset < transfer_size) {
+        ssize_t nread = read(fd, buffer, sizeof(buffer));
+        if (nread <= 0)
+            break;
+        for (ssize_t i = 0; i < nread && data_is_intact; ++i)
+            data_is_intact = buffer[i] == pattern_byte(offset + i);
+        offset += nread;
+    }
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    EXPECT(sender.success);
+    EXPECT_EQ(offset, transfer_size);
+    EXPECT(data_is_intact);
+
+    auto elapsed = Duration::from_timespec(end) - Duration::from_timespec(start);
+    auto milliseconds = max(elapsed.to_milliseconds(), static_cast<i64>(1));
+    outln("{}: {} KiB in {} ms, {} KiB/s", algorithm, transfer_size / KiB, milliseconds, transfer_size / KiB * 1000 / milliseconds);
+
+    close(fd);
+    close(listen_fd);
+}
+
+TEST_CASE(congestion_control_socket_option)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    EXPECT(fd >= 0);
+
+    char name[16] {};
+    socklen_t name_length = sizeof(name);
+    EXPECT_EQ(getsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, name, &name_length), 0);
+    EXPECT_EQ(name_length, strlen(name) + 1);
+
+    EXPECT_EQ(setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, "newreno", 7), 0);
+    name_length = sizeof(name);
+    EXPECT_EQ(getsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, name, &name_length), 0);
+    EXPECT_EQ(StringView { name, strlen(name) }, "newreno"sv);
+
+    EXPECT_EQ(setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, "cubic", 6), 0);
+    name_length = sizeof(name);
+    EXPECT_EQ(getsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, name, &name_length), 0);
+    EXPECT_EQ(StringView { name, strlen(name) }, "cubic"sv);
+
+    EXPECT_EQ(setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION, "vegas", 5), -1);
+    EXPECT_EQ(errno, ENOENT);
+
+    close(fd);
+}
+
+TEST_CASE(bulk_transfer_without_loss)
+{
+    transfer_with_algorithm("newreno");
+    transfer_with_algorithm("cubic");
+}
+
+TEST_CASE(bulk_transfer_with_loss)
+{
+    // This needs root, as it makes the loopback adapter drop packets for everyone.
+    if (!set_loopback_packet_loss("2"sv)) {
+        warnln("Skipping, unable to make the loopback adapter drop packets");
+        return;
+    }
+
+    transfer_with_algorithm("newreno");
+    transfer_with_algorithm("cubic");
+
+    EXPECT(set_loopback_packet_loss("0"sv));
+}
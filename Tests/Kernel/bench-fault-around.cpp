@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteString.h>
+#include <AK/NumericLimits.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/ProcessStatisticsReader.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Measures how many inode faults it takes to touch the executables and libraries of a program,
+// the way the dynamic loader and the program itself do during startup, and how long starting
+// the program takes. By default this looks at Browser and WebContent, as they map the largest
+// libraries in the system.
+
+extern char** environ;
+
+static u64 now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<u64>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+static Optional<u64> current_inode_fault_count()
+{
+    auto all_processes = Core::ProcessStatisticsReader::get_all(false);
+    if (all_processes.is_error())
+        return {};
+    for (auto& process : all_processes.value().processes) {
+        if (process.pid != getpid())
+            continue;
+        u64 inode_faults = 0;
+        for (auto& thread : process.threads)
+            inode_faults += thread.inode_faults;
+        return inode_faults;
+    }
+    return {};
+}
+
+static bool touch_file(char const* path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = st.st_size;
+    auto* data = static_cast<u8 volatile*>(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+
+    auto faults_before = current_inode_fault_count();
+    auto start = now_ns();
+    // Startup mostly hops around the text and data of a library, touching some pages of every window,
+    // so go through it in a large stride first and fill in the gaps afterwards.
+    size_t page_count = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+    for (size_t first_page = 0; first_page < 7; ++first_page) {
+        for (size_t page = first_page; page < page_count; page += 7)
+            (void)data[page * PAGE_SIZE];
+    }
+    auto elapsed_ns = now_ns() - start;
+    auto faults_after = current_inode_fault_count();
+
+    if (faults_before.has_value() && faults_after.has_value())
+        printf("%-40s %6zu pages, %6llu inode faults, %8llu us\n", path, page_count, static_cast<unsigned long long>(faults_after.value() - faults_before.value()), static_cast<unsigned long long>(elapsed_ns / 1000));
+    else
+        printf("%-40s %6zu pages, ? inode faults, %8llu us\n", path, page_count, static_cast<unsigned long long>(elapsed_ns / 1000));
+
+    munmap(const_cast<u8*>(data), size);
+    return true;
+}
+
+static bool time_startup(ByteString const& program, int iterations)
+{
+    u64 total_ns = 0;
+    u64 min_ns = NumericLimits<u64>::max();
+    for (int i = 0; i < iterations; ++i) {
+        char const* argv[] = { program.characters(), "--help", nullptr };
+        posix_spawn_file_actions_t file_actions;
+        posix_spawn_file_actions_init(&file_actions);
+        posix_spawn_file_actions_addopen(&file_actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+        posix_spawn_file_actions_addopen(&file_actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+        auto start = now_ns();
+        pid_t pid;
+        int rc = posix_spawn(&pid, program.characters(), &file_actions, nullptr, const_cast<char**>(argv), environ);
+        posix_spawn_file_actions_destroy(&file_actions);
+        if (rc != 0) {
+            fprintf(stderr, "posix_spawn %s: %s\n", program.characters(), strerror(rc));
+            return false;
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        auto elapsed_ns = now_ns() - start;
+
+        total_ns += elapsed_ns;
+        min_ns = min(min_ns, elapsed_ns);
+        if (i == 0)
+            printf("%-40s first start: %8llu us\n", program.characters(), static_cast<unsigned long long>(elapsed_ns / 1000));
+    }
+    printf("%-40s %d starts: %8llu us avg, %8llu us min\n", program.characters(), iterations, static_cast<unsigned long long>(total_ns / iterations / 1000), static_cast<unsigned long long>(min_ns / 1000));
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<StringView> arguments;
+    arguments.ensure_capacity(argc);
+    for (auto i = 0; i < argc; ++i)
+        arguments.append({ argv[i], strlen(argv[i]) });
+
+    int iterations = 10;
+    Vector<ByteString> files;
+    ByteString program = "/bin/Browser";
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(iterations, "Number of times to start the program", "iterations", 'n', "number");
+    args_parser.add_option(program, "Program to time the startup of, which is started with --help", "program", 'p', "path");
+    args_parser.add_positional_argument(files, "Executables and libraries to touch", "files", Core::ArgsParser::Required::No);
+    args_parser.parse(arguments);
+
+    if (iterations <= 0) {
+        fprintf(stderr, "Iterations must be positive\n");
+        return EXIT_FAILURE;
+    }
+    if (files.is_empty())
+        files = { "/bin/Browser", "/bin/WebContent", "/usr/lib/libweb.so.serenity", "/usr/lib/libjs.so.serenity", "/usr/lib/libgfx.so.serenity" };
+
+    for (auto& file : files)
+        (void)touch_file(file.characters());
+
+    if (!time_startup(program, iterations))
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
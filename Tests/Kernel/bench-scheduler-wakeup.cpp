@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// Measures scheduler context switch and wakeup latency by bouncing a timestamp
+// between pairs of threads over pipes. Each round trip requires two wakeups and
+// (on a single processor) two context switches. The number of concurrently
+// running pairs is stepped from 1 up to the number of processors, which shows
+// how well the scheduler scales when many threads are waking each other up.
+
+static u64 now_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<u64>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+struct PingPong {
+    int to_ponger[2];
+    int to_pinger[2];
+    int iterations { 0 };
+    pthread_t pinger;
+    pthread_t ponger;
+
+    u64 total_wakeup_ns { 0 };
+    u64 max_wakeup_ns { 0 };
+    u64 elapsed_ns { 0 };
+};
+
+static void record_wakeup(PingPong& pair, u64 sent_at)
+{
+    auto latency = now_ns() - sent_at;
+    pair.total_wakeup_ns += latency;
+    if (latency > pair.max_wakeup_ns)
+        pair.max_wakeup_ns = latency;
+}
+
+static void* ponger_main(void* argument)
+{
+    auto& pair = *static_cast<PingPong*>(argument);
+    for (int i = 0; i < pair.iterations; ++i) {
+        u64 sent_at = 0;
+        if (read(pair.to_ponger[0], &sent_at, sizeof(sent_at)) != sizeof(sent_at)) {
+            perror("read");
+            exit(1);
+        }
+        sent_at = now_ns();
+        if (write(pair.to_pinger[1], &sent_at, sizeof(sent_at)) != sizeof(sent_at)) {
+            perror("write");
+            exit(1);
+        }
+    }
+    return nullptr;
+}
+
+static void* pinger_main(void* argument)
+{
+    auto& pair = *static_cast<PingPong*>(argument);
+    auto start = now_ns();
+    for (int i = 0; i < pair.iterations; ++i) {
+        u64 sent_at = now_ns();
+        if (write(pair.to_ponger[1], &sent_at, sizeof(sent_at)) != sizeof(sent_at)) {
+            perror("write");
+            exit(1);
+        }
+        if (read(pair.to_pinger[0], &sent_at, sizeof(sent_at)) != sizeof(sent_at)) {
+            perror("read");
+            exit(1);
+        }
+        record_wakeup(pair, sent_at);
+    }
+    pair.elapsed_ns = now_ns() - start;
+    return nullptr;
+}
+
+static bool run_with_pairs(int pair_count, int iterations)
+{
+    Vector<PingPong> pairs;
+    pairs.resize(pair_count);
+
+    for (auto& pair : pairs) {
+        pair.iterations = iterations;
+        if (pipe(pair.to_ponger) < 0 || pipe(pair.to_pinger) < 0) {
+            perror("pipe");
+            return false;
+        }
+    }
+
+    for (auto& pair : pairs) {
+        if (pthread_create(&pair.ponger, nullptr, ponger_main, &pair) != 0 || pthread_create(&pair.pinger, nullptr, pinger_main, &pair) != 0) {
+            perror("pthread_create");
+            return false;
+        }
+    }
+
+    u64 total_elapsed_ns = 0;
+    u64 total_wakeup_ns = 0;
+    u64 max_wakeup_ns = 0;
+    for (auto& pair : pairs) {
+        pthread_join(pair.pinger, nullptr);
+        pthread_join(pair.ponger, nullptr);
+        total_elapsed_ns += pair.elapsed_ns;
+        total_wakeup_ns += pair.total_wakeup_ns;
+        if (pair.max_wakeup_ns > max_wakeup_ns)
+            max_wakeup_ns = pair.max_wakeup_ns;
+        close(pair.to_ponger[0]);
+        close(pair.to_ponger[1]);
+        close(pair.to_pinger[0]);
+        close(pair.to_pinger[1]);
+    }
+
+    u64 round_trips = static_cast<u64>(pair_count) * iterations;
+    // Every round trip consists of two switches between the threads of a pair.
+    auto switch_ns = total_elapsed_ns / (round_trips * 2);
+    auto wakeup_ns = total_wakeup_ns / round_trips;
+    printf("%5d pair(s): %8llu ns/switch, %8llu ns avg wakeup, %10llu ns max wakeup\n",
+        pair_count,
+        static_cast<unsigned long long>(switch_ns),
+        static_cast<unsigned long long>(wakeup_ns),
+        static_cast<unsigned long long>(max_wakeup_ns));
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Vector<StringView> arguments;
+    arguments.ensure_capacity(argc);
+    for (auto i = 0; i < argc; ++i)
+        arguments.append({ argv[i], strlen(argv[i]) });
+
+    int iterations = 10000;
+    int max_pairs = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(iterations, "Number of round trips per thread pair", "iterations", 'n', "number");
+    args_parser.add_option(max_pairs, "Maximum number of concurrently running thread pairs", "pairs", 'p', "number");
+    args_parser.parse(arguments);
+
+    if (iterations <= 0 || max_pairs <= 0) {
+        fprintf(stderr, "Iterations and pairs must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Running %d round trips per pair on %ld processor(s)\n", iterations, sysconf(_SC_NPROCESSORS_ONLN));
+    for (int pair_count = 1; pair_count <= max_pairs; ++pair_count) {
+        if (!run_with_pairs(pair_count, iterations))
+            return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+static int watch(int epoll_fd, int op, int fd, u32 events)
+{
+    epoll_event event {};
+    event.events = events;
+    event.data.fd = fd;
+    return epoll_ctl(epoll_fd, op, fd, &event);
+}
+
+TEST_CASE(epoll_reports_readable_pipe)
+{
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    EXPECT_NE(epoll_fd, -1);
+
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], EPOLLIN), 0);
+
+    epoll_event events[4];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    EXPECT_EQ(write(pipe_fds[1], "x", 1), 1);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 1000), 1);
+    EXPECT_EQ(events[0].data.fd, pipe_fds[0]);
+    EXPECT(events[0].events & EPOLLIN);
+
+    // Level-triggered interests keep being reported until the data is read.
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+
+    char c;
+    EXPECT_EQ(read(pipe_fds[0], &c, 1), 1);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_edge_triggered_and_oneshot)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT_NE(epoll_fd, -1);
+
+    int edge_pipe[2];
+    int oneshot_pipe[2];
+    EXPECT_EQ(pipe(edge_pipe), 0);
+    EXPECT_EQ(pipe(oneshot_pipe), 0);
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_ADD, edge_pipe[0], EPOLLIN | EPOLLET), 0);
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_ADD, oneshot_pipe[0], EPOLLIN | EPOLLONESHOT), 0);
+
+    EXPECT_EQ(write(edge_pipe[1], "x", 1), 1);
+    EXPECT_EQ(write(oneshot_pipe[1], "x", 1), 1);
+
+    epoll_event events[4];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 1000), 2);
+    // Neither is reported again while nothing changes.
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    // More data is a new edge, but the one-shot interest stays disarmed until it is modified.
+    EXPECT_EQ(write(edge_pipe[1], "y", 1), 1);
+    EXPECT_EQ(write(oneshot_pipe[1], "y", 1), 1);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 1000), 1);
+    EXPECT_EQ(events[0].data.fd, edge_pipe[0]);
+
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_MOD, oneshot_pipe[0], EPOLLIN | EPOLLONESHOT), 0);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 1000), 1);
+    EXPECT_EQ(events[0].data.fd, oneshot_pipe[0]);
+
+    close(edge_pipe[0]);
+    close(edge_pipe[1]);
+    close(oneshot_pipe[0]);
+    close(oneshot_pipe[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_ctl_errors)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT_NE(epoll_fd, -1);
+
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_MOD, pipe_fds[0], EPOLLIN), -1);
+    EXPECT_EQ(errno, ENOENT);
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_DEL, pipe_fds[0], 0), -1);
+    EXPECT_EQ(errno, ENOENT);
+
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], EPOLLIN), 0);
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], EPOLLIN), -1);
+    EXPECT_EQ(errno, EEXIST);
+
+    EXPECT_EQ(watch(pipe_fds[0], EPOLL_CTL_ADD, pipe_fds[1], EPOLLOUT), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_DEL, pipe_fds[0], 0), 0);
+    EXPECT_EQ(write(pipe_fds[1], "x", 1), 1);
+    epoll_event events[4];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_reports_hang_up)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT_NE(epoll_fd, -1);
+
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    EXPECT_EQ(watch(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], EPOLLIN), 0);
+
+    close(pipe_fds[1]);
+    epoll_event events[4];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 1000), 1);
+    EXPECT(events[0].events & (EPOLLIN | EPOLLHUP));
+
+    close(pipe_fds[0]);
+    close(epoll_fd);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int bind_udp_on_loopback(sockaddr_in& address)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    VERIFY(fd >= 0);
+
+    address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    VERIFY(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+    socklen_t address_length = sizeof(address);
+    VERIFY(getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_length) == 0);
+    return fd;
+}
+
+TEST_CASE(sendmmsg_and_recvmmsg)
+{
+    sockaddr_in receiver_address;
+    int receiver_fd = bind_udp_on_loopback(receiver_address);
+    sockaddr_in sender_address;
+    int sender_fd = bind_udp_on_loopback(sender_address);
+
+    static constexpr size_t message_count = 8;
+    char payloads[message_count][16];
+    iovec send_iovecs[message_count];
+    mmsghdr send_messages[message_count] {};
+    for (size_t i = 0; i < message_count; ++i) {
+        snprintf(payloads[i], sizeof(payloads[i]), "datagram %zu", i);
+        send_iovecs[i] = { payloads[i], strlen(payloads[i]) };
+        send_messages[i].msg_hdr.msg_name = &receiver_address;
+        send_messages[i].msg_hdr.msg_namelen = sizeof(receiver_address);
+        send_messages[i].msg_hdr.msg_iov = &send_iovecs[i];
+        send_messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    EXPECT_EQ(sendmmsg(sender_fd, send_messages, message_count, 0), static_cast<int>(message_count));
+    for (size_t i = 0; i < message_count; ++i)
+        EXPECT_EQ(send_messages[i].msg_len, strlen(payloads[i]));
+
+    // Ask for more than was sent, so MSG_WAITFORONE has to stop the call from blocking once the queue is empty.
+    char buffers[message_count * 2][32];
+    iovec receive_iovecs[message_count * 2];
+    sockaddr_in from_addresses[message_count * 2];
+    mmsghdr receive_messages[message_count * 2] {};
+    for (size_t i = 0; i < message_count * 2; ++i) {
+        receive_iovecs[i] = { buffers[i], sizeof(buffers[i]) };
+        receive_messages[i].msg_hdr.msg_name = &from_addresses[i];
+        receive_messages[i].msg_hdr.msg_namelen = sizeof(from_addresses[i]);
+        receive_messages[i].msg_hdr.msg_iov = &receive_iovecs[i];
+        receive_messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    EXPECT_EQ(recvmmsg(receiver_fd, receive_messages, message_count * 2, MSG_WAITFORONE, nullptr), static_cast<int>(message_count));
+    for (size_t i = 0; i < message_count; ++i) {
+        EXPECT_EQ(StringView(buffers[i], receive_messages[i].msg_len), StringView(payloads[i], strlen(payloads[i])));
+        EXPECT_EQ(from_addresses[i].sin_port, sender_address.sin_port);
+    }
+
+    EXPECT_EQ(recvmmsg(receiver_fd, receive_messages, message_count, MSG_DONTWAIT, nullptr), -1);
+    EXPECT_EQ(errno, EAGAIN);
+
+    close(sender_fd);
+    close(receiver_fd);
+}
@@ -4,11 +4,14 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Vector.h>
 #include <LibTest/TestCase.h>
 
 #include <errno.h>
 #include <mallocdefs.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 
 TEST_CASE(malloc_limits)
 {
@@ -38,3 +41,80 @@ TEST_CASE(malloc_limits)
         return Test::Crash::Failure::DidNotCrash;
     });
 }
+
+TEST_CASE(free_from_other_thread)
+{
+    static constexpr size_t allocation_count = 1000;
+    static void* allocations[allocation_count];
+
+    for (size_t i = 0; i < allocation_count; ++i) {
+        allocations[i] = malloc(16 + (i % 512));
+        EXPECT_NE(allocations[i], nullptr);
+        memset(allocations[i], 0xaa, 16);
+    }
+
+    pthread_t thread;
+    EXPECT_EQ(pthread_create(
+                  &thread, nullptr, [](void*) -> void* {
+                      for (size_t i = 0; i < allocation_count; ++i)
+                          free(allocations[i]);
+                      return nullptr;
+                  },
+                  nullptr),
+        0);
+    EXPECT_EQ(pthread_join(thread, nullptr), 0);
+
+    // Chunks freed by the other thread must be usable again from this one.
+    for (size_t i = 0; i < allocation_count; ++i) {
+        allocations[i] = malloc(16 + (i % 512));
+        EXPECT_NE(allocations[i], nullptr);
+    }
+    for (size_t i = 0; i < allocation_count; ++i)
+        free(allocations[i]);
+}
+
+static void* allocation_worker(void*)
+{
+    static constexpr size_t iterations = 200'000;
+    static constexpr size_t live_allocations = 64;
+    void* allocations[live_allocations] = {};
+
+    for (size_t i = 0; i < iterations; ++i) {
+        auto slot = i % live_allocations;
+        free(allocations[slot]);
+        allocations[slot] = malloc(16 << (i % 6));
+    }
+    for (auto* allocation : allocations)
+        free(allocation);
+    return nullptr;
+}
+
+static void run_threaded_allocation_benchmark(size_t thread_count)
+{
+    Vector<pthread_t> threads;
+    threads.resize(thread_count);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_create(&thread, nullptr, allocation_worker, nullptr), 0);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+}
+
+BENCHMARK_CASE(threaded_allocation_1_thread)
+{
+    run_threaded_allocation_benchmark(1);
+}
+
+BENCHMARK_CASE(threaded_allocation_2_threads)
+{
+    run_threaded_allocation_benchmark(2);
+}
+
+BENCHMARK_CASE(threaded_allocation_4_threads)
+{
+    run_threaded_allocation_benchmark(4);
+}
+
+BENCHMARK_CASE(threaded_allocation_8_threads)
+{
+    run_threaded_allocation_benchmark(8);
+}
@@ -16,6 +16,7 @@
 #include <LibCore/UDPServer.h>
 #include <LibTest/TestCase.h>
 #include <LibThreading/BackgroundAction.h>
+#include <LibThreading/Thread.h>
 #include <fcntl.h>
 #include <unistd.h>
 
@@ -261,6 +262,124 @@ TEST_CASE(tcp_socket_eof)
     EXPECT(client_socket->is_eof());
 }
 
+static ErrorOr<NonnullOwnPtr<Core::File>> create_file_to_send(StringView path, size_t size)
+{
+    auto file = TRY(Core::File::open(path, Core::File::OpenMode::ReadWrite | Core::File::OpenMode::Truncate));
+    auto contents = TRY(ByteBuffer::create_uninitialized(size));
+    for (size_t i = 0; i < size; ++i)
+        contents[i] = static_cast<u8>(i * 7 + i / 251);
+    TRY(file->write_until_depleted(contents));
+    return file;
+}
+
+// Reads everything the socket receives until EOF on another thread, since the sender blocks once the socket buffers are full.
+static NonnullRefPtr<Threading::Thread> receive_on_thread(Core::TCPSocket& socket, ByteBuffer& received)
+{
+    auto thread = Threading::Thread::construct([&socket, &received]() -> intptr_t {
+        u8 buffer[64 * KiB];
+        while (true) {
+            auto bytes = MUST(socket.read_some({ buffer, sizeof(buffer) }));
+            if (bytes.is_empty())
+                return 0;
+            MUST(received.try_append(bytes));
+        }
+    });
+    thread->start();
+    return thread;
+}
+
+TEST_CASE(tcp_socket_send_file)
+{
+    Core::EventLoop event_loop;
+
+    auto tcp_server = TRY_OR_FAIL(Core::TCPServer::try_create());
+    TRY_OR_FAIL(tcp_server->listen({ 127, 0, 0, 1 }, 9090));
+    TRY_OR_FAIL(tcp_server->set_blocking(true));
+
+    auto client_socket = TRY_OR_FAIL(Core::TCPSocket::connect({ { 127, 0, 0, 1 }, 9090 }));
+    TRY_OR_FAIL(client_socket->set_blocking(true));
+    auto server_socket = TRY_OR_FAIL(tcp_server->accept());
+    TRY_OR_FAIL(server_socket->set_blocking(true));
+
+    // Not a multiple of the page size, and starting in the middle of a page.
+    constexpr size_t file_size = 300 * KiB + 123;
+    constexpr off_t start_offset = 1000;
+    auto file = TRY_OR_FAIL(create_file_to_send("/tmp/tcp-send-file-test"sv, file_size));
+    TRY_OR_FAIL(file->seek(0, SeekMode::SetPosition));
+
+    ByteBuffer received;
+    auto receiver = receive_on_thread(*client_socket, received);
+
+    // Asking for more than the file has only sends what's there.
+    off_t offset = start_offset;
+    while (true) {
+        auto nsent = TRY_OR_FAIL(server_socket->send_file(file->fd(), offset, file_size));
+        if (nsent == 0)
+            break;
+    }
+    EXPECT_EQ(offset, static_cast<off_t>(file_size));
+    // The file's own offset isn't used when one is given.
+    EXPECT_EQ(TRY_OR_FAIL(file->tell()), 0u);
+    server_socket->close();
+    (void)TRY_OR_FAIL(receiver->join());
+
+    auto contents = TRY_OR_FAIL(file->read_until_eof());
+    EXPECT_EQ(received.size(), file_size - start_offset);
+    EXPECT(received.bytes() == contents.bytes().slice(start_offset));
+    ::unlink("/tmp/tcp-send-file-test");
+}
+
+static void send_file_over_loopback(bool use_send_file)
+{
+    Core::EventLoop event_loop;
+
+    auto tcp_server = MUST(Core::TCPServer::try_create());
+    MUST(tcp_server->listen({ 127, 0, 0, 1 }, 9090));
+    MUST(tcp_server->set_blocking(true));
+
+    auto client_socket = MUST(Core::TCPSocket::connect({ { 127, 0, 0, 1 }, 9090 }));
+    MUST(client_socket->set_blocking(true));
+    auto server_socket = MUST(tcp_server->accept());
+    MUST(server_socket->set_blocking(true));
+
+    constexpr size_t file_size = 64 * MiB;
+    auto file = MUST(create_file_to_send("/tmp/tcp-send-file-benchmark"sv, file_size));
+
+    ByteBuffer received;
+    MUST(received.try_ensure_capacity(file_size));
+    auto receiver = receive_on_thread(*client_socket, received);
+
+    if (use_send_file) {
+        off_t offset = 0;
+        while (MUST(server_socket->send_file(file->fd(), offset, file_size - offset)) > 0)
+            ;
+    } else {
+        MUST(file->seek(0, SeekMode::SetPosition));
+        u8 buffer[64 * KiB];
+        while (true) {
+            auto bytes = MUST(file->read_some({ buffer, sizeof(buffer) }));
+            if (bytes.is_empty())
+                break;
+            MUST(server_socket->write_until_depleted(bytes));
+        }
+    }
+    server_socket->close();
+    MUST(receiver->join());
+
+    EXPECT_EQ(received.size(), file_size);
+    ::unlink("/tmp/tcp-send-file-benchmark");
+}
+
+BENCHMARK_CASE(tcp_socket_read_and_write_file)
+{
+    send_file_over_loopback(false);
+}
+
+BENCHMARK_CASE(tcp_socket_send_file_throughput)
+{
+    send_file_over_loopback(true);
+}
+
 // UDPSocket tests
 
 constexpr auto udp_reply_data = "Well hello friends!"sv;
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibCore/EventLoop.h>
+#include <LibJS/Heap/Handle.h>
+#include <LibJS/Heap/Heap.h>
+#include <LibJS/Runtime/AbstractOperations.h>
+#include <LibJS/Runtime/Array.h>
+#include <LibJS/Runtime/FinalizationRegistry.h>
+#include <LibJS/Runtime/FinalizationRegistryConstructor.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/Intrinsics.h>
+#include <LibJS/Runtime/NativeFunction.h>
+#include <LibJS/Runtime/Object.h>
+#include <LibJS/Runtime/PrivateEnvironment.h>
+#include <LibJS/Runtime/VM.h>
+#include <LibJS/Runtime/ValueInlines.h>
+#include <LibTest/TestCase.h>
+
+static constexpr size_t retained_object_count = 200'000;
+static constexpr size_t collection_count = 20;
+
+static NEVER_INLINE JS::NonnullGCPtr<JS::Object> create_object_with_value(JS::Realm& realm)
+{
+    auto object = JS::Object::create(realm, nullptr);
+    MUST(object->create_data_property_or_throw(JS::PropertyKey { "value" }, JS::Value(42)));
+    return object;
+}
+
+static NEVER_INLINE void store_young_object_into(JS::Realm& realm, JS::Object& old_object)
+{
+    MUST(old_object.create_data_property_or_throw(JS::PropertyKey { "young" }, create_object_with_value(realm)));
+}
+
+static void expect_object_with_value(JS::Value value)
+{
+    EXPECT(value.is_object());
+    if (value.is_object())
+        EXPECT_EQ(MUST(value.as_object().get(JS::PropertyKey { "value" })), JS::Value(42));
+}
+
+// Private elements live outside of the object's property storage, so they need barriers of their own.
+static JS::PrivateName const added_field_name { 1, "#added_field" };
+static JS::PrivateName const added_method_name { 2, "#added_method" };
+static JS::PrivateName const set_field_name { 3, "#set_field" };
+
+static NEVER_INLINE void store_young_objects_into_private_elements(JS::Realm& realm, JS::Object& old_object)
+{
+    MUST(old_object.private_field_add(added_field_name, create_object_with_value(realm)));
+    MUST(old_object.private_method_or_accessor_add(JS::PrivateElement { added_method_name, JS::PrivateElement::Kind::Method, create_object_with_value(realm) }));
+    MUST(old_object.private_set(set_field_name, create_object_with_value(realm)));
+}
+
+// The stack is scanned conservatively, so a pointer that an earlier call left behind on it can keep a cell alive.
+static NEVER_INLINE void clear_unused_stack()
+{
+    u8 volatile unused_stack[64 * KiB];
+    for (auto& byte : unused_stack)
+        byte = 0;
+}
+
+static NEVER_INLINE void register_young_target_with_young_held_value(JS::Realm& realm, JS::FinalizationRegistry& registry)
+{
+    registry.add_finalization_record(*JS::Object::create(realm, nullptr), create_object_with_value(realm), nullptr);
+}
+
+static JS::NonnullGCPtr<JS::FinalizationRegistry> create_finalization_registry(JS::Realm& realm, JS::Value& cleaned_up_held_value)
+{
+    auto cleanup_callback = JS::NativeFunction::create(
+        realm, [&cleaned_up_held_value](JS::VM& vm) -> JS::ThrowCompletionOr<JS::Value> {
+            cleaned_up_held_value = vm.argument(0);
+            return JS::js_undefined();
+        },
+        1, "");
+    auto registry = MUST(JS::construct(realm.vm(), *realm.intrinsics().finalization_registry_constructor(), JS::Value(cleanup_callback)));
+    return verify_cast<JS::FinalizationRegistry>(*registry);
+}
+
+TEST_CASE(young_object_referenced_from_old_object_survives)
+{
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+    auto& heap = vm->heap();
+
+    heap.set_generational_collection_enabled(true);
+
+    auto old_object = JS::make_handle(JS::Object::create(realm, nullptr));
+    heap.collect_garbage();
+    EXPECT(old_object->is_marked());
+
+    store_young_object_into(realm, *old_object);
+    heap.collect_garbage(JS::Heap::CollectionType::CollectYoungGeneration);
+
+    auto young_object = MUST(old_object->get(JS::PropertyKey { "young" }));
+    EXPECT(young_object.is_object());
+    EXPECT(young_object.as_object().is_marked());
+    EXPECT_EQ(MUST(young_object.as_object().get(JS::PropertyKey { "value" })), JS::Value(42));
+
+    heap.set_generational_collection_enabled(false);
+}
+
+TEST_CASE(young_objects_stored_into_private_elements_of_old_object_survive)
+{
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+    auto& heap = vm->heap();
+
+    heap.set_generational_collection_enabled(true);
+
+    auto old_object = JS::make_handle(JS::Object::create(realm, nullptr));
+    MUST(old_object->private_field_add(set_field_name, JS::js_undefined()));
+    heap.collect_garbage();
+    EXPECT(old_object->is_marked());
+
+    store_young_objects_into_private_elements(realm, *old_object);
+    heap.collect_garbage(JS::Heap::CollectionType::CollectYoungGeneration);
+
+    for (auto const* name : { &added_field_name, &added_method_name, &set_field_name }) {
+        auto value = MUST(old_object->private_get(*name));
+        EXPECT(value.is_object() && value.as_object().is_marked());
+        expect_object_with_value(value);
+    }
+
+    heap.set_generational_collection_enabled(false);
+}
+
+TEST_CASE(young_held_value_of_old_finalization_registry_survives)
+{
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+    auto& heap = vm->heap();
+
+    heap.set_generational_collection_enabled(true);
+
+    JS::Value cleaned_up_held_value;
+    auto registry = JS::make_handle(create_finalization_registry(realm, cleaned_up_held_value));
+    heap.collect_garbage();
+    EXPECT(registry->is_marked());
+
+    // The target dies right away, but the held value has to stay around for the cleanup callback.
+    register_young_target_with_young_held_value(realm, *registry);
+    clear_unused_stack();
+    heap.collect_garbage(JS::Heap::CollectionType::CollectYoungGeneration);
+    MUST(registry->cleanup());
+    expect_object_with_value(cleaned_up_held_value);
+
+    heap.set_generational_collection_enabled(false);
+}
+
+TEST_CASE(object_stored_into_visited_object_during_incremental_marking_survives)
+{
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+    auto& heap = vm->heap();
+
+    heap.set_incremental_marking_enabled(true);
+
+    auto visited_object = JS::make_handle(JS::Object::create(realm, nullptr));
+
+    // Allocate until the heap starts marking, then let marking visit everything reachable so far.
+    while (!heap.is_incremental_marking_in_progress())
+        (void)JS::Object::create(realm, nullptr);
+    heap.set_incremental_marking_slice_budget(Duration::from_seconds(10));
+    while (!visited_object->is_marked())
+        (void)JS::Object::create(realm, nullptr);
+
+    store_young_object_into(realm, *visited_object);
+    heap.collect_garbage();
+    EXPECT(!heap.is_incremental_marking_in_progress());
+
+    auto stored_object = MUST(visited_object->get(JS::PropertyKey { "young" }));
+    EXPECT(stored_object.is_object());
+    EXPECT_EQ(MUST(stored_object.as_object().get(JS::PropertyKey { "value" })), JS::Value(42));
+
+    heap.set_incremental_marking_enabled(false);
+}
+
+// A chain this long takes incremental marking many slices to get through.
+static constexpr size_t chain_length = 100'000;
+
+// The address of the chain is kept hidden from the conservative stack scan, which would otherwise mark the chain
+// as a root, without marking having been through the object that holds it.
+static constexpr FlatPtr hidden_address_mask = 0x5555'5555;
+
+static NEVER_INLINE FlatPtr append_chain_ending_in_objects_with_values(JS::Realm& realm, JS::Object& object)
+{
+    JS::NonnullGCPtr<JS::Object> link = JS::Object::create(realm, nullptr);
+    for (auto const* key : { "field", "method", "set_field", "held_value" })
+        MUST(link->create_data_property_or_throw(JS::PropertyKey { key }, create_object_with_value(realm)));
+    for (size_t i = 0; i < chain_length; ++i) {
+        auto previous_link = JS::Object::create(realm, nullptr);
+        MUST(previous_link->create_data_property_or_throw(JS::PropertyKey { "next" }, link));
+        link = previous_link;
+    }
+    MUST(object.create_data_property_or_throw(JS::PropertyKey { "next" }, link));
+    return bit_cast<FlatPtr>(link.ptr()) ^ hidden_address_mask;
+}
+
+static NEVER_INLINE void move_chain(JS::Object& from, JS::Object& to)
+{
+    MUST(to.create_data_property_or_throw(JS::PropertyKey { "next" }, MUST(from.get(JS::PropertyKey { "next" }))));
+    MUST(from.delete_property_or_throw(JS::PropertyKey { "next" }));
+}
+
+static NEVER_INLINE bool is_hidden_cell_marked(FlatPtr hidden_address)
+{
+    return bit_cast<JS::Cell*>(hidden_address ^ hidden_address_mask)->is_marked();
+}
+
+// Takes the objects out of the end of the chain, which marking hasn't reached yet, and stores them
+// into the private elements and finalization records of the registry, which marking is done with.
+static NEVER_INLINE void move_objects_from_end_of_chain_into(JS::Realm& realm, JS::FinalizationRegistry& registry)
+{
+    auto link = MUST(registry.get(JS::PropertyKey { "next" }));
+    for (auto next = MUST(link.as_object().get(JS::PropertyKey { "next" })); !next.is_undefined(); next = MUST(link.as_object().get(JS::PropertyKey { "next" })))
+        link = next;
+    auto& last_link = link.as_object();
+    EXPECT(!last_link.is_marked());
+
+    auto take_value = [&](char const* key) {
+        auto value = MUST(last_link.get(JS::PropertyKey { key }));
+        MUST(last_link.delete_property_or_throw(JS::PropertyKey { key }));
+        return value;
+    };
+    MUST(registry.private_field_add(added_field_name, take_value("field")));
+    MUST(registry.private_method_or_accessor_add(JS::PrivateElement { added_method_name, JS::PrivateElement::Kind::Method, take_value("method") }));
+    MUST(registry.private_set(set_field_name, take_value("set_field")));
+    registry.add_finalization_record(*JS::Object::create(realm, nullptr), take_value("held_value"), nullptr);
+}
+
+TEST_CASE(objects_moved_into_visited_object_between_incremental_marking_slices_survive)
+{
+    Core::EventLoop event_loop;
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+    auto& heap = vm->heap();
+
+    heap.set_incremental_marking_enabled(true);
+    heap.set_incremental_marking_slice_budget(Duration::zero());
+
+    auto holder = JS::make_handle(JS::Object::create(realm, nullptr));
+    auto hidden_chain_address = append_chain_ending_in_objects_with_values(realm, *holder);
+    clear_unused_stack();
+    heap.collect_garbage();
+
+    // Cells allocated while marking is in progress are visited by the next marking slice, so once the registry has been
+    // allocated and given the chain, the slices run from the event loop go through the registry before the chain.
+    while (!heap.is_incremental_marking_in_progress())
+        (void)JS::Object::create(realm, nullptr);
+    JS::Value cleaned_up_held_value;
+    auto registry = JS::make_handle(create_finalization_registry(realm, cleaned_up_held_value));
+    MUST(registry->private_field_add(set_field_name, JS::js_undefined()));
+    move_chain(*holder, *registry);
+    while (!is_hidden_cell_marked(hidden_chain_address))
+        event_loop.pump(Core::EventLoop::WaitMode::PollForEvents);
+
+    move_objects_from_end_of_chain_into(realm, *registry);
+    clear_unused_stack();
+    heap.collect_garbage();
+    EXPECT(!heap.is_incremental_marking_in_progress());
+
+    // Anything that didn't survive has its cell taken over by one of these.
+    for (size_t i = 0; i < 10'000; ++i)
+        (void)JS::Object::create(realm, nullptr);
+
+    for (auto const* name : { &added_field_name, &added_method_name, &set_field_name })
+        expect_object_with_value(MUST(registry->private_get(*name)));
+
+    // The target of the finalization record is gone after another collection, which hands the held value to the cleanup callback.
+    heap.set_incremental_marking_enabled(false);
+    clear_unused_stack();
+    heap.collect_garbage();
+    MUST(registry->cleanup());
+    expect_object_with_value(cleaned_up_held_value);
+}
+
+// Like LibWeb's CSSStyleSheet, this is Weakable at two levels of its class hierarchy.
+class WeakableCell : public JS::Cell
+    , public Weakable<WeakableCell> {
+    JS_CELL(WeakableCell, JS::Cell);
+};
+
+class DerivedWeakableCell final : public WeakableCell
+    , public Weakable<DerivedWeakableCell> {
+    JS_CELL(DerivedWeakableCell, WeakableCell);
+};
+
+static NEVER_INLINE void create_weakly_referenced_cell(JS::Heap& heap, WeakPtr<WeakableCell>& weak_ptr, WeakPtr<DerivedWeakableCell>& derived_weak_ptr)
+{
+    auto cell = heap.allocate_without_realm<DerivedWeakableCell>();
+    weak_ptr = cell->Weakable<WeakableCell>::make_weak_ptr();
+    derived_weak_ptr = cell->Weakable<DerivedWeakableCell>::make_weak_ptr();
+}
+
+TEST_CASE(weak_pointers_to_dead_cells_are_revoked_before_lazy_sweeping)
+{
+    auto vm = MUST(JS::VM::create());
+    auto& heap = vm->heap();
+
+    heap.set_lazy_sweeping_enabled(true);
+
+    WeakPtr<WeakableCell> weak_ptr;
+    WeakPtr<DerivedWeakableCell> derived_weak_ptr;
+    create_weakly_referenced_cell(heap, weak_ptr, derived_weak_ptr);
+    EXPECT(weak_ptr && derived_weak_ptr);
+
+    // The cell is dead now, but its block is only swept once its allocator needs room in it.
+    clear_unused_stack();
+    heap.collect_garbage();
+    EXPECT(!weak_ptr);
+    EXPECT(!derived_weak_ptr);
+
+    heap.set_lazy_sweeping_enabled(false);
+}
+
+// Keeps a large number of objects alive and measures how long collecting the garbage allocated next to them takes.
+static void collect_with_large_retained_heap(JS::Heap::CollectionType collection_type)
+{
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+    auto& heap = vm->heap();
+
+    heap.set_generational_collection_enabled(collection_type == JS::Heap::CollectionType::CollectYoungGeneration);
+
+    auto retained = JS::make_handle(MUST(JS::Array::create(realm, 0)));
+    for (size_t i = 0; i < retained_object_count; ++i)
+        MUST(retained->create_data_property_or_throw(i, JS::Object::create(realm, nullptr)));
+    heap.collect_garbage();
+
+    for (size_t i = 0; i < collection_count; ++i) {
+        for (size_t j = 0; j < 1000; ++j)
+            (void)JS::Object::create(realm, nullptr);
+        heap.collect_garbage(collection_type);
+    }
+
+    heap.set_generational_collection_enabled(false);
+}
+
+BENCHMARK_CASE(full_collection_with_large_retained_heap)
+{
+    collect_with_large_retained_heap(JS::Heap::CollectionType::CollectGarbage);
+}
+
+BENCHMARK_CASE(young_generation_collection_with_large_retained_heap)
+{
+    collect_with_large_retained_heap(JS::Heap::CollectionType::CollectYoungGeneration);
+}
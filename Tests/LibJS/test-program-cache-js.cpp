@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/ProgramCache.h>
+#include <LibJS/Runtime/GlobalObject.h>
+#include <LibJS/Runtime/VM.h>
+#include <LibJS/Runtime/ValueInlines.h>
+#include <LibJS/Script.h>
+#include <LibTest/TestCase.h>
+
+TEST_CASE(same_source_text_is_only_parsed_once)
+{
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+
+    auto source = "function f(x) { return x * 2; } f(21);"sv;
+    auto first = MUST(JS::Script::parse(source, realm, "script.js"sv));
+    auto second = MUST(JS::Script::parse(source, realm, "script.js"sv));
+    EXPECT_EQ(&first->parse_node(), &second->parse_node());
+    EXPECT_EQ(vm->program_cache().hit_count(), 1u);
+
+    EXPECT_EQ(MUST(vm->bytecode_interpreter().run(*first)), JS::Value(42));
+    EXPECT_EQ(MUST(vm->bytecode_interpreter().run(*second)), JS::Value(42));
+}
+
+TEST_CASE(programs_are_only_shared_if_everything_matches)
+{
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+
+    auto source = "1 + 2"sv;
+    auto script = MUST(JS::Script::parse(source, realm, "a.js"sv));
+    EXPECT_NE(&MUST(JS::Script::parse(source, realm, "b.js"sv))->parse_node(), &script->parse_node());
+    EXPECT_NE(&MUST(JS::Script::parse(source, realm, "a.js"sv, nullptr, 10))->parse_node(), &script->parse_node());
+    EXPECT_NE(&MUST(JS::Script::parse("1 + 3"sv, realm, "a.js"sv))->parse_node(), &script->parse_node());
+    EXPECT_EQ(vm->program_cache().hit_count(), 0u);
+}
+
+TEST_CASE(scripts_with_annex_b_function_hoisting_are_not_cached)
+{
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+
+    auto source = "{ function f() {} }"sv;
+    auto first = MUST(JS::Script::parse(source, realm));
+    auto second = MUST(JS::Script::parse(source, realm));
+    EXPECT_NE(&first->parse_node(), &second->parse_node());
+    EXPECT_EQ(vm->program_cache().size_in_bytes(), 0u);
+}
+
+TEST_CASE(least_recently_used_program_is_evicted_first)
+{
+    auto vm = MUST(JS::VM::create());
+    auto root_execution_context = JS::create_simple_execution_context<JS::GlobalObject>(*vm);
+    auto& realm = *root_execution_context->realm;
+    auto& program_cache = vm->program_cache();
+
+    program_cache.set_capacity_in_bytes(10);
+    auto first = MUST(JS::Script::parse("1111"sv, realm));
+    auto second = MUST(JS::Script::parse("2222"sv, realm));
+    (void)MUST(JS::Script::parse("1111"sv, realm));
+    (void)MUST(JS::Script::parse("3333"sv, realm));
+    EXPECT_EQ(program_cache.size_in_bytes(), 8u);
+
+    EXPECT_EQ(&MUST(JS::Script::parse("1111"sv, realm))->parse_node(), &first->parse_node());
+    EXPECT_NE(&MUST(JS::Script::parse("2222"sv, realm))->parse_node(), &second->parse_node());
+}
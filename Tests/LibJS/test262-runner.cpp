@@ -16,6 +16,7 @@
 #include <LibJS/Bytecode/BasicBlock.h>
 #include <LibJS/Bytecode/Generator.h>
 #include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Bytecode/PassManager.h>
 #include <LibJS/Contrib/Test262/GlobalObject.h>
 #include <LibJS/Parser.h>
 #include <LibJS/Runtime/Agent.h>
@@ -575,6 +576,7 @@ int main(int argc, char** argv)
     int timeout = 10;
     bool enable_debug_printing = false;
     bool disable_core_dumping = false;
+    bool dump_bytecode_pass_statistics = false;
 
     Core::ArgsParser args_parser;
     args_parser.set_general_help("LibJS test262 runner for streaming tests");
@@ -583,6 +585,7 @@ int main(int argc, char** argv)
     args_parser.add_option(timeout, "Seconds before test should timeout", "timeout", 't', "seconds");
     args_parser.add_option(enable_debug_printing, "Enable debug printing", "debug", 'd');
     args_parser.add_option(disable_core_dumping, "Disable core dumping", "disable-core-dump", 0);
+    args_parser.add_option(dump_bytecode_pass_statistics, "Print how many bytecode instructions the optimization passes removed", "bytecode-pass-stats", 0);
     args_parser.parse(arguments);
 
 #ifdef AK_OS_GNU_HURD
@@ -810,6 +813,9 @@ int main(int argc, char** argv)
     s_current_test = "";
     outln(saved_stdout_fd, "DONE {}", count);
 
+    if (dump_bytecode_pass_statistics)
+        JS::Bytecode::PassManager::optimization_pipeline().dump_statistics();
+
     // After this point we have already written our output so pretend everything is fine if we get an error.
     if (dup2(saved_stdout, STDOUT_FILENO) < 0) {
         perror("dup2");
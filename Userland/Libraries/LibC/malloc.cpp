@@ -50,6 +50,13 @@ constexpr size_t number_of_hot_chunked_blocks_to_keep_around = 16;
 constexpr size_t number_of_cold_chunked_blocks_to_keep_around = 16;
 constexpr size_t number_of_big_blocks_to_keep_around_per_size_class = 8;
 
+// Threads keep a few free chunks of the smaller size classes around, so that the
+// common malloc()/free() path does not have to take s_malloc_mutex. Chunks move
+// between a thread cache and the shared allocators in batches.
+constexpr size_t thread_cache_batch_size = 16;
+constexpr size_t thread_cache_max_chunks_per_size_class = 2 * thread_cache_batch_size;
+constexpr size_t thread_cache_max_chunk_size = 1008;
+
 static bool s_log_malloc = false;
 static bool s_scrub_malloc = true;
 static bool s_scrub_free = true;
@@ -115,6 +122,11 @@ struct MallocStats {
     size_t number_of_hot_keeps;
     size_t number_of_cold_keeps;
     size_t number_of_frees;
+
+    size_t number_of_thread_cache_hits;
+    size_t number_of_thread_cache_refills;
+    size_t number_of_thread_cache_keeps;
+    size_t number_of_thread_cache_flushes;
 };
 static MallocStats g_malloc_stats = {};
 
@@ -228,6 +240,11 @@ static Allocator* allocator_for_size(size_t size, size_t& good_size, size_t alig
     return nullptr;
 }
 
+static size_t size_class_index(Allocator const& allocator)
+{
+    return &allocator - &allocators()[0];
+}
+
 #ifdef RECYCLE_BIG_ALLOCATIONS
 static BigAllocator* big_allocator_for_size(size_t size)
 {
@@ -291,6 +308,60 @@ enum class CallerWillInitializeMemory {
 
 #ifndef NO_TLS
 __thread bool s_allocation_enabled = true;
+
+struct ThreadCache {
+    FreelistEntry* chunks[num_size_classes];
+    size_t chunk_count[num_size_classes];
+};
+
+static __thread ThreadCache s_thread_cache;
+
+static bool thread_cache_is_usable(size_t align, size_t chunk_size)
+{
+    // The userspace emulator tracks every chunk, keep it in the loop by always going through the allocators.
+    if (s_in_userspace_emulator)
+        return false;
+    // All chunks are 16-byte aligned, anything stricter needs a search through the blocks.
+    return align <= 16 && chunk_size <= thread_cache_max_chunk_size;
+}
+
+static void* take_chunk_from_thread_cache(size_t size_class)
+{
+    auto*& chunks = s_thread_cache.chunks[size_class];
+    auto* entry = chunks;
+    if (!entry)
+        return nullptr;
+    chunks = entry->next;
+    --s_thread_cache.chunk_count[size_class];
+    return entry;
+}
+
+static void put_chunk_in_thread_cache(void* ptr, size_t size_class)
+{
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = s_thread_cache.chunks[size_class];
+    s_thread_cache.chunks[size_class] = entry;
+    ++s_thread_cache.chunk_count[size_class];
+}
+
+// NOTE: s_malloc_mutex must be held.
+static void fill_thread_cache(Allocator& allocator)
+{
+    g_malloc_stats.number_of_thread_cache_refills++;
+    auto size_class = size_class_index(allocator);
+    // Only take chunks from blocks we already have, we don't want to map in new blocks just to fill the cache.
+    while (s_thread_cache.chunk_count[size_class] < thread_cache_batch_size && !allocator.usable_blocks.is_empty()) {
+        auto& block = *allocator.usable_blocks.first();
+        auto* ptr = try_allocate_chunk_aligned(16, block);
+        VERIFY(ptr);
+        if (block.is_full()) {
+            g_malloc_stats.number_of_blocks_full++;
+            allocator.usable_blocks.remove(block);
+            allocator.full_blocks.append(block);
+        }
+        put_chunk_in_thread_cache(ptr, size_class);
+    }
+}
 #endif
 
 static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializeMemory caller_will_initialize_memory)
@@ -321,6 +392,19 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
     size_t good_size;
     auto* allocator = allocator_for_size(size, good_size, align);
 
+#ifndef NO_TLS
+    bool use_thread_cache = allocator && thread_cache_is_usable(align, good_size);
+    if (use_thread_cache) {
+        if (auto* ptr = take_chunk_from_thread_cache(size_class_index(*allocator))) {
+            g_malloc_stats.number_of_thread_cache_hits++;
+            if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
+                memset(ptr, MALLOC_SCRUB_BYTE, good_size);
+            ue_notify_malloc(ptr, size);
+            return ptr;
+        }
+    }
+#endif
+
     PthreadMutexLocker locker(s_malloc_mutex);
 
     if (!allocator) {
@@ -436,6 +520,12 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
     }
     dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
 
+#ifndef NO_TLS
+    // We already hold the lock, grab a batch of chunks so the next allocations of this size don't need it.
+    if (use_thread_cache)
+        fill_thread_cache(*allocator);
+#endif
+
     if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
         memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
 
@@ -443,6 +533,64 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
     return ptr;
 }
 
+// NOTE: s_malloc_mutex must be held.
+static void free_chunk(ChunkedBlock* block, void* ptr)
+{
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = block->m_freelist;
+    block->m_freelist = entry;
+
+    if (block->is_full()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
+        g_malloc_stats.number_of_freed_full_blocks++;
+        allocator->full_blocks.remove(*block);
+        allocator->usable_blocks.prepend(*block);
+    }
+
+    ++block->m_free_chunks;
+
+    if (!block->used_chunks()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
+            g_malloc_stats.number_of_hot_keeps++;
+            allocator->usable_blocks.remove(*block);
+            s_hot_empty_blocks[s_hot_empty_block_count++] = block;
+            return;
+        }
+        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
+            g_malloc_stats.number_of_cold_keeps++;
+            allocator->usable_blocks.remove(*block);
+            s_cold_empty_blocks[s_cold_empty_block_count++] = block;
+            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
+            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
+            return;
+        }
+        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
+        g_malloc_stats.number_of_frees++;
+        allocator->usable_blocks.remove(*block);
+        --allocator->block_count;
+        os_free(block, ChunkedBlock::block_size);
+    }
+}
+
+#ifndef NO_TLS
+// NOTE: s_malloc_mutex must be held.
+static void flush_thread_cache(size_t size_class, size_t chunks_to_keep)
+{
+    g_malloc_stats.number_of_thread_cache_flushes++;
+    while (s_thread_cache.chunk_count[size_class] > chunks_to_keep) {
+        auto* ptr = take_chunk_from_thread_cache(size_class);
+        auto* block = (ChunkedBlock*)((FlatPtr)ptr & ChunkedBlock::block_mask);
+        free_chunk(block, ptr);
+    }
+}
+#endif
+
 static void free_impl(void* ptr)
 {
 #ifndef NO_TLS
@@ -459,6 +607,29 @@ static void free_impl(void* ptr)
     void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
     size_t magic = *(size_t*)block_base;
 
+#ifndef NO_TLS
+    if (magic == MAGIC_PAGE_HEADER) {
+        auto* block = (ChunkedBlock*)block_base;
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        if (thread_cache_is_usable(16, good_size)) {
+            if (s_scrub_free)
+                memset(ptr, FREE_SCRUB_BYTE, good_size);
+
+            auto size_class = size_class_index(*allocator);
+            put_chunk_in_thread_cache(ptr, size_class);
+            g_malloc_stats.number_of_thread_cache_keeps++;
+            if (s_thread_cache.chunk_count[size_class] <= thread_cache_max_chunks_per_size_class)
+                return;
+
+            // The cache is overflowing, hand a batch of chunks back to the shared allocator.
+            PthreadMutexLocker locker(s_malloc_mutex);
+            flush_thread_cache(size_class, thread_cache_max_chunks_per_size_class - thread_cache_batch_size);
+            return;
+        }
+    }
+#endif
+
     PthreadMutexLocker locker(s_malloc_mutex);
 
     if (magic == MAGIC_BIGALLOC_HEADER) {
@@ -494,46 +665,7 @@ static void free_impl(void* ptr)
     if (s_scrub_free)
         memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
 
-    auto* entry = (FreelistEntry*)ptr;
-    entry->next = block->m_freelist;
-    block->m_freelist = entry;
-
-    if (block->is_full()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
-        g_malloc_stats.number_of_freed_full_blocks++;
-        allocator->full_blocks.remove(*block);
-        allocator->usable_blocks.prepend(*block);
-    }
-
-    ++block->m_free_chunks;
-
-    if (!block->used_chunks()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
-            g_malloc_stats.number_of_hot_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_hot_empty_blocks[s_hot_empty_block_count++] = block;
-            return;
-        }
-        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
-            g_malloc_stats.number_of_cold_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_cold_empty_blocks[s_cold_empty_block_count++] = block;
-            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
-            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
-            return;
-        }
-        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
-        g_malloc_stats.number_of_frees++;
-        allocator->usable_blocks.remove(*block);
-        --allocator->block_count;
-        os_free(block, ChunkedBlock::block_size);
-    }
+    free_chunk(block, ptr);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/malloc.html
@@ -682,6 +814,17 @@ void __malloc_init()
     new (&big_allocators()[0])(BigAllocator);
 }
 
+void __malloc_thread_cache_flush()
+{
+#ifndef NO_TLS
+    PthreadMutexLocker locker(s_malloc_mutex);
+    for (size_t i = 0; i < num_size_classes; ++i) {
+        if (s_thread_cache.chunk_count[i] != 0)
+            flush_thread_cache(i, 0);
+    }
+#endif
+}
+
 void serenity_dump_malloc_stats()
 {
     dbgln("# malloc() calls: {}", g_malloc_stats.number_of_malloc_calls);
@@ -705,5 +848,10 @@ void serenity_dump_malloc_stats()
     dbgln("number of hot keeps: {}", g_malloc_stats.number_of_hot_keeps);
     dbgln("number of cold keeps: {}", g_malloc_stats.number_of_cold_keeps);
     dbgln("number of frees: {}", g_malloc_stats.number_of_frees);
+    dbgln();
+    dbgln("thread cache hits: {}", g_malloc_stats.number_of_thread_cache_hits);
+    dbgln("thread cache refills: {}", g_malloc_stats.number_of_thread_cache_refills);
+    dbgln("thread cache keeps: {}", g_malloc_stats.number_of_thread_cache_keeps);
+    dbgln("thread cache flushes: {}", g_malloc_stats.number_of_thread_cache_flushes);
 }
 }
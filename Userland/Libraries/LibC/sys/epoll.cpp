@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <bits/pthread_cancel.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <syscall.h>
+
+extern "C" {
+
+int epoll_create(int size)
+{
+    // NOTE: The size hint is meaningless nowadays, but it still has to be positive.
+    if (size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return epoll_create1(0);
+}
+
+int epoll_create1(int flags)
+{
+    int rc = syscall(SC_epoll_create, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event* event)
+{
+    int rc = syscall(SC_epoll_ctl, epfd, op, fd, event);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int epoll_wait(int epfd, struct epoll_event* events, int max_events, int timeout_ms)
+{
+    return epoll_pwait(epfd, events, max_events, timeout_ms, nullptr);
+}
+
+int epoll_pwait(int epfd, struct epoll_event* events, int max_events, int timeout_ms, sigset_t const* sigmask)
+{
+    __pthread_maybe_cancel();
+
+    timespec timeout;
+    timespec* timeout_ts = &timeout;
+    if (timeout_ms < 0)
+        timeout_ts = nullptr;
+    else
+        timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1'000'000 };
+
+    Syscall::SC_epoll_wait_params params { epfd, events, max_events, timeout_ts, sigmask };
+    int rc = syscall(SC_epoll_wait, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+}
@@ -16,6 +16,8 @@
 
 __BEGIN_DECLS
 
+struct timespec;
+
 int socket(int domain, int type, int protocol);
 int bind(int sockfd, const struct sockaddr* addr, socklen_t);
 int listen(int sockfd, int backlog);
@@ -25,9 +27,11 @@ int connect(int sockfd, const struct sockaddr*, socklen_t);
 int shutdown(int sockfd, int how);
 ssize_t send(int sockfd, void const*, size_t, int flags);
 ssize_t sendmsg(int sockfd, const struct msghdr*, int flags);
+int sendmmsg(int sockfd, struct mmsghdr*, unsigned int vlen, int flags);
 ssize_t sendto(int sockfd, void const*, size_t, int flags, const struct sockaddr*, socklen_t);
 ssize_t recv(int sockfd, void*, size_t, int flags);
 ssize_t recvmsg(int sockfd, struct msghdr*, int flags);
+int recvmmsg(int sockfd, struct mmsghdr*, unsigned int vlen, int flags, struct timespec* timeout);
 ssize_t recvfrom(int sockfd, void*, size_t, int flags, struct sockaddr*, socklen_t*);
 int getsockopt(int sockfd, int level, int option, void*, socklen_t*);
 int setsockopt(int sockfd, int level, int option, void const*, socklen_t);
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
 #include <AK/IDAllocator.h>
 #include <AK/Singleton.h>
 #include <AK/TemporaryChange.h>
@@ -19,6 +20,11 @@
 #include <sys/select.h>
 #include <unistd.h>
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+#    define EVENT_LOOP_USES_EPOLL
+#    include <sys/epoll.h>
+#endif
+
 namespace Core {
 
 struct ThreadData;
@@ -61,6 +67,13 @@ struct ThreadData {
             close(wake_pipe_fds[0]);
         if (wake_pipe_fds[1] != -1)
             close(wake_pipe_fds[1]);
+#ifdef EVENT_LOOP_USES_EPOLL
+        // NOTE: A forked child shares the interest list of its parent's epoll instance, so it needs its own.
+        if (epoll_fd != -1)
+            close(epoll_fd);
+        notifiers_by_fd.clear();
+        always_ready_fds.clear();
+#endif
 
 #if defined(SOCK_NONBLOCK)
         int rc = pipe2(wake_pipe_fds, O_CLOEXEC);
@@ -71,12 +84,66 @@ struct ThreadData {
 
 #endif
         VERIFY(rc == 0);
+
+#ifdef EVENT_LOOP_USES_EPOLL
+        epoll_fd = MUST(Core::System::epoll_create1(EPOLL_CLOEXEC));
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = wake_pipe_fds[0];
+        MUST(Core::System::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_pipe_fds[0], &event));
+#endif
     }
 
+#ifdef EVENT_LOOP_USES_EPOLL
+    void update_epoll_interest(int fd)
+    {
+        u32 events = 0;
+        auto it = notifiers_by_fd.find(fd);
+        if (it != notifiers_by_fd.end()) {
+            for (auto* notifier : it->value) {
+                if (notifier->type() == Notifier::Type::Read)
+                    events |= EPOLLIN;
+                if (notifier->type() == Notifier::Type::Write)
+                    events |= EPOLLOUT;
+                if (notifier->type() == Notifier::Type::Exceptional)
+                    events |= EPOLLPRI;
+            }
+        }
+
+        if (!events) {
+            always_ready_fds.remove(fd);
+            // NOTE: The fd may have been closed already, in which case the kernel has forgotten about it.
+            (void)Core::System::epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+            return;
+        }
+
+        epoll_event event {};
+        event.events = events;
+        event.data.fd = fd;
+        auto result = Core::System::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+        if (result.is_error() && result.error().code() == ENOENT)
+            result = Core::System::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+        if (result.is_error() && result.error().code() == EPERM) {
+            // Regular files and directories can't be watched, but they're always ready anyway.
+            always_ready_fds.set(fd);
+            return;
+        }
+        if (result.is_error())
+            dbgln("EventLoopImplementationUnix: Failed to watch fd {}: {}", fd, result.error());
+    }
+#endif
+
     // Each thread has its own timers, notifiers and a wake pipe.
     HashMap<int, NonnullOwnPtr<EventLoopTimer>> timers;
     HashTable<Notifier*> notifiers;
 
+#ifdef EVENT_LOOP_USES_EPOLL
+    // The kernel keeps track of which fds we're interested in, so we only need to find the notifiers for ready fds.
+    int epoll_fd { -1 };
+    HashMap<int, Vector<Notifier*, 1>> notifiers_by_fd;
+    HashTable<int> always_ready_fds;
+#endif
+
     // The wake pipe is used to notify another event loop that someone has called wake(), or a signal has been received.
     // wake() writes 0i32 into the pipe, signals write the signal number (guaranteed non-zero).
     int wake_pipe_fds[2] { -1, -1 };
@@ -139,6 +206,166 @@ void EventLoopImplementationUnix::wake()
     MUST(Core::System::write((*m_wake_pipe_fds)[1], { &wake_event, sizeof(wake_event) }));
 }
 
+// Figure out how long to wait at maximum, or return an empty Optional to wait until something happens.
+// This mainly depends on the PumpMode and whether we have pending events, but also the next expiring timer.
+static Optional<Duration> compute_wait_timeout(EventLoopImplementation::PumpMode mode)
+{
+    bool has_pending_events = ThreadEventQueue::current().has_pending_events();
+    if (mode != EventLoopImplementation::PumpMode::WaitForEvents || has_pending_events)
+        return Duration::zero();
+
+    auto next_timer_expiration = EventLoopManagerUnix::get_next_timer_expiration();
+    if (!next_timer_expiration.has_value())
+        return {};
+
+    auto now = MonotonicTime::now_coarse();
+    auto computed_timeout = next_timer_expiration.value() - now;
+    if (computed_timeout.is_negative())
+        computed_timeout = Duration::zero();
+    return computed_timeout;
+}
+
+// We woke up due to a call to wake() or a POSIX signal.
+// Handle signals and see whether we need to handle events as well.
+EventLoopManagerUnix::WakePipeResult EventLoopManagerUnix::handle_wake_pipe()
+{
+    auto& thread_data = ThreadData::the();
+
+    int wake_events[8];
+    ssize_t nread;
+    // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
+    // but we get interrupted. Therefore, just retry while we were interrupted.
+    do {
+        errno = 0;
+        nread = read(thread_data.wake_pipe_fds[0], wake_events, sizeof(wake_events));
+        if (nread == 0)
+            break;
+    } while (nread < 0 && errno == EINTR);
+    if (nread < 0) {
+        perror("EventLoopImplementationUnix::wait_for_events: read from wake pipe");
+        VERIFY_NOT_REACHED();
+    }
+    VERIFY(nread > 0);
+    bool wake_requested = false;
+    int event_count = nread / sizeof(wake_events[0]);
+    for (int i = 0; i < event_count; i++) {
+        if (wake_events[i] != 0)
+            dispatch_signal(wake_events[i]);
+        else
+            wake_requested = true;
+    }
+
+    if (!wake_requested && nread == sizeof(wake_events))
+        return WakePipeResult::ShouldWaitAgain;
+    return WakePipeResult::Done;
+}
+
+static void handle_expired_timers()
+{
+    auto& thread_data = ThreadData::the();
+    if (thread_data.timers.is_empty())
+        return;
+
+    auto now = MonotonicTime::now_coarse();
+
+    for (auto& it : thread_data.timers) {
+        auto& timer = *it.value;
+        if (!timer.has_expired(now))
+            continue;
+        auto owner = timer.owner.strong_ref();
+        if (timer.fire_when_not_visible == TimerShouldFireWhenNotVisible::No
+            && owner && !owner->is_visible_for_timer_purposes()) {
+            continue;
+        }
+
+        if (owner)
+            ThreadEventQueue::current().post_event(*owner, make<TimerEvent>(timer.timer_id));
+        if (timer.should_reload) {
+            timer.reload(now);
+        } else {
+            // FIXME: Support removing expired timers that don't want to reload.
+            VERIFY_NOT_REACHED();
+        }
+    }
+}
+
+#ifdef EVENT_LOOP_USES_EPOLL
+static bool notifier_wants(Notifier const& notifier, u32 events)
+{
+    switch (notifier.type()) {
+    case Notifier::Type::Read:
+        return events & (EPOLLIN | EPOLLHUP | EPOLLERR);
+    case Notifier::Type::Write:
+        return events & (EPOLLOUT | EPOLLHUP | EPOLLERR);
+    case Notifier::Type::Exceptional:
+        return events & EPOLLPRI;
+    case Notifier::Type::None:
+        return false;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+void EventLoopManagerUnix::wait_for_events(EventLoopImplementation::PumpMode mode)
+{
+    auto& thread_data = ThreadData::the();
+
+    Array<epoll_event, 64> events;
+    int ready_fd_count = 0;
+
+retry:
+    auto timeout = compute_wait_timeout(mode);
+    // Files that can't be watched with epoll (i.e. regular files) are always ready, just like select() would say.
+    if (!thread_data.always_ready_fds.is_empty())
+        timeout = Duration::zero();
+
+    int timeout_ms = -1;
+    if (timeout.has_value()) {
+        // Round up, so we don't wake up right before the next timer expires and then have to wait again.
+        timeout_ms = static_cast<int>(min<i64>((timeout->to_microseconds() + 999) / 1000, NumericLimits<int>::max()));
+    }
+
+    // Wait for file system events, calls to wake(), POSIX signals, or timer expirations.
+    // Unlike with select(), the kernel keeps track of the fds we're interested in, so this doesn't cost O(notifiers).
+    for (;;) {
+        ready_fd_count = epoll_wait(thread_data.epoll_fd, events.data(), events.size(), timeout_ms);
+        if (ready_fd_count >= 0)
+            break;
+        // Because POSIX, we might spuriously return from epoll_wait() with EINTR; just wait again.
+        int saved_errno = errno;
+        if (saved_errno != EINTR) {
+            dbgln("EventLoopImplementationUnix::wait_for_events: {} ({}: {})", ready_fd_count, saved_errno, strerror(saved_errno));
+            VERIFY_NOT_REACHED();
+        }
+    }
+
+    for (int i = 0; i < ready_fd_count; ++i) {
+        if (events[i].data.fd != thread_data.wake_pipe_fds[0])
+            continue;
+        if (handle_wake_pipe() == WakePipeResult::ShouldWaitAgain)
+            goto retry;
+    }
+
+    handle_expired_timers();
+
+    // Handle file system notifiers by making them normal events.
+    auto post_activations = [&](int fd, u32 ready_events) {
+        auto it = thread_data.notifiers_by_fd.find(fd);
+        if (it == thread_data.notifiers_by_fd.end())
+            return;
+        for (auto* notifier : it->value) {
+            if (notifier_wants(*notifier, ready_events))
+                ThreadEventQueue::current().post_event(*notifier, make<NotifierActivationEvent>(fd));
+        }
+    };
+
+    for (int i = 0; i < ready_fd_count; ++i) {
+        if (events[i].data.fd != thread_data.wake_pipe_fds[0])
+            post_activations(events[i].data.fd, events[i].events);
+    }
+    for (int fd : thread_data.always_ready_fds)
+        post_activations(fd, EPOLLIN | EPOLLOUT);
+}
+#else
 void EventLoopManagerUnix::wait_for_events(EventLoopImplementation::PumpMode mode)
 {
     auto& thread_data = ThreadData::the();
@@ -165,28 +392,14 @@ retry:
             TODO();
     }
 
-    bool has_pending_events = ThreadEventQueue::current().has_pending_events();
-
-    // Figure out how long to wait at maximum.
-    // This mainly depends on the PumpMode and whether we have pending events, but also the next expiring timer.
     struct timeval timeout = { 0, 0 };
-    bool should_wait_forever = false;
-    if (mode == EventLoopImplementation::PumpMode::WaitForEvents && !has_pending_events) {
-        auto next_timer_expiration = get_next_timer_expiration();
-        if (next_timer_expiration.has_value()) {
-            auto now = MonotonicTime::now_coarse();
-            auto computed_timeout = next_timer_expiration.value() - now;
-            if (computed_timeout.is_negative())
-                computed_timeout = Duration::zero();
-            timeout = computed_timeout.to_timeval();
-        } else {
-            should_wait_forever = true;
-        }
-    }
+    auto computed_timeout = compute_wait_timeout(mode);
+    if (computed_timeout.has_value())
+        timeout = computed_timeout->to_timeval();
 
 try_select_again:
     // select() and wait for file system events, calls to wake(), POSIX signals, or timer expirations.
-    int marked_fd_count = select(max_fd + 1, &read_fds, &write_fds, nullptr, should_wait_forever ? nullptr : &timeout);
+    int marked_fd_count = select(max_fd + 1, &read_fds, &write_fds, nullptr, computed_timeout.has_value() ? &timeout : nullptr);
     // Because POSIX, we might spuriously return from select() with EINTR; just select again.
     if (marked_fd_count < 0) {
         int saved_errno = errno;
@@ -196,61 +409,12 @@ try_select_again:
         VERIFY_NOT_REACHED();
     }
 
-    // We woke up due to a call to wake() or a POSIX signal.
-    // Handle signals and see whether we need to handle events as well.
     if (FD_ISSET(thread_data.wake_pipe_fds[0], &read_fds)) {
-        int wake_events[8];
-        ssize_t nread;
-        // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
-        // but we get interrupted. Therefore, just retry while we were interrupted.
-        do {
-            errno = 0;
-            nread = read(thread_data.wake_pipe_fds[0], wake_events, sizeof(wake_events));
-            if (nread == 0)
-                break;
-        } while (nread < 0 && errno == EINTR);
-        if (nread < 0) {
-            perror("EventLoopImplementationUnix::wait_for_events: read from wake pipe");
-            VERIFY_NOT_REACHED();
-        }
-        VERIFY(nread > 0);
-        bool wake_requested = false;
-        int event_count = nread / sizeof(wake_events[0]);
-        for (int i = 0; i < event_count; i++) {
-            if (wake_events[i] != 0)
-                dispatch_signal(wake_events[i]);
-            else
-                wake_requested = true;
-        }
-
-        if (!wake_requested && nread == sizeof(wake_events))
+        if (handle_wake_pipe() == WakePipeResult::ShouldWaitAgain)
             goto retry;
     }
 
-    // Handle expired timers.
-    if (!thread_data.timers.is_empty()) {
-        auto now = MonotonicTime::now_coarse();
-
-        for (auto& it : thread_data.timers) {
-            auto& timer = *it.value;
-            if (!timer.has_expired(now))
-                continue;
-            auto owner = timer.owner.strong_ref();
-            if (timer.fire_when_not_visible == TimerShouldFireWhenNotVisible::No
-                && owner && !owner->is_visible_for_timer_purposes()) {
-                continue;
-            }
-
-            if (owner)
-                ThreadEventQueue::current().post_event(*owner, make<TimerEvent>(timer.timer_id));
-            if (timer.should_reload) {
-                timer.reload(now);
-            } else {
-                // FIXME: Support removing expired timers that don't want to reload.
-                VERIFY_NOT_REACHED();
-            }
-        }
-    }
+    handle_expired_timers();
 
     if (!marked_fd_count)
         return;
@@ -265,6 +429,7 @@ try_select_again:
         }
     }
 }
+#endif
 
 class SignalHandlers : public RefCounted<SignalHandlers> {
     AK_MAKE_NONCOPYABLE(SignalHandlers);
@@ -505,12 +670,28 @@ bool EventLoopManagerUnix::unregister_timer(int timer_id)
 
 void EventLoopManagerUnix::register_notifier(Notifier& notifier)
 {
-    ThreadData::the().notifiers.set(&notifier);
+    auto& thread_data = ThreadData::the();
+    if (thread_data.notifiers.set(&notifier) != HashSetResult::InsertedNewEntry)
+        return;
+#ifdef EVENT_LOOP_USES_EPOLL
+    thread_data.notifiers_by_fd.ensure(notifier.fd()).append(&notifier);
+    thread_data.update_epoll_interest(notifier.fd());
+#endif
 }
 
 void EventLoopManagerUnix::unregister_notifier(Notifier& notifier)
 {
-    ThreadData::the().notifiers.remove(&notifier);
+    auto& thread_data = ThreadData::the();
+    if (!thread_data.notifiers.remove(&notifier))
+        return;
+#ifdef EVENT_LOOP_USES_EPOLL
+    auto it = thread_data.notifiers_by_fd.find(notifier.fd());
+    VERIFY(it != thread_data.notifiers_by_fd.end());
+    it->value.remove_first_matching([&](auto* other) { return other == &notifier; });
+    if (it->value.is_empty())
+        thread_data.notifiers_by_fd.remove(it);
+    thread_data.update_epoll_interest(notifier.fd());
+#endif
 }
 
 void EventLoopManagerUnix::did_post_event()
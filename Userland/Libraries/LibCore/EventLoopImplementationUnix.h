@@ -32,6 +32,13 @@ public:
     static Optional<MonotonicTime> get_next_timer_expiration();
 
 private:
+    enum class WakePipeResult {
+        Done,
+        // The pipe was full of signals and we haven't seen a wake() yet, so there may be more to read.
+        ShouldWaitAgain,
+    };
+    WakePipeResult handle_wake_pipe();
+
     void dispatch_signal(int signal_number);
     static void handle_signal(int signal_number);
 };
@@ -27,12 +27,26 @@ void Notifier::set_enabled(bool enabled)
 {
     if (m_fd < 0)
         return;
+    m_is_enabled = enabled;
     if (enabled)
         Core::EventLoop::register_notifier({}, *this);
     else
         Core::EventLoop::unregister_notifier({}, *this);
 }
 
+void Notifier::set_type(Type type)
+{
+    if (m_type == type)
+        return;
+
+    // The event loop may have told the kernel what we're waiting for, so it has to hear about the change.
+    if (m_is_enabled)
+        Core::EventLoop::unregister_notifier({}, *this);
+    m_type = type;
+    if (m_is_enabled && m_type != Type::None)
+        Core::EventLoop::register_notifier({}, *this);
+}
+
 void Notifier::close()
 {
     if (m_fd < 0)
@@ -125,6 +125,25 @@ ErrorOr<size_t> PosixSocketHelper::write(ReadonlyBytes buffer, int flags)
     return TRY(System::send(m_fd, buffer.data(), buffer.size(), flags));
 }
 
+ErrorOr<size_t> PosixSocketHelper::send_file(int in_fd, off_t& offset, size_t count)
+{
+    if (!is_open()) {
+        return Error::from_errno(ENOTCONN);
+    }
+
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+    return System::sendfile(m_fd, in_fd, &offset, count);
+#else
+    u8 buffer[4 * KiB];
+    auto nread = ::pread(in_fd, buffer, min(count, sizeof(buffer)), offset);
+    if (nread < 0)
+        return Error::from_syscall("pread"sv, -errno);
+    auto nsent = TRY(System::send(m_fd, buffer, nread, 0));
+    offset += nsent;
+    return nsent;
+#endif
+}
+
 void PosixSocketHelper::close()
 {
     if (!is_open()) {
@@ -131,6 +131,8 @@ public:
 
     ErrorOr<Bytes> read(Bytes, int flags);
     ErrorOr<size_t> write(ReadonlyBytes, int flags);
+    // Sends up to count bytes of in_fd, starting at offset, and advances offset past what was sent.
+    ErrorOr<size_t> send_file(int in_fd, off_t& offset, size_t count);
 
     bool is_eof() const { return !is_open() || m_last_read_was_eof; }
     bool is_open() const { return m_fd != -1; }
@@ -191,6 +193,9 @@ public:
     ErrorOr<void> set_blocking(bool enabled) override { return m_helper.set_blocking(enabled); }
     ErrorOr<void> set_close_on_exec(bool enabled) override { return m_helper.set_close_on_exec(enabled); }
 
+    // Sends the file's contents without copying them through userspace, where the system supports it.
+    ErrorOr<size_t> send_file(int in_fd, off_t& offset, size_t count) { return m_helper.send_file(in_fd, offset, count); }
+
     virtual ~TCPSocket() override { close(); }
 
 private:
@@ -400,6 +405,11 @@ public:
 
     virtual ErrorOr<Bytes> read_some(Bytes buffer) override { return m_helper.read(move(buffer)); }
     virtual ErrorOr<size_t> write_some(ReadonlyBytes buffer) override { return m_helper.stream().write_some(buffer); }
+    ErrorOr<size_t> send_file(int in_fd, off_t& offset, size_t count)
+    requires(requires(T& stream) { stream.send_file(in_fd, offset, count); })
+    {
+        return m_helper.stream().send_file(in_fd, offset, count);
+    }
     virtual bool is_eof() const override { return m_helper.is_eof(); }
     virtual bool is_open() const override { return m_helper.stream().is_open(); }
     virtual void close() override { m_helper.stream().close(); }
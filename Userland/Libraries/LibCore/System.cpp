@@ -1752,6 +1752,55 @@ ErrorOr<int> poll(Span<struct pollfd> poll_fds, int timeout)
     return { rc };
 }
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+ErrorOr<int> epoll_create1(int flags)
+{
+    int rc = ::epoll_create1(flags);
+    if (rc < 0)
+        return Error::from_syscall("epoll_create1"sv, -errno);
+    return rc;
+}
+
+ErrorOr<void> epoll_ctl(int epoll_fd, int op, int fd, struct epoll_event* event)
+{
+    if (::epoll_ctl(epoll_fd, op, fd, event) < 0)
+        return Error::from_syscall("epoll_ctl"sv, -errno);
+    return {};
+}
+
+ErrorOr<int> epoll_wait(int epoll_fd, Span<struct epoll_event> events, int timeout)
+{
+    int rc = ::epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), timeout);
+    if (rc < 0)
+        return Error::from_syscall("epoll_wait"sv, -errno);
+    return rc;
+}
+
+ErrorOr<size_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    auto rc = ::sendfile(out_fd, in_fd, offset, count);
+    if (rc < 0)
+        return Error::from_syscall("sendfile"sv, -errno);
+    return static_cast<size_t>(rc);
+}
+
+ErrorOr<size_t> sendmmsg(int sockfd, Span<struct mmsghdr> messages, int flags)
+{
+    int rc = ::sendmmsg(sockfd, messages.data(), messages.size(), flags);
+    if (rc < 0)
+        return Error::from_syscall("sendmmsg"sv, -errno);
+    return static_cast<size_t>(rc);
+}
+
+ErrorOr<size_t> recvmmsg(int sockfd, Span<struct mmsghdr> messages, int flags, struct timespec* timeout)
+{
+    int rc = ::recvmmsg(sockfd, messages.data(), messages.size(), flags, timeout);
+    if (rc < 0)
+        return Error::from_syscall("recvmmsg"sv, -errno);
+    return static_cast<size_t>(rc);
+}
+#endif
+
 #ifdef AK_OS_SERENITY
 ErrorOr<void> posix_fallocate(int fd, off_t offset, off_t length)
 {
@@ -35,6 +35,11 @@
 #    include <Kernel/API/Jail.h>
 #endif
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+#    include <sys/epoll.h>
+#    include <sys/sendfile.h>
+#endif
+
 #if !defined(AK_OS_BSD_GENERIC) && !defined(AK_OS_ANDROID)
 #    include <shadow.h>
 #endif
@@ -238,6 +243,15 @@ ErrorOr<void> access(StringView pathname, int mode, int flags = 0);
 ErrorOr<ByteString> readlink(StringView pathname);
 ErrorOr<int> poll(Span<struct pollfd>, int timeout);
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+ErrorOr<int> epoll_create1(int flags);
+ErrorOr<void> epoll_ctl(int epoll_fd, int op, int fd, struct epoll_event*);
+ErrorOr<int> epoll_wait(int epoll_fd, Span<struct epoll_event>, int timeout);
+ErrorOr<size_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+ErrorOr<size_t> sendmmsg(int sockfd, Span<struct mmsghdr>, int flags);
+ErrorOr<size_t> recvmmsg(int sockfd, Span<struct mmsghdr>, int flags, struct timespec* timeout = nullptr);
+#endif
+
 #ifdef AK_OS_SERENITY
 ErrorOr<void> create_block_device(StringView name, mode_t mode, unsigned major, unsigned minor);
 ErrorOr<void> create_char_device(StringView name, mode_t mode, unsigned major, unsigned minor);
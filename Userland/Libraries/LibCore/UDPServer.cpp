@@ -72,6 +72,97 @@ ErrorOr<ByteBuffer> UDPServer::receive(size_t size, sockaddr_in& in)
     return buf;
 }
 
+ErrorOr<Vector<UDPServer::Datagram>> UDPServer::receive_batch(size_t max_count, size_t max_size)
+{
+    Vector<Datagram> datagrams;
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+    // All datagrams land in one scratch buffer, so we don't allocate room for datagrams that never arrive.
+    if (m_batch_buffer.size() < max_count * max_size)
+        TRY(m_batch_buffer.try_resize(max_count * max_size));
+
+    Vector<struct mmsghdr> messages;
+    Vector<struct iovec> iovecs;
+    Vector<sockaddr_in> addresses;
+    TRY(messages.try_resize(max_count));
+    TRY(iovecs.try_resize(max_count));
+    TRY(addresses.try_resize(max_count));
+    for (size_t i = 0; i < max_count; ++i) {
+        iovecs[i] = { m_batch_buffer.data() + i * max_size, max_size };
+        messages[i] = {};
+        messages[i].msg_hdr.msg_name = &addresses[i];
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    auto count = TRY(Core::System::recvmmsg(m_fd, messages, MSG_DONTWAIT));
+    TRY(datagrams.try_ensure_capacity(count));
+    for (size_t i = 0; i < count; ++i) {
+        auto data = TRY(ByteBuffer::copy(m_batch_buffer.span().slice(i * max_size, min<size_t>(messages[i].msg_len, max_size))));
+        datagrams.unchecked_append({ move(data), addresses[i] });
+    }
+#else
+    while (datagrams.size() < max_count) {
+        Datagram datagram;
+        auto data_or_error = receive(max_size, datagram.address);
+        if (data_or_error.is_error()) {
+            if (datagrams.is_empty() || data_or_error.error().code() != EAGAIN)
+                return data_or_error.release_error();
+            break;
+        }
+        datagram.data = data_or_error.release_value();
+        TRY(datagrams.try_append(move(datagram)));
+    }
+#endif
+    return datagrams;
+}
+
+ErrorOr<size_t> UDPServer::send_batch(ReadonlySpan<Datagram> datagrams)
+{
+    if (m_fd < 0) {
+        return Error::from_errno(EBADF);
+    }
+
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+    Vector<struct mmsghdr> messages;
+    Vector<struct iovec> iovecs;
+    TRY(messages.try_resize(datagrams.size()));
+    TRY(iovecs.try_resize(datagrams.size()));
+    for (size_t i = 0; i < datagrams.size(); ++i) {
+        iovecs[i] = { const_cast<u8*>(datagrams[i].data.data()), datagrams[i].data.size() };
+        messages[i] = {};
+        messages[i].msg_hdr.msg_name = const_cast<sockaddr_in*>(&datagrams[i].address);
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t sent = 0;
+    while (sent < messages.size()) {
+        auto count_or_error = Core::System::sendmmsg(m_fd, messages.span().slice(sent), 0);
+        if (count_or_error.is_error()) {
+            if (sent == 0)
+                return count_or_error.release_error();
+            break;
+        }
+        sent += count_or_error.value();
+    }
+    return sent;
+#else
+    size_t sent = 0;
+    for (auto& datagram : datagrams) {
+        auto result = send(datagram.data, datagram.address);
+        if (result.is_error()) {
+            if (sent == 0)
+                return result.release_error();
+            break;
+        }
+        ++sent;
+    }
+    return sent;
+#endif
+}
+
 Optional<IPv4Address> UDPServer::local_address() const
 {
     if (m_fd == -1)
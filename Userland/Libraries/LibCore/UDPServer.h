@@ -10,6 +10,7 @@
 #include <AK/ByteBuffer.h>
 #include <AK/Forward.h>
 #include <AK/Function.h>
+#include <AK/Vector.h>
 #include <LibCore/EventReceiver.h>
 #include <LibCore/Forward.h>
 #include <LibCore/SocketAddress.h>
@@ -33,6 +34,16 @@ public:
 
     ErrorOr<size_t> send(ReadonlyBytes, sockaddr_in const& to);
 
+    struct Datagram {
+        ByteBuffer data;
+        sockaddr_in address {};
+    };
+
+    // These move many datagrams with a single system call where the system supports it.
+    // Receiving returns whatever is queued, up to max_count datagrams, and sending returns how many datagrams went out.
+    ErrorOr<Vector<Datagram>> receive_batch(size_t max_count, size_t max_size);
+    ErrorOr<size_t> send_batch(ReadonlySpan<Datagram>);
+
     Optional<IPv4Address> local_address() const;
     Optional<u16> local_port() const;
 
@@ -47,6 +58,7 @@ private:
     int m_fd { -1 };
     bool m_bound { false };
     RefPtr<Notifier> m_notifier;
+    ByteBuffer m_batch_buffer;
 };
 
 }
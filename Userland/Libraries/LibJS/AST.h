@@ -320,6 +320,7 @@ public:
     void block_declaration_instantiation(VM&, Environment*) const;
 
     ThrowCompletionOr<void> for_each_function_hoistable_with_annexB_extension(ThrowCompletionOrVoidCallback<FunctionDeclaration&>&& callback) const;
+    bool has_functions_hoistable_with_annexB_extension() const { return !m_functions_hoistable_with_annexB_extension.is_empty(); }
 
     Vector<DeprecatedFlyString> const& local_variables_names() const { return m_local_variables_names; }
     size_t add_local_variable(DeprecatedFlyString name)
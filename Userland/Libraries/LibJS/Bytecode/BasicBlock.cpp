@@ -57,4 +57,27 @@ void BasicBlock::grow(size_t additional_size)
     m_buffer.resize(m_buffer.size() + additional_size);
 }
 
+Vector<u8> BasicBlock::take_instruction_stream()
+{
+    m_terminated = false;
+    return move(m_buffer);
+}
+
+void BasicBlock::set_instruction_stream(Vector<u8> buffer)
+{
+    VERIFY(m_buffer.is_empty());
+    m_buffer = move(buffer);
+    m_terminated = terminator() != nullptr;
+}
+
+Instruction const* BasicBlock::terminator() const
+{
+    Instruction const* last_instruction = nullptr;
+    for (InstructionStreamIterator it(instruction_stream()); !it.at_end(); ++it)
+        last_instruction = &*it;
+    if (!last_instruction || !last_instruction->is_terminator())
+        return nullptr;
+    return last_instruction;
+}
+
 }
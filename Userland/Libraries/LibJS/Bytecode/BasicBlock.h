@@ -16,6 +16,8 @@ namespace JS::Bytecode {
 struct UnwindInfo {
     JS::GCPtr<Executable const> executable;
     JS::GCPtr<Environment> lexical_environment;
+    // The jump that is pending while the `try` and `catch` blocks of this context run. Exceptions handled here don't cancel it.
+    BasicBlock const* scheduled_jump { nullptr };
 
     bool handler_called { false };
 };
@@ -35,6 +37,12 @@ public:
 
     void grow(size_t additional_size);
 
+    // Used by optimization passes to rebuild the block. The caller takes over the instructions in the returned stream.
+    Vector<u8> take_instruction_stream();
+    void set_instruction_stream(Vector<u8>);
+
+    Instruction const* terminator() const;
+
     void terminate(Badge<Generator>) { m_terminated = true; }
     bool is_terminated() const { return m_terminated; }
 
@@ -72,6 +72,23 @@ ThrowCompletionOr<NonnullGCPtr<Object>> base_object_for_get(VM& vm, Value base_v
     return base_value.to_object(vm);
 }
 
+static Optional<u32> cached_property_offset(PropertyLookupCache const& cache, MegamorphicPropertyCache const& megamorphic_cache, Shape const& shape, DeprecatedFlyString const& property)
+{
+    if (auto property_offset = cache.property_offset_for(shape); property_offset.has_value())
+        return property_offset;
+    if (cache.is_megamorphic)
+        return megamorphic_cache.property_offset_for(shape, property);
+    return {};
+}
+
+static void cache_property_offset(PropertyLookupCache& cache, MegamorphicPropertyCache& megamorphic_cache, Shape& shape, DeprecatedFlyString const& property, u32 property_offset)
+{
+    if (!cache.is_megamorphic && cache.add(shape, property_offset))
+        return;
+    cache.is_megamorphic = true;
+    megamorphic_cache.set(shape, property, property_offset);
+}
+
 ThrowCompletionOr<Value> get_by_id(VM& vm, DeprecatedFlyString const& property, Value base_value, Value this_value, PropertyLookupCache& cache)
 {
     if (base_value.is_string()) {
@@ -82,19 +99,17 @@ ThrowCompletionOr<Value> get_by_id(VM& vm, DeprecatedFlyString const& property,
 
     auto base_obj = TRY(base_object_for_get(vm, base_value));
 
-    // OPTIMIZATION: If the shape of the object hasn't changed, we can use the cached property offset.
+    // OPTIMIZATION: If we've seen an object with this shape here before, we can use the cached property offset.
     auto& shape = base_obj->shape();
-    if (&shape == cache.shape) {
-        return base_obj->get_direct(cache.property_offset.value());
-    }
+    auto& megamorphic_cache = vm.bytecode_interpreter().megamorphic_get_cache();
+    if (auto property_offset = cached_property_offset(cache, megamorphic_cache, shape, property); property_offset.has_value())
+        return base_obj->get_direct(*property_offset);
 
     CacheablePropertyMetadata cacheable_metadata;
     auto value = TRY(base_obj->internal_get(property, this_value, &cacheable_metadata));
 
-    if (cacheable_metadata.type == CacheablePropertyMetadata::Type::OwnProperty) {
-        cache.shape = shape;
-        cache.property_offset = cacheable_metadata.property_offset.value();
-    }
+    if (cacheable_metadata.type == CacheablePropertyMetadata::Type::OwnProperty)
+        cache_property_offset(cache, megamorphic_cache, shape, property, cacheable_metadata.property_offset.value());
 
     return value;
 }
@@ -172,15 +187,18 @@ ThrowCompletionOr<Value> get_global(Bytecode::Interpreter& interpreter, Deprecat
     auto& binding_object = realm.global_environment().object_record().binding_object();
     auto& declarative_record = realm.global_environment().declarative_record();
 
-    // OPTIMIZATION: If the shape of the object hasn't changed, we can use the cached property offset.
+    // OPTIMIZATION: If the global object had this shape here before, we can use the cached property offset.
     auto& shape = binding_object.shape();
-    if (cache.environment_serial_number == declarative_record.environment_serial_number()
-        && &shape == cache.shape) {
-        return binding_object.get_direct(cache.property_offset.value());
+    auto& megamorphic_cache = interpreter.megamorphic_get_cache();
+    if (cache.environment_serial_number == declarative_record.environment_serial_number()) {
+        if (auto property_offset = cached_property_offset(cache, megamorphic_cache, shape, identifier); property_offset.has_value())
+            return binding_object.get_direct(*property_offset);
+    } else {
+        // New lexical bindings may shadow properties we've cached.
+        cache.clear();
+        cache.environment_serial_number = declarative_record.environment_serial_number();
     }
 
-    cache.environment_serial_number = declarative_record.environment_serial_number();
-
     if (vm.running_execution_context().script_or_module.has<NonnullGCPtr<Module>>()) {
         // NOTE: GetGlobal is used to access variables stored in the module environment and global environment.
         //       The module environment is checked first since it precedes the global environment in the environment chain.
@@ -199,10 +217,8 @@ ThrowCompletionOr<Value> get_global(Bytecode::Interpreter& interpreter, Deprecat
     if (TRY(binding_object.has_property(identifier))) {
         CacheablePropertyMetadata cacheable_metadata;
         auto value = TRY(binding_object.internal_get(identifier, js_undefined(), &cacheable_metadata));
-        if (cacheable_metadata.type == CacheablePropertyMetadata::Type::OwnProperty) {
-            cache.shape = shape;
-            cache.property_offset = cacheable_metadata.property_offset.value();
-        }
+        if (cacheable_metadata.type == CacheablePropertyMetadata::Type::OwnProperty)
+            cache_property_offset(cache, megamorphic_cache, shape, identifier, cacheable_metadata.property_offset.value());
         return value;
     }
 
@@ -237,18 +253,23 @@ ThrowCompletionOr<void> put_by_property_key(VM& vm, Value base, Value this_value
         break;
     }
     case Op::PropertyKind::KeyValue: {
-        if (cache && cache->shape == &object->shape()) {
-            object->put_direct(*cache->property_offset, value);
-            return {};
+        // Puts have a megamorphic cache of their own, which only has writable data properties in it.
+        auto& megamorphic_cache = vm.bytecode_interpreter().megamorphic_put_cache();
+        if (cache && name.is_string()) {
+            if (auto property_offset = cached_property_offset(*cache, megamorphic_cache, object->shape(), name.as_string()); property_offset.has_value()) {
+                object->put_direct(*property_offset, value);
+                return {};
+            }
         }
 
         CacheablePropertyMetadata cacheable_metadata;
         bool succeeded = TRY(object->internal_set(name, value, this_value, &cacheable_metadata));
 
-        if (succeeded && cache && cacheable_metadata.type == CacheablePropertyMetadata::Type::OwnProperty) {
-            cache->shape = object->shape();
-            cache->property_offset = cacheable_metadata.property_offset.value();
-        }
+        // The offset is only good for a direct put if [[Set]] wrote to a writable data property of the object itself.
+        // Dictionary shapes change the attributes of their properties in place, so they aren't cached for puts at all.
+        bool receiver_is_object = this_value.is_object() && &this_value.as_object() == object.ptr();
+        if (succeeded && receiver_is_object && !object->shape().is_dictionary() && cache && name.is_string() && cacheable_metadata.type == CacheablePropertyMetadata::Type::OwnProperty)
+            cache_property_offset(*cache, megamorphic_cache, object->shape(), name.as_string(), cacheable_metadata.property_offset.value());
 
         if (!succeeded && vm.in_strict_mode()) {
             if (base.is_object())
@@ -721,11 +742,13 @@ ThrowCompletionOr<void> append(VM& vm, Value lhs, Value rhs, bool is_spread)
         size_t i = lhs_size;
         TRY(get_iterator_values(vm, rhs, [&i, &lhs_array](Value iterator_value) -> Optional<Completion> {
             lhs_array.indexed_properties().put(i, iterator_value, default_attributes);
+            lhs_array.write_barrier();
             ++i;
             return {};
         }));
     } else {
         lhs_array.indexed_properties().put(lhs_size, rhs, default_attributes);
+        lhs_array.write_barrier();
     }
 
     return {};
@@ -9,6 +9,7 @@
 #include <LibJS/Bytecode/RegexTable.h>
 #include <LibJS/JIT/Compiler.h>
 #include <LibJS/JIT/NativeExecutable.h>
+#include <LibJS/Runtime/Shape.h>
 #include <LibJS/SourceCode.h>
 
 namespace JS::Bytecode {
@@ -23,6 +24,7 @@ Executable::Executable(
     size_t number_of_property_lookup_caches,
     size_t number_of_global_variable_caches,
     size_t number_of_environment_variable_caches,
+    size_t number_of_type_feedback_slots,
     size_t number_of_registers,
     Vector<NonnullOwnPtr<BasicBlock>> basic_blocks,
     bool is_strict_mode)
@@ -37,10 +39,44 @@ Executable::Executable(
     property_lookup_caches.resize(number_of_property_lookup_caches);
     global_variable_caches.resize(number_of_global_variable_caches);
     environment_variable_caches.resize(number_of_environment_variable_caches);
+    type_feedback.resize(number_of_type_feedback_slots);
 }
 
 Executable::~Executable() = default;
 
+bool PropertyLookupCache::add(Shape& shape, u32 property_offset)
+{
+    for (auto& entry : entries) {
+        if (!entry.shape) {
+            entry.shape = shape;
+            entry.property_offset = property_offset;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t MegamorphicPropertyCache::index_for(Shape const& shape, DeprecatedFlyString const& name)
+{
+    return pair_int_hash(ptr_hash(&shape), name.hash()) % entry_count;
+}
+
+Optional<u32> MegamorphicPropertyCache::property_offset_for(Shape const& shape, DeprecatedFlyString const& name) const
+{
+    auto const& entry = m_entries[index_for(shape, name)];
+    if (entry.shape != &shape || entry.name != name)
+        return {};
+    return entry.property_offset;
+}
+
+void MegamorphicPropertyCache::set(Shape& shape, DeprecatedFlyString const& name, u32 property_offset)
+{
+    auto& entry = m_entries[index_for(shape, name)];
+    entry.shape = shape;
+    entry.name = name;
+    entry.property_offset = property_offset;
+}
+
 void Executable::dump() const
 {
     dbgln("\033[33;1mJS::Bytecode::Executable\033[0m ({})", name);
@@ -56,13 +92,38 @@ void Executable::dump() const
     }
 }
 
+// How many times an executable runs in the interpreter (collecting type feedback) before we try to compile it.
+static u32 jit_warm_up_run_count()
+{
+    static u32 const run_count = [] {
+        if (auto const* value = getenv("LIBJS_JIT_WARM_UP"))
+            return StringView { value, strlen(value) }.to_number<u32>().value_or(1);
+        return 1u;
+    }();
+    return run_count;
+}
+
 JIT::NativeExecutable const* Executable::get_or_create_native_executable()
 {
     if (!m_did_try_jitting) {
+        if (m_interpreted_run_count < jit_warm_up_run_count()) {
+            ++m_interpreted_run_count;
+            return nullptr;
+        }
         m_did_try_jitting = true;
         m_native_executable = JIT::Compiler::compile(*this);
     }
     return m_native_executable;
 }
 
+void Executable::discard_native_executable(JIT::NativeExecutable const& native_executable)
+{
+    // We may already have discarded this native code when bailing out of it in a nested call.
+    if (m_native_executable.ptr() != &native_executable)
+        return;
+    m_discarded_native_executables.append(m_native_executable.release_nonnull());
+    m_did_try_jitting = false;
+    ++m_deoptimization_count;
+}
+
 }
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/DeprecatedFlyString.h>
 #include <AK/HashMap.h>
 #include <AK/NonnullOwnPtr.h>
@@ -25,12 +26,61 @@ class NativeExecutable;
 
 namespace JS::Bytecode {
 
+// A polymorphic inline cache: remembers where a property lives for up to max_number_of_shapes object shapes.
+// Once a site has seen more shapes than that, it is megamorphic, and uses the MegamorphicPropertyCache as well.
 struct PropertyLookupCache {
-    static FlatPtr shape_offset() { return OFFSET_OF(PropertyLookupCache, shape); }
-    static FlatPtr property_offset_offset() { return OFFSET_OF(PropertyLookupCache, property_offset); }
+    static constexpr size_t max_number_of_shapes = 4;
+
+    struct Entry {
+        static FlatPtr shape_offset() { return OFFSET_OF(Entry, shape); }
+        static FlatPtr property_offset_offset() { return OFFSET_OF(Entry, property_offset); }
+
+        WeakPtr<Shape> shape;
+        Optional<u32> property_offset;
+    };
+
+    static FlatPtr entry_offset(size_t index) { return OFFSET_OF(PropertyLookupCache, entries) + index * sizeof(Entry); }
+
+    Optional<u32> property_offset_for(Shape const& shape) const
+    {
+        for (auto const& entry : entries) {
+            if (entry.shape == &shape)
+                return entry.property_offset;
+        }
+        return {};
+    }
+
+    // Returns false if all entries are taken by other (live) shapes.
+    bool add(Shape&, u32 property_offset);
+
+    void clear()
+    {
+        entries = {};
+        is_megamorphic = false;
+    }
+
+    AK::Array<Entry, max_number_of_shapes> entries;
+    bool is_megamorphic { false };
+};
+
+// Shared by all megamorphic property lookup sites of one kind (gets or puts), keyed by shape and property name.
+class MegamorphicPropertyCache {
+public:
+    Optional<u32> property_offset_for(Shape const&, DeprecatedFlyString const& name) const;
+    void set(Shape&, DeprecatedFlyString const& name, u32 property_offset);
+
+private:
+    static constexpr size_t entry_count = 1024;
+
+    struct Entry {
+        WeakPtr<Shape> shape;
+        DeprecatedFlyString name;
+        u32 property_offset { 0 };
+    };
+
+    static size_t index_for(Shape const&, DeprecatedFlyString const& name);
 
-    WeakPtr<Shape> shape;
-    Optional<u32> property_offset;
+    AK::Array<Entry, entry_count> m_entries;
 };
 
 struct GlobalVariableCache : public PropertyLookupCache {
@@ -41,6 +91,21 @@ struct GlobalVariableCache : public PropertyLookupCache {
 
 using EnvironmentVariableCache = Optional<EnvironmentCoordinate>;
 
+// The kinds of values an arithmetic or comparison instruction has seen while running in the interpreter.
+// The JIT specializes the instruction for exactly these kinds, and deoptimizes back to the interpreter when it sees anything else.
+struct TypeFeedback {
+    enum ObservedType : u8 {
+        Int32 = 1 << 0,
+        Double = 1 << 1,
+        Other = 1 << 2,
+    };
+
+    bool has_observed_anything() const { return observed_types != 0; }
+    bool has_observed_only(u8 types) const { return has_observed_anything() && (observed_types & ~types) == 0; }
+
+    u8 observed_types { 0 };
+};
+
 struct SourceRecord {
     u32 source_start_offset {};
     u32 source_end_offset {};
@@ -59,6 +124,7 @@ public:
         size_t number_of_property_lookup_caches,
         size_t number_of_global_variable_caches,
         size_t number_of_environment_variable_caches,
+        size_t number_of_type_feedback_slots,
         size_t number_of_registers,
         Vector<NonnullOwnPtr<BasicBlock>>,
         bool is_strict_mode);
@@ -69,6 +135,7 @@ public:
     Vector<PropertyLookupCache> property_lookup_caches;
     Vector<GlobalVariableCache> global_variable_caches;
     Vector<EnvironmentVariableCache> environment_variable_caches;
+    Vector<TypeFeedback> type_feedback;
     Vector<NonnullOwnPtr<BasicBlock>> basic_blocks;
     NonnullOwnPtr<StringTable> string_table;
     NonnullOwnPtr<IdentifierTable> identifier_table;
@@ -86,9 +153,22 @@ public:
     JIT::NativeExecutable const* get_or_create_native_executable();
     JIT::NativeExecutable const* native_executable() const { return m_native_executable; }
 
+    // Called when native code bailed out to the interpreter because a type speculation failed.
+    // The native code is recompiled (with the updated type feedback) the next time we enter this executable.
+    void discard_native_executable(JIT::NativeExecutable const&);
+
+    // After this many deoptimizations, we stop speculating on types and compile generic code instead.
+    static constexpr u32 max_deoptimization_count = 4;
+    u32 deoptimization_count() const { return m_deoptimization_count; }
+
 private:
     OwnPtr<JIT::NativeExecutable> m_native_executable;
     bool m_did_try_jitting { false };
+
+    // Native code we've bailed out of may still be running further up the stack, so it's kept around until we die.
+    Vector<NonnullOwnPtr<JIT::NativeExecutable>> m_discarded_native_executables;
+    u32 m_deoptimization_count { 0 };
+    u32 m_interpreted_run_count { 0 };
 };
 
 }
@@ -10,6 +10,7 @@
 #include <LibJS/Bytecode/Generator.h>
 #include <LibJS/Bytecode/Instruction.h>
 #include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/PassManager.h>
 #include <LibJS/Bytecode/Register.h>
 #include <LibJS/Runtime/VM.h>
 
@@ -66,10 +67,13 @@ CodeGenerationErrorOr<NonnullGCPtr<Executable>> Generator::generate(VM& vm, ASTN
         generator.m_next_property_lookup_cache,
         generator.m_next_global_variable_cache,
         generator.m_next_environment_variable_cache,
+        generator.m_next_type_feedback_slot,
         generator.m_next_register,
         move(generator.m_root_basic_blocks),
         is_strict_mode);
 
+    PassManager::optimization_pipeline().perform(*executable);
+
     return executable;
 }
 
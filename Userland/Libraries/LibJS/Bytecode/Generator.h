@@ -74,6 +74,8 @@ public:
             m_current_basic_block->terminate({});
         auto* op = static_cast<OpType*>(slot);
         op->set_source_record({ m_current_ast_node->start_offset(), m_current_ast_node->end_offset() });
+        if constexpr (OpType::HasTypeFeedback)
+            op->set_type_feedback_slot(m_next_type_feedback_slot++);
     }
 
     template<typename OpType, typename... Args>
@@ -90,6 +92,8 @@ public:
             m_current_basic_block->terminate({});
         auto* op = static_cast<OpType*>(slot);
         op->set_source_record({ m_current_ast_node->start_offset(), m_current_ast_node->end_offset() });
+        if constexpr (OpType::HasTypeFeedback)
+            op->set_type_feedback_slot(m_next_type_feedback_slot++);
     }
 
     struct ReferenceRegisters {
@@ -271,6 +275,7 @@ private:
     u32 m_next_register { Register::reserved_register_count };
     u32 m_next_block { 1 };
     u32 m_next_property_lookup_cache { 0 };
+    u32 m_next_type_feedback_slot { 0 };
     u32 m_next_global_variable_cache { 0 };
     u32 m_next_environment_variable_cache { 0 };
     FunctionKind m_enclosing_function_kind { FunctionKind::Normal };
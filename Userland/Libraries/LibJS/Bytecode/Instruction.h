@@ -7,6 +7,7 @@
 #pragma once
 
 #include <AK/Forward.h>
+#include <AK/Function.h>
 #include <AK/Span.h>
 #include <LibJS/Bytecode/Executable.h>
 #include <LibJS/Forward.h>
@@ -125,6 +126,7 @@ namespace JS::Bytecode {
 class alignas(void*) Instruction {
 public:
     constexpr static bool IsTerminator = false;
+    constexpr static bool HasTypeFeedback = false;
 
     enum class Type {
 #define __BYTECODE_OP(op) \
@@ -137,6 +139,8 @@ public:
     size_t length() const { return m_length; }
     ByteString to_byte_string(Bytecode::Executable const&) const;
     ThrowCompletionOr<void> execute(Bytecode::Interpreter&) const;
+    bool is_terminator() const;
+    void visit_labels(Function<void(Label&)> const&);
     static void destroy(Instruction&);
 
     // FIXME: Find a better way to organize this information
@@ -150,6 +154,8 @@ protected:
     {
     }
 
+    void visit_labels_impl(Function<void(Label&)> const&) { }
+
 private:
     SourceRecord m_source_record {};
     Type m_type {};
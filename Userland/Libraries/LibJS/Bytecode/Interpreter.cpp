@@ -194,14 +194,14 @@ ThrowCompletionOr<Value> Interpreter::run(SourceTextModule& module)
     return js_undefined();
 }
 
-void Interpreter::run_bytecode()
+void Interpreter::run_bytecode(size_t entry_point_offset)
 {
     auto* locals = vm().running_execution_context().locals.data();
     auto* registers = this->registers().data();
     auto& accumulator = this->accumulator();
     for (;;) {
     start:
-        auto pc = InstructionStreamIterator { m_current_block->instruction_stream(), m_current_executable };
+        auto pc = InstructionStreamIterator { m_current_block->instruction_stream(), m_current_executable, exchange(entry_point_offset, 0) };
         TemporaryChange temp_change { m_pc, Optional<InstructionStreamIterator&>(pc) };
 
         bool will_return = false;
@@ -256,10 +256,19 @@ void Interpreter::run_bytecode()
                 else
                     m_current_block = &static_cast<Op::Jump const&>(instruction).false_target()->block();
                 goto start;
-            case Instruction::Type::EnterUnwindContext:
+            case Instruction::Type::EnterUnwindContext: {
+                auto const& entry_point = static_cast<Op::EnterUnwindContext const&>(instruction).entry_point().block();
                 enter_unwind_context();
-                m_current_block = &static_cast<Op::EnterUnwindContext const&>(instruction).entry_point().block();
+                // Only a `finally` block ends in a ContinuePendingUnwind, which picks up the scheduled jump again.
+                // A `try` with just a `catch` has to leave it alone, e.g. for a `break` that is running a finalizer.
+                if (entry_point.finalizer()) {
+                    call_frame().previously_scheduled_jumps.append(m_scheduled_jump);
+                    m_scheduled_jump = nullptr;
+                }
+                unwind_contexts().last().scheduled_jump = m_scheduled_jump;
+                m_current_block = &entry_point;
                 goto start;
+            }
             case Instruction::Type::ContinuePendingUnwind: {
                 if (auto exception = reg(Register::exception()); !exception.is_empty()) {
                     result = throw_completion(exception);
@@ -297,14 +306,17 @@ void Interpreter::run_bytecode()
 
             if (result.is_error()) [[unlikely]] {
                 reg(Register::exception()) = *result.throw_completion().value();
-                m_scheduled_jump = {};
                 auto const* handler = m_current_block->handler();
                 auto const* finalizer = m_current_block->finalizer();
-                if (!handler && !finalizer)
+                if (!handler && !finalizer) {
+                    m_scheduled_jump = {};
                     return;
+                }
 
                 auto& unwind_context = unwind_contexts().last();
                 VERIFY(unwind_context.executable == m_current_executable);
+                // A jump scheduled since we entered this context is abandoned, but one from an enclosing `finally` still happens.
+                m_scheduled_jump = unwind_context.scheduled_jump;
 
                 if (handler) {
                     m_current_block = handler;
@@ -312,11 +324,9 @@ void Interpreter::run_bytecode()
                 }
                 if (finalizer) {
                     m_current_block = finalizer;
-                    // If an exception was thrown inside the corresponding `catch` block, we need to rethrow it
-                    // from the `finally` block. But if the exception is from the `try` block, and has already been
-                    // handled by `catch`, we swallow it.
-                    if (!unwind_context.handler_called)
-                        reg(Register::exception()) = {};
+                    // NOTE: We only get here from a `try` block without a `catch`, or from inside the `catch` block itself.
+                    //       Either way the exception has not been handled, so we keep it around for the
+                    //       `ContinuePendingUnwind` at the end of the `finally` block to rethrow.
                     goto start;
                 }
                 // An unwind context with no handler or finalizer? We have nowhere to jump, and continuing on will make us crash on the next `Call` to a non-native function if there's an exception! So let's crash here instead.
@@ -379,6 +389,15 @@ Interpreter::ValueAndFrame Interpreter::run_and_return_frame(Executable& executa
             block_index = executable.basic_blocks.find_first_index_if([&](auto const& block) { return block.ptr() == entry_point; }).value();
         native_executable->run(vm(), block_index);
 
+        if (auto deoptimization_point = m_pending_deoptimization; deoptimization_point.has_value()) {
+            // The native code hit a type it wasn't specialized for. Finish this run in the interpreter,
+            // starting at the instruction it bailed out of, and recompile with the updated type feedback next time.
+            m_pending_deoptimization.clear();
+            executable.discard_native_executable(*native_executable);
+            m_current_block = executable.basic_blocks[deoptimization_point->block_index];
+            run_bytecode(deoptimization_point->bytecode_offset);
+        }
+
 #if 0
         for (size_t i = 0; i < vm().running_execution_context().local_variables.size(); ++i) {
             dbgln("%{}: {}", i, vm().running_execution_context().local_variables[i]);
@@ -437,8 +456,6 @@ void Interpreter::enter_unwind_context()
     unwind_contexts().empend(
         m_current_executable,
         vm().running_execution_context().lexical_environment);
-    call_frame().previously_scheduled_jumps.append(m_scheduled_jump);
-    m_scheduled_jump = nullptr;
 }
 
 void Interpreter::leave_unwind_context()
@@ -559,13 +576,36 @@ static ThrowCompletionOr<Value> strict_equals(VM&, Value src1, Value src2)
     return Value(is_strictly_equal(src1, src2));
 }
 
+static void record_type_feedback(TypeFeedback& feedback, Value value)
+{
+    if (value.is_int32())
+        feedback.observed_types |= TypeFeedback::Int32;
+    else if (value.is_number())
+        feedback.observed_types |= TypeFeedback::Double;
+    else
+        feedback.observed_types |= TypeFeedback::Other;
+}
+
+// NOTE: Results are only recorded when they're numbers, so that the JIT learns about e.g. int32 arithmetic overflowing,
+//       while comparisons (which always produce a boolean) stay specializable.
+static void record_type_feedback(Interpreter& interpreter, u32 slot, Value lhs, Value rhs, Value result)
+{
+    auto& feedback = interpreter.current_executable().type_feedback[slot];
+    record_type_feedback(feedback, lhs);
+    record_type_feedback(feedback, rhs);
+    if (result.is_number())
+        record_type_feedback(feedback, result);
+}
+
 #define JS_DEFINE_COMMON_BINARY_OP(OpTitleCase, op_snake_case)                                  \
     ThrowCompletionOr<void> OpTitleCase::execute_impl(Bytecode::Interpreter& interpreter) const \
     {                                                                                           \
         auto& vm = interpreter.vm();                                                            \
         auto lhs = interpreter.reg(m_lhs_reg);                                                  \
         auto rhs = interpreter.accumulator();                                                   \
-        interpreter.accumulator() = TRY(op_snake_case(vm, lhs, rhs));                           \
+        auto result = TRY(op_snake_case(vm, lhs, rhs));                                         \
+        record_type_feedback(interpreter, m_type_feedback_slot, lhs, rhs, result);              \
+        interpreter.accumulator() = result;                                                     \
         return {};                                                                              \
     }                                                                                           \
     ByteString OpTitleCase::to_byte_string_impl(Bytecode::Executable const&) const              \
@@ -1051,24 +1091,28 @@ ThrowCompletionOr<void> Return::execute_impl(Bytecode::Interpreter& interpreter)
 ThrowCompletionOr<void> Increment::execute_impl(Bytecode::Interpreter& interpreter) const
 {
     auto& vm = interpreter.vm();
-    auto old_value = TRY(interpreter.accumulator().to_numeric(vm));
+    auto operand = interpreter.accumulator();
+    auto old_value = TRY(operand.to_numeric(vm));
 
     if (old_value.is_number())
         interpreter.accumulator() = Value(old_value.as_double() + 1);
     else
         interpreter.accumulator() = BigInt::create(vm, old_value.as_bigint().big_integer().plus(Crypto::SignedBigInteger { 1 }));
+    record_type_feedback(interpreter, m_type_feedback_slot, operand, operand, interpreter.accumulator());
     return {};
 }
 
 ThrowCompletionOr<void> Decrement::execute_impl(Bytecode::Interpreter& interpreter) const
 {
     auto& vm = interpreter.vm();
-    auto old_value = TRY(interpreter.accumulator().to_numeric(vm));
+    auto operand = interpreter.accumulator();
+    auto old_value = TRY(operand.to_numeric(vm));
 
     if (old_value.is_number())
         interpreter.accumulator() = Value(old_value.as_double() - 1);
     else
         interpreter.accumulator() = BigInt::create(vm, old_value.as_bigint().big_integer().minus(Crypto::SignedBigInteger { 1 }));
+    record_type_feedback(interpreter, m_type_feedback_slot, operand, operand, interpreter.accumulator());
     return {};
 }
 
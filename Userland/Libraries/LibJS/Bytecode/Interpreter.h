@@ -95,11 +95,22 @@ public:
 
     void visit_edges(Cell::Visitor&);
 
+    // Gets and puts don't share a megamorphic cache, as a property that can be read directly can't always be written directly.
+    MegamorphicPropertyCache& megamorphic_get_cache() { return m_megamorphic_get_cache; }
+    MegamorphicPropertyCache& megamorphic_put_cache() { return m_megamorphic_put_cache; }
+
+    // Called by native code right before it bails out, so we can pick up where it left off.
+    void request_deoptimization(size_t block_index, size_t bytecode_offset)
+    {
+        VERIFY(!m_pending_deoptimization.has_value());
+        m_pending_deoptimization = DeoptimizationPoint { block_index, bytecode_offset };
+    }
+
     Span<Value> registers() { return m_current_call_frame; }
     ReadonlySpan<Value> registers() const { return m_current_call_frame; }
 
 private:
-    void run_bytecode();
+    void run_bytecode(size_t entry_point_offset = 0);
 
     CallFrame& call_frame()
     {
@@ -121,6 +132,14 @@ private:
     Executable* m_current_executable { nullptr };
     BasicBlock const* m_current_block { nullptr };
     Optional<InstructionStreamIterator&> m_pc {};
+    MegamorphicPropertyCache m_megamorphic_get_cache;
+    MegamorphicPropertyCache m_megamorphic_put_cache;
+
+    struct DeoptimizationPoint {
+        size_t block_index { 0 };
+        size_t bytecode_offset { 0 };
+    };
+    Optional<DeoptimizationPoint> m_pending_deoptimization;
 };
 
 extern bool g_dump_bytecode;
@@ -105,22 +105,27 @@ private:
     O(RightShift, right_shift)                \
     O(UnsignedRightShift, unsigned_right_shift)
 
-#define JS_DECLARE_COMMON_BINARY_OP(OpTitleCase, op_snake_case)             \
-    class OpTitleCase final : public Instruction {                          \
-    public:                                                                 \
-        explicit OpTitleCase(Register lhs_reg)                              \
-            : Instruction(Type::OpTitleCase, sizeof(*this))                 \
-            , m_lhs_reg(lhs_reg)                                            \
-        {                                                                   \
-        }                                                                   \
-                                                                            \
-        ThrowCompletionOr<void> execute_impl(Bytecode::Interpreter&) const; \
-        ByteString to_byte_string_impl(Bytecode::Executable const&) const;  \
-                                                                            \
-        Register lhs() const { return m_lhs_reg; }                          \
-                                                                            \
-    private:                                                                \
-        Register m_lhs_reg;                                                 \
+#define JS_DECLARE_COMMON_BINARY_OP(OpTitleCase, op_snake_case)                \
+    class OpTitleCase final : public Instruction {                             \
+    public:                                                                    \
+        constexpr static bool HasTypeFeedback = true;                          \
+                                                                               \
+        explicit OpTitleCase(Register lhs_reg)                                 \
+            : Instruction(Type::OpTitleCase, sizeof(*this))                    \
+            , m_lhs_reg(lhs_reg)                                               \
+        {                                                                      \
+        }                                                                      \
+                                                                               \
+        ThrowCompletionOr<void> execute_impl(Bytecode::Interpreter&) const;    \
+        ByteString to_byte_string_impl(Bytecode::Executable const&) const;     \
+                                                                               \
+        Register lhs() const { return m_lhs_reg; }                             \
+        u32 type_feedback_slot() const { return m_type_feedback_slot; }        \
+        void set_type_feedback_slot(u32 slot) { m_type_feedback_slot = slot; } \
+                                                                               \
+    private:                                                                   \
+        Register m_lhs_reg;                                                    \
+        u32 m_type_feedback_slot { 0 };                                        \
     };
 
 JS_ENUMERATE_COMMON_BINARY_OPS(JS_DECLARE_COMMON_BINARY_OP)
@@ -960,6 +965,14 @@ public:
     auto& true_target() const { return m_true_target; }
     auto& false_target() const { return m_false_target; }
 
+    void visit_labels_impl(Function<void(Label&)> const& visitor)
+    {
+        if (m_true_target.has_value())
+            visitor(*m_true_target);
+        if (m_false_target.has_value())
+            visitor(*m_false_target);
+    }
+
 protected:
     Optional<Label> m_true_target;
     Optional<Label> m_false_target;
@@ -1159,6 +1172,8 @@ public:
 
 class Increment final : public Instruction {
 public:
+    constexpr static bool HasTypeFeedback = true;
+
     Increment()
         : Instruction(Type::Increment, sizeof(*this))
     {
@@ -1166,10 +1181,18 @@ public:
 
     ThrowCompletionOr<void> execute_impl(Bytecode::Interpreter&) const;
     ByteString to_byte_string_impl(Bytecode::Executable const&) const;
+
+    u32 type_feedback_slot() const { return m_type_feedback_slot; }
+    void set_type_feedback_slot(u32 slot) { m_type_feedback_slot = slot; }
+
+private:
+    u32 m_type_feedback_slot { 0 };
 };
 
 class Decrement final : public Instruction {
 public:
+    constexpr static bool HasTypeFeedback = true;
+
     Decrement()
         : Instruction(Type::Decrement, sizeof(*this))
     {
@@ -1177,6 +1200,12 @@ public:
 
     ThrowCompletionOr<void> execute_impl(Bytecode::Interpreter&) const;
     ByteString to_byte_string_impl(Bytecode::Executable const&) const;
+
+    u32 type_feedback_slot() const { return m_type_feedback_slot; }
+    void set_type_feedback_slot(u32 slot) { m_type_feedback_slot = slot; }
+
+private:
+    u32 m_type_feedback_slot { 0 };
 };
 
 class ToNumeric final : public Instruction {
@@ -1240,6 +1269,8 @@ public:
 
     auto& entry_point() const { return m_entry_point; }
 
+    void visit_labels_impl(Function<void(Label&)> const& visitor) { visitor(m_entry_point); }
+
 private:
     Label m_entry_point;
 };
@@ -1265,6 +1296,8 @@ public:
 
     Label target() const { return m_target; }
 
+    void visit_labels_impl(Function<void(Label&)> const& visitor) { visitor(m_target); }
+
     ThrowCompletionOr<void> execute_impl(Bytecode::Interpreter&) const;
     ByteString to_byte_string_impl(Bytecode::Executable const&) const;
 
@@ -1309,6 +1342,8 @@ public:
 
     auto& resume_target() const { return m_resume_target; }
 
+    void visit_labels_impl(Function<void(Label&)> const& visitor) { visitor(m_resume_target); }
+
 private:
     Label m_resume_target;
 };
@@ -1333,6 +1368,12 @@ public:
 
     auto& continuation() const { return m_continuation_label; }
 
+    void visit_labels_impl(Function<void(Label&)> const& visitor)
+    {
+        if (m_continuation_label.has_value())
+            visitor(*m_continuation_label);
+    }
+
 private:
     Optional<Label> m_continuation_label;
 };
@@ -1352,6 +1393,8 @@ public:
 
     auto& continuation() const { return m_continuation_label; }
 
+    void visit_labels_impl(Function<void(Label&)> const& visitor) { visitor(m_continuation_label); }
+
 private:
     Label m_continuation_label;
 };
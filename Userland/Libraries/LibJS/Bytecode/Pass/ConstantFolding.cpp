@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashMap.h>
+#include <AK/Variant.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/PassManager.h>
+#include <LibJS/Runtime/ValueInlines.h>
+
+namespace JS::Bytecode::Passes {
+
+// NOTE: Constants come from LoadImmediate, so they are always primitives that aren't strings, symbols or bigints.
+//       That means folding never has to call into the runtime and can't have side effects.
+
+static Optional<Value> fold_binary_op(Instruction::Type type, Value lhs, Value rhs)
+{
+    switch (type) {
+    case Instruction::Type::StrictlyEquals:
+        return Value(is_strictly_equal(lhs, rhs));
+    case Instruction::Type::StrictlyInequals:
+        return Value(!is_strictly_equal(lhs, rhs));
+    default:
+        break;
+    }
+
+    if (!lhs.is_number() || !rhs.is_number())
+        return {};
+
+    auto left = lhs.as_double();
+    auto right = rhs.as_double();
+    switch (type) {
+    case Instruction::Type::Add:
+        return Value(left + right);
+    case Instruction::Type::Sub:
+        return Value(left - right);
+    case Instruction::Type::Mul:
+        return Value(left * right);
+    case Instruction::Type::Div:
+        return Value(left / right);
+    case Instruction::Type::LessThan:
+        return Value(left < right);
+    case Instruction::Type::LessThanEquals:
+        return Value(left <= right);
+    case Instruction::Type::GreaterThan:
+        return Value(left > right);
+    case Instruction::Type::GreaterThanEquals:
+        return Value(left >= right);
+    case Instruction::Type::LooselyEquals:
+        return Value(left == right);
+    case Instruction::Type::LooselyInequals:
+        return Value(left != right);
+    default:
+        break;
+    }
+
+    if (!lhs.is_int32() || !rhs.is_int32())
+        return {};
+
+    auto left_i32 = lhs.as_i32();
+    auto right_i32 = rhs.as_i32();
+    auto shift_count = static_cast<u32>(right_i32) % 32;
+    switch (type) {
+    case Instruction::Type::BitwiseAnd:
+        return Value(left_i32 & right_i32);
+    case Instruction::Type::BitwiseOr:
+        return Value(left_i32 | right_i32);
+    case Instruction::Type::BitwiseXor:
+        return Value(left_i32 ^ right_i32);
+    case Instruction::Type::LeftShift:
+        return Value(static_cast<i32>(static_cast<u32>(left_i32) << shift_count));
+    case Instruction::Type::RightShift:
+        return Value(left_i32 >> shift_count);
+    case Instruction::Type::UnsignedRightShift:
+        return Value(static_cast<double>(static_cast<u32>(left_i32) >> shift_count));
+    default:
+        return {};
+    }
+}
+
+static Optional<Value> fold_unary_op(Instruction::Type type, Value value)
+{
+    if (type == Instruction::Type::Not)
+        return Value(!value.to_boolean());
+
+    if (!value.is_number())
+        return {};
+
+    switch (type) {
+    case Instruction::Type::UnaryPlus:
+    case Instruction::Type::ToNumeric:
+        return value;
+    case Instruction::Type::UnaryMinus:
+        return Value(-value.as_double());
+    case Instruction::Type::Increment:
+        return Value(value.as_double() + 1);
+    case Instruction::Type::Decrement:
+        return Value(value.as_double() - 1);
+    case Instruction::Type::BitwiseNot:
+        if (value.is_int32())
+            return Value(~value.as_i32());
+        return {};
+    default:
+        return {};
+    }
+}
+
+static Optional<Label> fold_conditional_jump(Op::Jump const& jump, Value condition)
+{
+    bool taken = false;
+    switch (jump.type()) {
+    case Instruction::Type::JumpConditional:
+        taken = condition.to_boolean();
+        break;
+    case Instruction::Type::JumpNullish:
+        taken = condition.is_nullish();
+        break;
+    case Instruction::Type::JumpUndefined:
+        taken = condition.is_undefined();
+        break;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+    return taken ? jump.true_target() : jump.false_target();
+}
+
+static Optional<Register> binary_op_lhs(Instruction const& instruction)
+{
+#define __HANDLE_BINARY_OP(OpTitleCase, op_snake_case) \
+    case Instruction::Type::OpTitleCase:               \
+        return static_cast<Op::OpTitleCase const&>(instruction).lhs();
+
+    switch (instruction.type()) {
+        JS_ENUMERATE_COMMON_BINARY_OPS(__HANDLE_BINARY_OP)
+    default:
+        return {};
+    }
+
+#undef __HANDLE_BINARY_OP
+}
+
+namespace {
+
+// What we know about the contents of the accumulator, registers and locals at some point within a basic block.
+class KnownConstants {
+public:
+    Optional<Value> const& accumulator() const { return m_accumulator; }
+    void set_accumulator(Optional<Value> value) { m_accumulator = move(value); }
+
+    Optional<Value> in_register(Register reg) const
+    {
+        if (reg.index() < Register::reserved_register_count)
+            return {};
+        return m_registers.get(reg.index());
+    }
+
+    void store_accumulator_in_register(Register reg)
+    {
+        if (reg.index() < Register::reserved_register_count)
+            return;
+        if (m_accumulator.has_value())
+            m_registers.set(reg.index(), *m_accumulator);
+        else
+            m_registers.remove(reg.index());
+    }
+
+    Optional<Value> in_local(size_t index) const { return m_locals.get(index); }
+
+    void store_accumulator_in_local(size_t index)
+    {
+        if (m_accumulator.has_value())
+            m_locals.set(index, *m_accumulator);
+        else
+            m_locals.remove(index);
+    }
+
+    void forget_everything()
+    {
+        m_accumulator.clear();
+        m_registers.clear();
+        m_locals.clear();
+    }
+
+private:
+    Optional<Value> m_accumulator;
+    HashMap<u32, Value> m_registers;
+    HashMap<size_t, Value> m_locals;
+};
+
+struct Replacement {
+    size_t offset { 0 };
+    // A constant to load into the accumulator instead, or where to jump unconditionally.
+    Variant<Value, Label> replacement;
+};
+
+}
+
+static Vector<Replacement> find_foldable_instructions(BasicBlock const& block)
+{
+    Vector<Replacement> replacements;
+    KnownConstants known;
+
+    for (InstructionStreamIterator it(block.instruction_stream()); !it.at_end(); ++it) {
+        auto const& instruction = *it;
+        auto const& accumulator = known.accumulator();
+
+        switch (instruction.type()) {
+        case Instruction::Type::LoadImmediate: {
+            auto value = static_cast<Op::LoadImmediate const&>(instruction).value();
+            known.set_accumulator(value.is_empty() ? Optional<Value> {} : value);
+            continue;
+        }
+        case Instruction::Type::Load:
+            known.set_accumulator(known.in_register(static_cast<Op::Load const&>(instruction).src()));
+            continue;
+        case Instruction::Type::Store:
+            known.store_accumulator_in_register(static_cast<Op::Store const&>(instruction).dst());
+            continue;
+        case Instruction::Type::GetLocal: {
+            // The local was set earlier in this block, so it's initialized and reading it can't throw.
+            auto value = known.in_local(static_cast<Op::GetLocal const&>(instruction).index());
+            if (value.has_value())
+                replacements.append({ it.offset(), *value });
+            known.set_accumulator(value);
+            continue;
+        }
+        case Instruction::Type::SetLocal:
+            known.store_accumulator_in_local(static_cast<Op::SetLocal const&>(instruction).index());
+            continue;
+        case Instruction::Type::Not:
+        case Instruction::Type::UnaryPlus:
+        case Instruction::Type::UnaryMinus:
+        case Instruction::Type::BitwiseNot:
+        case Instruction::Type::Increment:
+        case Instruction::Type::Decrement:
+        case Instruction::Type::ToNumeric: {
+            Optional<Value> result;
+            if (accumulator.has_value())
+                result = fold_unary_op(instruction.type(), *accumulator);
+            if (result.has_value() && instruction.type() != Instruction::Type::ToNumeric)
+                replacements.append({ it.offset(), *result });
+            known.set_accumulator(result);
+            continue;
+        }
+        case Instruction::Type::JumpConditional:
+        case Instruction::Type::JumpNullish:
+        case Instruction::Type::JumpUndefined:
+            if (accumulator.has_value())
+                replacements.append({ it.offset(), *fold_conditional_jump(static_cast<Op::Jump const&>(instruction), *accumulator) });
+            continue;
+        default:
+            break;
+        }
+
+        if (auto lhs = binary_op_lhs(instruction); lhs.has_value()) {
+            // NOTE: Even when we can't fold this, it can only call out to user code (e.g. valueOf), which has no way
+            //       of touching this frame's registers or locals.
+            auto lhs_value = known.in_register(*lhs);
+            Optional<Value> result;
+            if (lhs_value.has_value() && accumulator.has_value())
+                result = fold_binary_op(instruction.type(), *lhs_value, *accumulator);
+            if (result.has_value())
+                replacements.append({ it.offset(), *result });
+            known.set_accumulator(result);
+            continue;
+        }
+
+        // We don't know what this instruction writes to.
+        known.forget_everything();
+    }
+
+    return replacements;
+}
+
+void ConstantFolding::perform(Executable& executable)
+{
+    for (auto& block : executable.basic_blocks) {
+        auto replacements = find_foldable_instructions(*block);
+        if (replacements.is_empty())
+            continue;
+
+        InstructionStreamRewriter rewriter(*block);
+        size_t next_replacement = 0;
+        for (auto it = rewriter.old_instructions(); !it.at_end(); ++it) {
+            if (next_replacement == replacements.size() || replacements[next_replacement].offset != it.offset()) {
+                rewriter.keep(*it);
+                continue;
+            }
+            replacements[next_replacement++].replacement.visit(
+                [&](Value value) { rewriter.replace<Op::LoadImmediate>(*it, value); },
+                [&](Label target) { rewriter.replace<Op::Jump>(*it, target); });
+        }
+    }
+}
+
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashTable.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/PassManager.h>
+
+namespace JS::Bytecode::Passes {
+
+namespace {
+
+// The registers and locals that are known to hold the same value as the accumulator.
+class AccumulatorCopies {
+public:
+    bool is_in_register(Register reg) const { return m_registers.contains(reg.index()); }
+    bool is_in_local(size_t index) const { return m_locals.contains(index); }
+
+    // A local holding an empty value is uninitialized, and reading it has to throw.
+    bool may_be_empty() const { return m_may_be_empty; }
+
+    void copied_to_register(Register reg) { m_registers.set(reg.index()); }
+    void copied_to_local(size_t index) { m_locals.set(index); }
+
+    void replaced(bool may_be_empty)
+    {
+        m_registers.clear();
+        m_locals.clear();
+        m_may_be_empty = may_be_empty;
+    }
+
+private:
+    HashTable<u32> m_registers;
+    HashTable<size_t> m_locals;
+    bool m_may_be_empty { true };
+};
+
+}
+
+static bool is_general_purpose(Register reg)
+{
+    return reg.index() >= Register::reserved_register_count;
+}
+
+static Vector<size_t> find_redundant_copies(BasicBlock const& block)
+{
+    Vector<size_t> redundant_instructions;
+    AccumulatorCopies copies;
+
+    for (InstructionStreamIterator it(block.instruction_stream()); !it.at_end(); ++it) {
+        auto const& instruction = *it;
+        switch (instruction.type()) {
+        case Instruction::Type::Load: {
+            auto src = static_cast<Op::Load const&>(instruction).src();
+            if (!is_general_purpose(src)) {
+                copies.replaced(true);
+            } else if (copies.is_in_register(src)) {
+                redundant_instructions.append(it.offset());
+            } else {
+                copies.replaced(true);
+                copies.copied_to_register(src);
+            }
+            break;
+        }
+        case Instruction::Type::Store: {
+            auto dst = static_cast<Op::Store const&>(instruction).dst();
+            if (!is_general_purpose(dst))
+                break;
+            if (copies.is_in_register(dst))
+                redundant_instructions.append(it.offset());
+            else
+                copies.copied_to_register(dst);
+            break;
+        }
+        case Instruction::Type::GetLocal: {
+            auto index = static_cast<Op::GetLocal const&>(instruction).index();
+            if (copies.is_in_local(index) && !copies.may_be_empty()) {
+                redundant_instructions.append(it.offset());
+            } else {
+                copies.replaced(false);
+                copies.copied_to_local(index);
+            }
+            break;
+        }
+        case Instruction::Type::SetLocal: {
+            auto index = static_cast<Op::SetLocal const&>(instruction).index();
+            if (copies.is_in_local(index))
+                redundant_instructions.append(it.offset());
+            else
+                copies.copied_to_local(index);
+            break;
+        }
+        case Instruction::Type::LoadImmediate:
+            copies.replaced(static_cast<Op::LoadImmediate const&>(instruction).value().is_empty());
+            break;
+        default:
+            // We don't know what this instruction writes to.
+            copies.replaced(true);
+            break;
+        }
+    }
+
+    return redundant_instructions;
+}
+
+void CopyPropagation::perform(Executable& executable)
+{
+    for (auto& block : executable.basic_blocks) {
+        auto redundant_instructions = find_redundant_copies(*block);
+        if (redundant_instructions.is_empty())
+            continue;
+
+        InstructionStreamRewriter rewriter(*block);
+        size_t next_redundant_instruction = 0;
+        for (auto it = rewriter.old_instructions(); !it.at_end(); ++it) {
+            if (next_redundant_instruction < redundant_instructions.size() && redundant_instructions[next_redundant_instruction] == it.offset()) {
+                rewriter.remove(*it);
+                ++next_redundant_instruction;
+            } else {
+                rewriter.keep(*it);
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,558 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/PassManager.h>
+
+namespace JS::Bytecode::Passes {
+
+// Liveness is tracked for the accumulator, every register and every local. The accumulator shares its index with
+// register 0, and the locals come after the registers. Reserved registers are always treated as live.
+
+namespace {
+
+class LiveSet {
+public:
+    explicit LiveSet(size_t variable_count)
+    {
+        m_words.resize(ceil_div(variable_count, bits_per_word));
+    }
+
+    bool contains(size_t index) const { return m_words[index / bits_per_word] & bit(index); }
+    void add(size_t index) { m_words[index / bits_per_word] |= bit(index); }
+    void remove(size_t index) { m_words[index / bits_per_word] &= ~bit(index); }
+
+    // Returns whether anything was added.
+    bool merge(LiveSet const& other)
+    {
+        bool changed = false;
+        for (size_t i = 0; i < m_words.size(); ++i) {
+            auto merged = m_words[i] | other.m_words[i];
+            changed |= merged != m_words[i];
+            m_words[i] = merged;
+        }
+        return changed;
+    }
+
+private:
+    static constexpr size_t bits_per_word = 64;
+    static constexpr u64 bit(size_t index) { return 1ull << (index % bits_per_word); }
+
+    Vector<u64> m_words;
+};
+
+struct BlockInfo {
+    BasicBlock* block { nullptr };
+    Vector<Instruction const*> instructions;
+    Vector<size_t> successors;
+    Vector<size_t> exception_successors;
+};
+
+}
+
+// Anything not listed here is assumed to look at the accumulator.
+static bool reads_accumulator(Instruction const& instruction)
+{
+    switch (instruction.type()) {
+    case Instruction::Type::Catch:
+    case Instruction::Type::CreateLexicalEnvironment:
+    case Instruction::Type::EnterUnwindContext:
+    case Instruction::Type::GetCalleeAndThisFromEnvironment:
+    case Instruction::Type::GetGlobal:
+    case Instruction::Type::GetLocal:
+    case Instruction::Type::GetNewTarget:
+    case Instruction::Type::GetImportMeta:
+    case Instruction::Type::GetVariable:
+    case Instruction::Type::Jump:
+    case Instruction::Type::LeaveLexicalEnvironment:
+    case Instruction::Type::LeaveUnwindContext:
+    case Instruction::Type::Load:
+    case Instruction::Type::LoadImmediate:
+    case Instruction::Type::NewArray:
+    case Instruction::Type::NewBigInt:
+    case Instruction::Type::NewFunction:
+    case Instruction::Type::NewObject:
+    case Instruction::Type::NewPrimitiveArray:
+    case Instruction::Type::NewRegExp:
+    case Instruction::Type::NewString:
+    case Instruction::Type::ResolveThisBinding:
+    case Instruction::Type::TypeofLocal:
+    case Instruction::Type::TypeofVariable:
+        return false;
+    default:
+        return true;
+    }
+}
+
+// Instructions that always overwrite the accumulator (unless they throw).
+static bool writes_accumulator(Instruction const& instruction)
+{
+    switch (instruction.type()) {
+    case Instruction::Type::Catch:
+    case Instruction::Type::GetGlobal:
+    case Instruction::Type::GetLocal:
+    case Instruction::Type::GetNewTarget:
+    case Instruction::Type::GetImportMeta:
+    case Instruction::Type::GetVariable:
+    case Instruction::Type::Load:
+    case Instruction::Type::LoadImmediate:
+    case Instruction::Type::NewArray:
+    case Instruction::Type::NewBigInt:
+    case Instruction::Type::NewFunction:
+    case Instruction::Type::NewObject:
+    case Instruction::Type::NewPrimitiveArray:
+    case Instruction::Type::NewRegExp:
+    case Instruction::Type::NewString:
+    case Instruction::Type::ResolveThisBinding:
+    case Instruction::Type::TypeofLocal:
+    case Instruction::Type::TypeofVariable:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Calls the callback for every register the instruction reads. Registers that an instruction writes
+// (other than the destination of Store) are reported too, which only makes the analysis more conservative.
+// NOTE: This has to know about every register operand of every instruction, so every instruction type has a case.
+template<typename Callback>
+static void for_each_register_read(Instruction const& instruction, Callback callback)
+{
+    auto for_each_in_range = [&](Register first, size_t count) {
+        for (size_t i = 0; i < count; ++i)
+            callback(Register { static_cast<u32>(first.index() + i) });
+    };
+
+    switch (instruction.type()) {
+#define __HANDLE_BINARY_OP(OpTitleCase, op_snake_case)                    \
+    case Instruction::Type::OpTitleCase:                                  \
+        callback(static_cast<Op::OpTitleCase const&>(instruction).lhs()); \
+        return;
+        JS_ENUMERATE_COMMON_BINARY_OPS(__HANDLE_BINARY_OP)
+#undef __HANDLE_BINARY_OP
+    case Instruction::Type::Load:
+        callback(static_cast<Op::Load const&>(instruction).src());
+        return;
+    case Instruction::Type::Append:
+        callback(static_cast<Op::Append const&>(instruction).lhs());
+        return;
+    case Instruction::Type::Call: {
+        auto const& call = static_cast<Op::Call const&>(instruction);
+        callback(call.callee());
+        callback(call.this_value());
+        for_each_in_range(call.first_argument(), call.argument_count());
+        return;
+    }
+    case Instruction::Type::CallWithArgumentArray: {
+        auto const& call = static_cast<Op::CallWithArgumentArray const&>(instruction);
+        callback(call.callee());
+        callback(call.this_value());
+        return;
+    }
+    case Instruction::Type::ConcatString:
+        callback(static_cast<Op::ConcatString const&>(instruction).lhs());
+        return;
+    case Instruction::Type::CopyObjectExcludingProperties: {
+        auto const& copy = static_cast<Op::CopyObjectExcludingProperties const&>(instruction);
+        callback(copy.from_object());
+        for (size_t i = 0; i < copy.excluded_names_count(); ++i)
+            callback(copy.excluded_names()[i]);
+        return;
+    }
+    case Instruction::Type::DeleteByIdWithThis:
+        callback(static_cast<Op::DeleteByIdWithThis const&>(instruction).this_value());
+        return;
+    case Instruction::Type::DeleteByValue:
+        callback(static_cast<Op::DeleteByValue const&>(instruction).base());
+        return;
+    case Instruction::Type::DeleteByValueWithThis: {
+        auto const& delete_ = static_cast<Op::DeleteByValueWithThis const&>(instruction);
+        callback(delete_.base());
+        callback(delete_.this_value());
+        return;
+    }
+    case Instruction::Type::GetByIdWithThis:
+        callback(static_cast<Op::GetByIdWithThis const&>(instruction).this_value());
+        return;
+    case Instruction::Type::GetByValue:
+        callback(static_cast<Op::GetByValue const&>(instruction).base());
+        return;
+    case Instruction::Type::GetByValueWithThis: {
+        auto const& get = static_cast<Op::GetByValueWithThis const&>(instruction);
+        callback(get.base());
+        callback(get.this_value());
+        return;
+    }
+    case Instruction::Type::GetCalleeAndThisFromEnvironment: {
+        auto const& get = static_cast<Op::GetCalleeAndThisFromEnvironment const&>(instruction);
+        callback(get.callee());
+        callback(get.this_());
+        return;
+    }
+    case Instruction::Type::GetNextMethodFromIteratorRecord: {
+        auto const& get = static_cast<Op::GetNextMethodFromIteratorRecord const&>(instruction);
+        callback(get.next_method());
+        callback(get.iterator_record());
+        return;
+    }
+    case Instruction::Type::GetObjectFromIteratorRecord: {
+        auto const& get = static_cast<Op::GetObjectFromIteratorRecord const&>(instruction);
+        callback(get.object());
+        callback(get.iterator_record());
+        return;
+    }
+    case Instruction::Type::ImportCall: {
+        auto const& import_call = static_cast<Op::ImportCall const&>(instruction);
+        callback(import_call.specifier());
+        callback(import_call.options());
+        return;
+    }
+    case Instruction::Type::NewArray: {
+        auto const& new_array = static_cast<Op::NewArray const&>(instruction);
+        if (new_array.element_count())
+            for_each_in_range(new_array.start(), new_array.element_count());
+        return;
+    }
+    case Instruction::Type::NewFunction:
+        if (auto const& home_object = static_cast<Op::NewFunction const&>(instruction).home_object(); home_object.has_value())
+            callback(*home_object);
+        return;
+    case Instruction::Type::PutById:
+        callback(static_cast<Op::PutById const&>(instruction).base());
+        return;
+    case Instruction::Type::PutByIdWithThis: {
+        auto const& put = static_cast<Op::PutByIdWithThis const&>(instruction);
+        callback(put.base());
+        callback(put.this_value());
+        return;
+    }
+    case Instruction::Type::PutByValue: {
+        auto const& put = static_cast<Op::PutByValue const&>(instruction);
+        callback(put.base());
+        callback(put.property());
+        return;
+    }
+    case Instruction::Type::PutByValueWithThis: {
+        auto const& put = static_cast<Op::PutByValueWithThis const&>(instruction);
+        callback(put.base());
+        callback(put.property());
+        callback(put.this_value());
+        return;
+    }
+    case Instruction::Type::PutPrivateById:
+        callback(static_cast<Op::PutPrivateById const&>(instruction).base());
+        return;
+#define __HANDLE_UNARY_OP(OpTitleCase, op_snake_case) \
+    case Instruction::Type::OpTitleCase:
+        JS_ENUMERATE_COMMON_UNARY_OPS(__HANDLE_UNARY_OP)
+#undef __HANDLE_UNARY_OP
+    case Instruction::Type::AsyncIteratorClose:
+    case Instruction::Type::Await:
+    case Instruction::Type::BlockDeclarationInstantiation:
+    case Instruction::Type::Catch:
+    case Instruction::Type::ContinuePendingUnwind:
+    case Instruction::Type::CreateLexicalEnvironment:
+    case Instruction::Type::CreateVariable:
+    case Instruction::Type::Decrement:
+    case Instruction::Type::DeleteById:
+    case Instruction::Type::DeleteVariable:
+    case Instruction::Type::EnterObjectEnvironment:
+    case Instruction::Type::EnterUnwindContext:
+    case Instruction::Type::GetById:
+    case Instruction::Type::GetGlobal:
+    case Instruction::Type::GetImportMeta:
+    case Instruction::Type::GetIterator:
+    case Instruction::Type::GetLocal:
+    case Instruction::Type::GetMethod:
+    case Instruction::Type::GetNewTarget:
+    case Instruction::Type::GetObjectPropertyIterator:
+    case Instruction::Type::GetPrivateById:
+    case Instruction::Type::GetVariable:
+    case Instruction::Type::HasPrivateId:
+    case Instruction::Type::Increment:
+    case Instruction::Type::IteratorClose:
+    case Instruction::Type::IteratorNext:
+    case Instruction::Type::IteratorToArray:
+    case Instruction::Type::Jump:
+    case Instruction::Type::JumpConditional:
+    case Instruction::Type::JumpNullish:
+    case Instruction::Type::JumpUndefined:
+    case Instruction::Type::LeaveLexicalEnvironment:
+    case Instruction::Type::LeaveUnwindContext:
+    case Instruction::Type::LoadImmediate:
+    case Instruction::Type::NewBigInt:
+    case Instruction::Type::NewClass:
+    case Instruction::Type::NewObject:
+    case Instruction::Type::NewPrimitiveArray:
+    case Instruction::Type::NewRegExp:
+    case Instruction::Type::NewString:
+    case Instruction::Type::NewTypeError:
+    case Instruction::Type::ResolveSuperBase:
+    case Instruction::Type::ResolveThisBinding:
+    case Instruction::Type::Return:
+    case Instruction::Type::ScheduleJump:
+    case Instruction::Type::SetLocal:
+    case Instruction::Type::SetVariable:
+    case Instruction::Type::Store:
+    case Instruction::Type::SuperCallWithArgumentArray:
+    case Instruction::Type::Throw:
+    case Instruction::Type::ThrowIfNotObject:
+    case Instruction::Type::ThrowIfNullish:
+    case Instruction::Type::ToNumeric:
+    case Instruction::Type::TypeofLocal:
+    case Instruction::Type::TypeofVariable:
+    case Instruction::Type::Yield:
+        // These don't read any register (Store only writes its destination).
+        return;
+    }
+    // There's deliberately no default case above, so that new instructions have to be added here to compile.
+    VERIFY_NOT_REACHED();
+}
+
+namespace {
+
+class Liveness {
+public:
+    Liveness(Executable const& executable, size_t local_count)
+        : m_register_count(executable.number_of_registers)
+        , m_variable_count(m_register_count + local_count)
+    {
+    }
+
+    size_t variable_count() const { return m_variable_count; }
+    size_t local(size_t index) const { return m_register_count + index; }
+
+    // Updates `live` from the state after the instruction to the state before it.
+    void step_backwards(Instruction const& instruction, LiveSet& live) const
+    {
+        switch (instruction.type()) {
+        case Instruction::Type::Store:
+            kill_register(static_cast<Op::Store const&>(instruction).dst(), live);
+            break;
+        case Instruction::Type::SetLocal:
+            live.remove(local(static_cast<Op::SetLocal const&>(instruction).index()));
+            break;
+        default:
+            break;
+        }
+
+        if (writes_accumulator(instruction))
+            live.remove(Register::accumulator_index);
+        if (reads_accumulator(instruction))
+            live.add(Register::accumulator_index);
+
+        switch (instruction.type()) {
+        case Instruction::Type::GetLocal:
+            live.add(local(static_cast<Op::GetLocal const&>(instruction).index()));
+            break;
+        case Instruction::Type::TypeofLocal:
+            live.add(local(static_cast<Op::TypeofLocal const&>(instruction).index()));
+            break;
+        default:
+            break;
+        }
+
+        for_each_register_read(instruction, [&](Register reg) {
+            live.add(reg.index());
+        });
+    }
+
+    // Whether the instruction only writes something that is dead afterwards, and has no other effect.
+    bool is_dead(Instruction const& instruction, LiveSet const& live_after) const
+    {
+        switch (instruction.type()) {
+        case Instruction::Type::Store: {
+            auto dst = static_cast<Op::Store const&>(instruction).dst();
+            return dst.index() >= Register::reserved_register_count && !live_after.contains(dst.index());
+        }
+        case Instruction::Type::SetLocal:
+            return !live_after.contains(local(static_cast<Op::SetLocal const&>(instruction).index()));
+        case Instruction::Type::Load:
+        case Instruction::Type::LoadImmediate:
+            return !live_after.contains(Register::accumulator_index);
+        default:
+            return false;
+        }
+    }
+
+private:
+    void kill_register(Register reg, LiveSet& live) const
+    {
+        if (reg.index() >= Register::reserved_register_count)
+            live.remove(reg.index());
+    }
+
+    size_t m_register_count { 0 };
+    size_t m_variable_count { 0 };
+};
+
+}
+
+static size_t count_locals(Executable const& executable)
+{
+    size_t count = 0;
+    for (auto const& block : executable.basic_blocks) {
+        for (InstructionStreamIterator it(block->instruction_stream()); !it.at_end(); ++it) {
+            switch ((*it).type()) {
+            case Instruction::Type::GetLocal:
+                count = max(count, static_cast<Op::GetLocal const&>(*it).index() + 1);
+                break;
+            case Instruction::Type::SetLocal:
+                count = max(count, static_cast<Op::SetLocal const&>(*it).index() + 1);
+                break;
+            case Instruction::Type::TypeofLocal:
+                count = max(count, static_cast<Op::TypeofLocal const&>(*it).index() + 1);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+static Vector<BlockInfo> build_control_flow_graph(Executable& executable)
+{
+    HashMap<BasicBlock const*, size_t> block_indices;
+    for (size_t i = 0; i < executable.basic_blocks.size(); ++i)
+        block_indices.set(executable.basic_blocks[i].ptr(), i);
+
+    // ContinuePendingUnwind may resume at any break or continue target that was scheduled before running a finalizer.
+    Vector<size_t> scheduled_jump_targets;
+    for (auto const& block : executable.basic_blocks) {
+        auto const* terminator = block->terminator();
+        if (terminator && terminator->type() == Instruction::Type::ScheduleJump)
+            scheduled_jump_targets.append(*block_indices.get(&static_cast<Op::ScheduleJump const&>(*terminator).target().block()));
+    }
+
+    Vector<BlockInfo> blocks;
+    blocks.ensure_capacity(executable.basic_blocks.size());
+    for (auto const& block : executable.basic_blocks) {
+        BlockInfo info;
+        info.block = block.ptr();
+        for (InstructionStreamIterator it(block->instruction_stream()); !it.at_end(); ++it)
+            info.instructions.append(&*it);
+        if (block->handler())
+            info.exception_successors.append(*block_indices.get(block->handler()));
+        if (block->finalizer())
+            info.exception_successors.append(*block_indices.get(block->finalizer()));
+
+        if (auto const* terminator = block->terminator()) {
+            const_cast<Instruction&>(*terminator).visit_labels([&](Label& label) {
+                info.successors.append(*block_indices.get(&label.block()));
+            });
+            if (terminator->type() == Instruction::Type::ContinuePendingUnwind)
+                info.successors.extend(scheduled_jump_targets);
+        }
+        blocks.unchecked_append(move(info));
+    }
+    return blocks;
+}
+
+// Stop before the live sets get unreasonably big on huge generated scripts.
+static constexpr size_t max_live_set_bits = 64 * MiB;
+
+static size_t eliminate_dead_stores(Executable& executable)
+{
+    if (executable.basic_blocks.is_empty())
+        return 0;
+
+    auto local_count = count_locals(executable);
+    Liveness liveness(executable, local_count);
+    auto blocks = build_control_flow_graph(executable);
+    if (liveness.variable_count() * blocks.size() > max_live_set_bits)
+        return 0;
+
+    auto const empty_set = LiveSet(liveness.variable_count());
+
+    // When we leave the executable, the caller may look at the accumulator (e.g. for a script's completion value),
+    // and the function body may look at locals that were assigned while evaluating a default parameter value.
+    auto exit_set = empty_set;
+    exit_set.add(Register::accumulator_index);
+    for (size_t i = 0; i < local_count; ++i)
+        exit_set.add(liveness.local(i));
+
+    Vector<LiveSet> live_in;
+    live_in.ensure_capacity(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+        live_in.unchecked_append(empty_set);
+
+    auto live_out_of = [&](BlockInfo const& info) {
+        if (info.successors.is_empty())
+            return exit_set;
+        auto live = empty_set;
+        for (auto successor : info.successors)
+            live.merge(live_in[successor]);
+        return live;
+    };
+
+    auto live_on_exception = [&](BlockInfo const& info) {
+        auto live = empty_set;
+        for (auto successor : info.exception_successors)
+            live.merge(live_in[successor]);
+        return live;
+    };
+
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = blocks.size(); i > 0; --i) {
+            auto const& info = blocks[i - 1];
+            auto exception_live = live_on_exception(info);
+            auto live = live_out_of(info);
+            live.merge(exception_live);
+            for (size_t j = info.instructions.size(); j > 0; --j) {
+                liveness.step_backwards(*info.instructions[j - 1], live);
+                live.merge(exception_live);
+            }
+            changed |= live_in[i - 1].merge(live);
+        }
+    }
+
+    size_t removed_count = 0;
+    for (auto const& info : blocks) {
+        auto exception_live = live_on_exception(info);
+        auto live = live_out_of(info);
+        live.merge(exception_live);
+
+        HashTable<Instruction const*> dead_instructions;
+        for (size_t j = info.instructions.size(); j > 0; --j) {
+            auto const& instruction = *info.instructions[j - 1];
+            if (liveness.is_dead(instruction, live)) {
+                dead_instructions.set(&instruction);
+                continue;
+            }
+            liveness.step_backwards(instruction, live);
+            live.merge(exception_live);
+        }
+
+        if (dead_instructions.is_empty())
+            continue;
+        removed_count += dead_instructions.size();
+
+        InstructionStreamRewriter rewriter(*info.block);
+        for (auto it = rewriter.old_instructions(); !it.at_end(); ++it) {
+            if (dead_instructions.contains(&*it))
+                rewriter.remove(*it);
+            else
+                rewriter.keep(*it);
+        }
+    }
+    return removed_count;
+}
+
+void DeadStoreElimination::perform(Executable& executable)
+{
+    // Removing a store can make the instructions that fed it dead as well.
+    for (size_t round = 0; round < 4; ++round) {
+        if (eliminate_dead_stores(executable) == 0)
+            break;
+    }
+}
+
+}
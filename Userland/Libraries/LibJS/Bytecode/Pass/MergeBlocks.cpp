@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/PassManager.h>
+
+namespace JS::Bytecode::Passes {
+
+static void remove_unreachable_blocks(Executable& executable)
+{
+    HashTable<BasicBlock const*> reachable;
+    Vector<BasicBlock const*> worklist;
+
+    auto visit = [&](BasicBlock const* block) {
+        if (block && reachable.set(block) == HashSetResult::InsertedNewEntry)
+            worklist.append(block);
+    };
+
+    visit(executable.basic_blocks.first().ptr());
+    while (!worklist.is_empty()) {
+        auto const* block = worklist.take_last();
+        // Anything that may throw can take us to the handler or finalizer, so those are always successors.
+        visit(block->handler());
+        visit(block->finalizer());
+        if (auto const* terminator = block->terminator()) {
+            const_cast<Instruction&>(*terminator).visit_labels([&](Label& label) {
+                visit(&label.block());
+            });
+        }
+    }
+
+    if (reachable.size() == executable.basic_blocks.size())
+        return;
+    executable.basic_blocks.remove_all_matching([&](auto const& block) {
+        return !reachable.contains(block.ptr());
+    });
+}
+
+void MergeBlocks::perform(Executable& executable)
+{
+    if (executable.basic_blocks.is_empty())
+        return;
+
+    remove_unreachable_blocks(executable);
+
+    // Blocks that are entered in some way other than a plain jump can't be appended to another block.
+    HashTable<BasicBlock const*> pinned_blocks;
+    HashMap<BasicBlock const*, size_t> reference_counts;
+    pinned_blocks.set(executable.basic_blocks.first().ptr());
+    for (auto const& block : executable.basic_blocks) {
+        if (block->handler())
+            pinned_blocks.set(block->handler());
+        if (block->finalizer())
+            pinned_blocks.set(block->finalizer());
+        auto const* terminator = block->terminator();
+        if (!terminator)
+            continue;
+        if (terminator->type() != Instruction::Type::Jump) {
+            const_cast<Instruction&>(*terminator).visit_labels([&](Label& label) {
+                pinned_blocks.set(&label.block());
+            });
+            continue;
+        }
+        auto const& target = static_cast<Op::Jump const&>(*terminator).true_target()->block();
+        reference_counts.ensure(&target, [] { return 0; })++;
+    }
+
+    auto mergeable_successor = [&](BasicBlock const& block) -> BasicBlock* {
+        auto const* terminator = block.terminator();
+        if (!terminator || terminator->type() != Instruction::Type::Jump)
+            return nullptr;
+        auto const& successor = static_cast<Op::Jump const&>(*terminator).true_target()->block();
+        if (&successor == &block || pinned_blocks.contains(&successor))
+            return nullptr;
+        if (reference_counts.get(&successor).value_or(0) != 1)
+            return nullptr;
+        // The interpreter looks up handlers and finalizers per block, so both halves need to agree on them.
+        if (successor.handler() != block.handler() || successor.finalizer() != block.finalizer())
+            return nullptr;
+        return const_cast<BasicBlock*>(&successor);
+    };
+
+    HashTable<BasicBlock const*> merged_blocks;
+    for (auto& block : executable.basic_blocks) {
+        if (merged_blocks.contains(block.ptr()))
+            continue;
+        while (auto* successor = mergeable_successor(*block)) {
+            auto const* jump = block->terminator();
+            InstructionStreamRewriter rewriter(*block);
+            for (auto it = rewriter.old_instructions(); !it.at_end(); ++it) {
+                if (&*it == jump)
+                    rewriter.remove(*it);
+                else
+                    rewriter.keep(*it);
+            }
+            rewriter.append_instructions_from(*successor);
+            merged_blocks.set(successor);
+        }
+    }
+
+    if (merged_blocks.is_empty())
+        return;
+    executable.basic_blocks.remove_all_matching([&](auto const& block) {
+        return merged_blocks.contains(block.ptr());
+    });
+}
+
+}
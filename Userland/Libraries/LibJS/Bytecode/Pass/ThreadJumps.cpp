@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/PassManager.h>
+
+namespace JS::Bytecode::Passes {
+
+static BasicBlock const* jump_target_if_trivial(BasicBlock const& block)
+{
+    InstructionStreamIterator it(block.instruction_stream());
+    if (it.at_end() || (*it).type() != Instruction::Type::Jump)
+        return nullptr;
+    return &static_cast<Op::Jump const&>(*it).true_target()->block();
+}
+
+static BasicBlock const& final_target(BasicBlock const& block, size_t block_count)
+{
+    // NOTE: The step limit keeps us from going around in circles on `for (;;) {}`.
+    auto const* target = &block;
+    for (size_t steps = 0; steps < block_count; ++steps) {
+        auto const* next = jump_target_if_trivial(*target);
+        if (!next || next == target)
+            break;
+        target = next;
+    }
+    return *target;
+}
+
+void ThreadJumps::perform(Executable& executable)
+{
+    auto block_count = executable.basic_blocks.size();
+
+    for (auto& block : executable.basic_blocks) {
+        auto const* terminator = block->terminator();
+        if (!terminator)
+            continue;
+
+        const_cast<Instruction&>(*terminator).visit_labels([&](Label& label) {
+            label = Label { final_target(label.block(), block_count) };
+        });
+
+        switch (terminator->type()) {
+        case Instruction::Type::JumpConditional:
+        case Instruction::Type::JumpNullish:
+        case Instruction::Type::JumpUndefined: {
+            auto const& jump = static_cast<Op::Jump const&>(*terminator);
+            if (&jump.true_target()->block() != &jump.false_target()->block())
+                break;
+            // Checking the accumulator has no side effects, so this is just a jump.
+            auto target = *jump.true_target();
+            InstructionStreamRewriter rewriter(*block);
+            for (auto it = rewriter.old_instructions(); !it.at_end(); ++it) {
+                if (&*it == terminator)
+                    rewriter.replace<Op::Jump>(*it, target);
+                else
+                    rewriter.keep(*it);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+}
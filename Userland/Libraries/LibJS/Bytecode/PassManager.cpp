@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Format.h>
+#include <AK/StringView.h>
+#include <LibJS/Bytecode/BasicBlock.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Bytecode/PassManager.h>
+
+namespace JS::Bytecode {
+
+PassManager& PassManager::optimization_pipeline()
+{
+    static auto pipeline = [] {
+        auto pipeline = make<PassManager>();
+        pipeline->add<Passes::ThreadJumps>();
+        pipeline->add<Passes::MergeBlocks>();
+        pipeline->add<Passes::ConstantFolding>();
+        pipeline->add<Passes::CopyPropagation>();
+        pipeline->add<Passes::DeadStoreElimination>();
+        // Folded conditional jumps leave behind unreachable blocks and new jump chains.
+        pipeline->add<Passes::ThreadJumps>();
+        pipeline->add<Passes::MergeBlocks>();
+
+        if (auto const* value = getenv("LIBJS_DISABLE_BYTECODE_PASSES")) {
+            StringView disabled_passes { value, strlen(value) };
+            for (auto disabled_pass : disabled_passes.split_view(',')) {
+                for (auto& pass : pipeline->m_passes) {
+                    if (disabled_pass == "all"sv || disabled_pass == pass->name())
+                        pass->set_enabled(false);
+                }
+            }
+        }
+        return pipeline;
+    }();
+    return *pipeline;
+}
+
+void PassManager::perform(Executable& executable)
+{
+    auto count = instruction_count(executable);
+    m_instruction_count_before += count;
+
+    for (auto& pass : m_passes) {
+        if (!pass->is_enabled())
+            continue;
+        pass->perform(executable);
+        auto new_count = instruction_count(executable);
+        VERIFY(new_count <= count);
+        pass->did_remove_instructions(count - new_count);
+        count = new_count;
+    }
+
+    m_instruction_count_after += count;
+}
+
+void PassManager::dump_statistics() const
+{
+    warnln("Bytecode instructions before optimization: {}", m_instruction_count_before);
+    for (auto const& pass : m_passes) {
+        if (!pass->is_enabled())
+            warnln("    {}: disabled", pass->name());
+        else
+            warnln("    {}: removed {}", pass->name(), pass->removed_instruction_count());
+    }
+    auto removed = m_instruction_count_before - m_instruction_count_after;
+    warnln("Bytecode instructions after optimization: {} ({:.1}% fewer)", m_instruction_count_after,
+        m_instruction_count_before ? 100.0 * removed / m_instruction_count_before : 0.0);
+}
+
+InstructionStreamRewriter::InstructionStreamRewriter(BasicBlock& block)
+    : m_block(block)
+    , m_old_stream(block.take_instruction_stream())
+{
+    m_new_stream.ensure_capacity(m_old_stream.size());
+}
+
+InstructionStreamRewriter::~InstructionStreamRewriter()
+{
+    VERIFY(m_old_offset == m_old_stream.size());
+    m_block.set_instruction_stream(move(m_new_stream));
+}
+
+void InstructionStreamRewriter::consume(Instruction const& instruction)
+{
+    VERIFY(reinterpret_cast<u8 const*>(&instruction) == m_old_stream.data() + m_old_offset);
+    m_old_offset += instruction.length();
+}
+
+void InstructionStreamRewriter::keep(Instruction const& instruction)
+{
+    consume(instruction);
+    // NOTE: Instructions are relocated with a plain copy, just like when a block's buffer grows.
+    m_new_stream.append(reinterpret_cast<u8 const*>(&instruction), instruction.length());
+}
+
+void InstructionStreamRewriter::remove(Instruction const& instruction)
+{
+    consume(instruction);
+    Instruction::destroy(const_cast<Instruction&>(instruction));
+}
+
+void InstructionStreamRewriter::append_instructions_from(BasicBlock& block)
+{
+    VERIFY(&block != &m_block);
+    auto stream = block.take_instruction_stream();
+    m_new_stream.append(stream.data(), stream.size());
+}
+
+size_t instruction_count(BasicBlock const& block)
+{
+    size_t count = 0;
+    for (InstructionStreamIterator it(block.instruction_stream()); !it.at_end(); ++it)
+        ++count;
+    return count;
+}
+
+size_t instruction_count(Executable const& executable)
+{
+    size_t count = 0;
+    for (auto const& block : executable.basic_blocks)
+        count += instruction_count(*block);
+    return count;
+}
+
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibJS/Bytecode/BasicBlock.h>
+#include <LibJS/Bytecode/Instruction.h>
+
+namespace JS::Bytecode {
+
+class Pass {
+public:
+    virtual ~Pass() = default;
+
+    // The name used to refer to this pass in LIBJS_DISABLE_BYTECODE_PASSES and in the statistics.
+    virtual StringView name() const = 0;
+    virtual void perform(Executable&) = 0;
+
+    bool is_enabled() const { return m_enabled; }
+    void set_enabled(bool enabled) { m_enabled = enabled; }
+
+    size_t removed_instruction_count() const { return m_removed_instruction_count; }
+    void did_remove_instructions(size_t count) { m_removed_instruction_count += count; }
+
+private:
+    bool m_enabled { true };
+    size_t m_removed_instruction_count { 0 };
+};
+
+class PassManager {
+public:
+    // The pipeline that the Generator runs on every executable it produces.
+    // Passes can be turned off for debugging by listing their names (or "all") in LIBJS_DISABLE_BYTECODE_PASSES.
+    static PassManager& optimization_pipeline();
+
+    template<typename PassT, typename... Args>
+    void add(Args&&... args)
+    {
+        m_passes.append(make<PassT>(forward<Args>(args)...));
+    }
+
+    void perform(Executable&);
+
+    // Prints how many instructions each pass removed from all the executables seen so far.
+    void dump_statistics() const;
+
+private:
+    Vector<NonnullOwnPtr<Pass>> m_passes;
+    size_t m_instruction_count_before { 0 };
+    size_t m_instruction_count_after { 0 };
+};
+
+// Rebuilds the instruction stream of a basic block. Every instruction of the old stream
+// has to be kept, removed or replaced, in order. The new stream is installed on destruction.
+class InstructionStreamRewriter {
+    AK_MAKE_NONCOPYABLE(InstructionStreamRewriter);
+    AK_MAKE_NONMOVABLE(InstructionStreamRewriter);
+
+public:
+    explicit InstructionStreamRewriter(BasicBlock&);
+    ~InstructionStreamRewriter();
+
+    InstructionStreamIterator old_instructions() const { return InstructionStreamIterator { m_old_stream.span() }; }
+
+    void keep(Instruction const&);
+    void remove(Instruction const&);
+
+    template<typename OpType, typename... Args>
+    void replace(Instruction const& instruction, Args&&... args)
+    {
+        static_assert(!OpType::HasTypeFeedback, "Passes can't hand out new type feedback slots");
+        auto source_record = instruction.source_record();
+        remove(instruction);
+        size_t slot_offset = m_new_stream.size();
+        m_new_stream.resize(slot_offset + sizeof(OpType));
+        auto* op = new (m_new_stream.data() + slot_offset) OpType(forward<Args>(args)...);
+        op->set_source_record(source_record);
+    }
+
+    // Moves all instructions of the given block to the end of the new stream, leaving that block empty.
+    void append_instructions_from(BasicBlock&);
+
+private:
+    void consume(Instruction const&);
+
+    BasicBlock& m_block;
+    Vector<u8> m_old_stream;
+    Vector<u8> m_new_stream;
+    size_t m_old_offset { 0 };
+};
+
+size_t instruction_count(BasicBlock const&);
+size_t instruction_count(Executable const&);
+
+namespace Passes {
+
+// Retargets jumps that land on a block which does nothing but jump somewhere else,
+// and turns conditional jumps whose targets agree into unconditional ones.
+class ThreadJumps final : public Pass {
+public:
+    virtual StringView name() const override { return "jump-threading"sv; }
+    virtual void perform(Executable&) override;
+};
+
+// Drops blocks that can't be reached, and appends blocks to their only predecessor when it jumps straight to them.
+class MergeBlocks final : public Pass {
+public:
+    virtual StringView name() const override { return "block-merging"sv; }
+    virtual void perform(Executable&) override;
+};
+
+// Evaluates arithmetic, comparisons and conditional jumps on constants known within a basic block.
+class ConstantFolding final : public Pass {
+public:
+    virtual StringView name() const override { return "constant-folding"sv; }
+    virtual void perform(Executable&) override;
+};
+
+// Removes loads and stores that move a value to where it already is.
+class CopyPropagation final : public Pass {
+public:
+    virtual StringView name() const override { return "copy-propagation"sv; }
+    virtual void perform(Executable&) override;
+};
+
+// Removes writes to registers, locals and the accumulator that are never read afterwards.
+class DeadStoreElimination final : public Pass {
+public:
+    virtual StringView name() const override { return "dead-store-elimination"sv; }
+    virtual void perform(Executable&) override;
+};
+
+}
+
+}
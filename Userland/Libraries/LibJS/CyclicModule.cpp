@@ -502,6 +502,7 @@ ThrowCompletionOr<u32> CyclicModule::inner_module_evaluation(VM& vm, Vector<Modu
 
             // 2. Append module to requiredModule.[[AsyncParentModules]].
             cyclic_module->m_async_parent_modules.append(this);
+            cyclic_module->write_barrier();
         }
     }
 
@@ -198,6 +198,7 @@ class Parser;
 struct ParserError;
 class PrimitiveString;
 class Program;
+class ProgramCache;
 class PromiseCapability;
 class PromiseReaction;
 class PropertyAttributes;
@@ -311,6 +312,7 @@ class Executable;
 class Generator;
 class Instruction;
 class Interpreter;
+class Label;
 class RegexTable;
 class Register;
 }
@@ -11,19 +11,29 @@
 #include <AK/Forward.h>
 #include <AK/Noncopyable.h>
 #include <AK/StringView.h>
+#include <AK/Weakable.h>
 #include <LibJS/Forward.h>
 #include <LibJS/Heap/GCPtr.h>
 #include <LibJS/Heap/Internals.h>
 
 namespace JS {
 
-#define JS_CELL(class_, base_class)                \
-public:                                            \
-    using Base = base_class;                       \
-    virtual StringView class_name() const override \
-    {                                              \
-        return #class_##sv;                        \
-    }                                              \
+#define JS_CELL(class_, base_class)                                           \
+public:                                                                       \
+    using Base = base_class;                                                  \
+    virtual StringView class_name() const override                            \
+    {                                                                         \
+        return #class_##sv;                                                   \
+    }                                                                         \
+    virtual void revoke_weak_ptrs_to_dead_cell() override                     \
+    {                                                                         \
+        Base::revoke_weak_ptrs_to_dead_cell();                                \
+        [](auto& self) {                                                      \
+            using Self = RemoveCVReference<decltype(self)>;                   \
+            if constexpr (IsBaseOf<AK::Weakable<Self>, Self>)                 \
+                self.AK::Weakable<Self>::revoke_weak_ptrs();                  \
+        }(*this);                                                             \
+    }                                                                         \
     friend class JS::Heap;
 
 class Cell {
@@ -45,6 +55,19 @@ public:
     State state() const { return m_state; }
     void set_state(State state) { m_state = state; }
 
+    bool is_remembered() const { return m_remembered; }
+    void set_remembered(bool b) { m_remembered = b; }
+
+    // Must be called after storing a reference to another cell into this cell by any means other than
+    // assigning to a GCPtr or NonnullGCPtr member (e.g. into a Value, or into a container owned by this cell).
+    // This lets the heap find references stored into cells it has already marked: old cells with generational
+    // garbage collection, or cells that incremental marking has already visited.
+    ALWAYS_INLINE void write_barrier()
+    {
+        if (g_gc_write_barriers_enabled && m_mark && !m_remembered) [[unlikely]]
+            remember();
+    }
+
     virtual StringView class_name() const = 0;
 
     class Visitor {
@@ -94,6 +117,11 @@ public:
     // This will be called on unmarked objects by the garbage collector in a separate pass before destruction.
     virtual void finalize() { }
 
+    // This is called on unmarked objects right after finalize(), and revokes any AK::WeakPtr to them, as their
+    // destruction may be deferred by lazy sweeping. Overrides that do this for the AK::Weakable<T> of each class
+    // are generated by the JS_CELL macro.
+    virtual void revoke_weak_ptrs_to_dead_cell() { }
+
     // This allows cells to survive GC by choice, even if nothing points to them.
     // It's used to implement special rules in the web platform.
     // NOTE: Cells must call set_overrides_must_survive_garbage_collection() for this to be honored.
@@ -110,7 +138,10 @@ protected:
     void set_overrides_must_survive_garbage_collection(bool b) { m_overrides_must_survive_garbage_collection = b; }
 
 private:
+    void remember();
+
     bool m_mark : 1 { false };
+    bool m_remembered : 1 { false };
     bool m_overrides_must_survive_garbage_collection : 1 { false };
     State m_state : 1 { State::Live };
 };
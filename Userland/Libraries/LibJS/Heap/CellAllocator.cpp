@@ -22,8 +22,12 @@ Cell* CellAllocator::allocate_cell(Heap& heap)
     if (!m_list_node.is_in_list())
         heap.register_cell_allocator({}, *this);
 
+    while (m_usable_blocks.is_empty() && sweep_next_pending_block(heap))
+        ;
+
     if (m_usable_blocks.is_empty()) {
         auto block = HeapBlock::create_with_cell_size(heap, *this, m_cell_size);
+        heap.did_create_block({}, *block);
         m_usable_blocks.append(*block.leak_ptr());
     }
 
@@ -36,8 +40,14 @@ Cell* CellAllocator::allocate_cell(Heap& heap)
 }
 
 void CellAllocator::block_did_become_empty(Badge<Heap>, HeapBlock& block)
+{
+    free_block(block);
+}
+
+void CellAllocator::free_block(HeapBlock& block)
 {
     auto& heap = block.heap();
+    heap.will_destroy_block({}, block);
     block.m_list_node.remove();
     // NOTE: HeapBlocks are managed by the BlockAllocator, so we don't want to `delete` the block here.
     block.~HeapBlock();
@@ -50,4 +60,38 @@ void CellAllocator::block_did_become_usable(Badge<Heap>, HeapBlock& block)
     m_usable_blocks.append(block);
 }
 
+void CellAllocator::sweep_blocks_lazily(Badge<Heap>)
+{
+    while (!m_full_blocks.is_empty())
+        m_blocks_pending_sweep.append(*m_full_blocks.first());
+    while (!m_usable_blocks.is_empty())
+        m_blocks_pending_sweep.append(*m_usable_blocks.first());
+}
+
+// Returns false if there was no block left to sweep.
+bool CellAllocator::sweep_next_pending_block(Heap& heap)
+{
+    auto* block = m_blocks_pending_sweep.first();
+    if (!block)
+        return false;
+    heap.sweep_block({}, *block);
+    if (block->is_full())
+        m_full_blocks.append(*block);
+    else
+        m_usable_blocks.append(*block);
+    return true;
+}
+
+void CellAllocator::finish_lazy_sweeping(Badge<Heap>, Heap& heap)
+{
+    while (auto* block = m_blocks_pending_sweep.first()) {
+        if (!heap.sweep_block({}, *block))
+            free_block(*block);
+        else if (block->is_full())
+            m_full_blocks.append(*block);
+        else
+            m_usable_blocks.append(*block);
+    }
+}
+
 }
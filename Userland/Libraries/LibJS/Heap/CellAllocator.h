@@ -40,21 +40,33 @@ public:
             if (callback(block) == IterationDecision::Break)
                 return IterationDecision::Break;
         }
+        for (auto& block : m_blocks_pending_sweep) {
+            if (callback(block) == IterationDecision::Break)
+                return IterationDecision::Break;
+        }
         return IterationDecision::Continue;
     }
 
     void block_did_become_empty(Badge<Heap>, HeapBlock&);
     void block_did_become_usable(Badge<Heap>, HeapBlock&);
 
+    // With lazy sweeping, blocks are swept one at a time as the allocator needs room, instead of all at once after marking.
+    void sweep_blocks_lazily(Badge<Heap>);
+    void finish_lazy_sweeping(Badge<Heap>, Heap&);
+
     IntrusiveListNode<CellAllocator> m_list_node;
     using List = IntrusiveList<&CellAllocator::m_list_node>;
 
 private:
+    bool sweep_next_pending_block(Heap&);
+    void free_block(HeapBlock&);
+
     size_t const m_cell_size;
 
     using BlockList = IntrusiveList<&HeapBlock::m_list_node>;
     BlockList m_full_blocks;
     BlockList m_usable_blocks;
+    BlockList m_blocks_pending_sweep;
 };
 
 template<typename T>
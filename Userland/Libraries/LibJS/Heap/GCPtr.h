@@ -6,11 +6,23 @@
 
 #pragma once
 
+#include <AK/Platform.h>
 #include <AK/Traits.h>
 #include <AK/Types.h>
 
 namespace JS {
 
+// Set while a Heap in this process uses generational collection or incremental marking.
+// Stores into GC pointers then have to tell the heap about references it may not have seen yet.
+extern bool g_gc_write_barriers_enabled;
+void gc_write_barrier_slow(void const* slot);
+
+ALWAYS_INLINE void gc_write_barrier(void const* slot)
+{
+    if (g_gc_write_barriers_enabled) [[unlikely]]
+        gc_write_barrier_slow(slot);
+}
+
 template<typename T>
 class GCPtr;
 
@@ -38,17 +50,28 @@ public:
     {
     }
 
+    NonnullGCPtr(NonnullGCPtr const&) = default;
+
+    NonnullGCPtr& operator=(NonnullGCPtr const& other)
+    {
+        m_ptr = other.m_ptr;
+        gc_write_barrier(this);
+        return *this;
+    }
+
     template<typename U>
     NonnullGCPtr& operator=(NonnullGCPtr<U> const& other)
     requires(IsConvertible<U*, T*>)
     {
         m_ptr = static_cast<T*>(other.ptr());
+        gc_write_barrier(this);
         return *this;
     }
 
     NonnullGCPtr& operator=(T& other)
     {
         m_ptr = &other;
+        gc_write_barrier(this);
         return *this;
     }
 
@@ -57,6 +80,7 @@ public:
     requires(IsConvertible<U*, T*>)
     {
         m_ptr = &static_cast<T&>(other);
+        gc_write_barrier(this);
         return *this;
     }
 
@@ -113,17 +137,28 @@ public:
     {
     }
 
+    GCPtr(GCPtr const&) = default;
+
+    GCPtr& operator=(GCPtr const& other)
+    {
+        m_ptr = other.m_ptr;
+        gc_write_barrier(this);
+        return *this;
+    }
+
     template<typename U>
     GCPtr& operator=(GCPtr<U> const& other)
     requires(IsConvertible<U*, T*>)
     {
         m_ptr = static_cast<T*>(other.ptr());
+        gc_write_barrier(this);
         return *this;
     }
 
     GCPtr& operator=(NonnullGCPtr<T> const& other)
     {
         m_ptr = other.ptr();
+        gc_write_barrier(this);
         return *this;
     }
 
@@ -132,12 +167,14 @@ public:
     requires(IsConvertible<U*, T*>)
     {
         m_ptr = static_cast<T*>(other.ptr());
+        gc_write_barrier(this);
         return *this;
     }
 
     GCPtr& operator=(T& other)
     {
         m_ptr = &other;
+        gc_write_barrier(this);
         return *this;
     }
 
@@ -146,12 +183,14 @@ public:
     requires(IsConvertible<U*, T*>)
     {
         m_ptr = &static_cast<T&>(other);
+        gc_write_barrier(this);
         return *this;
     }
 
     GCPtr& operator=(T* other)
     {
         m_ptr = other;
+        gc_write_barrier(this);
         return *this;
     }
 
@@ -160,6 +199,7 @@ public:
     requires(IsConvertible<U*, T*>)
     {
         m_ptr = static_cast<T*>(other);
+        gc_write_barrier(this);
         return *this;
     }
 
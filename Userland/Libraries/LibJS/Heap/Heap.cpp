@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/Badge.h>
 #include <AK/Debug.h>
 #include <AK/HashTable.h>
@@ -13,6 +14,8 @@
 #include <AK/StackInfo.h>
 #include <AK/TemporaryChange.h>
 #include <LibCore/ElapsedTimer.h>
+#include <LibCore/EventLoop.h>
+#include <LibCore/Timer.h>
 #include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Heap/CellAllocator.h>
 #include <LibJS/Heap/Handle.h>
@@ -40,6 +43,10 @@ static int gc_perf_string_id;
 // NOTE: We keep a per-thread list of custom ranges. This hinges on the assumption that there is one JS VM per thread.
 static __thread HashMap<FlatPtr*, size_t>* s_custom_ranges_for_conservative_scan = nullptr;
 static __thread HashMap<FlatPtr*, SourceLocation*>* s_safe_function_locations = nullptr;
+static __thread Heap* s_heap_with_write_barriers = nullptr;
+
+bool g_gc_write_barriers_enabled = false;
+static Atomic<size_t> s_heaps_with_write_barriers_count { 0 };
 
 Heap::Heap(VM& vm)
     : HeapBase(vm)
@@ -65,22 +72,146 @@ Heap::Heap(VM& vm)
 
 Heap::~Heap()
 {
+    set_generational_collection_enabled(false);
     vm().string_cache().clear();
     vm().byte_string_cache().clear();
+    // This also abandons incremental marking, since the VM's roots can't be gathered anymore.
     collect_garbage(CollectionType::CollectEverything);
+    set_incremental_marking_enabled(false);
 }
 
 void Heap::will_allocate(size_t size)
 {
+    // With generational collection, the threshold is the size of the young generation, which doesn't grow with the heap.
+    auto threshold = m_generational_collection_enabled ? GC_MIN_BYTES_THRESHOLD : m_gc_bytes_threshold;
+
     if (should_collect_on_every_allocation()) {
         m_allocated_bytes_since_last_gc = 0;
-        collect_garbage();
-    } else if (m_allocated_bytes_since_last_gc + size > m_gc_bytes_threshold) {
+        collect_garbage(collection_type_for_allocation());
+    } else if (m_allocated_bytes_since_last_gc + size > threshold) {
         m_allocated_bytes_since_last_gc = 0;
-        collect_garbage();
+        // If incremental marking is still in progress at this point, the mutator is outpacing it, and
+        // collect_garbage() finishes the marking in one go.
+        if (m_incremental_marking_enabled && !is_incremental_marking_in_progress())
+            start_incremental_marking();
+        else
+            collect_garbage(collection_type_for_allocation());
+    } else if (is_incremental_marking_in_progress() && m_allocated_bytes_since_last_marking_slice + size > INCREMENTAL_MARKING_SLICE_BYTES) {
+        perform_incremental_marking_slice();
     }
 
     m_allocated_bytes_since_last_gc += size;
+    m_allocated_bytes_since_last_marking_slice += size;
+}
+
+Heap::CollectionType Heap::collection_type_for_allocation() const
+{
+    if (!m_generational_collection_enabled)
+        return CollectionType::CollectGarbage;
+    // Do a full collection once the old generation has grown as much as it was large after the last one.
+    if (m_promoted_bytes_since_last_full_gc > m_gc_bytes_threshold)
+        return CollectionType::CollectGarbage;
+    return CollectionType::CollectYoungGeneration;
+}
+
+void Heap::set_generational_collection_enabled(bool enabled)
+{
+    if (m_generational_collection_enabled == enabled)
+        return;
+
+    if (enabled) {
+        VERIFY(!m_incremental_marking_enabled);
+        VERIFY(!m_lazy_sweeping_enabled);
+        VERIFY(!m_gc_deferrals);
+        m_generational_collection_enabled = true;
+        update_write_barriers();
+        // Everything that survives this collection stays marked and becomes part of the old generation.
+        collect_garbage();
+        return;
+    }
+
+    clear_all_marks();
+    m_generational_collection_enabled = false;
+    m_promoted_bytes_since_last_full_gc = 0;
+    update_write_barriers();
+}
+
+void Heap::set_incremental_marking_enabled(bool enabled)
+{
+    if (m_incremental_marking_enabled == enabled)
+        return;
+
+    if (enabled) {
+        VERIFY(!m_generational_collection_enabled);
+        m_incremental_marking_enabled = true;
+        update_write_barriers();
+        return;
+    }
+
+    // Marking can't continue without write barriers, so finish it now.
+    if (is_incremental_marking_in_progress())
+        collect_garbage();
+    if (m_incremental_marking_timer)
+        m_incremental_marking_timer->stop();
+    m_incremental_marking_enabled = false;
+    update_write_barriers();
+}
+
+void Heap::set_lazy_sweeping_enabled(bool enabled)
+{
+    if (m_lazy_sweeping_enabled == enabled)
+        return;
+
+    VERIFY(!enabled || !m_generational_collection_enabled);
+    if (!enabled)
+        finish_lazy_sweeping();
+    m_lazy_sweeping_enabled = enabled;
+}
+
+void Heap::update_write_barriers()
+{
+    bool needs_write_barriers = m_generational_collection_enabled || m_incremental_marking_enabled;
+    if (needs_write_barriers == (s_heap_with_write_barriers == this))
+        return;
+
+    if (needs_write_barriers) {
+        VERIFY(!s_heap_with_write_barriers);
+        s_heap_with_write_barriers = this;
+        g_gc_write_barriers_enabled = ++s_heaps_with_write_barriers_count > 0;
+    } else {
+        s_heap_with_write_barriers = nullptr;
+        g_gc_write_barriers_enabled = --s_heaps_with_write_barriers_count > 0;
+    }
+}
+
+void Heap::remember_cell(Badge<Cell>, Cell& cell)
+{
+    // Everything that survives a collection becomes old, and marking is atomic while collecting,
+    // so stores made while collecting don't need to be remembered.
+    if (m_collecting_garbage)
+        return;
+    // Old cells with references to young ones are traced by the next young collection, and cells that
+    // incremental marking has already visited are visited again by the next marking slice.
+    if (!m_generational_collection_enabled && !is_incremental_marking_in_progress())
+        return;
+    cell.set_remembered(true);
+    m_remembered_cells.append(&cell);
+}
+
+void Heap::did_store_into_slot(void const* slot)
+{
+    auto* block = HeapBlock::from_cell(reinterpret_cast<Cell const*>(slot));
+    if (!m_blocks.contains(block))
+        return;
+    auto* cell = block->cell_from_possible_pointer(reinterpret_cast<FlatPtr>(slot));
+    if (cell && cell->state() == Cell::State::Live)
+        cell->write_barrier();
+}
+
+void gc_write_barrier_slow(void const* slot)
+{
+    if (s_heap_with_write_barriers)
+        s_heap_with_write_barriers->did_store_into_slot(slot);
 }
 
 static void add_possible_value(HashMap<FlatPtr, HeapRoot>& possible_pointers, FlatPtr data, HeapRoot origin, FlatPtr min_block_address, FlatPtr max_block_address)
@@ -273,21 +404,52 @@ void Heap::collect_garbage(CollectionType collection_type, bool print_report)
     perf_event(PERF_EVENT_SIGNPOST, gc_perf_string_id, global_gc_counter++);
 #endif
 
-    Core::ElapsedTimer collection_measurement_timer;
-    if (print_report)
-        collection_measurement_timer.start();
+    auto collection_measurement_timer = Core::ElapsedTimer::start_new();
+
+    // Uprooted cells have to be unmarked to be collected, which would make them look young, so they need a full collection.
+    if (collection_type == CollectionType::CollectYoungGeneration && (!m_generational_collection_enabled || !m_uprooted_cells.is_empty()))
+        collection_type = CollectionType::CollectGarbage;
+
+    if (collection_type != CollectionType::CollectEverything && m_gc_deferrals) {
+        if (!m_should_gc_when_deferral_ends || collection_type == CollectionType::CollectGarbage)
+            m_deferred_collection_type = collection_type;
+        m_should_gc_when_deferral_ends = true;
+        return;
+    }
+
+    if (collection_type == CollectionType::CollectYoungGeneration) {
+        collect_young_generation(print_report, collection_measurement_timer);
+        return;
+    }
+
+    if (collection_type == CollectionType::CollectEverything && is_incremental_marking_in_progress()) {
+        m_incremental_marking_visitor = nullptr;
+        m_cells_allocated_during_marking.clear();
+        clear_all_marks();
+    }
+
+    // Blocks that haven't been swept since the last collection still have marks from it.
+    finish_lazy_sweeping();
+
+    // The survivors of previous collections are still marked, so a full collection has to start from scratch.
+    if (m_generational_collection_enabled)
+        clear_all_marks();
 
     if (collection_type == CollectionType::CollectGarbage) {
-        if (m_gc_deferrals) {
-            m_should_gc_when_deferral_ends = true;
-            return;
-        }
         HashMap<Cell*, HeapRoot> roots;
         gather_roots(roots);
         mark_live_cells(roots);
     }
-    finalize_unmarked_cells();
-    sweep_dead_cells(print_report, collection_measurement_timer);
+    auto live_cell_bytes = finalize_unmarked_cells();
+
+    for (auto& weak_container : m_weak_containers)
+        weak_container.remove_dead_cells({});
+
+    if (m_lazy_sweeping_enabled && collection_type == CollectionType::CollectGarbage)
+        sweep_dead_cells_lazily(live_cell_bytes, print_report, collection_measurement_timer);
+    else
+        sweep_dead_cells(print_report, collection_measurement_timer);
+    m_promoted_bytes_since_last_full_gc = 0;
 }
 
 void Heap::gather_roots(HashMap<Cell*, HeapRoot>& roots)
@@ -391,11 +553,11 @@ public:
         : m_heap(heap)
     {
         m_heap.find_min_and_max_block_addresses(m_min_block_address, m_max_block_address);
-        m_heap.for_each_block([&](auto& block) {
-            m_all_live_heap_blocks.set(&block);
-            return IterationDecision::Continue;
-        });
+        visit_roots(roots);
+    }
 
+    void visit_roots(HashMap<Cell*, HeapRoot> const& roots)
+    {
         for (auto* root : roots.keys()) {
             visit(root);
         }
@@ -419,7 +581,7 @@ public:
         for (size_t i = 0; i < (bytes.size() / sizeof(FlatPtr)); ++i)
             add_possible_value(possible_pointers, raw_pointer_sized_values[i], HeapRoot { .type = HeapRoot::Type::HeapFunctionCapturedPointer }, m_min_block_address, m_max_block_address);
 
-        for_each_cell_among_possible_pointers(m_all_live_heap_blocks, possible_pointers, [&](Cell* cell, FlatPtr) {
+        for_each_cell_among_possible_pointers(m_heap.m_blocks, possible_pointers, [&](Cell* cell, FlatPtr) {
             if (cell->is_marked())
                 return;
             if (cell->state() != Cell::State::Live)
@@ -436,10 +598,22 @@ public:
         }
     }
 
+    // Returns whether there is nothing left to mark.
+    bool mark_live_cells_until(MonotonicTime deadline)
+    {
+        static constexpr size_t cells_between_deadline_checks = 256;
+        size_t visited_cells = 0;
+        while (!m_work_queue.is_empty()) {
+            m_work_queue.take_last().visit_edges(*this);
+            if (++visited_cells % cells_between_deadline_checks == 0 && MonotonicTime::now() >= deadline)
+                break;
+        }
+        return m_work_queue.is_empty();
+    }
+
 private:
     Heap& m_heap;
     Vector<Cell&> m_work_queue;
-    HashTable<HeapBlock*> m_all_live_heap_blocks;
     FlatPtr m_min_block_address;
     FlatPtr m_max_block_address;
 };
@@ -448,11 +622,19 @@ void Heap::mark_live_cells(HashMap<Cell*, HeapRoot> const& roots)
 {
     dbgln_if(HEAP_DEBUG, "mark_live_cells:");
 
-    MarkingVisitor visitor(*this, roots);
+    // If incremental marking is in progress, this is its final pause. Everything it has marked so far stays marked,
+    // and the roots are visited again since they may have changed in the meantime.
+    OwnPtr<MarkingVisitor> visitor = move(m_incremental_marking_visitor);
+    if (visitor)
+        visitor->visit_roots(roots);
+    else
+        visitor = make<MarkingVisitor>(*this, roots);
 
-    vm().bytecode_interpreter().visit_edges(visitor);
+    vm().bytecode_interpreter().visit_edges(*visitor);
+
+    visit_remembered_and_newly_allocated_cells(*visitor);
 
-    visitor.mark_all_live_cells();
+    visitor->mark_all_live_cells();
 
     for (auto& inverse_root : m_uprooted_cells)
         inverse_root->set_marked(false);
@@ -460,6 +642,78 @@ void Heap::mark_live_cells(HashMap<Cell*, HeapRoot> const& roots)
     m_uprooted_cells.clear();
 }
 
+void Heap::visit_remembered_and_newly_allocated_cells(MarkingVisitor& visitor)
+{
+    // These are old cells that had references to young ones stored into them, or cells that had references
+    // stored into them after incremental marking visited them. Either way, they have to be visited again.
+    for (auto* cell : m_remembered_cells) {
+        cell->set_remembered(false);
+        cell->visit_edges(visitor);
+    }
+    m_remembered_cells.clear_with_capacity();
+
+    // Cells allocated while incremental marking is in progress are considered reachable.
+    for (auto* cell : m_cells_allocated_during_marking)
+        visitor.visit(cell);
+    m_cells_allocated_during_marking.clear_with_capacity();
+}
+
+void Heap::start_incremental_marking()
+{
+    VERIFY(!is_incremental_marking_in_progress());
+    if (m_gc_deferrals) {
+        collect_garbage();
+        return;
+    }
+
+    auto pause_timer = Core::ElapsedTimer::start_new();
+    finish_lazy_sweeping();
+
+    HashMap<Cell*, HeapRoot> roots;
+    gather_roots(roots);
+    m_incremental_marking_visitor = make<MarkingVisitor>(*this, roots);
+    vm().bytecode_interpreter().visit_edges(*m_incremental_marking_visitor);
+
+    m_allocated_bytes_since_last_marking_slice = 0;
+    record_pause(pause_timer.elapsed_time());
+    schedule_incremental_marking_slice();
+}
+
+void Heap::perform_incremental_marking_slice()
+{
+    if (!is_incremental_marking_in_progress() || m_collecting_garbage)
+        return;
+
+    // Cells that are still being constructed can't be visited, so wait until nothing defers GC anymore.
+    if (m_gc_deferrals) {
+        schedule_incremental_marking_slice();
+        return;
+    }
+
+    auto pause_timer = Core::ElapsedTimer::start_new();
+    auto deadline = MonotonicTime::now() + m_incremental_marking_slice_budget;
+    visit_remembered_and_newly_allocated_cells(*m_incremental_marking_visitor);
+    bool finished = m_incremental_marking_visitor->mark_live_cells_until(deadline);
+    m_allocated_bytes_since_last_marking_slice = 0;
+    record_pause(pause_timer.elapsed_time());
+
+    // The final pause visits the roots again and marks whatever they lead to, then sweeps.
+    if (finished)
+        collect_garbage();
+    else
+        schedule_incremental_marking_slice();
+}
+
+void Heap::schedule_incremental_marking_slice()
+{
+    // Without an event loop, marking only makes progress as the mutator allocates.
+    if (!Core::EventLoop::is_running())
+        return;
+    if (!m_incremental_marking_timer)
+        m_incremental_marking_timer = MUST(Core::Timer::create_single_shot(0, [this] { perform_incremental_marking_slice(); }));
+    m_incremental_marking_timer->restart();
+}
+
 bool Heap::cell_must_survive_garbage_collection(Cell const& cell)
 {
     if (!cell.overrides_must_survive_garbage_collection({}))
@@ -467,15 +721,25 @@ bool Heap::cell_must_survive_garbage_collection(Cell const& cell)
     return cell.must_survive_garbage_collection();
 }
 
-void Heap::finalize_unmarked_cells()
+// Returns the number of bytes in cells that survive the collection.
+size_t Heap::finalize_unmarked_cells()
 {
+    size_t live_cell_bytes = 0;
     for_each_block([&](auto& block) {
-        block.template for_each_cell_in_state<Cell::State::Live>([](Cell* cell) {
-            if (!cell->is_marked() && !cell_must_survive_garbage_collection(*cell))
+        block.template for_each_cell_in_state<Cell::State::Live>([&](Cell* cell) {
+            // Cells that must survive are marked as well, so that weak containers and sweeping only have to look at the mark.
+            if (!cell->is_marked() && cell_must_survive_garbage_collection(*cell))
+                cell->set_marked(true);
+            if (cell->is_marked())
+                live_cell_bytes += block.cell_size();
+            else {
                 cell->finalize();
+                cell->revoke_weak_ptrs_to_dead_cell();
+            }
         });
         return IterationDecision::Continue;
     });
+    return live_cell_bytes;
 }
 
 void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measurement_timer)
@@ -493,13 +757,15 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
         bool block_has_live_cells = false;
         bool block_was_full = block.is_full();
         block.template for_each_cell_in_state<Cell::State::Live>([&](Cell* cell) {
-            if (!cell->is_marked() && !cell_must_survive_garbage_collection(*cell)) {
+            if (!cell->is_marked()) {
                 dbgln_if(HEAP_DEBUG, "  ~ {}", cell);
                 block.deallocate(cell);
                 ++collected_cells;
                 collected_cell_bytes += block.cell_size();
             } else {
-                cell->set_marked(false);
+                // With generational collection, surviving cells stay marked to show that they are old.
+                if (!m_generational_collection_enabled)
+                    cell->set_marked(false);
                 block_has_live_cells = true;
                 ++live_cells;
                 live_cell_bytes += block.cell_size();
@@ -512,9 +778,6 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
         return IterationDecision::Continue;
     });
 
-    for (auto& weak_container : m_weak_containers)
-        weak_container.remove_dead_cells({});
-
     for (auto* block : empty_blocks) {
         dbgln_if(HEAP_DEBUG, " - HeapBlock empty @ {}: cell_size={}", block, block->cell_size());
         block->cell_allocator().block_did_become_empty({}, *block);
@@ -534,8 +797,10 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
 
     m_gc_bytes_threshold = live_cell_bytes > GC_MIN_BYTES_THRESHOLD ? live_cell_bytes : GC_MIN_BYTES_THRESHOLD;
 
+    Duration const time_spent = measurement_timer.elapsed_time();
+    record_pause(time_spent);
+
     if (print_report) {
-        Duration const time_spent = measurement_timer.elapsed_time();
         size_t live_block_count = 0;
         for_each_block([&](auto&) {
             ++live_block_count;
@@ -549,6 +814,164 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
         dbgln("Collected cells: {} ({} bytes)", collected_cells, collected_cell_bytes);
         dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
         dbgln("   Freed blocks: {} ({} bytes)", empty_blocks.size(), empty_blocks.size() * HeapBlock::block_size);
+        dump_pause_histogram();
+        dbgln("=============================================");
+    }
+}
+
+void Heap::sweep_dead_cells_lazily(size_t live_cell_bytes, bool print_report, Core::ElapsedTimer const& measurement_timer)
+{
+    dbgln_if(HEAP_DEBUG, "sweep_dead_cells_lazily:");
+
+    // Dead cells have been finalized, and their blocks are swept when they are needed for allocation, or before the next collection.
+    for (auto& allocator : m_all_cell_allocators)
+        allocator.sweep_blocks_lazily({});
+
+    m_gc_bytes_threshold = live_cell_bytes > GC_MIN_BYTES_THRESHOLD ? live_cell_bytes : GC_MIN_BYTES_THRESHOLD;
+
+    Duration const time_spent = measurement_timer.elapsed_time();
+    record_pause(time_spent);
+
+    if (print_report) {
+        dbgln("Garbage collection report");
+        dbgln("=============================================");
+        dbgln("     Time spent: {} ms", time_spent.to_milliseconds());
+        dbgln("     Live cells: {} bytes", live_cell_bytes);
+        dbgln("Dead cells will be swept lazily");
+        dump_pause_histogram();
+        dbgln("=============================================");
+    }
+}
+
+bool Heap::sweep_block(Badge<CellAllocator>, HeapBlock& block)
+{
+    bool block_has_live_cells = false;
+    block.for_each_cell_in_state<Cell::State::Live>([&](Cell* cell) {
+        if (!cell->is_marked()) {
+            block.deallocate(cell);
+        } else {
+            cell->set_marked(false);
+            block_has_live_cells = true;
+        }
+    });
+    return block_has_live_cells;
+}
+
+void Heap::finish_lazy_sweeping()
+{
+    for (auto& allocator : m_all_cell_allocators)
+        allocator.finish_lazy_sweeping({}, *this);
+}
+
+void Heap::record_pause(Duration pause)
+{
+    size_t bucket = 0;
+    for (i64 limit_in_microseconds = 1000; bucket < m_pause_histogram.size() - 1 && pause.to_microseconds() >= limit_in_microseconds; limit_in_microseconds *= 2)
+        ++bucket;
+    ++m_pause_histogram[bucket];
+}
+
+void Heap::dump_pause_histogram() const
+{
+    dbgln("Pause histogram:");
+    for (size_t i = 0; i < m_pause_histogram.size() - 1; ++i)
+        dbgln("{:>10} ms: {}", ByteString::formatted("< {}", 1 << i), m_pause_histogram[i]);
+    dbgln("{:>10} ms: {}", ByteString::formatted(">= {}", 1 << (m_pause_histogram.size() - 2)), m_pause_histogram.last());
+}
+
+void Heap::clear_all_marks()
+{
+    for_each_block([&](auto& block) {
+        block.template for_each_cell_in_state<Cell::State::Live>([](Cell* cell) {
+            cell->set_marked(false);
+            cell->set_remembered(false);
+        });
+        return IterationDecision::Continue;
+    });
+    m_young_cells.clear_with_capacity();
+    m_remembered_cells.clear_with_capacity();
+}
+
+void Heap::forget_young_generation()
+{
+    m_young_cells.clear_with_capacity();
+    for (auto* cell : m_remembered_cells)
+        cell->set_remembered(false);
+    m_remembered_cells.clear_with_capacity();
+}
+
+void Heap::collect_young_generation(bool print_report, Core::ElapsedTimer const& measurement_timer)
+{
+    dbgln_if(HEAP_DEBUG, "collect_young_generation: {} young cells, {} remembered cells", m_young_cells.size(), m_remembered_cells.size());
+
+    HashMap<Cell*, HeapRoot> roots;
+    gather_roots(roots);
+    mark_live_cells(roots);
+
+    for (auto* cell : m_young_cells) {
+        if (!cell->is_marked() && cell_must_survive_garbage_collection(*cell))
+            cell->set_marked(true);
+        if (!cell->is_marked())
+            cell->finalize();
+    }
+
+    for (auto& weak_container : m_weak_containers)
+        weak_container.remove_dead_cells({});
+
+    HashMap<HeapBlock*, bool> touched_blocks_and_whether_they_were_full;
+    size_t collected_cells = 0;
+    size_t promoted_cells = 0;
+    size_t collected_cell_bytes = 0;
+    size_t promoted_cell_bytes = 0;
+
+    for (auto* cell : m_young_cells) {
+        auto* block = HeapBlock::from_cell(cell);
+        touched_blocks_and_whether_they_were_full.ensure(block, [&] { return block->is_full(); });
+        if (!cell->is_marked()) {
+            dbgln_if(HEAP_DEBUG, "  ~ {}", cell);
+            block->deallocate(cell);
+            ++collected_cells;
+            collected_cell_bytes += block->cell_size();
+        } else {
+            ++promoted_cells;
+            promoted_cell_bytes += block->cell_size();
+        }
+    }
+
+    Vector<HeapBlock*, 32> empty_blocks;
+    Vector<HeapBlock*, 32> full_blocks_that_became_usable;
+    for (auto& it : touched_blocks_and_whether_they_were_full) {
+        auto* block = it.key;
+        bool block_has_live_cells = false;
+        block->for_each_cell_in_state<Cell::State::Live>([&](Cell*) {
+            block_has_live_cells = true;
+        });
+        if (!block_has_live_cells)
+            empty_blocks.append(block);
+        else if (it.value != block->is_full())
+            full_blocks_that_became_usable.append(block);
+    }
+
+    for (auto* block : empty_blocks)
+        block->cell_allocator().block_did_become_empty({}, *block);
+
+    for (auto* block : full_blocks_that_became_usable)
+        block->cell_allocator().block_did_become_usable({}, *block);
+
+    forget_young_generation();
+    m_promoted_bytes_since_last_full_gc += promoted_cell_bytes;
+
+    Duration const time_spent = measurement_timer.elapsed_time();
+    record_pause(time_spent);
+
+    if (print_report) {
+        dbgln("Young generation collection report");
+        dbgln("=============================================");
+        dbgln("     Time spent: {} ms", time_spent.to_milliseconds());
+        dbgln(" Promoted cells: {} ({} bytes)", promoted_cells, promoted_cell_bytes);
+        dbgln("Collected cells: {} ({} bytes)", collected_cells, collected_cell_bytes);
+        dbgln("   Freed blocks: {} ({} bytes)", empty_blocks.size(), empty_blocks.size() * HeapBlock::block_size);
+        dump_pause_histogram();
         dbgln("=============================================");
     }
 }
@@ -565,7 +988,7 @@ void Heap::undefer_gc()
 
     if (!m_gc_deferrals) {
         if (m_should_gc_when_deferral_ends)
-            collect_garbage();
+            collect_garbage(m_deferred_collection_type);
         m_should_gc_when_deferral_ends = false;
     }
 }
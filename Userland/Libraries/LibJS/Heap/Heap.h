@@ -6,11 +6,15 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Badge.h>
 #include <AK/HashTable.h>
 #include <AK/IntrusiveList.h>
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefPtr.h>
+#include <AK/Time.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCore/Forward.h>
@@ -28,6 +32,8 @@
 
 namespace JS {
 
+class MarkingVisitor;
+
 class Heap : public HeapBase {
     AK_MAKE_NONCOPYABLE(Heap);
     AK_MAKE_NONMOVABLE(Heap);
@@ -61,6 +67,7 @@ public:
     enum class CollectionType {
         CollectGarbage,
         CollectEverything,
+        CollectYoungGeneration,
     };
 
     void collect_garbage(CollectionType = CollectionType::CollectGarbage, bool print_report = false);
@@ -69,6 +76,31 @@ public:
     bool should_collect_on_every_allocation() const { return m_should_collect_on_every_allocation; }
     void set_should_collect_on_every_allocation(bool b) { m_should_collect_on_every_allocation = b; }
 
+    // With generational collection, cells that survive a collection become "old" and stay marked, and most
+    // collections only trace and sweep the cells allocated since the previous one. References from old cells to
+    // young ones are found through write barriers: assignments to GCPtr and NonnullGCPtr are covered automatically,
+    // but any other store of a cell reference into an existing cell must be followed by Cell::write_barrier().
+    // LibJS runtime objects do this for their property storage, environments and internal slots, but embedders
+    // that keep references in other places must not enable this.
+    bool is_generational_collection_enabled() const { return m_generational_collection_enabled; }
+    void set_generational_collection_enabled(bool);
+
+    // With incremental marking, a collection triggered by allocation only gathers the roots, and the marking is then
+    // done in slices of bounded duration, from the event loop and as the mutator allocates. The sweep happens in a
+    // final pause that visits the roots again. Stores into cells that have already been visited are caught by the
+    // same write barriers as with generational collection, so the same caveat applies.
+    bool is_incremental_marking_enabled() const { return m_incremental_marking_enabled; }
+    void set_incremental_marking_enabled(bool);
+    bool is_incremental_marking_in_progress() const { return m_incremental_marking_visitor.ptr() != nullptr; }
+    void set_incremental_marking_slice_budget(Duration budget) { m_incremental_marking_slice_budget = budget; }
+
+    // With lazy sweeping, dead cells are finalized after marking, but their blocks are only swept once the
+    // CellAllocator needs room in them, or before the next collection. The heap revokes AK::WeakPtrs to dead cells
+    // right after finalizing them, but cells that can be found through anything else that isn't a strong reference
+    // (e.g. caches keyed by raw pointers) must become unreachable in finalize(), not in their destructor.
+    bool is_lazy_sweeping_enabled() const { return m_lazy_sweeping_enabled; }
+    void set_lazy_sweeping_enabled(bool);
+
     void did_create_handle(Badge<HandleImpl>, HandleImpl&);
     void did_destroy_handle(Badge<HandleImpl>, HandleImpl&);
 
@@ -82,6 +114,11 @@ public:
     void did_destroy_execution_context(Badge<ExecutionContext>, ExecutionContext&);
 
     void register_cell_allocator(Badge<CellAllocator>, CellAllocator&);
+    void did_create_block(Badge<CellAllocator>, HeapBlock&);
+    void will_destroy_block(Badge<CellAllocator>, HeapBlock&);
+    bool sweep_block(Badge<CellAllocator>, HeapBlock&);
+
+    void remember_cell(Badge<Cell>, Cell&);
 
     BlockAllocator& block_allocator() { return m_block_allocator; }
 
@@ -91,6 +128,7 @@ private:
     friend class MarkingVisitor;
     friend class GraphConstructorVisitor;
     friend class DeferGC;
+    friend void gc_write_barrier_slow(void const*);
 
     void defer_gc();
     void undefer_gc();
@@ -101,23 +139,47 @@ private:
     Cell* allocate_cell()
     {
         will_allocate(sizeof(T));
+        Cell* cell = nullptr;
         if constexpr (requires { T::cell_allocator.allocator.get().allocate_cell(*this); }) {
             if constexpr (IsSame<T, typename decltype(T::cell_allocator)::CellType>) {
-                return T::cell_allocator.allocator.get().allocate_cell(*this);
+                cell = T::cell_allocator.allocator.get().allocate_cell(*this);
             }
         }
-        return allocator_for_size(sizeof(T)).allocate_cell(*this);
+        if (!cell)
+            cell = allocator_for_size(sizeof(T)).allocate_cell(*this);
+        if (m_generational_collection_enabled)
+            m_young_cells.append(cell);
+        else if (is_incremental_marking_in_progress())
+            m_cells_allocated_during_marking.append(cell);
+        return cell;
     }
 
     void will_allocate(size_t);
+    CollectionType collection_type_for_allocation() const;
+    void did_store_into_slot(void const* slot);
 
     void find_min_and_max_block_addresses(FlatPtr& min_address, FlatPtr& max_address);
     void gather_roots(HashMap<Cell*, HeapRoot>&);
     void gather_conservative_roots(HashMap<Cell*, HeapRoot>&);
     void gather_asan_fake_stack_roots(HashMap<FlatPtr, HeapRoot>&, FlatPtr, FlatPtr min_block_address, FlatPtr max_block_address);
     void mark_live_cells(HashMap<Cell*, HeapRoot> const& live_cells);
-    void finalize_unmarked_cells();
+    void visit_remembered_and_newly_allocated_cells(MarkingVisitor&);
+    size_t finalize_unmarked_cells();
     void sweep_dead_cells(bool print_report, Core::ElapsedTimer const&);
+    void sweep_dead_cells_lazily(size_t live_cell_bytes, bool print_report, Core::ElapsedTimer const&);
+    void finish_lazy_sweeping();
+
+    void start_incremental_marking();
+    void perform_incremental_marking_slice();
+    void schedule_incremental_marking_slice();
+    void update_write_barriers();
+
+    void record_pause(Duration);
+    void dump_pause_histogram() const;
+
+    void clear_all_marks();
+    void forget_young_generation();
+    void collect_young_generation(bool print_report, Core::ElapsedTimer const&);
 
     ALWAYS_INLINE CellAllocator& allocator_for_size(size_t cell_size)
     {
@@ -145,6 +207,25 @@ private:
 
     bool m_should_collect_on_every_allocation { false };
 
+    bool m_generational_collection_enabled { false };
+    Vector<Cell*> m_young_cells;
+    Vector<Cell*> m_remembered_cells;
+    HashTable<HeapBlock*> m_blocks;
+    size_t m_promoted_bytes_since_last_full_gc { 0 };
+
+    static constexpr size_t INCREMENTAL_MARKING_SLICE_BYTES { 256 * 1024 };
+    bool m_incremental_marking_enabled { false };
+    OwnPtr<MarkingVisitor> m_incremental_marking_visitor;
+    Vector<Cell*> m_cells_allocated_during_marking;
+    Duration m_incremental_marking_slice_budget { Duration::from_milliseconds(2) };
+    size_t m_allocated_bytes_since_last_marking_slice { 0 };
+    RefPtr<Core::Timer> m_incremental_marking_timer;
+
+    bool m_lazy_sweeping_enabled { false };
+
+    // Number of collection pauses (including incremental marking slices) that took < 1 ms, < 2 ms, ..., < 128 ms, and >= 128 ms.
+    AK::Array<size_t, 9> m_pause_histogram {};
+
     Vector<NonnullOwnPtr<CellAllocator>> m_size_based_cell_allocators;
     CellAllocator::List m_all_cell_allocators;
 
@@ -158,6 +239,7 @@ private:
 
     size_t m_gc_deferrals { 0 };
     bool m_should_gc_when_deferral_ends { false };
+    CollectionType m_deferred_collection_type { CollectionType::CollectYoungGeneration };
 
     bool m_collecting_garbage { false };
 };
@@ -203,4 +285,14 @@ inline void Heap::register_cell_allocator(Badge<CellAllocator>, CellAllocator& a
     m_all_cell_allocators.append(allocator);
 }
 
+inline void Heap::did_create_block(Badge<CellAllocator>, HeapBlock& block)
+{
+    m_blocks.set(&block);
+}
+
+inline void Heap::will_destroy_block(Badge<CellAllocator>, HeapBlock& block)
+{
+    m_blocks.remove(&block);
+}
+
 }
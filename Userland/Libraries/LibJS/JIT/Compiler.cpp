@@ -53,6 +53,10 @@ namespace JS::JIT {
 
 void Compiler::store_vm_register(Bytecode::Register dst, Assembler::Reg src)
 {
+    if (dst.index() >= Bytecode::Register::reserved_register_count) {
+        store_allocatable_value({ AllocatableValue::Kind::Register, dst.index() }, src);
+        return;
+    }
     m_assembler.mov(
         Assembler::Operand::Mem64BaseAndOffset(REGISTER_ARRAY_BASE, dst.index() * sizeof(Value)),
         Assembler::Operand::Register(src));
@@ -60,6 +64,10 @@ void Compiler::store_vm_register(Bytecode::Register dst, Assembler::Reg src)
 
 void Compiler::load_vm_register(Assembler::Reg dst, Bytecode::Register src)
 {
+    if (src.index() >= Bytecode::Register::reserved_register_count) {
+        load_allocatable_value(dst, { AllocatableValue::Kind::Register, src.index() });
+        return;
+    }
     m_assembler.mov(
         Assembler::Operand::Register(dst),
         Assembler::Operand::Mem64BaseAndOffset(REGISTER_ARRAY_BASE, src.index() * sizeof(Value)));
@@ -95,16 +103,123 @@ void Compiler::flush_cached_accumulator()
 
 void Compiler::store_vm_local(size_t dst, Assembler::Reg src)
 {
-    m_assembler.mov(
-        Assembler::Operand::Mem64BaseAndOffset(LOCALS_ARRAY_BASE, dst * sizeof(Value)),
-        Assembler::Operand::Register(src));
+    store_allocatable_value({ AllocatableValue::Kind::Local, static_cast<u32>(dst) }, src);
 }
 
 void Compiler::load_vm_local(Assembler::Reg dst, size_t src)
 {
+    load_allocatable_value(dst, { AllocatableValue::Kind::Local, static_cast<u32>(src) });
+}
+
+Assembler::Operand Compiler::register_file_slot(AllocatableValue value)
+{
+    if (value.kind == AllocatableValue::Kind::Local)
+        return Assembler::Operand::Mem64BaseAndOffset(LOCALS_ARRAY_BASE, value.index * sizeof(Value));
+    return Assembler::Operand::Mem64BaseAndOffset(REGISTER_ARRAY_BASE, value.index * sizeof(Value));
+}
+
+Compiler::AllocatedValue* Compiler::allocated_value(AllocatableValue value)
+{
+    for (auto& allocated_value : m_allocated_values) {
+        if (allocated_value.value == value)
+            return &allocated_value;
+    }
+    return nullptr;
+}
+
+void Compiler::load_allocatable_value(Assembler::Reg dst, AllocatableValue value)
+{
+    if (auto* allocated = allocated_value(value)) {
+        m_assembler.mov(
+            Assembler::Operand::Register(dst),
+            Assembler::Operand::Register(allocated->reg));
+        return;
+    }
     m_assembler.mov(
         Assembler::Operand::Register(dst),
-        Assembler::Operand::Mem64BaseAndOffset(LOCALS_ARRAY_BASE, src * sizeof(Value)));
+        register_file_slot(value));
+}
+
+void Compiler::store_allocatable_value(AllocatableValue value, Assembler::Reg src)
+{
+    if (auto* allocated = allocated_value(value)) {
+        m_assembler.mov(
+            Assembler::Operand::Register(allocated->reg),
+            Assembler::Operand::Register(src));
+        allocated->dirty = true;
+        return;
+    }
+    m_assembler.mov(
+        register_file_slot(value),
+        Assembler::Operand::Register(src));
+}
+
+void Compiler::begin_block_register_allocation(ReadonlySpan<Bytecode::Instruction const*> instructions)
+{
+    VERIFY(m_allocated_values.is_empty());
+    m_live_intervals = RegisterAllocator::allocate(instructions, ALLOCATABLE_REGISTERS);
+    m_next_live_interval = 0;
+}
+
+void Compiler::update_allocated_registers(size_t instruction_index)
+{
+    // NOTE: This runs between instructions, where every path through the previous instruction has joined up again,
+    //       so the set of values living in machine registers is the same no matter how we got here.
+    m_allocated_values.remove_all_matching([&](auto const& allocated) {
+        if (allocated.end >= instruction_index)
+            return false;
+        if (allocated.dirty) {
+            m_assembler.mov(
+                register_file_slot(allocated.value),
+                Assembler::Operand::Register(allocated.reg));
+        }
+        return true;
+    });
+
+    while (m_next_live_interval < m_live_intervals.size() && m_live_intervals[m_next_live_interval].start == instruction_index) {
+        auto const& interval = m_live_intervals[m_next_live_interval++];
+        if (!interval.starts_with_write) {
+            m_assembler.mov(
+                Assembler::Operand::Register(interval.reg),
+                register_file_slot(interval.value));
+        }
+        m_allocated_values.append({ interval.value, interval.reg, interval.end });
+    }
+}
+
+bool Compiler::has_dirty_allocated_registers() const
+{
+    return any_of(m_allocated_values, [](auto const& allocated) { return allocated.dirty; });
+}
+
+void Compiler::spill_allocated_registers()
+{
+    // NOTE: This doesn't clear the dirty flags, since we may be on a path that other paths through the
+    //       current instruction join up with later.
+    for (auto const& allocated : m_allocated_values) {
+        if (!allocated.dirty)
+            continue;
+        m_assembler.mov(
+            register_file_slot(allocated.value),
+            Assembler::Operand::Register(allocated.reg));
+    }
+}
+
+void Compiler::flush_allocated_registers()
+{
+    // Only valid between instructions.
+    spill_allocated_registers();
+    for (auto& allocated : m_allocated_values)
+        allocated.dirty = false;
+}
+
+void Compiler::reload_allocated_registers()
+{
+    for (auto const& allocated : m_allocated_values) {
+        m_assembler.mov(
+            Assembler::Operand::Register(allocated.reg),
+            register_file_slot(allocated.value));
+    }
 }
 
 void Compiler::compile_load_immediate(Bytecode::Op::LoadImmediate const& op)
@@ -369,93 +484,109 @@ void Compiler::convert_to_double(Assembler::Reg dst, Assembler::Reg src, Assembl
 }
 
 template<typename CodegenI32, typename CodegenDouble, typename CodegenValue>
-void Compiler::compile_binary_op_fastpaths(Assembler::Reg lhs, Assembler::Reg rhs, CodegenI32 codegen_i32, CodegenDouble codegen_double, CodegenValue codegen_value)
+void Compiler::compile_binary_op_fastpaths(Assembler::Reg lhs, Assembler::Reg rhs, TypeSpecialization specialization, CodegenI32 codegen_i32, CodegenDouble codegen_double, CodegenValue codegen_value)
 {
     Assembler::Label end {};
     Assembler::Label slow_case {};
 
     // The only case where we can take the int32 fastpath
-    branch_if_both_int32(lhs, rhs, [&] {
-        // use GPR0 to preserve lhs for the slow case
-        m_assembler.mov32(
-            Assembler::Operand::Register(GPR0),
-            Assembler::Operand::Register(lhs));
-        store_accumulator(codegen_i32(GPR0, rhs, slow_case));
+    if (specialization != TypeSpecialization::Double) {
+        branch_if_both_int32(lhs, rhs, [&] {
+            // use GPR0 to preserve lhs for the slow case
+            m_assembler.mov32(
+                Assembler::Operand::Register(GPR0),
+                Assembler::Operand::Register(lhs));
+            store_accumulator(codegen_i32(GPR0, rhs, slow_case));
 
-        // accumulator |= SHIFTED_INT32_TAG;
+            // accumulator |= SHIFTED_INT32_TAG;
+            m_assembler.mov(
+                Assembler::Operand::Register(GPR0),
+                Assembler::Operand::Imm(SHIFTED_INT32_TAG));
+            m_assembler.bitwise_or(
+                Assembler::Operand::Register(CACHED_ACCUMULATOR),
+                Assembler::Operand::Register(GPR0));
+            m_assembler.jump(end);
+        });
+    }
+
+    if (specialization != TypeSpecialization::Int32) {
+        // accumulator = op_double(lhs.to_double(), rhs.to_double()) [if not numeric goto slow_case]
+        auto temp_register = GPR0;
+        auto nan_register = GPR1;
+        m_assembler.mov(Assembler::Operand::Register(nan_register), Assembler::Operand::Imm(CANON_NAN_BITS));
+        convert_to_double(FPR0, ARG1, nan_register, temp_register, slow_case);
+        convert_to_double(FPR1, ARG2, nan_register, temp_register, slow_case);
+        auto result_fp_register = codegen_double(FPR0, FPR1);
+        // if result != result then result = nan (canonical)
+        Assembler::Label nan_case;
+        m_assembler.jump_if(
+            Assembler::Operand::FloatRegister(result_fp_register),
+            Assembler::Condition::Unordered,
+            Assembler::Operand::FloatRegister(result_fp_register),
+            nan_case);
         m_assembler.mov(
-            Assembler::Operand::Register(GPR0),
-            Assembler::Operand::Imm(SHIFTED_INT32_TAG));
-        m_assembler.bitwise_or(
             Assembler::Operand::Register(CACHED_ACCUMULATOR),
-            Assembler::Operand::Register(GPR0));
+            Assembler::Operand::FloatRegister(result_fp_register));
         m_assembler.jump(end);
-    });
-
-    // accumulator = op_double(lhs.to_double(), rhs.to_double()) [if not numeric goto slow_case]
-    auto temp_register = GPR0;
-    auto nan_register = GPR1;
-    m_assembler.mov(Assembler::Operand::Register(nan_register), Assembler::Operand::Imm(CANON_NAN_BITS));
-    convert_to_double(FPR0, ARG1, nan_register, temp_register, slow_case);
-    convert_to_double(FPR1, ARG2, nan_register, temp_register, slow_case);
-    auto result_fp_register = codegen_double(FPR0, FPR1);
-    // if result != result then result = nan (canonical)
-    Assembler::Label nan_case;
-    m_assembler.jump_if(
-        Assembler::Operand::FloatRegister(result_fp_register),
-        Assembler::Condition::Unordered,
-        Assembler::Operand::FloatRegister(result_fp_register),
-        nan_case);
-    m_assembler.mov(
-        Assembler::Operand::Register(CACHED_ACCUMULATOR),
-        Assembler::Operand::FloatRegister(result_fp_register));
-    m_assembler.jump(end);
-    nan_case.link(m_assembler);
-    m_assembler.mov(
-        Assembler::Operand::Register(CACHED_ACCUMULATOR),
-        Assembler::Operand::Register(nan_register));
-    m_assembler.jump(end);
+        nan_case.link(m_assembler);
+        m_assembler.mov(
+            Assembler::Operand::Register(CACHED_ACCUMULATOR),
+            Assembler::Operand::Register(nan_register));
+        m_assembler.jump(end);
+    }
 
     slow_case.link(m_assembler);
 
-    // accumulator = TRY(op_value(lhs, rhs))
-    store_accumulator(codegen_value(lhs, rhs));
-    check_exception();
+    if (specialization == TypeSpecialization::Generic) {
+        // accumulator = TRY(op_value(lhs, rhs))
+        store_accumulator(codegen_value(lhs, rhs));
+        check_exception();
+    } else {
+        deoptimize();
+    }
     end.link(m_assembler);
 }
 
 template<typename CodegenI32, typename CodegenDouble, typename CodegenValue>
-void Compiler::compiler_comparison_fastpaths(Assembler::Reg lhs, Assembler::Reg rhs, CodegenI32 codegen_i32, CodegenDouble codegen_double, CodegenValue codegen_value)
+void Compiler::compiler_comparison_fastpaths(Assembler::Reg lhs, Assembler::Reg rhs, TypeSpecialization specialization, CodegenI32 codegen_i32, CodegenDouble codegen_double, CodegenValue codegen_value)
 {
     Assembler::Label end {};
     Assembler::Label slow_case {};
 
     // The only case where we can take the int32 fastpath
-    branch_if_both_int32(lhs, rhs, [&] {
-        store_accumulator(codegen_i32(lhs, rhs));
+    if (specialization != TypeSpecialization::Double) {
+        branch_if_both_int32(lhs, rhs, [&] {
+            store_accumulator(codegen_i32(lhs, rhs));
 
-        // accumulator |= SHIFTED_BOOLEAN_TAG;
-        m_assembler.jump(end);
-    });
+            // accumulator |= SHIFTED_BOOLEAN_TAG;
+            m_assembler.jump(end);
+        });
+    }
 
-    // accumulator = op_double(lhs.to_double(), rhs.to_double())
-    auto temp_register = GPR0;
-    auto nan_register = GPR1;
-    m_assembler.mov(Assembler::Operand::Register(nan_register), Assembler::Operand::Imm(CANON_NAN_BITS));
-    convert_to_double(FPR0, ARG1, nan_register, temp_register, slow_case);
-    convert_to_double(FPR1, ARG2, nan_register, temp_register, slow_case);
-    store_accumulator(codegen_double(FPR0, FPR1));
-    m_assembler.jump(end);
+    if (specialization != TypeSpecialization::Int32) {
+        // accumulator = op_double(lhs.to_double(), rhs.to_double())
+        auto temp_register = GPR0;
+        auto nan_register = GPR1;
+        m_assembler.mov(Assembler::Operand::Register(nan_register), Assembler::Operand::Imm(CANON_NAN_BITS));
+        convert_to_double(FPR0, ARG1, nan_register, temp_register, slow_case);
+        convert_to_double(FPR1, ARG2, nan_register, temp_register, slow_case);
+        store_accumulator(codegen_double(FPR0, FPR1));
+        m_assembler.jump(end);
+    }
 
     slow_case.link(m_assembler);
 
-    // accumulator = TRY(op_value(lhs, rhs))
-    store_accumulator(codegen_value(lhs, rhs));
-    check_exception();
+    if (specialization == TypeSpecialization::Generic) {
+        // accumulator = TRY(op_value(lhs, rhs))
+        store_accumulator(codegen_value(lhs, rhs));
+        check_exception();
+    } else {
+        deoptimize();
+    }
     end.link(m_assembler);
 }
 
-void Compiler::compile_increment(Bytecode::Op::Increment const&)
+void Compiler::compile_increment(Bytecode::Op::Increment const& op)
 {
     load_accumulator(ARG1);
 
@@ -485,9 +616,14 @@ void Compiler::compile_increment(Bytecode::Op::Increment const&)
     });
 
     slow_case.link(m_assembler);
-    native_call((void*)cxx_increment);
-    store_accumulator(RET);
-    check_exception();
+    // NOTE: We only have an inline int32 path, so anything but int32 specialization means a generic slow path.
+    if (type_specialization_for(op.type_feedback_slot()) == TypeSpecialization::Int32) {
+        deoptimize();
+    } else {
+        native_call((void*)cxx_increment);
+        store_accumulator(RET);
+        check_exception();
+    }
 
     end.link(m_assembler);
 }
@@ -500,7 +636,7 @@ static Value cxx_decrement(VM& vm, Value value)
     return BigInt::create(vm, old_value.as_bigint().big_integer().minus(Crypto::SignedBigInteger { 1 }));
 }
 
-void Compiler::compile_decrement(Bytecode::Op::Decrement const&)
+void Compiler::compile_decrement(Bytecode::Op::Decrement const& op)
 {
     load_accumulator(ARG1);
 
@@ -533,13 +669,52 @@ void Compiler::compile_decrement(Bytecode::Op::Decrement const&)
     });
 
     slow_case.link(m_assembler);
-    native_call((void*)cxx_decrement);
-    store_accumulator(RET);
-    check_exception();
+    // NOTE: We only have an inline int32 path, so anything but int32 specialization means a generic slow path.
+    if (type_specialization_for(op.type_feedback_slot()) == TypeSpecialization::Int32) {
+        deoptimize();
+    } else {
+        native_call((void*)cxx_decrement);
+        store_accumulator(RET);
+        check_exception();
+    }
 
     end.link(m_assembler);
 }
 
+Compiler::TypeSpecialization Compiler::type_specialization_for(u32 type_feedback_slot) const
+{
+    if (m_bytecode_executable.deoptimization_count() >= Bytecode::Executable::max_deoptimization_count)
+        return TypeSpecialization::Generic;
+
+    auto const& feedback = m_bytecode_executable.type_feedback[type_feedback_slot];
+    if (feedback.has_observed_only(Bytecode::TypeFeedback::Int32))
+        return TypeSpecialization::Int32;
+    if (feedback.has_observed_only(Bytecode::TypeFeedback::Double))
+        return TypeSpecialization::Double;
+    if (feedback.has_observed_only(Bytecode::TypeFeedback::Int32 | Bytecode::TypeFeedback::Double))
+        return TypeSpecialization::Number;
+    return TypeSpecialization::Generic;
+}
+
+static void cxx_deoptimize(VM& vm, size_t block_index, size_t bytecode_offset)
+{
+    vm.bytecode_interpreter().request_deoptimization(block_index, bytecode_offset);
+}
+
+void Compiler::deoptimize()
+{
+    // NOTE: Specialized instructions only bail out before they have changed anything,
+    //       so the interpreter can simply run the current instruction again.
+    m_assembler.mov(
+        Assembler::Operand::Register(ARG1),
+        Assembler::Operand::Imm(m_current_block_index));
+    m_assembler.mov(
+        Assembler::Operand::Register(ARG2),
+        Assembler::Operand::Imm(m_current_bytecode_offset));
+    native_call((void*)cxx_deoptimize);
+    jump_to_exit();
+}
+
 void Compiler::check_exception()
 {
     load_vm_register(GPR0, Bytecode::Register::exception());
@@ -554,21 +729,37 @@ void Compiler::check_exception()
             no_exception);
         store_accumulator(GPR0);
         store_vm_register(Bytecode::Register::exception(), GPR1);
+        spill_allocated_registers();
         m_assembler.jump(label_for(*handler));
         no_exception.link(m_assembler);
-    } else if (auto const* finalizer = current_block().finalizer(); finalizer) {
+        return;
+    }
+
+    Assembler::Label* target = &m_exit_label;
+    if (auto const* finalizer = current_block().finalizer(); finalizer) {
         store_vm_register(Bytecode::Register::saved_exception(), GPR0);
         store_vm_register(Bytecode::Register::exception(), GPR1);
-        m_assembler.jump_if(Assembler::Operand::Register(GPR0),
-            Assembler::Condition::NotEqualTo,
-            Assembler::Operand::Register(GPR1),
-            label_for(*finalizer));
-    } else {
-        m_assembler.jump_if(Assembler::Operand::Register(GPR0),
-            Assembler::Condition::NotEqualTo,
+        target = &label_for(*finalizer);
+    }
+
+    if (has_dirty_allocated_registers()) {
+        // Keep the write-back of values living in machine registers off the common path.
+        Assembler::Label no_exception;
+        m_assembler.jump_if(
+            Assembler::Operand::Register(GPR0),
+            Assembler::Condition::EqualTo,
             Assembler::Operand::Register(GPR1),
-            m_exit_label);
+            no_exception);
+        spill_allocated_registers();
+        m_assembler.jump(*target);
+        no_exception.link(m_assembler);
+        return;
     }
+
+    m_assembler.jump_if(Assembler::Operand::Register(GPR0),
+        Assembler::Condition::NotEqualTo,
+        Assembler::Operand::Register(GPR1),
+        *target);
 }
 
 static void cxx_enter_unwind_context(VM& vm)
@@ -999,7 +1190,7 @@ void Compiler::compile_add(Bytecode::Op::Add const& op)
     load_accumulator(ARG2);
 
     compile_binary_op_fastpaths(
-        ARG1, ARG2,
+        ARG1, ARG2, type_specialization_for(op.type_feedback_slot()),
         [&](auto lhs, auto rhs, auto& slow_case) {
         m_assembler.add32(
             Assembler::Operand::Register(lhs),
@@ -1034,7 +1225,7 @@ void Compiler::compile_sub(Bytecode::Op::Sub const& op)
     load_accumulator(ARG2);
 
     compile_binary_op_fastpaths(
-        ARG1, ARG2,
+        ARG1, ARG2, type_specialization_for(op.type_feedback_slot()),
         [&](auto lhs, auto rhs, auto& slow_case) {
             m_assembler.sub32(
                 Assembler::Operand::Register(lhs),
@@ -1069,12 +1260,34 @@ void Compiler::compile_mul(Bytecode::Op::Mul const& op)
     load_accumulator(ARG2);
 
     compile_binary_op_fastpaths(
-        ARG1, ARG2,
+        ARG1, ARG2, type_specialization_for(op.type_feedback_slot()),
         [&](auto lhs, auto rhs, auto& slow_case) {
             m_assembler.mul32(
                 Assembler::Operand::Register(lhs),
                 Assembler::Operand::Register(rhs),
                 slow_case);
+
+            // A zero product with a negative operand is -0, which isn't an int32.
+            // if (result == 0 && (ARG1 | rhs) < 0) goto slow_case;
+            Assembler::Label not_zero {};
+            m_assembler.jump_if(
+                Assembler::Operand::Register(lhs),
+                Assembler::Condition::NotEqualTo,
+                Assembler::Operand::Imm(0),
+                not_zero);
+            m_assembler.mov(
+                Assembler::Operand::Register(GPR1),
+                Assembler::Operand::Register(ARG1));
+            m_assembler.bitwise_or(
+                Assembler::Operand::Register(GPR1),
+                Assembler::Operand::Register(rhs));
+            m_assembler.sign_extend_32_to_64_bits(GPR1);
+            m_assembler.jump_if(
+                Assembler::Operand::Register(GPR1),
+                Assembler::Condition::SignedLessThan,
+                Assembler::Operand::Imm(0),
+                slow_case);
+            not_zero.link(m_assembler);
             return lhs; },
         [&](auto lhs, auto rhs) {
             m_assembler.mul(
@@ -1105,7 +1318,7 @@ void Compiler::compile_mul(Bytecode::Op::Mul const& op)
             load_accumulator(ARG2);                                                                    \
                                                                                                        \
             compiler_comparison_fastpaths(                                                             \
-                ARG1, ARG2,                                                                            \
+                ARG1, ARG2, type_specialization_for(op.type_feedback_slot()),                          \
                 [&](auto lhs, auto rhs) {                                                              \
                     m_assembler.sign_extend_32_to_64_bits(lhs);                                        \
                     m_assembler.sign_extend_32_to_64_bits(rhs);                                        \
@@ -1689,40 +1902,15 @@ void Compiler::compile_get_by_id(Bytecode::Op::GetById const& op)
             no_magical_length_property_case.link(m_assembler);
         }
 
-        // if (cache.shape != &object->shape()) goto slow_case;
+        // GPR2 = &object->shape()
         m_assembler.mov(
             Assembler::Operand::Register(GPR2),
             Assembler::Operand::Mem64BaseAndOffset(GPR0, Object::shape_offset()));
-        m_assembler.mov(
-            Assembler::Operand::Register(GPR1),
-            Assembler::Operand::Mem64BaseAndOffset(ARG5, Bytecode::PropertyLookupCache::shape_offset()));
-
-        m_assembler.jump_if(
-            Assembler::Operand::Register(GPR1),
-            Assembler::Condition::EqualTo,
-            Assembler::Operand::Imm(0),
-            slow_case);
-
-        m_assembler.mov(
-            Assembler::Operand::Register(GPR1),
-            Assembler::Operand::Mem64BaseAndOffset(GPR1, AK::WeakLink::ptr_offset()));
-
-        m_assembler.jump_if(
-            Assembler::Operand::Register(GPR2),
-            Assembler::Condition::NotEqualTo,
-            Assembler::Operand::Register(GPR1),
-            slow_case);
 
-        // return object->get_direct(*cache.property_offset);
+        // return object->get_direct(*cache.property_offset_for(object->shape()));
         // GPR0 = object
-        // GPR1 = *cache.property_offset * sizeof(Value)
-        m_assembler.mov(
-            Assembler::Operand::Register(GPR1),
-            Assembler::Operand::Mem64BaseAndOffset(ARG5, Bytecode::PropertyLookupCache::property_offset_offset() + decltype(cache.property_offset)::value_offset()));
-        m_assembler.mul32(
-            Assembler::Operand::Register(GPR1),
-            Assembler::Operand::Imm(sizeof(Value)),
-            slow_case);
+        // GPR1 = *cache.property_offset_for(object->shape()) * sizeof(Value)
+        load_cached_property_offset(ARG5, GPR2, GPR1, slow_case);
 
         // GPR0 = object->m_storage.outline_buffer
         m_assembler.mov(
@@ -1948,39 +2136,18 @@ void Compiler::compile_get_global(Bytecode::Op::GetGlobal const& op)
         Assembler::Operand::Register(GPR0),
         Assembler::Operand::Mem64BaseAndOffset(GPR1, Object::shape_offset()));
 
-    // GPR2 = cache.shape.ptr()
-    m_assembler.mov(
-        Assembler::Operand::Register(GPR2),
-        Assembler::Operand::Mem64BaseAndOffset(ARG2, Bytecode::PropertyLookupCache::shape_offset()));
-    m_assembler.jump_if(
-        Assembler::Operand::Register(GPR2),
-        Assembler::Condition::EqualTo,
-        Assembler::Operand::Imm(0),
-        slow_case);
-    m_assembler.mov(
-        Assembler::Operand::Register(GPR2),
-        Assembler::Operand::Mem64BaseAndOffset(GPR2, AK::WeakLink::ptr_offset()));
+    // GPR2 = *cache.property_offset_for(GPR1->shape()) * sizeof(Value)
+    load_cached_property_offset(ARG2, GPR0, GPR2, slow_case);
 
-    // if (GPR2 != GPR0) goto slow_case;
-    m_assembler.jump_if(
-        Assembler::Operand::Register(GPR2),
-        Assembler::Condition::NotEqualTo,
-        Assembler::Operand::Register(GPR0),
-        slow_case);
-
-    // accumulator = GPR1->get_direct(*cache.property_offset);
+    // accumulator = GPR1->get_direct(*cache.property_offset_for(GPR1->shape()));
     // GPR0 = GPR1
-    // GPR1 = *cache.property_offset * sizeof(Value)
+    // GPR1 = GPR2
     m_assembler.mov(
         Assembler::Operand::Register(GPR0),
         Assembler::Operand::Register(GPR1));
     m_assembler.mov(
         Assembler::Operand::Register(GPR1),
-        Assembler::Operand::Mem64BaseAndOffset(ARG2, Bytecode::PropertyLookupCache::property_offset_offset() + decltype(cache.property_offset)::value_offset()));
-    m_assembler.mul32(
-        Assembler::Operand::Register(GPR1),
-        Assembler::Operand::Imm(sizeof(Value)),
-        slow_case);
+        Assembler::Operand::Register(GPR2));
 
     // GPR0 = GPR0->m_storage.outline_buffer
     m_assembler.mov(
@@ -2238,6 +2405,69 @@ void Compiler::extract_object_pointer(Assembler::Reg dst_object, Assembler::Reg
         Assembler::Operand::Imm(16));
 }
 
+void Compiler::jump_if_write_barriers_enabled(Assembler::Label& label)
+{
+    // The GC can turn write barriers on and off after this code has been compiled, so the flag is checked at run time.
+    // if (g_gc_write_barriers_enabled) goto label;
+    m_assembler.mov(
+        Assembler::Operand::Register(GPR0),
+        Assembler::Operand::Imm(bit_cast<u64>(&g_gc_write_barriers_enabled)));
+    m_assembler.mov8(
+        Assembler::Operand::Register(GPR0),
+        Assembler::Operand::Mem64BaseAndOffset(GPR0, 0));
+    m_assembler.jump_if(
+        Assembler::Operand::Register(GPR0),
+        Assembler::Condition::NotEqualTo,
+        Assembler::Operand::Imm(0),
+        label);
+}
+
+void Compiler::load_cached_property_offset(Assembler::Reg cache, Assembler::Reg shape, Assembler::Reg dst_offset, Assembler::Label& slow_case)
+{
+    // NOTE: Megamorphic lookups are left to the slow case.
+    Assembler::Label found;
+    for (size_t i = 0; i < Bytecode::PropertyLookupCache::max_number_of_shapes; ++i) {
+        auto entry_offset = Bytecode::PropertyLookupCache::entry_offset(i);
+        Assembler::Label next_entry;
+
+        // if (!cache.entries[i].shape) goto next_entry;
+        m_assembler.mov(
+            Assembler::Operand::Register(dst_offset),
+            Assembler::Operand::Mem64BaseAndOffset(cache, entry_offset + Bytecode::PropertyLookupCache::Entry::shape_offset()));
+        m_assembler.jump_if(
+            Assembler::Operand::Register(dst_offset),
+            Assembler::Condition::EqualTo,
+            Assembler::Operand::Imm(0),
+            next_entry);
+
+        // if (cache.entries[i].shape.ptr() != shape) goto next_entry;
+        m_assembler.mov(
+            Assembler::Operand::Register(dst_offset),
+            Assembler::Operand::Mem64BaseAndOffset(dst_offset, AK::WeakLink::ptr_offset()));
+        m_assembler.jump_if(
+            Assembler::Operand::Register(dst_offset),
+            Assembler::Condition::NotEqualTo,
+            Assembler::Operand::Register(shape),
+            next_entry);
+
+        // dst_offset = *cache.entries[i].property_offset;
+        m_assembler.mov(
+            Assembler::Operand::Register(dst_offset),
+            Assembler::Operand::Mem64BaseAndOffset(cache, entry_offset + Bytecode::PropertyLookupCache::Entry::property_offset_offset() + decltype(Bytecode::PropertyLookupCache::Entry::property_offset)::value_offset()));
+        m_assembler.jump(found);
+
+        next_entry.link(m_assembler);
+    }
+    m_assembler.jump(slow_case);
+
+    // dst_offset *= sizeof(Value);
+    found.link(m_assembler);
+    m_assembler.mul32(
+        Assembler::Operand::Register(dst_offset),
+        Assembler::Operand::Imm(sizeof(Value)),
+        slow_case);
+}
+
 void Compiler::compile_put_by_id(Bytecode::Op::PutById const& op)
 {
     auto& cache = m_bytecode_executable.property_lookup_caches[op.cache_index()];
@@ -2250,44 +2480,21 @@ void Compiler::compile_put_by_id(Bytecode::Op::PutById const& op)
     Assembler::Label end;
     Assembler::Label slow_case;
     if (op.kind() == Bytecode::Op::PropertyKind::KeyValue) {
+        // Stores into objects need a write barrier while the GC has them enabled, which only the slow path has.
+        jump_if_write_barriers_enabled(slow_case);
 
         branch_if_object(ARG1, [&] {
             extract_object_pointer(GPR0, ARG1);
 
-            // if (cache.shape != &object->shape()) goto slow_case;
+            // GPR2 = &object->shape()
             m_assembler.mov(
                 Assembler::Operand::Register(GPR2),
                 Assembler::Operand::Mem64BaseAndOffset(GPR0, Object::shape_offset()));
-            m_assembler.mov(
-                Assembler::Operand::Register(GPR1),
-                Assembler::Operand::Mem64BaseAndOffset(ARG5, Bytecode::PropertyLookupCache::shape_offset()));
 
-            m_assembler.jump_if(
-                Assembler::Operand::Register(GPR1),
-                Assembler::Condition::EqualTo,
-                Assembler::Operand::Imm(0),
-                slow_case);
-
-            m_assembler.mov(
-                Assembler::Operand::Register(GPR1),
-                Assembler::Operand::Mem64BaseAndOffset(GPR1, AK::WeakLink::ptr_offset()));
-
-            m_assembler.jump_if(
-                Assembler::Operand::Register(GPR2),
-                Assembler::Condition::NotEqualTo,
-                Assembler::Operand::Register(GPR1),
-                slow_case);
-
-            // object->put_direct(*cache.property_offset, value);
+            // object->put_direct(*cache.property_offset_for(object->shape()), value);
             // GPR0 = object
-            // GPR1 = *cache.property_offset * sizeof(Value)
-            m_assembler.mov(
-                Assembler::Operand::Register(GPR1),
-                Assembler::Operand::Mem64BaseAndOffset(ARG5, Bytecode::PropertyLookupCache::property_offset_offset() + decltype(cache.property_offset)::value_offset()));
-            m_assembler.mul32(
-                Assembler::Operand::Register(GPR1),
-                Assembler::Operand::Imm(sizeof(Value)),
-                slow_case);
+            // GPR1 = *cache.property_offset_for(object->shape()) * sizeof(Value)
+            load_cached_property_offset(ARG5, GPR2, GPR1, slow_case);
 
             // GPR0 = object->m_storage.outline_buffer
             m_assembler.mov(
@@ -2339,6 +2546,8 @@ void Compiler::compile_put_by_value(Bytecode::Op::PutByValue const& op)
     Assembler::Label end {};
     Assembler::Label slow_case {};
 
+    // Stores into objects need a write barrier while the GC has them enabled, which only the slow path has.
+    jump_if_write_barriers_enabled(slow_case);
     branch_if_object(ARG1, [&] {
         branch_if_int32(ARG2, [&] {
             // if (ARG2 < 0) goto slow_case;
@@ -2770,11 +2979,16 @@ void Compiler::compile_set_variable(Bytecode::Op::SetVariable const& op)
     // Load the value in ARG2 for both cases
     load_accumulator(ARG2);
 
-    // if (!cache.has_value()) goto slow_case;
+    // Load the cache in ARG5 for both cases
     m_assembler.mov(
         Assembler::Operand::Register(ARG5),
         Assembler::Operand::Imm(bit_cast<u64>(&m_bytecode_executable.environment_variable_caches[op.cache_index()])));
 
+    // Stores into environments need a write barrier while the GC has them enabled, which only the slow path has.
+    jump_if_write_barriers_enabled(slow_case);
+
+    // if (!cache.has_value()) goto slow_case;
+
     m_assembler.mov8(
         Assembler::Operand::Register(GPR0),
         Assembler::Operand::Mem64BaseAndOffset(ARG5, Bytecode::EnvironmentVariableCache::has_value_offset()));
@@ -2874,6 +3088,17 @@ void Compiler::compile_set_variable(Bytecode::Op::SetVariable const& op)
         Assembler::Operand::Imm(0),
         slow_case);
 
+    // if (!binding.mutable_) goto slow_case;
+    // NOTE: The slow case throws for assignments to constants, or ignores them in sloppy mode.
+    m_assembler.mov8(
+        Assembler::Operand::Register(GPR0),
+        Assembler::Operand::Mem64BaseAndOffset(GPR1, DeclarativeEnvironment::Binding::mutable_offset()));
+    m_assembler.jump_if(
+        Assembler::Operand::Register(GPR0),
+        Assembler::Condition::EqualTo,
+        Assembler::Operand::Imm(0),
+        slow_case);
+
     // binding.value = accumulator;
     m_assembler.mov(
         Assembler::Operand::Mem64BaseAndOffset(GPR1, DeclarativeEnvironment::Binding::value_offset()),
@@ -3559,9 +3784,15 @@ void Compiler::compile_continuation(Optional<Bytecode::Label> continuation, bool
         Assembler::Operand::Register(ARG3),
         Assembler::Operand::Imm(Value(is_await).encoded()));
     native_call((void*)cxx_continuation);
-    store_vm_register(Bytecode::Register::return_value(), RET);
 
-    // FIXME: This should run the finalizer if it is a return
+    // A yield without a continuation is a `return` from a generator, which has to run the finalizer first.
+    if (auto const* finalizer = current_block().finalizer(); finalizer && !continuation.has_value()) {
+        store_vm_register(Bytecode::Register::saved_return_value(), RET);
+        m_assembler.jump(label_for(*finalizer));
+        return;
+    }
+
+    store_vm_register(Bytecode::Register::return_value(), RET);
     jump_to_exit();
 }
 
@@ -3577,6 +3808,7 @@ void Compiler::compile_await(Bytecode::Op::Await const& op)
 
 void Compiler::jump_to_exit()
 {
+    spill_allocated_registers();
     m_assembler.jump(m_exit_label);
 }
 
@@ -3584,7 +3816,11 @@ void Compiler::native_call(void* function_address, Vector<Assembler::Operand> co
 {
     // NOTE: We don't preserve caller-saved registers when making a native call.
     //       This means that they may have changed after we return from the call.
+    //       Values living in machine registers are written back first, since the callee may access the register file,
+    //       and reloaded afterwards, since the callee may have clobbered them or updated the register file.
+    spill_allocated_registers();
     m_assembler.native_call(bit_cast<u64>(function_address), { Assembler::Operand::Register(ARG0) }, stack_arguments);
+    reload_allocated_registers();
 }
 
 OwnPtr<NativeExecutable> Compiler::compile(Bytecode::Executable& bytecode_executable)
@@ -3634,9 +3870,15 @@ OwnPtr<NativeExecutable> Compiler::compile(Bytecode::Executable& bytecode_execut
         auto& block = bytecode_executable.basic_blocks[block_index];
         compiler.block_data_for(*block).start_offset = compiler.m_output.size();
         compiler.set_current_block(*block);
-        auto it = Bytecode::InstructionStreamIterator(block->instruction_stream());
 
-        if (it.at_end()) {
+        Vector<Bytecode::Instruction const*> instructions;
+        Vector<size_t> instruction_offsets;
+        for (auto it = Bytecode::InstructionStreamIterator(block->instruction_stream()); !it.at_end(); ++it) {
+            instructions.append(&*it);
+            instruction_offsets.append(it.offset());
+        }
+
+        if (instructions.is_empty()) {
             mapping.append({
                 .native_offset = compiler.m_output.size(),
                 .block_index = block_index,
@@ -3644,15 +3886,25 @@ OwnPtr<NativeExecutable> Compiler::compile(Bytecode::Executable& bytecode_execut
             });
         }
 
-        while (!it.at_end()) {
-            auto const& op = *it;
+        compiler.begin_block_register_allocation(instructions);
+
+        for (size_t instruction_index = 0; instruction_index < instructions.size(); ++instruction_index) {
+            auto const& op = *instructions[instruction_index];
 
             mapping.append({
                 .native_offset = compiler.m_output.size(),
                 .block_index = block_index,
-                .bytecode_offset = it.offset(),
+                .bytecode_offset = instruction_offsets[instruction_index],
             });
 
+            compiler.m_current_block_index = block_index;
+            compiler.m_current_bytecode_offset = instruction_offsets[instruction_index];
+            compiler.update_allocated_registers(instruction_index);
+
+            // The terminator may jump to other blocks, which expect to find every value in the register file.
+            if (block->is_terminated() && instruction_index == instructions.size() - 1)
+                compiler.flush_allocated_registers();
+
             switch (op.type()) {
 #    define CASE_BYTECODE_OP(OpTitleCase, op_snake_case, ...)                                \
     case Bytecode::Instruction::Type::OpTitleCase:                                           \
@@ -3667,11 +3919,10 @@ OwnPtr<NativeExecutable> Compiler::compile(Bytecode::Executable& bytecode_execut
                 }
                 return nullptr;
             }
-
-            ++it;
         }
         if (!block->is_terminated())
             compiler.jump_to_exit();
+        compiler.m_allocated_values.clear();
     }
 
     mapping.append({
@@ -7,12 +7,14 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Platform.h>
 #include <LibJIT/Assembler.h>
 #include <LibJS/Bytecode/Builtins.h>
 #include <LibJS/Bytecode/Executable.h>
 #include <LibJS/Bytecode/Op.h>
 #include <LibJS/JIT/NativeExecutable.h>
+#include <LibJS/JIT/RegisterAllocator.h>
 
 #ifdef JIT_ARCH_SUPPORTED
 
@@ -43,6 +45,10 @@ private:
     static constexpr auto LOCALS_ARRAY_BASE = Assembler::Reg::R14;
     static constexpr auto CACHED_ACCUMULATOR = Assembler::Reg::R12;
     static constexpr auto RUNNING_EXECUTION_CONTEXT_BASE = Assembler::Reg::R15;
+
+    // Caller-saved registers that are otherwise unused by the generated code.
+    // The register allocator keeps hot bytecode registers and locals in these within a basic block.
+    static constexpr AK::Array ALLOCATABLE_REGISTERS { Assembler::Reg::R10, Assembler::Reg::R11 };
 #    endif
 
     static Assembler::Reg argument_register(u32);
@@ -169,6 +175,23 @@ private:
     void store_vm_local(size_t, Assembler::Reg);
     void load_vm_local(Assembler::Reg, size_t);
 
+    struct AllocatedValue {
+        AllocatableValue value;
+        Assembler::Reg reg;
+        size_t end { 0 };
+        bool dirty { false };
+    };
+    static Assembler::Operand register_file_slot(AllocatableValue);
+    AllocatedValue* allocated_value(AllocatableValue);
+    void load_allocatable_value(Assembler::Reg dst, AllocatableValue);
+    void store_allocatable_value(AllocatableValue, Assembler::Reg src);
+    void begin_block_register_allocation(ReadonlySpan<Bytecode::Instruction const*>);
+    void update_allocated_registers(size_t instruction_index);
+    bool has_dirty_allocated_registers() const;
+    void spill_allocated_registers();
+    void flush_allocated_registers();
+    void reload_allocated_registers();
+
     void reload_cached_accumulator();
     void flush_cached_accumulator();
     void load_accumulator(Assembler::Reg);
@@ -211,6 +234,8 @@ private:
     }
 
     void extract_object_pointer(Assembler::Reg dst_object, Assembler::Reg src_value);
+    void jump_if_write_barriers_enabled(Assembler::Label&);
+    void load_cached_property_offset(Assembler::Reg cache, Assembler::Reg shape, Assembler::Reg dst_offset, Assembler::Label& slow_case);
     void convert_to_double(Assembler::Reg dst, Assembler::Reg src, Assembler::Reg nan, Assembler::Reg temp, Assembler::Label& not_number);
 
     template<typename Codegen>
@@ -218,10 +243,21 @@ private:
 
     void jump_if_not_double(Assembler::Reg reg, Assembler::Reg nan, Assembler::Reg temp, Assembler::Label&);
 
+    // Which operand types an instruction's native code handles inline, based on the type feedback collected by the interpreter.
+    // Anything but Generic drops the slow path, and deoptimizes when the operands turn out to be something else.
+    enum class TypeSpecialization {
+        Generic,
+        Int32,
+        Double,
+        Number,
+    };
+    TypeSpecialization type_specialization_for(u32 type_feedback_slot) const;
+    void deoptimize();
+
     template<typename CodegenI32, typename CodegenDouble, typename CodegenValue>
-    void compile_binary_op_fastpaths(Assembler::Reg lhs, Assembler::Reg rhs, CodegenI32, CodegenDouble, CodegenValue);
+    void compile_binary_op_fastpaths(Assembler::Reg lhs, Assembler::Reg rhs, TypeSpecialization, CodegenI32, CodegenDouble, CodegenValue);
     template<typename CodegenI32, typename CodegenDouble, typename CodegenValue>
-    void compiler_comparison_fastpaths(Assembler::Reg lhs, Assembler::Reg rhs, CodegenI32, CodegenDouble, CodegenValue);
+    void compiler_comparison_fastpaths(Assembler::Reg lhs, Assembler::Reg rhs, TypeSpecialization, CodegenI32, CodegenDouble, CodegenValue);
 
     explicit Compiler(Bytecode::Executable& bytecode_executable)
         : m_bytecode_executable(bytecode_executable)
@@ -262,6 +298,13 @@ private:
     Assembler::Label m_exit_label;
     Bytecode::Executable& m_bytecode_executable;
     Bytecode::BasicBlock const* m_current_block;
+    size_t m_current_block_index { 0 };
+    size_t m_current_bytecode_offset { 0 };
+
+    // Register allocation state for the current basic block.
+    Vector<LiveInterval> m_live_intervals;
+    size_t m_next_live_interval { 0 };
+    Vector<AllocatedValue, ALLOCATABLE_REGISTERS.size()> m_allocated_values;
 };
 
 }
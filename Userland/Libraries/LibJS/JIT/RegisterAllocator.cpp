@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/HashMap.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/JIT/RegisterAllocator.h>
+
+#ifdef JIT_ARCH_SUPPORTED
+
+namespace JS::JIT {
+
+namespace {
+
+enum class Access {
+    Read,
+    Write,
+};
+
+class IntervalBuilder {
+public:
+    void use(AllocatableValue value, size_t instruction_index, Access access)
+    {
+        auto key = (static_cast<u64>(value.kind) << 32) | value.index;
+        auto interval_index = m_interval_index_by_value.ensure(key, [&] {
+            m_intervals.append({ .value = value, .start = instruction_index, .starts_with_write = access == Access::Write });
+            return m_intervals.size() - 1;
+        });
+        auto& interval = m_intervals[interval_index];
+        interval.end = instruction_index;
+        ++interval.use_count;
+    }
+
+    void use_register(Bytecode::Register reg, size_t instruction_index, Access access)
+    {
+        // The accumulator already has a dedicated machine register, and the other reserved registers
+        // are read and written directly by the runtime.
+        if (reg.index() < Bytecode::Register::reserved_register_count)
+            return;
+        use({ AllocatableValue::Kind::Register, reg.index() }, instruction_index, access);
+    }
+
+    void use_local(size_t index, size_t instruction_index, Access access)
+    {
+        use({ AllocatableValue::Kind::Local, static_cast<u32>(index) }, instruction_index, access);
+    }
+
+    Vector<LiveInterval> take_intervals() { return move(m_intervals); }
+
+private:
+    // Intervals are created in order of first use, so they stay sorted by start.
+    Vector<LiveInterval> m_intervals;
+    HashMap<u64, size_t> m_interval_index_by_value;
+};
+
+}
+
+Vector<LiveInterval> RegisterAllocator::allocate(ReadonlySpan<Bytecode::Instruction const*> instructions, ReadonlySpan<Assembler::Reg> registers)
+{
+    IntervalBuilder builder;
+
+    // NOTE: Only the operands of instructions that are common in straight-line numeric code are considered here.
+    //       Accesses made by other instructions go through the same register mapping, so they stay correct,
+    //       they just don't influence which values get a register.
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        auto const& instruction = *instructions[i];
+        switch (instruction.type()) {
+        case Bytecode::Instruction::Type::Load:
+            builder.use_register(static_cast<Bytecode::Op::Load const&>(instruction).src(), i, Access::Read);
+            break;
+        case Bytecode::Instruction::Type::Store:
+            builder.use_register(static_cast<Bytecode::Op::Store const&>(instruction).dst(), i, Access::Write);
+            break;
+        case Bytecode::Instruction::Type::GetLocal:
+            builder.use_local(static_cast<Bytecode::Op::GetLocal const&>(instruction).index(), i, Access::Read);
+            break;
+        case Bytecode::Instruction::Type::SetLocal:
+            builder.use_local(static_cast<Bytecode::Op::SetLocal const&>(instruction).index(), i, Access::Write);
+            break;
+        case Bytecode::Instruction::Type::TypeofLocal:
+            builder.use_local(static_cast<Bytecode::Op::TypeofLocal const&>(instruction).index(), i, Access::Read);
+            break;
+#    define USE_BINARY_OP_LHS(OpTitleCase, op_snake_case)                                                         \
+    case Bytecode::Instruction::Type::OpTitleCase:                                                                \
+        builder.use_register(static_cast<Bytecode::Op::OpTitleCase const&>(instruction).lhs(), i, Access::Read); \
+        break;
+            JS_ENUMERATE_COMMON_BINARY_OPS(USE_BINARY_OP_LHS)
+#    undef USE_BINARY_OP_LHS
+        default:
+            break;
+        }
+    }
+
+    auto intervals = builder.take_intervals();
+
+    // A value that is only touched once gains nothing from living in a register.
+    intervals.remove_all_matching([](auto const& interval) { return interval.use_count < 2; });
+
+    Vector<Assembler::Reg, 4> free_registers;
+    for (size_t i = registers.size(); i > 0; --i)
+        free_registers.append(registers[i - 1]);
+
+    Vector<size_t, 4> active;
+    Vector<bool> allocated;
+    allocated.resize(intervals.size());
+
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        auto& interval = intervals[i];
+
+        active.remove_all_matching([&](size_t active_index) {
+            auto const& active_interval = intervals[active_index];
+            if (active_interval.end >= interval.start)
+                return false;
+            free_registers.append(active_interval.reg);
+            return true;
+        });
+
+        if (!free_registers.is_empty()) {
+            interval.reg = free_registers.take_last();
+            allocated[i] = true;
+            active.append(i);
+            continue;
+        }
+
+        if (active.is_empty())
+            continue;
+
+        // Out of registers: take the register from whichever interval lives the longest, unless that's this one.
+        size_t victim_slot = 0;
+        for (size_t slot = 1; slot < active.size(); ++slot) {
+            if (intervals[active[slot]].end > intervals[active[victim_slot]].end)
+                victim_slot = slot;
+        }
+        auto& victim = intervals[active[victim_slot]];
+        if (victim.end <= interval.end)
+            continue;
+
+        // The victim gives up its register just before this interval starts.
+        // NOTE: Every instruction we look at has at most one operand, so no two intervals start at the same instruction.
+        VERIFY(victim.start < interval.start);
+        victim.end = interval.start - 1;
+
+        interval.reg = victim.reg;
+        allocated[i] = true;
+        active[victim_slot] = i;
+    }
+
+    Vector<LiveInterval> result;
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        if (allocated[i])
+            result.append(intervals[i]);
+    }
+    return result;
+}
+
+}
+
+#endif
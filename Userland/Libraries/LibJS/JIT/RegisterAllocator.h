@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Span.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <LibJIT/Assembler.h>
+#include <LibJS/Bytecode/Instruction.h>
+
+#ifdef JIT_ARCH_SUPPORTED
+
+namespace JS::JIT {
+
+using ::JIT::Assembler;
+
+// A bytecode register or local variable that can live in a machine register.
+struct AllocatableValue {
+    enum class Kind : u8 {
+        Register,
+        Local,
+    };
+
+    Kind kind;
+    u32 index;
+
+    bool operator==(AllocatableValue const&) const = default;
+};
+
+// The range of instructions (by index within a basic block) during which a value lives in a machine register.
+struct LiveInterval {
+    AllocatableValue value;
+    size_t start { 0 };
+    size_t end { 0 };
+    size_t use_count { 0 };
+
+    // The first instruction in the interval overwrites the value, so it doesn't have to be loaded first.
+    bool starts_with_write { false };
+
+    Assembler::Reg reg { Assembler::Reg::RAX };
+};
+
+// Linear scan register allocation over the instructions of a single basic block.
+// Values are only kept in machine registers within a block; the compiler writes them back
+// to the register file at block boundaries and around native calls.
+class RegisterAllocator {
+public:
+    // Returns the intervals that got a machine register, ordered by start.
+    static Vector<LiveInterval> allocate(ReadonlySpan<Bytecode::Instruction const*>, ReadonlySpan<Assembler::Reg> registers);
+};
+
+}
+
+#endif
@@ -101,6 +101,7 @@ void finish_loading_imported_module(ImportedModuleReferrer referrer, ModuleReque
                 loaded_modules.append(ModuleWithSpecifier {
                     .specifier = module_request.module_specifier,
                     .module = NonnullGCPtr<Module>(*module) });
+                referrer.visit([](auto& cell) { cell->write_barrier(); });
             }
         }
     }
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/ProgramCache.h>
+#include <LibJS/SourceCode.h>
+
+namespace JS {
+
+// NOTE: The lexer turns a null filename or source text into an empty string, which a null StringView doesn't compare equal to.
+static bool is_same_text(String const& cached_text, StringView text)
+{
+    if (text.is_empty())
+        return cached_text.is_empty();
+    return cached_text == text;
+}
+
+static size_t size_of(Program const& program)
+{
+    return program.source_code().code().bytes().size();
+}
+
+Optional<size_t> ProgramCache::find(u32 source_hash, StringView source_text, StringView filename, size_t line_number_offset, Program::Type type) const
+{
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        auto const& entry = m_entries[i];
+        if (entry.source_hash != source_hash || entry.line_number_offset != line_number_offset || entry.program->type() != type)
+            continue;
+        // NOTE: The filename ends up in source ranges and stack traces, so it has to match as well.
+        auto const& source_code = entry.program->source_code();
+        if (!is_same_text(source_code.filename(), filename) || !is_same_text(source_code.code(), source_text))
+            continue;
+        return i;
+    }
+    return {};
+}
+
+RefPtr<Program> ProgramCache::get(StringView source_text, StringView filename, size_t line_number_offset, Program::Type type)
+{
+    auto index = find(source_text.hash(), source_text, filename, line_number_offset, type);
+    if (!index.has_value()) {
+        ++m_miss_count;
+        return nullptr;
+    }
+
+    ++m_hit_count;
+    auto entry = m_entries.take(*index);
+    auto program = entry.program;
+    m_entries.append(move(entry));
+    return program;
+}
+
+void ProgramCache::set(StringView source_text, StringView filename, size_t line_number_offset, NonnullRefPtr<Program> program)
+{
+    auto size = size_of(*program);
+    if (size > m_capacity_in_bytes)
+        return;
+
+    auto source_hash = source_text.hash();
+    if (auto index = find(source_hash, source_text, filename, line_number_offset, program->type()); index.has_value()) {
+        m_size_in_bytes -= size_of(*m_entries[*index].program);
+        m_entries.remove(*index);
+    }
+
+    evict_until_size_is_at_most(m_capacity_in_bytes - size);
+    m_entries.append({ source_hash, line_number_offset, move(program) });
+    m_size_in_bytes += size;
+}
+
+void ProgramCache::clear()
+{
+    m_entries.clear();
+    m_size_in_bytes = 0;
+}
+
+void ProgramCache::set_capacity_in_bytes(size_t capacity_in_bytes)
+{
+    m_capacity_in_bytes = capacity_in_bytes;
+    evict_until_size_is_at_most(m_capacity_in_bytes);
+}
+
+void ProgramCache::evict_until_size_is_at_most(size_t size_in_bytes)
+{
+    size_t evicted_count = 0;
+    while (m_size_in_bytes > size_in_bytes) {
+        m_size_in_bytes -= size_of(*m_entries[evicted_count].program);
+        ++evicted_count;
+    }
+    m_entries.remove(0, evicted_count);
+}
+
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2024, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/NonnullRefPtr.h>
+#include <AK/Noncopyable.h>
+#include <AK/StringView.h>
+#include <AK/Vector.h>
+#include <LibJS/AST.h>
+
+namespace JS {
+
+// Remembers the parse trees of recently parsed scripts and modules, so running the same source text again (e.g. the
+// same <script> on every page load) doesn't have to lex and parse it again. Function bodies are compiled to bytecode
+// lazily and keep their executable on the parse tree, which means a hit also skips compiling every function that has
+// already run once.
+//
+// NOTE: The cached executables are rooted by handles on the parse tree, so a cache must not outlive its VM's heap.
+class ProgramCache {
+    AK_MAKE_NONCOPYABLE(ProgramCache);
+    AK_MAKE_NONMOVABLE(ProgramCache);
+
+public:
+    static constexpr size_t default_capacity_in_bytes = 16 * MiB;
+
+    ProgramCache() = default;
+
+    RefPtr<Program> get(StringView source_text, StringView filename, size_t line_number_offset, Program::Type);
+    void set(StringView source_text, StringView filename, size_t line_number_offset, NonnullRefPtr<Program>);
+
+    void clear();
+
+    size_t capacity_in_bytes() const { return m_capacity_in_bytes; }
+    void set_capacity_in_bytes(size_t);
+
+    size_t size_in_bytes() const { return m_size_in_bytes; }
+    size_t hit_count() const { return m_hit_count; }
+    size_t miss_count() const { return m_miss_count; }
+
+private:
+    struct Entry {
+        u32 source_hash { 0 };
+        size_t line_number_offset { 0 };
+        NonnullRefPtr<Program> program;
+    };
+
+    Optional<size_t> find(u32 source_hash, StringView source_text, StringView filename, size_t line_number_offset, Program::Type) const;
+    void evict_until_size_is_at_most(size_t);
+
+    // Ordered from least to most recently used.
+    Vector<Entry> m_entries;
+
+    size_t m_capacity_in_bytes { default_capacity_in_bytes };
+    size_t m_size_in_bytes { 0 };
+    size_t m_hit_count { 0 };
+    size_t m_miss_count { 0 };
+};
+
+}
@@ -45,8 +45,10 @@ ThrowCompletionOr<void> AsyncFunctionDriverWrapper::await(JS::Value value)
     auto& realm = *vm.current_realm();
 
     // 1. Let asyncContext be the running execution context.
-    if (!m_suspended_execution_context)
+    if (!m_suspended_execution_context) {
         m_suspended_execution_context = vm.running_execution_context().copy();
+        write_barrier();
+    }
 
     // 2. Let promise be ? PromiseResolve(%Promise%, value).
     auto* promise_object = TRY(promise_resolve(vm, realm.intrinsics().promise_constructor(), value));
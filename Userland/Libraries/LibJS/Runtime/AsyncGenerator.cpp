@@ -59,6 +59,7 @@ void AsyncGenerator::async_generator_enqueue(Completion completion, NonnullGCPtr
 
     // 2. Append request to generator.[[AsyncGeneratorQueue]].
     m_async_generator_queue.append(move(request));
+    write_barrier();
 
     // 3. Return unused.
 }
@@ -205,6 +206,8 @@ void AsyncGenerator::execute(VM& vm, Completion completion)
 
         if (!m_frame)
             m_frame = move(next_result.frame);
+        // The frame's registers may have been written to while running.
+        write_barrier();
 
         auto result_value = move(next_result.value);
         if (!result_value.is_throw_completion()) {
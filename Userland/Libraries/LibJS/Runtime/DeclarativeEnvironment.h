@@ -21,6 +21,7 @@ class DeclarativeEnvironment : public Environment {
 
     struct Binding {
         static FlatPtr value_offset() { return OFFSET_OF(Binding, value); }
+        static FlatPtr mutable_offset() { return OFFSET_OF(Binding, mutable_); }
         static FlatPtr initialized_offset() { return OFFSET_OF(Binding, initialized); }
 
         DeprecatedFlyString name;
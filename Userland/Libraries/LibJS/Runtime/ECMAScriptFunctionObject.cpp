@@ -1192,6 +1192,7 @@ Completion ECMAScriptFunctionObject::ordinary_call_evaluate_body()
             } else {
                 m_default_parameter_bytecode_executables.append(*parameter.bytecode_executable);
             }
+            write_barrier();
         }
     }
 
@@ -77,10 +77,18 @@ public:
     void set_source_text(ByteString source_text) { m_source_text = move(source_text); }
 
     Vector<ClassFieldDefinition> const& fields() const { return m_fields; }
-    void add_field(ClassFieldDefinition field) { m_fields.append(move(field)); }
+    void add_field(ClassFieldDefinition field)
+    {
+        m_fields.append(move(field));
+        write_barrier();
+    }
 
     Vector<PrivateElement> const& private_methods() const { return m_private_methods; }
-    void add_private_method(PrivateElement method) { m_private_methods.append(move(method)); }
+    void add_private_method(PrivateElement method)
+    {
+        m_private_methods.append(move(method));
+        write_barrier();
+    }
 
     // This is for IsSimpleParameterList (static semantics)
     bool has_simple_parameter_list() const { return m_has_simple_parameter_list; }
@@ -23,6 +23,7 @@ void FinalizationRegistry::add_finalization_record(Cell& target, Value held_valu
 {
     VERIFY(!held_value.is_empty());
     m_records.append({ &target, held_value, unregister_token });
+    write_barrier();
 }
 
 // Extracted from FinalizationRegistry.prototype.unregister ( unregisterToken )
@@ -49,9 +50,13 @@ bool FinalizationRegistry::remove_by_token(Cell& unregister_token)
 
 void FinalizationRegistry::remove_dead_cells(Badge<Heap>)
 {
+    // If this registry is about to be swept as well, there is nobody left to clean up after.
+    if (!is_marked())
+        return;
+
     auto any_cells_were_removed = false;
     for (auto& record : m_records) {
-        if (!record.target || record.target->state() == Cell::State::Live)
+        if (!record.target || record.target->is_marked())
             continue;
         record.target = nullptr;
         any_cells_were_removed = true;
@@ -36,6 +36,7 @@ public:
     {
         VERIFY(!new_target.is_empty());
         m_new_target = new_target;
+        write_barrier();
     }
 
     // Abstract operations
@@ -128,6 +128,8 @@ ThrowCompletionOr<Value> GeneratorObject::execute(VM& vm, Completion const& comp
 
     if (!m_frame)
         m_frame = move(next_result.frame);
+    // The frame's registers may have been written to while running.
+    write_barrier();
 
     auto result_value = move(next_result.value);
     if (result_value.is_throw_completion()) {
@@ -520,6 +520,7 @@ ThrowCompletionOr<void> Object::private_field_add(PrivateName const& name, Value
 
     // 4. Append PrivateElement { [[Key]]: P, [[Kind]]: field, [[Value]]: value } to O.[[PrivateElements]].
     m_private_elements->empend(name, PrivateElement::Kind::Field, value);
+    write_barrier();
 
     // 5. Return unused.
     return {};
@@ -548,6 +549,7 @@ ThrowCompletionOr<void> Object::private_method_or_accessor_add(PrivateElement el
 
     // 5. Append method to O.[[PrivateElements]].
     m_private_elements->append(move(element));
+    write_barrier();
 
     // 6. Return unused.
     return {};
@@ -603,6 +605,7 @@ ThrowCompletionOr<void> Object::private_set(PrivateName const& name, Value value
     if (entry->kind == PrivateElement::Kind::Field) {
         // a. Set entry.[[Value]] to value.
         entry->value = value;
+        write_barrier();
         return {};
     }
     // 4. Else if entry.[[Kind]] is method, then
@@ -1117,8 +1120,10 @@ Optional<ValueAndAttributes> Object::storage_get(PropertyKey const& property_key
             return {};
 
         if (m_has_intrinsic_accessors) {
-            if (auto accessor = find_intrinsic_accessor(this, property_key); accessor.has_value())
+            if (auto accessor = find_intrinsic_accessor(this, property_key); accessor.has_value()) {
                 const_cast<Object&>(*this).m_storage[metadata->offset] = (*accessor)(shape().realm());
+                const_cast<Object&>(*this).write_barrier();
+            }
         }
 
         value = m_storage[metadata->offset];
@@ -1146,6 +1151,7 @@ void Object::storage_set(PropertyKey const& property_key, ValueAndAttributes con
     if (property_key.is_number()) {
         auto index = property_key.as_number();
         m_indexed_properties.put(index, value, attributes);
+        write_barrier();
         return;
     }
 
@@ -1167,6 +1173,7 @@ void Object::storage_set(PropertyKey const& property_key, ValueAndAttributes con
         else
             set_shape(*m_shape->create_put_transition(property_key_string_or_symbol, attributes));
         m_storage.append(value);
+        write_barrier();
         return;
     }
 
@@ -1178,6 +1185,7 @@ void Object::storage_set(PropertyKey const& property_key, ValueAndAttributes con
     }
 
     m_storage[metadata->offset] = value;
+    write_barrier();
 }
 
 void Object::storage_delete(PropertyKey const& property_key)
@@ -201,7 +201,11 @@ public:
     virtual void visit_edges(Cell::Visitor&) override;
 
     Value get_direct(size_t index) const { return m_storage[index]; }
-    void put_direct(size_t index, Value value) { m_storage[index] = value; }
+    void put_direct(size_t index, Value value)
+    {
+        m_storage[index] = value;
+        write_barrier();
+    }
 
     static FlatPtr storage_offset() { return OFFSET_OF(Object, m_storage); }
 
@@ -43,8 +43,12 @@ PrimitiveString::PrimitiveString(Utf16String string)
 {
 }
 
-PrimitiveString::~PrimitiveString()
+PrimitiveString::~PrimitiveString() = default;
+
+// NOTE: This can't wait for the destructor, since the heap may sweep dead cells lazily, and the caches must not hand out dead strings in the meantime.
+void PrimitiveString::finalize()
 {
+    Base::finalize();
     if (has_utf8_string())
         vm().string_cache().remove(*m_utf8_string);
     if (has_byte_string())
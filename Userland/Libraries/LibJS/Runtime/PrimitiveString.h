@@ -60,6 +60,7 @@ private:
     explicit PrimitiveString(Utf16String);
 
     virtual void visit_edges(Cell::Visitor&) override;
+    virtual void finalize() override;
 
     enum class EncodingPreference {
         UTF8,
@@ -92,6 +92,7 @@ Shape* Shape::create_put_transition(StringOrSymbol const& property_key, Property
     if (!m_forward_transitions)
         m_forward_transitions = make<HashMap<TransitionKey, WeakPtr<Shape>>>();
     m_forward_transitions->set(key, new_shape.ptr());
+    write_barrier();
     return new_shape;
 }
 
@@ -104,6 +105,7 @@ Shape* Shape::create_configure_transition(StringOrSymbol const& property_key, Pr
     if (!m_forward_transitions)
         m_forward_transitions = make<HashMap<TransitionKey, WeakPtr<Shape>>>();
     m_forward_transitions->set(key, new_shape.ptr());
+    write_barrier();
     return new_shape;
 }
 
@@ -164,6 +166,11 @@ void Shape::visit_edges(Cell::Visitor& visitor)
 
     // NOTE: We don't need to mark the keys in the property table, since they are guaranteed
     //       to also be marked by the chain of shapes leading up to this one.
+    //       Dictionaries don't have such a chain, and add their keys to the table directly.
+    if (m_dictionary && m_property_table) {
+        for (auto& it : *m_property_table)
+            it.key.visit_edges(visitor);
+    }
 
     visitor.ignore(m_prototype_transitions);
 
@@ -248,6 +255,7 @@ NonnullGCPtr<Shape> Shape::create_delete_transition(StringOrSymbol const& proper
     if (!m_delete_transitions)
         m_delete_transitions = make<HashMap<StringOrSymbol, WeakPtr<Shape>>>();
     m_delete_transitions->set(property_key, new_shape.ptr());
+    write_barrier();
     return new_shape;
 }
 
@@ -258,6 +266,7 @@ void Shape::add_property_without_transition(StringOrSymbol const& property_key,
     if (m_property_table->set(property_key, { m_property_count, attributes }) == AK::HashSetResult::InsertedNewEntry) {
         VERIFY(m_property_count < NumericLimits<u32>::max());
         ++m_property_count;
+        write_barrier();
     }
 }
 
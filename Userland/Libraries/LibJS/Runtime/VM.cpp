@@ -16,6 +16,7 @@
 #include <LibJS/AST.h>
 #include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/JIT/NativeExecutable.h>
+#include <LibJS/ProgramCache.h>
 #include <LibJS/Runtime/AbstractOperations.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/ArrayBuffer.h>
@@ -68,6 +69,7 @@ VM::VM(OwnPtr<CustomData> custom_data, ErrorMessages error_messages)
     , m_custom_data(move(custom_data))
 {
     m_bytecode_interpreter = make<Bytecode::Interpreter>(*this);
+    m_program_cache = make<ProgramCache>();
 
     m_empty_string = m_heap.allocate_without_realm<PrimitiveString>(String {});
 
@@ -457,6 +459,7 @@ ThrowCompletionOr<void> VM::iterator_binding_initialization(BindingPattern const
 
                 // f. Perform ! CreateDataPropertyOrThrow(A, ! ToString(𝔽(n)), nextValue).
                 array->indexed_properties().append(next_value.value());
+                array->write_barrier();
 
                 // g. Set n to n + 1.
             }
@@ -1015,6 +1018,10 @@ Vector<FlatPtr> VM::get_native_stack_trace() const
     auto* frame = bit_cast<NativeStackFrame*>(__builtin_frame_address(0));
     while (bit_cast<FlatPtr>(frame) < m_stack_info.top() && bit_cast<FlatPtr>(frame) >= m_stack_info.base()) {
         buffer.append(frame->return_address);
+        // Frames built without a frame pointer (e.g. in libc's startup code) can leave anything in the saved one.
+        // The stack grows down, so stop once the chain doesn't move towards its top rather than going round in circles.
+        if (bit_cast<FlatPtr>(frame->prev) <= bit_cast<FlatPtr>(frame))
+            break;
         frame = frame->prev;
     }
 #endif
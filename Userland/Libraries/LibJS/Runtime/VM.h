@@ -53,6 +53,8 @@ public:
 
     Bytecode::Interpreter& bytecode_interpreter();
 
+    ProgramCache& program_cache() { return *m_program_cache; }
+
     void dump_backtrace() const;
 
     void gather_roots(HashMap<Cell*, HeapRoot>&);
@@ -329,6 +331,9 @@ private:
 
     OwnPtr<Bytecode::Interpreter> m_bytecode_interpreter;
 
+    // NOTE: This is declared after the heap so that it's destroyed first, as cached programs hold handles to bytecode executables.
+    OwnPtr<ProgramCache> m_program_cache;
+
     bool m_dynamic_imports_allowed { false };
 };
 
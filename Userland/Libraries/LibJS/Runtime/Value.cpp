@@ -1819,7 +1819,8 @@ ThrowCompletionOr<Value> mul(VM& vm, Value lhs, Value rhs)
     if (lhs.is_int32() && rhs.is_int32()) {
         Checked<i32> result = lhs.as_i32();
         result *= rhs.as_i32();
-        if (!result.has_overflow())
+        // NOTE: A zero product with a negative operand is -0, which has to go through the double path.
+        if (!result.has_overflow() && (result.value() != 0 || (lhs.as_i32() | rhs.as_i32()) >= 0))
             return result.value();
     }
 
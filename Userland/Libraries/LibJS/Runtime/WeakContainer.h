@@ -16,6 +16,7 @@ public:
     explicit WeakContainer(Heap&);
     virtual ~WeakContainer();
 
+    // Called after marking and before sweeping, so dead cells are the ones that aren't marked.
     virtual void remove_dead_cells(Badge<Heap>) = 0;
 
 protected:
@@ -124,6 +124,7 @@ JS_DEFINE_NATIVE_FUNCTION(WeakMapPrototype::set)
     // 5. Let p be the Record { [[Key]]: key, [[Value]]: value }.
     // 6. Append p to M.[[WeakMapData]].
     weak_map->values().set(&key.as_cell(), value);
+    weak_map->write_barrier();
 
     // 7. Return M.
     return weak_map;
@@ -9,6 +9,7 @@
 #include <AK/QuickSort.h>
 #include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Parser.h>
+#include <LibJS/ProgramCache.h>
 #include <LibJS/Runtime/AsyncFunctionDriverWrapper.h>
 #include <LibJS/Runtime/ECMAScriptFunctionObject.h>
 #include <LibJS/Runtime/GlobalEnvironment.h>
@@ -126,13 +127,20 @@ void SourceTextModule::visit_edges(Cell::Visitor& visitor)
 // 16.2.1.6.1 ParseModule ( sourceText, realm, hostDefined ), https://tc39.es/ecma262/#sec-parsemodule
 Result<NonnullGCPtr<SourceTextModule>, Vector<ParserError>> SourceTextModule::parse(StringView source_text, Realm& realm, StringView filename, Script::HostDefined* host_defined)
 {
+    auto& program_cache = realm.vm().program_cache();
+
     // 1. Let body be ParseText(sourceText, Module).
-    auto parser = Parser(Lexer(source_text, filename), Program::Type::Module);
-    auto body = parser.parse_program();
+    auto body = program_cache.get(source_text, filename, 1, Program::Type::Module);
+    if (!body) {
+        auto parser = Parser(Lexer(source_text, filename), Program::Type::Module);
+        body = parser.parse_program();
+
+        // 2. If body is a List of errors, return body.
+        if (parser.has_errors())
+            return parser.errors();
 
-    // 2. If body is a List of errors, return body.
-    if (parser.has_errors())
-        return parser.errors();
+        program_cache.set(source_text, filename, 1, *body);
+    }
 
     // 3. Let requestedModules be the ModuleRequests of body.
     auto requested_modules = module_requests(*body);
@@ -249,7 +257,7 @@ Result<NonnullGCPtr<SourceTextModule>, Vector<ParserError>> SourceTextModule::pa
         filename,
         host_defined,
         async,
-        move(body),
+        body.release_nonnull(),
         move(requested_modules),
         move(import_entries),
         move(local_export_entries),
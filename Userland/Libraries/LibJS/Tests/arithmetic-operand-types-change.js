@@ -0,0 +1,67 @@
+test("Arithmetic keeps working when operand types change after warming up", () => {
+    function add(a, b) {
+        return a + b;
+    }
+    function sub(a, b) {
+        return a - b;
+    }
+    function mul(a, b) {
+        return a * b;
+    }
+
+    for (let i = 0; i < 10; ++i) {
+        expect(add(i, 1)).toBe(i + 1);
+        expect(sub(i, 1)).toBe(i - 1);
+        expect(mul(i, 2)).toBe(i * 2);
+    }
+
+    expect(add(2147483647, 1)).toBe(2147483648);
+    expect(sub(-2147483648, 1)).toBe(-2147483649);
+    expect(mul(65536, 65536)).toBe(4294967296);
+    expect(add(1.5, 1)).toBe(2.5);
+    expect(add("foo", 1)).toBe("foo1");
+    expect(add(1n, 2n)).toBe(3n);
+    expect(mul({ valueOf: () => 21 }, 2)).toBe(42);
+    expect(add(3, 4)).toBe(7);
+});
+
+test("Comparisons keep working when operand types change after warming up", () => {
+    function less(a, b) {
+        return a < b;
+    }
+
+    for (let i = 0; i < 10; ++i) expect(less(i, 5)).toBe(i < 5);
+
+    expect(less(0.5, 1)).toBeTrue();
+    expect(less(NaN, 1)).toBeFalse();
+    expect(less("a", "b")).toBeTrue();
+    expect(less(1n, 2)).toBeTrue();
+    expect(less(3, 4)).toBeTrue();
+});
+
+test("Loops keep their state when bailing out in the middle", () => {
+    function sum(values) {
+        let total = 0;
+        for (let i = 0; i < values.length; ++i) total = total + values[i];
+        return total;
+    }
+
+    for (let i = 0; i < 5; ++i) expect(sum([1, 2, 3, 4])).toBe(10);
+
+    expect(sum([1, 2, 0.5, 4])).toBe(7.5);
+    expect(sum([1, 2, "3", 4])).toBe("334");
+    expect(sum([2147483647, 1, 2])).toBe(2147483650);
+    expect(sum([1, 2, 3, 4])).toBe(10);
+});
+
+test("Increment keeps working after overflowing int32", () => {
+    function increment(value) {
+        return ++value;
+    }
+
+    for (let i = 0; i < 5; ++i) expect(increment(i)).toBe(i + 1);
+
+    expect(increment(2147483647)).toBe(2147483648);
+    expect(increment(0.5)).toBe(1.5);
+    expect(increment(1n)).toBe(2n);
+});
@@ -0,0 +1,114 @@
+test("code after return is never run", () => {
+    let ran = false;
+    function f() {
+        return 1;
+        ran = true;
+    }
+
+    expect(f()).toBe(1);
+    expect(ran).toBeFalse();
+});
+
+test("labelled blocks", () => {
+    function f(x) {
+        const log = [];
+        outer: {
+            log.push("start");
+            inner: {
+                if (x === 1) break inner;
+                if (x === 2) break outer;
+                log.push("inner");
+            }
+            log.push("after inner");
+        }
+        log.push("end");
+        return log;
+    }
+
+    expect(f(0)).toEqual(["start", "inner", "after inner", "end"]);
+    expect(f(1)).toEqual(["start", "after inner", "end"]);
+    expect(f(2)).toEqual(["start", "end"]);
+});
+
+test("nested loops with break and continue", () => {
+    function f() {
+        const pairs = [];
+        outer: for (let i = 0; i < 4; ++i) {
+            for (let j = 0; j < 4; ++j) {
+                if (j === i) continue outer;
+                if (i === 3) break outer;
+                pairs.push(`${i}${j}`);
+            }
+        }
+        return pairs;
+    }
+
+    expect(f()).toEqual(["10", "20", "21"]);
+});
+
+test("empty blocks and loops", () => {
+    function f(x) {
+        if (x) {
+        } else {
+        }
+        for (let i = 0; i < 3; ++i) {}
+        while (x-- > 0) {}
+        {
+            {
+            }
+        }
+        return x;
+    }
+
+    expect(f(3)).toBe(-1);
+    expect(f(0)).toBe(-1);
+});
+
+test("switch fallthrough and default in the middle", () => {
+    function f(x) {
+        const log = [];
+        switch (x) {
+            case 1:
+                log.push(1);
+            case 2:
+                log.push(2);
+                break;
+            default:
+                log.push("default");
+            case 3:
+                log.push(3);
+        }
+        return log;
+    }
+
+    expect(f(1)).toEqual([1, 2]);
+    expect(f(2)).toEqual([2]);
+    expect(f(3)).toEqual([3]);
+    expect(f(4)).toEqual(["default", 3]);
+});
+
+test("blocks that are only reachable through an exception", () => {
+    function f(x) {
+        let result = "none";
+        try {
+            if (x) throw x;
+        } catch (e) {
+            result = "caught " + e;
+        }
+        return result;
+    }
+
+    expect(f(0)).toBe("none");
+    expect(f(1)).toBe("caught 1");
+});
+
+test("short-circuiting chains", () => {
+    function f(a, b, c) {
+        return (a && b) || (c ?? "default");
+    }
+
+    expect(f(1, 2, 3)).toBe(2);
+    expect(f(0, 2, 3)).toBe(3);
+    expect(f(1, 0, null)).toBe("default");
+    expect(f(0, 0, 0)).toBe(0);
+});
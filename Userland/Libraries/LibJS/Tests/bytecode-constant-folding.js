@@ -0,0 +1,102 @@
+test("arithmetic on constants", () => {
+    expect(1 + 2).toBe(3);
+    expect(0.1 + 0.2).toBe(0.30000000000000004);
+    expect(7 - 10).toBe(-3);
+    expect(6 * 7).toBe(42);
+    expect(1 / 0).toBe(Infinity);
+    expect(-1 / 0).toBe(-Infinity);
+    expect(0 / 0).toBeNaN();
+    expect(7 % -3).toBe(1);
+    expect(-7 % 3).toBe(-1);
+    expect(2 ** 10).toBe(1024);
+    expect(2 ** -1).toBe(0.5);
+    expect((-8) ** (1 / 3)).toBeNaN();
+});
+
+test("negative zero survives folding", () => {
+    expect(Object.is(0 * -1, -0)).toBeTrue();
+    expect(Object.is(-0 + 0, 0)).toBeTrue();
+    expect(Object.is(-0 - 0, -0)).toBeTrue();
+    expect(Object.is(-0 % 5, -0)).toBeTrue();
+    expect(1 / (0 * -1)).toBe(-Infinity);
+});
+
+test("bitwise operations on constants", () => {
+    expect(5 & 3).toBe(1);
+    expect(5 | 3).toBe(7);
+    expect(5 ^ 3).toBe(6);
+    expect(1 << 31).toBe(-2147483648);
+    expect(1 << 32).toBe(1);
+    expect(-16 >> 2).toBe(-4);
+    expect(-1 >>> 0).toBe(4294967295);
+    expect(-1 >>> 28).toBe(15);
+    expect(2 ** 32 | 0).toBe(0);
+    expect(1.9 | 0).toBe(1);
+});
+
+test("comparisons on constants", () => {
+    expect(1 < 2).toBeTrue();
+    expect(2 <= 2).toBeTrue();
+    expect(3 > 4).toBeFalse();
+    expect(4 >= 5).toBeFalse();
+    expect(NaN === NaN).toBeFalse();
+    expect(NaN !== NaN).toBeTrue();
+    expect(NaN < 1).toBeFalse();
+    expect(NaN >= 1).toBeFalse();
+    expect(0 === -0).toBeTrue();
+    expect(null == undefined).toBeTrue();
+    expect(null === undefined).toBeFalse();
+    expect(null == 0).toBeFalse();
+    expect(true == 1).toBeTrue();
+    expect(true === 1).toBeFalse();
+});
+
+test("constant conditions in branches", () => {
+    function f() {
+        const log = [];
+        if (1 < 2) log.push("taken");
+        else log.push("not taken");
+        if (NaN) log.push("NaN is truthy");
+        if (0) log.push("0 is truthy");
+        if (-0) log.push("-0 is truthy");
+        if (1 === 1) log.push("equal");
+        while (false) log.push("loop");
+        do log.push("once");
+        while (0 > 1);
+        log.push(null ?? "nullish");
+        log.push(0 ?? "not nullish");
+        log.push(undefined ? "truthy" : "falsy");
+        return log;
+    }
+
+    expect(f()).toEqual(["taken", "equal", "once", "nullish", 0, "falsy"]);
+});
+
+test("constants that are overwritten before use", () => {
+    function f(x) {
+        let a = 1 + 1;
+        a = x;
+        let b = a * 2;
+        b = b + (3 - 3);
+        return [a, b];
+    }
+
+    expect(f(5)).toEqual([5, 10]);
+    expect(f("5")).toEqual(["5", 10]);
+});
+
+test("operands that are not constant are left alone", () => {
+    let calls = 0;
+    const object = {
+        valueOf() {
+            ++calls;
+            return 2;
+        },
+    };
+    expect(1 + object).toBe(3);
+    expect(object * 0).toBe(0);
+    expect(calls).toBe(2);
+    expect(1 + "2").toBe("12");
+    expect("3" * "4").toBe(12);
+    expect(1n + 2n).toBe(3n);
+});
@@ -0,0 +1,183 @@
+test("stores before a throw are seen by catch and finally", () => {
+    const log = [];
+    function f(shouldThrow) {
+        let x = 1;
+        try {
+            x = 2;
+            if (shouldThrow) throw new Error();
+            x = 3;
+        } catch {
+            log.push("catch " + x);
+            x = 4;
+        } finally {
+            log.push("finally " + x);
+        }
+        return x;
+    }
+
+    expect(f(true)).toBe(4);
+    expect(log).toEqual(["catch 2", "finally 4"]);
+    log.length = 0;
+    expect(f(false)).toBe(3);
+    expect(log).toEqual(["finally 3"]);
+});
+
+test("stores before a call that throws are seen by catch", () => {
+    function thrower() {
+        throw new Error();
+    }
+    function f(callback) {
+        let x = 0;
+        try {
+            x = 1;
+            callback();
+            x = 2;
+        } catch {
+            return x;
+        }
+        return x;
+    }
+
+    expect(f(thrower)).toBe(1);
+    expect(f(() => {})).toBe(2);
+});
+
+test("stores in finally after a return are not lost", () => {
+    let seen;
+    function f() {
+        let x = 1;
+        try {
+            x = 2;
+            return x;
+        } finally {
+            x = 3;
+            seen = x;
+        }
+    }
+
+    expect(f()).toBe(2);
+    expect(seen).toBe(3);
+});
+
+test("stores before break and continue through finally", () => {
+    const log = [];
+    function f() {
+        let last = -1;
+        for (let i = 0; i < 5; ++i) {
+            try {
+                last = i;
+                if (i === 1) continue;
+                if (i === 3) break;
+            } finally {
+                log.push(last);
+            }
+            last = -1;
+        }
+        return last;
+    }
+
+    expect(f()).toBe(3);
+    expect(log).toEqual([0, 1, 2, 3]);
+});
+
+test("stores in nested finally blocks", () => {
+    function f() {
+        let x = 0;
+        try {
+            try {
+                x = 1;
+                throw 1;
+            } finally {
+                x += 10;
+            }
+        } catch {
+            x += 100;
+        } finally {
+            x += 1000;
+        }
+        return x;
+    }
+
+    expect(f()).toBe(1111);
+});
+
+test("values stay live across yield", () => {
+    function* generator() {
+        let x = 1;
+        x = yield x;
+        let y = x + 1;
+        yield y;
+        x = 10;
+        try {
+            yield x;
+        } finally {
+            x = 20;
+        }
+        return x;
+    }
+
+    const iterator = generator();
+    expect(iterator.next()).toEqual({ value: 1, done: false });
+    expect(iterator.next(5)).toEqual({ value: 6, done: false });
+    expect(iterator.next()).toEqual({ value: 10, done: false });
+    expect(iterator.next()).toEqual({ value: 20, done: true });
+});
+
+test("stores before yield are seen by finally when the generator is returned from", () => {
+    let seen;
+    function* generator() {
+        let x = 1;
+        try {
+            x = 2;
+            yield x;
+            x = 3;
+        } finally {
+            seen = x;
+        }
+    }
+
+    const iterator = generator();
+    expect(iterator.next().value).toBe(2);
+    expect(iterator.return(42)).toEqual({ value: 42, done: true });
+    expect(seen).toBe(2);
+});
+
+test("stores before yield are seen by catch when the generator is thrown into", () => {
+    function* generator() {
+        let x = 1;
+        try {
+            x = 2;
+            yield x;
+            x = 3;
+        } catch {
+            yield x;
+        }
+    }
+
+    const iterator = generator();
+    expect(iterator.next().value).toBe(2);
+    expect(iterator.throw(new Error()).value).toBe(2);
+});
+
+test("values stay live across await", () => {
+    let result;
+    async function f() {
+        let x = 1;
+        x = (await x) + 1;
+        let y = x;
+        try {
+            y = 3;
+            await Promise.reject(y);
+            y = 4;
+        } catch (e) {
+            y += e;
+        }
+        return y;
+    }
+
+    f().then(value => {
+        result = value;
+    });
+    runQueuedPromiseJobs();
+    expect(result).toBe(6);
+});
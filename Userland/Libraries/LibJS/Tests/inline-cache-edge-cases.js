@@ -16,3 +16,89 @@ test("Inline cache invalidated by deleting property from unique shape", () => {
     expect(first).toBe(2);
     expect(second).toBeUndefined();
 });
+
+test("Polymorphic inline cache returns the right property for each shape", () => {
+    function get(o) {
+        return o.value;
+    }
+
+    function put(o, value) {
+        o.value = value;
+    }
+
+    // Each object has "value" at a different offset, and there are more shapes than the cache has room for.
+    let objects = [];
+    for (let i = 0; i < 8; ++i) {
+        let o = {};
+        for (let j = 0; j < i; ++j) o["padding" + j] = j;
+        o.value = i;
+        objects.push(o);
+    }
+
+    for (let round = 0; round < 3; ++round) {
+        for (let i = 0; i < objects.length; ++i) {
+            expect(get(objects[i])).toBe(i + round * 100);
+            put(objects[i], i + (round + 1) * 100);
+        }
+    }
+
+    for (let i = 0; i < objects.length; ++i) {
+        for (let j = 0; j < i; ++j) expect(objects[i]["padding" + j]).toBe(j);
+    }
+});
+
+test("Megamorphic put doesn't write to read-only properties that were read through the same shape", () => {
+    "use strict";
+
+    function get(o) {
+        return o.value;
+    }
+
+    function put(o, value) {
+        o.value = value;
+    }
+
+    // Enough shapes to make both sites megamorphic, each with a frozen object that has been read from but never written to.
+    let objects = [];
+    let frozenObjects = [];
+    for (let i = 0; i < 8; ++i) {
+        let o = {};
+        for (let j = 0; j < i; ++j) o["padding" + j] = j;
+        o.value = i;
+        objects.push(o);
+
+        let frozen = {};
+        for (let j = 0; j < i; ++j) frozen["other" + j] = j;
+        frozen.value = i;
+        Object.freeze(frozen);
+        frozenObjects.push(frozen);
+    }
+
+    for (let i = 0; i < objects.length; ++i) {
+        put(objects[i], i);
+        expect(get(frozenObjects[i])).toBe(i);
+    }
+
+    for (let i = 0; i < frozenObjects.length; ++i) {
+        expect(() => put(frozenObjects[i], 42)).toThrow(TypeError);
+        expect(frozenObjects[i].value).toBe(i);
+    }
+});
+
+test("Put cache doesn't write to a property of a dictionary that has become read-only", () => {
+    "use strict";
+
+    let o = {};
+    for (let x = 0; x < 100; ++x) o["prop" + x] = x;
+
+    function put(o, value) {
+        o.prop2 = value;
+    }
+
+    put(o, 10);
+    put(o, 20);
+    Object.defineProperty(o, "prop2", { writable: false });
+
+    expect(() => put(o, 30)).toThrow(TypeError);
+    expect(o.prop2).toBe(20);
+});
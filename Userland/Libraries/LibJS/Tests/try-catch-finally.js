@@ -162,6 +162,23 @@ test("try/catch/finally with exception in try, catch and finally", () => {
     expect(finallyHasBeenExecuted).toBeTrue();
 });
 
+test("try/finally with exception in try", () => {
+    var tryHasBeenExecuted = false;
+    var finallyHasBeenExecuted = false;
+    var tryError = Error("Error in try");
+    expect(() => {
+        try {
+            tryHasBeenExecuted = true;
+            throw tryError;
+            expect().fail();
+        } finally {
+            finallyHasBeenExecuted = true;
+        }
+    }).toThrow(Error, "Error in try");
+    expect(tryHasBeenExecuted).toBeTrue();
+    expect(finallyHasBeenExecuted).toBeTrue();
+});
+
 test("try statement must have either 'catch' or 'finally' clause", () => {
     expect("try {} catch {}").toEval();
     expect("try {} catch (e) {}").toEval();
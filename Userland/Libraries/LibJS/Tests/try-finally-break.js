@@ -342,19 +342,21 @@ test("labelled break in finally overrides labelled break in try", () => {
 
 test("Throw while breaking", () => {
     const executionOrder = [];
-    try {
-        for (const i = 1337; ; expect().fail("Jumped to for loop update block")) {
-            try {
-                executionOrder.push(1);
-                break;
-            } finally {
-                executionOrder.push(2);
-                throw 1;
+    expect(() => {
+        try {
+            for (const i = 1337; ; expect().fail("Jumped to for loop update block")) {
+                try {
+                    executionOrder.push(1);
+                    break;
+                } finally {
+                    executionOrder.push(2);
+                    throw 1;
+                }
             }
+        } finally {
+            executionOrder.push(3);
         }
-    } finally {
-        executionOrder.push(3);
-    }
+    }).toThrow();
     expect(() => {
         i;
     }).toThrowWithMessage(ReferenceError, "'i' is not defined");
@@ -20,6 +20,9 @@ namespace JS {
 
 RefPtr<::JS::VM> g_vm;
 bool g_collect_on_every_allocation = false;
+bool g_generational_gc = false;
+bool g_incremental_gc = false;
+bool g_lazy_sweep = false;
 ByteString g_currently_running_test;
 HashMap<ByteString, FunctionWithLength> s_exposed_global_functions;
 Function<void()> g_main_hook;
@@ -117,6 +120,9 @@ int main(int argc, char** argv)
     args_parser.add_option(print_json, "Show results as JSON", "json", 'j');
     args_parser.add_option(per_file, "Show detailed per-file results as JSON (implies -j)", "per-file", 0);
     args_parser.add_option(g_collect_on_every_allocation, "Collect garbage after every allocation", "collect-often", 'g');
+    args_parser.add_option(g_generational_gc, "Use generational garbage collection", "generational-gc", {});
+    args_parser.add_option(g_incremental_gc, "Use incremental marking in the garbage collector", "incremental-gc", {});
+    args_parser.add_option(g_lazy_sweep, "Sweep the heap lazily after garbage collection", "lazy-sweep", {});
     args_parser.add_option(JS::Bytecode::g_dump_bytecode, "Dump the bytecode", "dump-bytecode", 'd');
     args_parser.add_option(test_glob, "Only run tests matching the given glob", "filter", 'f', "glob");
     for (auto& entry : g_extra_args)
@@ -125,6 +131,11 @@ int main(int argc, char** argv)
     args_parser.add_positional_argument(common_path, "Path to tests-common.js", "common-path", Core::ArgsParser::Required::No);
     args_parser.parse(arguments);
 
+    if (g_generational_gc && (g_incremental_gc || g_lazy_sweep)) {
+        warnln("Generational garbage collection can't be combined with incremental marking or lazy sweeping");
+        return 1;
+    }
+
     if (per_file)
         print_json = true;
 
@@ -18,22 +18,43 @@ DNSServer::DNSServer(Core::EventReceiver* parent)
 {
     bind(IPv4Address(), 53);
     on_ready_to_receive = [this]() {
-        auto result = handle_client();
+        auto result = handle_clients();
         if (result.is_error()) {
-            dbgln("DNSServer: Failed to handle client: {}", result.error());
+            dbgln("DNSServer: Failed to handle clients: {}", result.error());
         }
     };
 }
 
-ErrorOr<void> DNSServer::handle_client()
+ErrorOr<void> DNSServer::handle_clients()
+{
+    // Drain everything that's queued at once, and answer it all with a single batch.
+    auto requests = TRY(receive_batch(max_requests_per_batch, 1024));
+
+    Vector<Datagram> responses;
+    TRY(responses.try_ensure_capacity(requests.size()));
+    for (auto& request : requests) {
+        auto response_or_error = handle_request(request.data);
+        if (response_or_error.is_error()) {
+            dbgln("DNSServer: Failed to handle client: {}", response_or_error.error());
+            continue;
+        }
+        auto response = response_or_error.release_value();
+        if (response.has_value())
+            responses.unchecked_append({ response.release_value(), request.address });
+    }
+
+    if (!responses.is_empty())
+        TRY(send_batch(responses));
+    return {};
+}
+
+ErrorOr<Optional<ByteBuffer>> DNSServer::handle_request(ReadonlyBytes buffer)
 {
-    sockaddr_in client_address;
-    auto buffer = TRY(receive(1024, client_address));
     auto request = TRY(Packet::from_raw_packet(buffer));
 
     if (!request.is_query()) {
         dbgln("It's not a request");
-        return {};
+        return OptionalNone {};
     }
 
     LookupServer& lookup_server = LookupServer::the();
@@ -57,10 +78,7 @@ ErrorOr<void> DNSServer::handle_client()
     else
         response.set_code(Packet::Code::NOERROR);
 
-    buffer = TRY(response.to_byte_buffer());
-
-    TRY(send(buffer, client_address));
-    return {};
+    return TRY(response.to_byte_buffer());
 }
 
 }
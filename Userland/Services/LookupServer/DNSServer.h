@@ -16,7 +16,10 @@ class DNSServer : public Core::UDPServer {
 private:
     explicit DNSServer(Core::EventReceiver* parent = nullptr);
 
-    ErrorOr<void> handle_client();
+    static constexpr size_t max_requests_per_batch = 64;
+
+    ErrorOr<void> handle_clients();
+    ErrorOr<Optional<ByteBuffer>> handle_request(ReadonlyBytes);
 };
 
 }
@@ -172,11 +172,11 @@ ErrorOr<bool> Client::handle_request(HTTP::HttpRequest const& request)
         .type = TRY(String::from_utf8(Core::guess_mime_type_based_on_filename(real_path.bytes_as_string_view()))),
         .length = TRY(FileSystem::size(real_path.bytes_as_string_view()))
     };
-    TRY(send_response(*stream, request, move(info)));
+    TRY(send_file_response(*stream, request, move(info)));
     return true;
 }
 
-ErrorOr<void> Client::send_response(Stream& response, HTTP::HttpRequest const& request, ContentInfo content_info)
+ErrorOr<void> Client::send_response_header(HTTP::HttpRequest const& request, ContentInfo const& content_info)
 {
     StringBuilder builder;
     TRY(builder.try_append("HTTP/1.0 200 OK\r\n"sv));
@@ -194,6 +194,12 @@ ErrorOr<void> Client::send_response(Stream& response, HTTP::HttpRequest const& r
     auto builder_contents = TRY(builder.to_byte_buffer());
     TRY(m_socket->write_until_depleted(builder_contents));
     log_response(200, request);
+    return {};
+}
+
+ErrorOr<void> Client::send_response(Stream& response, HTTP::HttpRequest const& request, ContentInfo content_info)
+{
+    TRY(send_response_header(request, content_info));
 
     char buffer[PAGE_SIZE];
     do {
@@ -213,6 +219,31 @@ ErrorOr<void> Client::send_response(Stream& response, HTTP::HttpRequest const& r
         }
     } while (true);
 
+    finish_response(request);
+    return {};
+}
+
+ErrorOr<void> Client::send_file_response(Core::File& file, HTTP::HttpRequest const& request, ContentInfo content_info)
+{
+    TRY(send_response_header(request, content_info));
+
+    // Let the kernel move the file's contents into the socket, so they don't have to be copied through our buffers.
+    off_t offset = 0;
+    size_t remaining = content_info.length;
+    while (remaining > 0) {
+        auto nsent = TRY(m_socket->send_file(file.fd(), offset, remaining));
+        // The file got shorter since we looked at its size, so we can't send the Content-Length we promised.
+        if (nsent == 0)
+            return Error::from_string_literal("File was truncated while sending it");
+        remaining -= nsent;
+    }
+
+    finish_response(request);
+    return {};
+}
+
+void Client::finish_response(HTTP::HttpRequest const& request)
+{
     auto keep_alive = false;
     if (auto it = request.headers().find_if([](auto& header) { return header.name.equals_ignoring_ascii_case("Connection"sv); }); !it.is_end()) {
         if (it->value.trim_whitespace().equals_ignoring_ascii_case("keep-alive"sv))
@@ -220,8 +251,6 @@ ErrorOr<void> Client::send_response(Stream& response, HTTP::HttpRequest const& r
     }
     if (!keep_alive)
         m_socket->close();
-
-    return {};
 }
 
 ErrorOr<void> Client::send_redirect(StringView redirect_path, HTTP::HttpRequest const& request)
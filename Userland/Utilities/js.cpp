@@ -534,6 +534,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     TRY(Core::System::pledge("stdio rpath wpath cpath tty sigaction"));
 
     bool gc_on_every_allocation = false;
+    bool generational_gc = false;
+    bool incremental_gc = false;
+    bool lazy_sweep = false;
     bool disable_syntax_highlight = false;
     bool disable_debug_printing = false;
     bool use_test262_global = false;
@@ -549,6 +552,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(s_strip_ansi, "Disable ANSI colors", "disable-ansi-colors", 'i');
     args_parser.add_option(s_disable_source_location_hints, "Disable source location hints", "disable-source-location-hints", 'h');
     args_parser.add_option(gc_on_every_allocation, "GC on every allocation", "gc-on-every-allocation", 'g');
+    args_parser.add_option(generational_gc, "Use generational garbage collection", "generational-gc", {});
+    args_parser.add_option(incremental_gc, "Use incremental marking in the garbage collector", "incremental-gc", {});
+    args_parser.add_option(lazy_sweep, "Sweep the heap lazily after garbage collection", "lazy-sweep", {});
     args_parser.add_option(disable_syntax_highlight, "Disable live syntax highlighting", "no-syntax-highlight", 's');
     args_parser.add_option(disable_debug_printing, "Disable debug output", "disable-debug-output", {});
     args_parser.add_option(evaluate_script, "Evaluate argument as a script", "evaluate", 'c', "script");
@@ -556,6 +562,11 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_positional_argument(script_paths, "Path to script files", "scripts", Core::ArgsParser::Required::No);
     args_parser.parse(arguments);
 
+    if (generational_gc && (incremental_gc || lazy_sweep)) {
+        warnln("Generational garbage collection can't be combined with incremental marking or lazy sweeping");
+        return 1;
+    }
+
     bool syntax_highlight = !disable_syntax_highlight;
 
     AK::set_debug_enabled(!disable_debug_printing);
@@ -595,6 +606,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         ReplConsoleClient console_client(console_object.console());
         console_object.console().set_client(console_client);
         g_vm->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        g_vm->heap().set_generational_collection_enabled(generational_gc);
+        g_vm->heap().set_incremental_marking_enabled(incremental_gc);
+        g_vm->heap().set_lazy_sweeping_enabled(lazy_sweep);
 
         auto& global_environment = realm.global_environment();
 
@@ -812,6 +826,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         ReplConsoleClient console_client(console_object.console());
         console_object.console().set_client(console_client);
         g_vm->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        g_vm->heap().set_generational_collection_enabled(generational_gc);
+        g_vm->heap().set_incremental_marking_enabled(incremental_gc);
+        g_vm->heap().set_lazy_sweeping_enabled(lazy_sweep);
 
         signal(SIGINT, [](int) {
             sigint_handler();
@@ -43,6 +43,14 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     u64 physical_available = json.get_u64("physical_available"sv).value_or(0);
     u64 physical_committed = json.get_u64("physical_committed"sv).value_or(0);
     u64 physical_uncommitted = json.get_u64("physical_uncommitted"sv).value_or(0);
+    u64 compressed_pages = json.get_u64("compressed_pages"sv).value_or(0);
+    u64 compressed_bytes = json.get_u64("compressed_bytes"sv).value_or(0);
+    u64 compressed_storage_pages = json.get_u64("compressed_storage_pages"sv).value_or(0);
+    u64 page_cache_active = json.get_u64("page_cache_active"sv).value_or(0);
+    u64 page_cache_inactive = json.get_u64("page_cache_inactive"sv).value_or(0);
+    u64 page_cache_hits = json.get_u64("page_cache_hits"sv).value_or(0);
+    u64 page_cache_misses = json.get_u64("page_cache_misses"sv).value_or(0);
+    u64 page_cache_reclaimed = json.get_u64("page_cache_reclaimed"sv).value_or(0);
     u32 kmalloc_call_count = json.get_u32("kmalloc_call_count"sv).value_or(0);
     u32 kfree_call_count = json.get_u32("kfree_call_count"sv).value_or(0);
 
@@ -56,13 +64,19 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         outln("Physical pages (committed) count: {}", TRY(String::formatted("{}", human_readable_size_long(page_count_to_bytes(physical_committed), UseThousandsSeparator::Yes))));
         outln("Physical pages (uncommitted) count: {}", TRY(String::formatted("{}", human_readable_size_long(page_count_to_bytes(physical_uncommitted), UseThousandsSeparator::Yes))));
         outln("Physical pages (total) count: {:'}", physical_pages_total);
+        outln("Compressed pages: {}", TRY(String::formatted("{} in {} ({} used)", human_readable_size_long(page_count_to_bytes(compressed_pages), UseThousandsSeparator::Yes), human_readable_size_long(page_count_to_bytes(compressed_storage_pages), UseThousandsSeparator::Yes), human_readable_size_long(compressed_bytes, UseThousandsSeparator::Yes))));
+        outln("Page cache (active/inactive): {}", TRY(String::formatted("{} / {}", human_readable_size_long(page_count_to_bytes(page_cache_active), UseThousandsSeparator::Yes), human_readable_size_long(page_count_to_bytes(page_cache_inactive), UseThousandsSeparator::Yes))));
     } else {
         outln("Kmalloc allocated: {}", TRY(String::formatted("{}/{}", kmalloc_allocated, kmalloc_bytes_total)));
         outln("Physical pages (in use) count: {}", TRY(String::formatted("{}/{}", page_count_to_bytes(physical_pages_in_use), page_count_to_bytes(physical_pages_total))));
         outln("Physical pages (committed) count: {}", TRY(String::formatted("{}", page_count_to_bytes(physical_committed))));
         outln("Physical pages (uncommitted) count: {}", TRY(String::formatted("{}", page_count_to_bytes(physical_uncommitted))));
         outln("Physical pages (total) count: {}", physical_pages_total);
+        outln("Compressed pages: {}", TRY(String::formatted("{} in {} ({} used)", page_count_to_bytes(compressed_pages), page_count_to_bytes(compressed_storage_pages), compressed_bytes)));
+        outln("Page cache (active/inactive): {}", TRY(String::formatted("{}/{}", page_count_to_bytes(page_cache_active), page_count_to_bytes(page_cache_inactive))));
     }
+    outln("Page cache hits/misses: {}", TRY(String::formatted("{}/{}", page_cache_hits, page_cache_misses)));
+    outln("Page cache reclaimed pages: {}", page_cache_reclaimed);
     outln("Kmalloc call count: {}", kmalloc_call_count);
     outln("Kfree call count: {}", kfree_call_count);
     outln("Kmalloc/Kfree delta: {}", TRY(String::formatted("{:+}", kmalloc_call_count - kfree_call_count)));
@@ -655,7 +655,7 @@ struct MmapFlags : BitflagBase {
     static constexpr auto options = {
         BITFLAG(MAP_SHARED), BITFLAG(MAP_PRIVATE), BITFLAG(MAP_FIXED), BITFLAG(MAP_ANONYMOUS),
         BITFLAG(MAP_RANDOMIZED), BITFLAG(MAP_STACK), BITFLAG(MAP_NORESERVE), BITFLAG(MAP_PURGEABLE),
-        BITFLAG(MAP_FIXED_NOREPLACE)
+        BITFLAG(MAP_FIXED_NOREPLACE), BITFLAG(MAP_HUGETLB)
     };
     static constexpr StringView default_ = "MAP_FILE"sv;
 };